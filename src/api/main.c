@@ -9,10 +9,15 @@
 #include "yyjson.h"        // from external/yyjson/src
 
 #include "app/analyze.h"
+#include "app/cost_model.h"
+#include "app/workers.h"
+#include "core/tokenizer.h"
 #include "input/request_validate.h"
 
 typedef struct {
     const char *stopwords_path;
+    size_t max_token_bytes;  // 0 = no limit
+    unsigned threads;        // page-stage workers per request
 } AppConfig;
 
 /* Request-level timer used to compute runtimeMsTotal. */
@@ -249,7 +254,7 @@ static int handle_analyze(struct mg_connection *conn, void *cbdata) {
         if (!ok) {
             validated_request_free(&req);
             free(body);
-            send_json_error(conn, 400, "invalid X-Pipeline (use auto|string|id)");
+            send_json_error(conn, 400, "invalid X-Pipeline (use " APP_PIPELINE_CHOICES ")");
             return 400;
         }
         pipeline = pl;
@@ -268,6 +273,20 @@ static int handle_analyze(struct mg_connection *conn, void *cbdata) {
         .domain           = req.domain,   // pointer into req.doc
         .pipeline         = pipeline,
         .deadline_ms = deadline_ms,
+        .max_token_bytes  = cfg->max_token_bytes,
+        .approximate      = req.approximate,
+        .approximate_capacity = req.approximate_capacity,
+        .sample_rate      = req.sample_rate,
+        .sample_seed      = req.sample_seed,
+        .ngram_max        = req.ngram_max,
+        .ngram_limit      = req.ngram_limit,
+        .cooc_window      = req.cooc_window,
+        .cooc_min_count   = req.cooc_min_count,
+        .cooc_limit       = req.cooc_limit,
+        .stem             = req.stem,
+        .tfidf            = req.tfidf,
+        .partial_on_timeout = req.partial_on_timeout,
+        .threads          = cfg->threads,
     };
 
     /* Core analysis stage (pipeline switch happens in app layer). */
@@ -327,7 +346,19 @@ int main(int argc, char **argv) {
     const char *port = get_env_or_default("PORT", "8080");
     const char *stopwords = get_env_or_default("STOPWORDS_FILE", "data/stopwords_de.txt");
 
-    AppConfig cfg = { stopwords };
+    /* Token length cap (bytes) against giant-token payloads; on by
+     * default for the public endpoint, "0" turns it off.
+     */
+    const char *max_tok = get_env_or_default("MAX_TOKEN_BYTES", NULL);
+    size_t max_token_bytes = max_tok ? (size_t)strtoul(max_tok, NULL, 10) : TOKENIZER_MAX_TOKEN_BYTES;
+
+    /* Page-stage workers per request ("auto" = online CPUs). */
+    const char *threads = get_env_or_default("ANALYZE_THREADS", "1");
+
+    AppConfig cfg = { stopwords, max_token_bytes, workers_parse(threads) };
+
+    /* AUTO cost model: microbenchmark before the first request. */
+    cost_model_calibrate(stopwords);
 
     const char *options[] = {
         "listening_ports", port,
@@ -352,6 +383,7 @@ int main(int argc, char **argv) {
 
     printf("API server running on http://localhost:%s\n", port);
     printf("Stopwords file: %s\n", stopwords);
+    printf("Analysis threads per request: %u\n", cfg.threads);
     printf("Endpoints: GET /health, POST /analyze\n");
     fflush(stdout);
 
@@ -1,25 +1,36 @@
 #include "app/analyze.h"
-#include "app/pipeline_id.h"
-#include "app/pipeline_string.h"
+#include "app/engine.h"
+#include "app/workers.h"
+#include "app/page_plan.h"
+#include "app/scratch.h"
+#include "app/cost_model.h"
 
 #include <string.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <time.h>
 #include <math.h>
 #include <stdio.h>
 
+#include "core/arena.h"
+#include "core/cancel.h"
 #include "core/tokenizer.h"
 #include "core/stopwords.h"
 #include "core/aggregate.h"
 #include "core/bigram_aggregate.h"
+#include "core/aggregate_ta.h"
+#include "core/heavy_hitters.h"
+#include "core/sampling.h"
+#include "core/small_count.h"
+#include "core/id_ngrams.h"
+#include "core/id_cooc.h"
+#include "core/stem_de.h"
+#include "core/id_docfreq.h"
 #include "view/topk.h"
 #include "metrics/metrics.h"
 
 #include "yyjson.h"
 
-/* AUTO pipeline switch threshold (total input chars). */
-#define PIPELINE_THRESHOLD_CHARS (1000 * 1024) // 1000 KB
-
 /* Measurement point for meta.runtimeMsAnalyze (core analysis only). */
 static double now_ms(void) {
 #if defined(CLOCK_MONOTONIC)
@@ -39,19 +50,24 @@ static app_analyze_result_t fail(int status, const char *msg) {
     return r;
 }
 
-/* JSON view helper: serializes WordCountList into response schema. */
-static void json_add_word_list(yyjson_mut_doc *doc, yyjson_mut_val *arr, const WordCountList *list) {
+/* JSON view helper: serializes WordCountList into response schema.
+ * errors (approximate mode) adds the per-entry overestimation bound.
+ */
+static void json_add_word_list(yyjson_mut_doc *doc, yyjson_mut_val *arr, const WordCountList *list,
+                               const size_t *errors) {
     for (size_t i = 0; i < list->count; i++) {
         yyjson_mut_val *obj = yyjson_mut_obj(doc);
         const char *w = list->items[i].word ? list->items[i].word : "";
         yyjson_mut_obj_add_strcpy(doc, obj, "word", w);
         yyjson_mut_obj_add_uint(doc, obj, "count", (uint64_t)list->items[i].count);
+        if (errors) yyjson_mut_obj_add_uint(doc, obj, "error", (uint64_t)errors[i]);
         yyjson_mut_arr_add_val(arr, obj);
     }
 }
 
 /* JSON view helper: serializes BigramCountList into response schema. */
-static void json_add_bigram_list(yyjson_mut_doc *doc, yyjson_mut_val *arr, const BigramCountList *list) {
+static void json_add_bigram_list(yyjson_mut_doc *doc, yyjson_mut_val *arr, const BigramCountList *list,
+                                 const size_t *errors) {
     for (size_t i = 0; i < list->count; i++) {
         yyjson_mut_val *obj = yyjson_mut_obj(doc);
         const char *w1 = list->items[i].w1 ? list->items[i].w1 : "";
@@ -59,6 +75,7 @@ static void json_add_bigram_list(yyjson_mut_doc *doc, yyjson_mut_val *arr, const
         yyjson_mut_obj_add_strcpy(doc, obj, "w1", w1);
         yyjson_mut_obj_add_strcpy(doc, obj, "w2", w2);
         yyjson_mut_obj_add_uint(doc, obj, "count", (uint64_t)list->items[i].count);
+        if (errors) yyjson_mut_obj_add_uint(doc, obj, "error", (uint64_t)errors[i]);
         yyjson_mut_arr_add_val(arr, obj);
     }
 }
@@ -67,15 +84,125 @@ static inline double round3(double v) {
     return round(v * 1000.0) / 1000.0;
 }
 
+/* JSON view helper: n-grams as word arrays (domainResult.ngrams[n]);
+ * sampled counts are scaled by fraction.
+ */
+static void json_add_ngram_list(yyjson_mut_doc *doc, yyjson_mut_val *arr, const NgramCountList *list,
+                                double fraction) {
+    for (size_t i = 0; i < list->count; i++) {
+        yyjson_mut_val *obj = yyjson_mut_obj(doc);
+        yyjson_mut_val *ws = yyjson_mut_arr(doc);
+        for (unsigned j = 0; j < list->items[i].n; j++) {
+            yyjson_mut_arr_add_strcpy(doc, ws, list->items[i].words[j]);
+        }
+        yyjson_mut_obj_add_val(doc, obj, "words", ws);
+        yyjson_mut_obj_add_uint(doc, obj, "count",
+                                (uint64_t)sample_scale_count(list->items[i].count, fraction));
+        yyjson_mut_arr_add_val(arr, obj);
+    }
+}
+
+/* JSON view helper: co-occurrence matrix in COO form (vocab + parallel
+ * rows/cols/counts arrays); sampled counts are scaled by fraction.
+ */
+static void json_add_cooc_matrix(yyjson_mut_doc *doc, yyjson_mut_val *obj, const CoocMatrix *m,
+                                 double fraction) {
+    yyjson_mut_val *vocab = yyjson_mut_arr(doc);
+    for (size_t v = 0; v < m->n_vocab; v++) yyjson_mut_arr_add_strcpy(doc, vocab, m->vocab[v]);
+    yyjson_mut_val *rows = yyjson_mut_arr(doc);
+    yyjson_mut_val *cols = yyjson_mut_arr(doc);
+    yyjson_mut_val *counts = yyjson_mut_arr(doc);
+    for (size_t i = 0; i < m->nnz; i++) {
+        yyjson_mut_arr_add_uint(doc, rows, m->rows[i]);
+        yyjson_mut_arr_add_uint(doc, cols, m->cols[i]);
+        yyjson_mut_arr_add_uint(doc, counts, (uint64_t)sample_scale_count(m->counts[i], fraction));
+    }
+    yyjson_mut_obj_add_val(doc, obj, "vocab", vocab);
+    yyjson_mut_obj_add_val(doc, obj, "rows", rows);
+    yyjson_mut_obj_add_val(doc, obj, "cols", cols);
+    yyjson_mut_obj_add_val(doc, obj, "counts", counts);
+}
+
+/* JSON view helper: TF-IDF ranking (domainResult.tfidf); sampled counts
+ * are scaled by fraction, scores follow the scaled counts.
+ */
+static void json_add_tfidf_list(yyjson_mut_doc *doc, yyjson_mut_val *arr, const TfidfList *list,
+                                double fraction) {
+    for (size_t i = 0; i < list->count; i++) {
+        const TfidfEntry *e = &list->items[i];
+        size_t count = sample_scale_count(e->count, fraction);
+        yyjson_mut_val *obj = yyjson_mut_obj(doc);
+        yyjson_mut_obj_add_strcpy(doc, obj, "word", e->word ? e->word : "");
+        yyjson_mut_obj_add_uint(doc, obj, "count", (uint64_t)count);
+        yyjson_mut_obj_add_uint(doc, obj, "df", e->df);
+        yyjson_mut_obj_add_real(doc, obj, "idf", round3(e->idf));
+        yyjson_mut_obj_add_real(doc, obj, "score", round3((double)count * e->idf));
+        yyjson_mut_arr_add_val(arr, obj);
+    }
+}
+
+/* ---------- Sampling views ---------- */
+
+static double sample_fraction(const SampleStats *st) {
+    return (st && st->bytes_total > 0) ? (double)st->bytes_kept / (double)st->bytes_total : 1.0;
+}
+
+/* Scales sampled counts (and approximate error bounds) to full-text estimates.
+ * A common factor >= 1 keeps the list order intact.
+ */
+static void scale_word_list(WordCountList *l, size_t *errors, double fraction) {
+    for (size_t i = 0; i < l->count; i++) {
+        l->items[i].count = sample_scale_count(l->items[i].count, fraction);
+        if (errors) errors[i] = sample_scale_count(errors[i], fraction);
+    }
+}
+
+static void scale_bigram_list(BigramCountList *l, size_t *errors, double fraction) {
+    for (size_t i = 0; i < l->count; i++) {
+        l->items[i].count = sample_scale_count(l->items[i].count, fraction);
+        if (errors) errors[i] = sample_scale_count(errors[i], fraction);
+    }
+}
+
+static TextMetrics scale_metrics(TextMetrics m, double fraction) {
+    m.charCount = sample_scale_count(m.charCount, fraction);
+    m.wordCount = sample_scale_count(m.wordCount, fraction);
+    m.wordCharCount = sample_scale_count(m.wordCharCount, fraction);
+    return m;
+}
+
+/* meta.sampling intervals (computed on the sampled counts, before scaling). */
+static void json_add_word_intervals(yyjson_mut_doc *doc, yyjson_mut_val *arr, const WordCountList *list,
+                                    double fraction) {
+    for (size_t i = 0; i < list->count; i++) {
+        size_t lo = 0, hi = 0;
+        sample_interval(list->items[i].count, fraction, &lo, &hi);
+        yyjson_mut_val *obj = yyjson_mut_obj(doc);
+        yyjson_mut_obj_add_strcpy(doc, obj, "word", list->items[i].word ? list->items[i].word : "");
+        yyjson_mut_obj_add_uint(doc, obj, "low", (uint64_t)lo);
+        yyjson_mut_obj_add_uint(doc, obj, "high", (uint64_t)hi);
+        yyjson_mut_arr_add_val(arr, obj);
+    }
+}
+
+static void json_add_bigram_intervals(yyjson_mut_doc *doc, yyjson_mut_val *arr, const BigramCountList *list,
+                                      double fraction) {
+    for (size_t i = 0; i < list->count; i++) {
+        size_t lo = 0, hi = 0;
+        sample_interval(list->items[i].count, fraction, &lo, &hi);
+        yyjson_mut_val *obj = yyjson_mut_obj(doc);
+        yyjson_mut_obj_add_strcpy(doc, obj, "w1", list->items[i].w1 ? list->items[i].w1 : "");
+        yyjson_mut_obj_add_strcpy(doc, obj, "w2", list->items[i].w2 ? list->items[i].w2 : "");
+        yyjson_mut_obj_add_uint(doc, obj, "low", (uint64_t)lo);
+        yyjson_mut_obj_add_uint(doc, obj, "high", (uint64_t)hi);
+        yyjson_mut_arr_add_val(arr, obj);
+    }
+}
+
 /* Converts enum into a stable string for meta.pipelineRequested. */
 static const char* pipeline_requested_str(const app_analyze_opts_t *opts) {
     if (!opts) return "auto";
-    switch (opts->pipeline) {
-        case APP_PIPELINE_STRING: return "string";
-        case APP_PIPELINE_ID:     return "id";
-        case APP_PIPELINE_AUTO:
-        default:                  return "auto";
-    }
+    return app_pipeline_to_str(opts->pipeline);
 }
 
 /* UTF-8 length helper */
@@ -90,18 +217,29 @@ static size_t utf8_strlen(const char *s) {
     return count;
 }
 
+/* Same for the first n bytes (page chunks). */
+static size_t utf8_strlen_n(const char *s, size_t n) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (((unsigned char)s[i] & 0xC0) != 0x80) count++;
+    }
+    return count;
+}
+
 /* Computes basic text metrics for meta/domain/page reporting.
- * Metrics are based on the raw token stream (includes stopwords).
+ * Metrics are based on the raw token stream (includes stopwords);
+ * text (len bytes) is NULL when only tokens are known (sampling).
  */
-static TextMetrics compute_metrics(const char *text, TokenList tokens) {
+static TextMetrics compute_metrics(const char *text, size_t len, TokenList tokens) {
     TextMetrics m = {0};
 
-    if (text) m.charCount = utf8_strlen(text);
-
-    m.wordCount = tokens.count;
+    if (text) m.charCount = utf8_strlen_n(text, len);
 
+    /* Empty tokens are sampling separators, not words. */
     for (size_t i = 0; i < tokens.count; i++) {
-        if (tokens.items[i]) m.wordCharCount += utf8_strlen(tokens.items[i]);
+        if (!tokens.items[i] || tokens.items[i][0] == '\0') continue;
+        m.wordCount++;
+        m.wordCharCount += utf8_strlen(tokens.items[i]);
     }
 
     return m;
@@ -123,7 +261,7 @@ typedef struct {
     // -> genau diese Anzahl muss per free_word_counts/free_bigram_counts freigegeben werden.
     size_t pages_filled;
 
-    // Stopwords
+    // Stopwords (sw_loaded: eigene Liste; sonst die des Thread-Scratch)
     StopwordList sw;
     bool sw_loaded;
 
@@ -146,6 +284,70 @@ typedef struct {
 
     BigramCountList top_bigs;
     bool top_bigs_live;
+
+    // Lexikografische Ränge für volle Ausgabe (top_k = 0)
+    TopkLexRank rank;
+    bool rank_live;
+
+    // Engine-Zustand (pro Request)
+    const app_engine_t *engine;
+    void *engine_state;
+    bool engine_live;
+
+    // Approximativer Modus: Heavy-Hitter-Zusammenfassungen + Fehlerschranken
+    HeavyHitters hh_words;
+    HeavyHitters hh_bigrams;
+    bool hh_live;
+    size_t *top_word_errors;
+    size_t *top_bigram_errors;
+
+    // Sampling: Zähler pro Seite (Anteil der gelesenen Bytes)
+    SampleStats *page_samples;
+
+    // Positionsbasierte Zähler (N-Gramme, Kookkurrenz): ein Dict pro Request,
+    // ID-Strom der aktuellen Seite wird von beiden gelesen
+    Dict id_dict;
+    bool id_dict_live;
+    IdStream id_stream;
+
+    IdNgrams ngrams;
+    bool ngrams_live;
+    NgramCountList top_ngrams[NGRAM_MAX_N];
+
+    IdCooc cooc;
+    bool cooc_live;
+    CoocMatrix cooc_matrix;
+
+    // Stemming: Stamm pro eindeutigem Wort (Memo), Listen werden gefaltet
+    StemMemo stem;
+    bool stem_live;
+
+    // TF-IDF: Dokumentfrequenzen pro ID (String-Engines mit eigenem Dict)
+    IdDocFreq docfreq;
+    bool docfreq_live;
+    Dict df_dict;
+    bool df_dict_live;
+    uint32_t *df_ranks;
+    TfidfList top_tfidf;
+
+    // Geteilte Seiten: Task-Plan, erstes/letztes Roh-Token je Chunk-Slot
+    // (für Bigramme über Chunk-Grenzen)
+    PagePlan plan;
+    char **chunk_edges;
+    _Atomic size_t *chunks_pending;
+
+    // Teilergebnis bei Timeout (partialOnTimeout): Seiten, die die Deadline
+    // abgeschnitten hat (leere Listen, Metriken 0)
+    atomic_bool *page_cut;
+
+    // Arenen pro Worker: Ergebnis-Strings (Listen, Dict-Schlüssel) und
+    // Scratch für die Tokens einer Einheit (vor jeder Einheit geleert).
+    // Worker 0 ist der aufrufende Thread und nutzt die Arenen der Anfrage;
+    // nur die Arenen der Hilfs-Threads (own_arenas) gehören dem Kontext.
+    Arena *worker_arenas[WORKERS_MAX];
+    Arena *scratch_arenas[WORKERS_MAX];
+    Arena *own_arenas;
+    unsigned n_own;
 } CleanupCtx;
 
 static void cleanup_ctx(CleanupCtx *c) {
@@ -202,16 +404,471 @@ static void cleanup_ctx(CleanupCtx *c) {
         stopwords_free(&c->sw);
         c->sw_loaded = false;
     }
+
+    if (c->rank_live) {
+        topk_lexrank_free(&c->rank);
+        c->rank_live = false;
+    }
+
+    if (c->engine_live) {
+        if (c->engine->destroy) c->engine->destroy(c->engine_state);
+        c->engine_state = NULL;
+        c->engine_live = false;
+    }
+
+    if (c->hh_live) {
+        hh_free(&c->hh_words);
+        hh_free(&c->hh_bigrams);
+        c->hh_live = false;
+    }
+    free(c->top_word_errors);
+    c->top_word_errors = NULL;
+    free(c->top_bigram_errors);
+    c->top_bigram_errors = NULL;
+
+    free(c->page_samples);
+    c->page_samples = NULL;
+
+    if (c->ngrams_live) {
+        idngrams_free(&c->ngrams);
+        c->ngrams_live = false;
+    }
+    for (unsigned n = 0; n < NGRAM_MAX_N; n++) free_ngram_counts(&c->top_ngrams[n]);
+    if (c->cooc_live) {
+        idcooc_free(&c->cooc);
+        c->cooc_live = false;
+    }
+    free_cooc_matrix(&c->cooc_matrix);
+    if (c->stem_live) {
+        stem_memo_free(&c->stem);
+        c->stem_live = false;
+    }
+    if (c->docfreq_live) {
+        iddf_free(&c->docfreq);
+        c->docfreq_live = false;
+    }
+    if (c->df_dict_live) {
+        dict_free(&c->df_dict);
+        c->df_dict_live = false;
+    }
+    free(c->df_ranks);
+    c->df_ranks = NULL;
+    free_tfidf_list(&c->top_tfidf);
+    if (c->chunk_edges) {
+        for (size_t k = 0; k < 2 * c->plan.n_slots; k++) str_free(c->chunk_edges[k]);
+        free(c->chunk_edges);
+        c->chunk_edges = NULL;
+    }
+    free((void*)c->chunks_pending);
+    c->chunks_pending = NULL;
+    free((void*)c->page_cut);
+    c->page_cut = NULL;
+    page_plan_free(&c->plan);
+    if (c->id_dict_live) {
+        dict_free(&c->id_dict);
+        c->id_dict_live = false;
+    }
+    id_stream_free(&c->id_stream);
+
+    /* Last: the strings released above may live in these arenas. */
+    for (unsigned k = 0; k < c->n_own; k++) arena_free(&c->own_arenas[k]);
+    free(c->own_arenas);
+    c->own_arenas = NULL;
+    c->n_own = 0;
 }
 
-app_analyze_result_t app_analyze_pages(const app_page_t *pages, size_t n_pages, const app_analyze_opts_t *opts) {
-    if (!pages || n_pages == 0) return fail(10, "No pages provided");
+/* ---------- Page stage (tasks over pages, chunks and batches) ---------- */
+
+/* First failure as (page << 8) | kind; the lowest page wins, as in a
+ * sequential run.
+ */
+enum { PAGE_FAIL_OOM = 1, PAGE_FAIL_TIMEOUT = 2, PAGE_FAIL_ENGINE = 3 };
+#define PAGE_FAILURE_NONE UINT64_MAX
+
+typedef struct {
+    CleanupCtx *cx;
+    const app_page_t *pages;
+    const app_analyze_opts_t *opts;
+    const SampleSpec *sample;  // NULL = no sampling
+    bool include_bigrams;
+    bool approximate;
+    bool id_stream;            // approximate/id_stream imply one worker
+    unsigned ngram_max;
+    unsigned cooc_window;
+    _Atomic uint64_t failure;
+    bool small_pages;          // small units take small_count_page
+    _Atomic size_t small_units;
+
+    /* Hot loops poll `cancel` (core/cancel.h); with `partial` a timeout
+     * cuts the unit's page instead of failing the request.
+     */
+    Cancel *cancel;
+    bool partial;
+
+    /* AUTO: per-unit counter choice, timings and one shadow count. */
+    const CostModel *model;    // NULL = counters fixed by the engine
+    app_pipeline_t pipeline;
+    atomic_bool shadow_pending;
+    CostReport reports[WORKERS_MAX];
+} PageJob;
+
+static int page_fail(PageJob *job, size_t page, int kind) {
+    uint64_t f = ((uint64_t)page << 8) | (uint64_t)kind;
+    uint64_t cur = atomic_load(&job->failure);
+    while (f < cur && !atomic_compare_exchange_weak(&job->failure, &cur, f)) {}
+    return 0;
+}
+
+static bool page_is_cut(const CleanupCtx *cx, size_t page) {
+    return cx->page_cut && atomic_load(&cx->page_cut[page]);
+}
+
+/* Partial mode: marks the page cut and empties the slot's lists and metrics. */
+static void slot_cut(PageJob *job, size_t page, size_t slot) {
+    CleanupCtx *cx = job->cx;
+    atomic_store(&cx->page_cut[page], true);
+    free_word_counts(&cx->page_words[slot]);
+    if (job->include_bigrams) free_bigram_counts(&cx->page_bigrams[slot]);
+    cx->page_metrics[slot] = (TextMetrics){0};
+}
+
+/* Deadline hit in unit u: fails the request, or (partial) cuts its page:
+ * the unit's lists and metrics are emptied, a split page is not joined,
+ * and the workers go on draining the remaining units.
+ */
+static int unit_timeout(PageJob *job, const PageUnit *u) {
+    if (!job->partial) return page_fail(job, u->page, PAGE_FAIL_TIMEOUT);
+
+    slot_cut(job, u->page, u->slot);
+    if (u->split != PAGE_NO_SPLIT) atomic_fetch_sub(&job->cx->chunks_pending[u->split], 1);
+    return 1;
+}
+
+static int seam_cmp(const void *a, const void *b) {
+    const BigramCount *x = (const BigramCount*)a, *y = (const BigramCount*)b;
+    int c = strcmp(x->w1, y->w1);
+    return c ? c : strcmp(x->w2, y->w2);
+}
+
+/* Bigrams across the chunk seams of one split page: the last raw token
+ * before a seam and the first one after it are adjacent in the page, and
+ * count under the usual no-bridging rule. Sorted, duplicates summed.
+ */
+static int page_seams(PageJob *job, const PageSplit *sp, BigramCountList *out) {
+    CleanupCtx *cx = job->cx;
+    *out = (BigramCountList){0};
+    if (sp->n_chunks < 2) return 1;
+    out->items = (BigramCount*)calloc(sp->n_chunks - 1, sizeof(BigramCount));
+    if (!out->items) return 0;
+
+    const char *prev = NULL;
+    for (size_t k = 0; k < sp->n_chunks; k++) {
+        const char *first = cx->chunk_edges[2 * (sp->first_slot + k)];
+        const char *last = cx->chunk_edges[2 * (sp->first_slot + k) + 1];
+        if (!first) continue;  // no tokens: the seam moves on
+        if (prev && !bigram_token_ignored(prev, &cx->sw) && !bigram_token_ignored(first, &cx->sw)) {
+            BigramCount *b = &out->items[out->count];
+            b->w1 = str_dup(prev);
+            b->w2 = str_dup(first);
+            b->count = 1;
+            out->count++;
+            if (!b->w1 || !b->w2) {
+                free_bigram_counts(out);
+                return 0;
+            }
+        }
+        prev = last;
+    }
+
+    qsort(out->items, out->count, sizeof(BigramCount), seam_cmp);
+    size_t w = 0;
+    for (size_t r = 0; r < out->count; r++) {
+        if (w > 0 && seam_cmp(&out->items[w - 1], &out->items[r]) == 0) {
+            out->items[w - 1].count += out->items[r].count;
+            str_free(out->items[r].w1);
+            str_free(out->items[r].w2);
+            continue;
+        }
+        out->items[w++] = out->items[r];
+    }
+    out->count = w;
+    return 1;
+}
+
+/* All chunks of a split page are counted: sum their metrics and join
+ * their lists (plus seams) into the page slot.
+ */
+static int page_join(PageJob *job, const PageSplit *sp) {
+    CleanupCtx *cx = job->cx;
+    const app_engine_t *eng = cx->engine;
+    size_t page = sp->page, first = sp->first_slot, n = sp->n_chunks;
+
+    TextMetrics m = {0};
+    for (size_t k = first; k < first + n; k++) {
+        m.charCount     += cx->page_metrics[k].charCount;
+        m.wordCount     += cx->page_metrics[k].wordCount;
+        m.wordCharCount += cx->page_metrics[k].wordCharCount;
+    }
+    cx->page_metrics[page] = m;
+
+    BigramCountList seams = {0};
+    if (job->include_bigrams && !page_seams(job, sp, &seams)) return page_fail(job, page, PAGE_FAIL_OOM);
+
+    int ok;
+    if (eng->join) {
+        ok = eng->join(cx->engine_state, page, first, n, job->include_bigrams ? &seams : NULL);
+    } else {
+        /* String lists: merge the chunk lists, seams as one more list. */
+        WordCountList *ws = (WordCountList*)calloc(n + 1, sizeof(WordCountList));
+        BigramCountList *bs = (BigramCountList*)calloc(n + 1, sizeof(BigramCountList));
+        ok = ws && bs;
+        if (ok) {
+            memcpy(ws, &cx->page_words[first], n * sizeof(WordCountList));
+            if (job->include_bigrams) {
+                memcpy(bs, &cx->page_bigrams[first], n * sizeof(BigramCountList));
+                bs[n] = seams;
+            }
+            ok = eng->merge(cx->engine_state, ws, job->include_bigrams ? bs : NULL, n + 1,
+                            &cx->page_words[page], job->include_bigrams ? &cx->page_bigrams[page] : NULL);
+        }
+        free(ws);
+        free(bs);
+        for (size_t k = first; k < first + n; k++) {
+            free_word_counts(&cx->page_words[k]);
+            if (job->include_bigrams) free_bigram_counts(&cx->page_bigrams[k]);
+        }
+    }
+    free_bigram_counts(&seams);
+    if (!ok) return page_fail(job, page, PAGE_FAIL_ENGINE);
+
+    /* The list merge stops at the deadline and keeps what it has: the
+     * page lists are short, so the page is cut like a timed-out unit.
+     */
+    if (!eng->join && cancel_requested()) {
+        if (!job->partial) return page_fail(job, page, PAGE_FAIL_TIMEOUT);
+        slot_cut(job, page, page);
+    }
+    return 1;
+}
+
+/* AUTO: timing of a counted unit against the model's prediction. */
+static void unit_report(PageJob *job, CostReport *r, size_t counter, const PageUnit *u,
+                        const TokenList *raw, size_t slot, double ns) {
+    CleanupCtx *cx = job->cx;
+    const app_engine_t *eng = app_engine_get((app_pipeline_t)counter);
+    bool lists = counter == COST_SMALL || !eng->lists_in_state;
+    size_t words = lists ? cx->page_words[slot].count : COST_UNKNOWN;
+    size_t bigrams = (lists && job->include_bigrams) ? cx->page_bigrams[slot].count : COST_UNKNOWN;
+    cost_report_unit(r, job->model, counter, raw->count, job->sample ? 0 : u->end - u->begin,
+                     words, bigrams, ns, false);
+}
+
+/* AUTO shadow run: count the unit again with counter c (any engine, own
+ * state) and keep only the timing; lists and state are dropped here.
+ */
+static void shadow_count(PageJob *job, size_t c, const TokenList *raw, unsigned worker) {
+    CleanupCtx *cx = job->cx;
+    const app_engine_t *eng = (c == COST_SMALL) ? NULL : app_engine_get((app_pipeline_t)c);
+    void *state = NULL;
+    if (eng && eng->init && !eng->init(&state, 1)) return;
+
+    WordCountList w = {0};
+    BigramCountList b = {0};
+    BigramCountList *bp = job->include_bigrams ? &b : NULL;
+    double t0 = now_ms();
+    int ok;
+    if (!eng) {
+        ok = small_count_page(raw, &cx->sw, false, scratch_small_tables(scratch_get()), &w, bp);
+    } else {
+        Arena *keep = arena_bind(cx->scratch_arenas[worker]);
+        TokenList filtered = filter_stopwords_list(raw, &cx->sw);
+        arena_bind(keep);
+        ok = eng->count_page(state, 0, &filtered, raw, &cx->sw, &w, bp);
+        free_tokens(&filtered);
+    }
+    double ns = (now_ms() - t0) * 1e6;
+
+    if (ok) {
+        bool lists = !eng || !eng->lists_in_state;
+        cost_report_unit(&job->reports[worker], job->model, c, raw->count, 0,
+                         lists ? w.count : COST_UNKNOWN, COST_UNKNOWN, ns, true);
+    }
+    free_word_counts(&w);
+    free_bigram_counts(&b);
+    if (eng && eng->destroy) eng->destroy(state);
+}
+
+/* Tokenize -> metrics -> filter -> count one unit (a page or a chunk)
+ * into its slot. Tokens are worker-local and released before returning.
+ */
+static int page_unit(PageJob *job, const PageUnit *u, unsigned worker) {
+    CleanupCtx *cx = job->cx;
+    const app_analyze_opts_t *opts = job->opts;
+    size_t i = u->page, slot = u->slot;
+
+    if (deadline_exceeded(opts)) return unit_timeout(job, u);
+
+    const char *t = job->pages[i].text ? job->pages[i].text : "";
+
+    /* Tokens of the previous unit are dead: raw and filtered tokens are
+     * taken from the scratch arena, everything that outlives the unit
+     * from the worker arena bound by page_task.
+     */
+    Arena *scratch = cx->scratch_arenas[worker];
+    arena_reset(scratch);
+
+    /* Length cap bounds per-token hashing cost on hostile input. */
+    Arena *keep = arena_bind(scratch);
+    TokenList raw = job->sample
+        ? sample_tokenize(t, i, job->sample, opts->max_token_bytes, &cx->page_samples[i])
+        : tokenize_span(t + u->begin, u->end - u->begin, NULL, opts ? opts->max_token_bytes : 0);
+    arena_bind(keep);
+
+    /* Also when the tokenizer stopped early (core/cancel.h). */
+    if (deadline_exceeded(opts)) {
+        free_tokens(&raw);
+        return unit_timeout(job, u);
+    }
+
+    /* Metrics are derived from the same token stream as word results. */
+    cx->page_metrics[slot] = compute_metrics(job->sample ? NULL : t + u->begin, u->end - u->begin, raw);
+    if (job->sample) cx->page_metrics[slot].charCount = cx->page_samples[i].chars_kept;
+
+    /* Chunk edges feed the seam bigrams of page_join. */
+    if (u->split != PAGE_NO_SPLIT && job->include_bigrams && raw.count > 0) {
+        cx->chunk_edges[2 * slot] = str_dup(raw.items[0]);
+        cx->chunk_edges[2 * slot + 1] = str_dup(raw.items[raw.count - 1]);
+        if (!cx->chunk_edges[2 * slot] || !cx->chunk_edges[2 * slot + 1]) {
+            free_tokens(&raw);
+            return page_fail(job, i, PAGE_FAIL_OOM);
+        }
+    }
+
+    /* Tokens are resolved once; all n-gram orders and all window
+     * offsets are then counted in one pass each over the ID stream.
+     */
+    if (job->id_stream) {
+        int counted = id_stream_resolve(&cx->id_stream, &cx->id_dict, &raw, &cx->sw);
+        if (counted && job->ngram_max > 0) {
+            counted = idngrams_count_ids(&cx->ngrams, cx->id_stream.ids, cx->id_stream.count, job->ngram_max);
+        }
+        if (counted && job->cooc_window > 0) {
+            counted = idcooc_count_ids(&cx->cooc, cx->id_stream.ids, cx->id_stream.count);
+        }
+        if (!counted) {
+            free_tokens(&raw);
+            return page_fail(job, i, PAGE_FAIL_OOM);
+        }
+    }
+
+    if (job->approximate) {
+        /* Summaries apply the filter rules inline (no filtered copy). */
+        int fed = hh_add_tokens(&cx->hh_words, job->include_bigrams ? &cx->hh_bigrams : NULL, &raw, &cx->sw);
+        free_tokens(&raw);
+        return fed ? 1 : page_fail(job, i, PAGE_FAIL_OOM);
+    }
+
+    /* Counter: the small-page path for small units, else the engine.
+     * AUTO picks the cheapest counter whose lists the engine merges.
+     */
+    size_t counter = (job->small_pages && raw.count <= SMALL_PAGE_MAX_TOKENS)
+        ? COST_SMALL : (size_t)job->pipeline;
+    size_t next = counter;
+    if (job->model) counter = cost_pick_counter(job->model, job->pipeline, raw.count, job->small_pages, &next);
+    double t_count0 = job->model ? now_ms() : 0.0;
+
+    int ok;
+    if (counter == COST_SMALL) {
+        /* Small unit: filter and count in one pass, same lists. */
+        ok = small_count_page(&raw, &cx->sw, cx->engine->lists_lexsorted, scratch_small_tables(scratch_get()),
+                              &cx->page_words[slot], job->include_bigrams ? &cx->page_bigrams[slot] : NULL);
+        if (ok) atomic_fetch_add_explicit(&job->small_units, 1, memory_order_relaxed);
+    } else {
+        /* Counters other than the request's engine are stateless. */
+        const app_engine_t *eng = app_engine_get((app_pipeline_t)counter);
+        void *state = (eng == cx->engine) ? cx->engine_state : NULL;
+
+        /* Words/metrics use filtered tokens (no stopwords, short, digits-only). */
+        arena_bind(scratch);
+        TokenList filtered = filter_stopwords_list(&raw, &cx->sw);
+        arena_bind(keep);
+
+        if (deadline_exceeded(opts)) {
+            free_tokens(&filtered);
+            free_tokens(&raw);
+            return unit_timeout(job, u);
+        }
+
+        /* Core analysis stage: engine-specific implementation.
+         * - words are based on filtered tokens
+         * - bigrams (if enabled) are based on raw tokens + stopword rules (no bridging)
+         * Counted (or partially counted) lists are released by cleanup_ctx.
+         */
+        ok = eng->count_page(state, slot, &filtered, &raw, &cx->sw,
+                             &cx->page_words[slot], job->include_bigrams ? &cx->page_bigrams[slot] : NULL);
+        free_tokens(&filtered);
+    }
+
+    if (ok && job->model) {
+        unit_report(job, &job->reports[worker], counter, u, &raw, slot, (now_ms() - t_count0) * 1e6);
+
+        /* One unit per sampled request is also timed with the runner-up. */
+        bool shadow = next != counter && raw.count >= COST_SHADOW_MIN_TOKENS &&
+                      cost_count_ns(job->model, next, (double)raw.count,
+                                    cost_distinct_words(job->model, (double)raw.count)) <= COST_SHADOW_MAX_NS;
+        if (shadow && atomic_exchange(&job->shadow_pending, false)) shadow_count(job, next, &raw, worker);
+    }
+
+    free_tokens(&raw);
+
+    /* Counters fail when a hot loop saw the deadline pass. */
+    if (!ok) return cancel_requested() ? unit_timeout(job, u) : page_fail(job, i, PAGE_FAIL_ENGINE);
+
+    /* The worker counting the last chunk of a page joins it (unless
+     * another chunk was cut).
+     */
+    if (u->split != PAGE_NO_SPLIT &&
+        atomic_fetch_sub(&cx->chunks_pending[u->split], 1) == 1 && !page_is_cut(cx, i)) {
+        return page_join(job, &cx->plan.splits[u->split]);
+    }
+    return 1;
+}
+
+/* One scheduler task: a batch of whole pages or a single chunk. */
+static int page_task(void *ctx, size_t task, unsigned worker) {
+    PageJob *job = (PageJob*)ctx;
+    const PagePlan *plan = &job->cx->plan;
+    const PageTask *pt = &plan->tasks[task];
+    Arena *prev = arena_bind(job->cx->worker_arenas[worker]);
+    Cancel *prev_cancel = cancel_bind(job->cancel);
+    int ok = 1;
+    for (size_t k = 0; ok && k < pt->n_units; k++) {
+        ok = page_unit(job, &plan->units[pt->first_unit + k], worker);
+    }
+    cancel_bind(prev_cancel);
+    arena_bind(prev);
+    return ok;
+}
+
+static app_analyze_result_t analyze_pages(const app_page_t *pages, size_t n_pages,
+                                          const app_analyze_opts_t *opts, Scratch *scratch,
+                                          Arena *request, Arena *tokens) {
 
     const char *stop_path = (opts && opts->stopwords_path) ? opts->stopwords_path : "data/stopwords_de.txt";
     const char *domain_str = (opts && opts->domain) ? opts->domain : NULL;
 
     bool include_bigrams = (opts) ? opts->include_bigrams : true;
     bool per_page = (opts) ? opts->per_page_results : true;
+    bool approximate = opts && opts->approximate;
+    unsigned ngram_max = opts ? opts->ngram_max : 0;
+    if (ngram_max > NGRAM_MAX_N) ngram_max = NGRAM_MAX_N;
+    unsigned cooc_window = opts ? opts->cooc_window : 0;
+    if (cooc_window > COOC_MAX_WINDOW) cooc_window = COOC_MAX_WINDOW;
+    bool id_stream = ngram_max > 0 || cooc_window > 0;
+    bool stem = opts && opts->stem && !approximate;
+    bool tfidf = opts && opts->tfidf && !approximate;
+    /* Cut pages would leave their tokens in the summaries and ID streams. */
+    bool partial = opts && opts->partial_on_timeout && !approximate && !id_stream;
 
     /* Top-K policy: 0 means FULL output (used by CLI/batch). */
     size_t topk = opts ? opts->top_k : 20;
@@ -219,149 +876,472 @@ app_analyze_result_t app_analyze_pages(const app_page_t *pages, size_t n_pages,
     CleanupCtx cx = {0};
     cx.include_bigrams = include_bigrams;
 
-    /* Allocate per-page containers */
-    cx.page_words = (WordCountList *)calloc(n_pages, sizeof(WordCountList));
-    cx.page_bigrams = include_bigrams ? (BigramCountList *)calloc(n_pages, sizeof(BigramCountList)) : NULL;
-    cx.page_metrics = (TextMetrics *)calloc(n_pages, sizeof(TextMetrics));
-    cx.pages_filled = 0;
-
-    if (!cx.page_words || !cx.page_metrics || (include_bigrams && !cx.page_bigrams)) {
-        cleanup_ctx(&cx);
-        return fail(11, "Out of memory");
-    }
-
-    /* Measurement point for AUTO pipeline decision (total chars received). */
+    /* Measurement point for AUTO pipeline decision (chars received per
+     * page; the cost model estimates each page from them).
+     */
+    bool auto_pick = !approximate && !(opts && opts->pipeline != APP_PIPELINE_AUTO);
+    size_t *page_bytes = auto_pick ? (size_t *)calloc(n_pages ? n_pages : 1, sizeof(size_t)) : NULL;
+    if (auto_pick && !page_bytes) return fail(11, "Out of memory");
     size_t chars_received = 0;
     for (size_t i = 0; i < n_pages; i++) {
         const char *t = pages[i].text ? pages[i].text : "";
-        chars_received += strlen(t);
+        size_t len = strlen(t);
+        chars_received += len;
+        if (page_bytes) page_bytes[i] = len;
+    }
+
+    /* Sampling happens before tokenization: explicit opts->sample_rate, or
+     * AUTO when the estimated cost would overrun the deadline.
+     */
+    SampleSpec sample = {
+        .rate = 1.0,
+        .seed = (opts && opts->sample_seed) ? opts->sample_seed : SAMPLE_DEFAULT_SEED,
+        .window_bytes = SAMPLE_WINDOW_BYTES
+    };
+    bool sample_auto = false;
+    if (opts && opts->sample_rate > 0.0) {
+        sample.rate = opts->sample_rate;
+    } else if (opts && opts->deadline_ms > 0.0) {
+        double est_ms = (double)chars_received * SAMPLE_COST_NS_PER_BYTE / 1e6;
+        sample.rate = sample_rate_for_budget(est_ms, opts->deadline_ms - now_ms());
+        sample_auto = sample.rate < 1.0;
+    }
+    bool sampling = sample.rate < 1.0;
+    if (sampling) {
+        cx.page_samples = (SampleStats *)calloc(n_pages, sizeof(SampleStats));
+        if (!cx.page_samples) {
+            free(page_bytes);
+            cleanup_ctx(&cx);
+            return fail(11, "Out of memory");
+        }
     }
 
+    /* Stages that feed request-wide tables (n-grams, co-occurrence,
+     * approximate summaries) keep the sequential order.
+     */
+    unsigned threads = (opts && opts->threads > 1) ? opts->threads : 1;
+    if (approximate || id_stream) threads = 1;
+    if (threads > WORKERS_MAX) threads = WORKERS_MAX;
+
     /* Pipeline switch:
-     * - AUTO selects ID for larger inputs
+     * - AUTO picks the engine with the lowest estimate of the cost model
+     *   (app/cost_model.h), on a copy taken now
      * - explicit opts->pipeline overrides AUTO decision
      */
-    int use_id_pipeline = (chars_received >= PIPELINE_THRESHOLD_CHARS);
-    if (opts) {
-        if (opts->pipeline == APP_PIPELINE_STRING) use_id_pipeline = 0;
-        else if (opts->pipeline == APP_PIPELINE_ID) use_id_pipeline = 1;
+    app_pipeline_t pipeline_used = opts ? opts->pipeline : APP_PIPELINE_AUTO;
+    CostModel model;
+    CostChoice choice = {0};
+    if (auto_pick) {
+        cost_model_snapshot(&model);
+        cost_choose(&model, page_bytes, n_pages, sample.rate, threads, include_bigrams,
+                    !(opts && opts->no_small_pages), &choice);
+        pipeline_used = choice.engine;
+        free(page_bytes);
     }
+    if (pipeline_used == APP_PIPELINE_AUTO) pipeline_used = APP_PIPELINE_STRING;
 
-    /* Metrics are reported both per-page and aggregated for domainResult. */
-    TextMetrics domain_metrics = (TextMetrics){0};
-
-    double t_analyze0 = now_ms();
+    cx.engine = app_engine_get(pipeline_used);
+    if (!cx.engine) {
+        cleanup_ctx(&cx);
+        return fail(13, "Unknown pipeline");
+    }
 
-    /* Load stopwords once */
-    if (stopwords_load(&cx.sw, stop_path) != 0) {
+    /* Page stage plan: with threads > 1 large pages are split into chunks
+     * (one slot each, joined per page) and small pages are batched; the
+     * workers steal tasks from each other. Sampling and engines without a
+     * join hook keep pages whole.
+     */
+    bool allow_split = !sampling && (cx.engine->join || !cx.engine->lists_in_state);
+    if (!page_plan_build(&cx.plan, pages, n_pages, threads, allow_split, NULL)) {
         cleanup_ctx(&cx);
-        return fail(20, "Stopwords load failed (file missing or invalid?)");
+        return fail(11, "Out of memory");
     }
-    cx.sw_loaded = true;
+    if ((size_t)threads > cx.plan.n_tasks) threads = (unsigned)cx.plan.n_tasks;
 
-    if (deadline_exceeded(opts)) {
+    cx.worker_arenas[0] = request;
+    cx.scratch_arenas[0] = tokens;
+    if (threads > 1) {
+        cx.own_arenas = (Arena *)calloc(2 * (threads - 1), sizeof(Arena));
+        if (!cx.own_arenas) {
+            cleanup_ctx(&cx);
+            return fail(11, "Out of memory");
+        }
+        cx.n_own = 2 * (threads - 1);
+        for (unsigned w = 1; w < threads; w++) {
+            cx.worker_arenas[w] = &cx.own_arenas[2 * (w - 1)];
+            cx.scratch_arenas[w] = &cx.own_arenas[2 * (w - 1) + 1];
+            arena_init(cx.worker_arenas[w]);
+            arena_init(cx.scratch_arenas[w]);
+        }
+    }
+
+    /* Allocate per-slot containers (pages, then chunks) */
+    size_t n_slots = cx.plan.n_slots;
+    cx.page_words = (WordCountList *)calloc(n_slots, sizeof(WordCountList));
+    cx.page_bigrams = include_bigrams ? (BigramCountList *)calloc(n_slots, sizeof(BigramCountList)) : NULL;
+    cx.page_metrics = (TextMetrics *)calloc(n_slots, sizeof(TextMetrics));
+    cx.pages_filled = 0;
+
+    if (!cx.page_words || !cx.page_metrics || (include_bigrams && !cx.page_bigrams)) {
         cleanup_ctx(&cx);
-        return fail(503, "analysis timeout (>10s)");
+        return fail(11, "Out of memory");
     }
+    if (cx.plan.n_splits > 0) {
+        cx.chunk_edges = (char **)calloc(2 * n_slots, sizeof(char *));
+        cx.chunks_pending = (_Atomic size_t *)calloc(cx.plan.n_splits, sizeof(*cx.chunks_pending));
+        if (!cx.chunk_edges || !cx.chunks_pending) {
+            cleanup_ctx(&cx);
+            return fail(11, "Out of memory");
+        }
+        for (size_t s = 0; s < cx.plan.n_splits; s++) {
+            atomic_init(&cx.chunks_pending[s], cx.plan.splits[s].n_chunks);
+        }
+    }
+    if (partial) {
+        cx.page_cut = (atomic_bool *)malloc(n_pages * sizeof(*cx.page_cut));
+        if (!cx.page_cut) {
+            cleanup_ctx(&cx);
+            return fail(11, "Out of memory");
+        }
+        for (size_t i = 0; i < n_pages; i++) atomic_init(&cx.page_cut[i], false);
+    }
+    if (approximate) {
+        /* Approximate mode bypasses the engines: two fixed-size summaries. */
+        size_t cap = opts->approximate_capacity;
+        cx.hh_live = true;
+        if (!hh_init(&cx.hh_words, cap) || (include_bigrams && !hh_init(&cx.hh_bigrams, cap))) {
+            cleanup_ctx(&cx);
+            return fail(11, "Out of memory");
+        }
+    } else {
+        if (cx.engine->init && !cx.engine->init(&cx.engine_state, n_slots)) {
+            cleanup_ctx(&cx);
+            return fail(11, "Out of memory");
+        }
+        cx.engine_live = true;
+
+        /* Engines with lists in state fold after merge (fold hook). */
+        if (cx.engine->lists_in_state && !cx.engine->fold) stem = false;
+        if (stem) {
+            cx.stem_live = stem_memo_init(&cx.stem);
+            if (!cx.stem_live) {
+                cleanup_ctx(&cx);
+                return fail(11, "Out of memory");
+            }
+        }
 
-    for (size_t i = 0; i < n_pages; i++) {
+        /* Document frequencies: string page lists are resolved into a
+         * request Dict; engines with lists in state provide their own.
+         */
+        if (cx.engine->lists_in_state && !cx.engine->doc_freq) tfidf = false;
+        if (tfidf) {
+            cx.docfreq_live = iddf_init(&cx.docfreq, 1024);
+            if (cx.docfreq_live && !cx.engine->lists_in_state) {
+                cx.df_dict_live = dict_init(&cx.df_dict, 1024);
+            }
+            if (!cx.docfreq_live || (!cx.engine->lists_in_state && !cx.df_dict_live)) {
+                cleanup_ctx(&cx);
+                return fail(11, "Out of memory");
+            }
+        }
+    }
 
-        if (deadline_exceeded(opts)) {
+    /* N-grams and co-occurrence share one request-wide Dict (IDs are domain
+     * IDs directly) and read the same resolved ID stream per page.
+     */
+    if (id_stream) {
+        cx.id_dict_live = dict_init(&cx.id_dict, 1024);
+        cx.ngrams_live = ngram_max > 0 && idngrams_init(&cx.ngrams, 1024, opts->ngram_limit);
+        cx.cooc_live = cooc_window > 0 && idcooc_init(&cx.cooc, cooc_window, opts->cooc_limit);
+        if (!cx.id_dict_live || cx.ngrams_live != (ngram_max > 0) || cx.cooc_live != (cooc_window > 0)) {
             cleanup_ctx(&cx);
-            return fail(503, "analysis timeout (>10s)");
+            return fail(11, "Out of memory");
         }
+    }
 
-        const char *t = pages[i].text ? pages[i].text : "";
+    /* Metrics are reported both per-page and aggregated for domainResult. */
+    TextMetrics domain_metrics = (TextMetrics){0};
 
-        cx.raw = tokenize(t);
-        cx.raw_live = true;
+    double t_analyze0 = now_ms();
 
-        if (deadline_exceeded(opts)) {
+    /* Load stopwords once (per thread and path while a scratch is held) */
+    const StopwordList *cached = scratch ? scratch_stopwords(scratch, stop_path) : NULL;
+    if (cached) {
+        cx.sw = *cached;
+    } else {
+        if (stopwords_load(&cx.sw, stop_path) != 0) {
             cleanup_ctx(&cx);
-            return fail(503, "analysis timeout (>10s)");
-        }   
+            return fail(20, "Stopwords load failed (file missing or invalid?)");
+        }
+        cx.sw_loaded = true;
+    }
 
-        /* Words/metrics use filtered tokens (no stopwords, short, digits-only). */
-        cx.filtered = filter_stopwords_copy(&cx.raw, stop_path);
-        cx.filtered_live = true;
+    if (deadline_exceeded(opts)) {
+        cleanup_ctx(&cx);
+        return fail(503, "analysis timeout (>10s)");
+    }
 
-        if (deadline_exceeded(opts)) {
+    PageJob job = {
+        .cx = &cx, .pages = pages, .opts = opts,
+        .sample = sampling ? &sample : NULL,
+        .include_bigrams = include_bigrams, .approximate = approximate,
+        .id_stream = id_stream, .ngram_max = ngram_max, .cooc_window = cooc_window,
+        .small_pages = cx.engine->small_pages && !(opts && opts->no_small_pages),
+        .model = auto_pick ? &model : NULL,
+        .pipeline = pipeline_used,
+        .cancel = cancel_bound(), .partial = partial
+    };
+    atomic_init(&job.failure, PAGE_FAILURE_NONE);
+    atomic_init(&job.small_units, 0);
+    atomic_init(&job.shadow_pending, choice.shadow);
+
+    /* Slots are zeroed, so every slot is released on failure. */
+    cx.pages_filled = approximate ? 0 : n_slots;
+    WorkersStats sched;
+    if (!workers_run(threads, cx.plan.n_tasks, page_task, &job, cx.plan.task_bytes, &sched)) {
+        uint64_t f = atomic_load(&job.failure);
+        cleanup_ctx(&cx);
+        switch ((int)(f & 0xff)) {
+        case PAGE_FAIL_TIMEOUT: return fail(503, "analysis timeout (>10s)");
+        case PAGE_FAIL_ENGINE:  return fail(cx.engine->fail_status, cx.engine->fail_message);
+        default:                return fail(11, "Out of memory");
+        }
+    }
+
+    /* Partial result: cut pages stay empty. The completed pages are merged
+     * and ranked to the end (no further cancellation), so the tail is
+     * bounded by work already done.
+     */
+    size_t pages_cut = 0;
+    if (partial) {
+        for (size_t i = 0; i < n_pages; i++) pages_cut += page_is_cut(&cx, i);
+        if (n_pages > 0 && pages_cut == n_pages) {
             cleanup_ctx(&cx);
             return fail(503, "analysis timeout (>10s)");
-        }       
+        }
+        cancel_bind(NULL);
+    }
 
-        /* Metrics are derived from the same token stream as word results. */
-        cx.page_metrics[i] = compute_metrics(t, cx.raw);
+    /* Sequential tail in page order: domain metrics, request-wide stem
+     * memo and document frequencies.
+     */
+    for (size_t i = 0; i < n_pages; i++) {
         domain_metrics.charCount     += cx.page_metrics[i].charCount;
         domain_metrics.wordCount     += cx.page_metrics[i].wordCount;
         domain_metrics.wordCharCount += cx.page_metrics[i].wordCharCount;
+        if (approximate) continue;
+
+        /* Stemming on string lists: one memo probe per distinct page word. */
+        if (stem && !cx.engine->lists_in_state) {
+            bool sorted = cx.engine->lists_lexsorted;
+            if (!stem_fold_words(&cx.stem, &cx.page_words[i], sorted) ||
+                (include_bigrams && !stem_fold_bigrams(&cx.stem, &cx.page_bigrams[i], sorted))) {
+                cleanup_ctx(&cx);
+                return fail(11, "Out of memory");
+            }
+        }
 
-        /* Core analysis stage: pipeline-specific implementation.
-         * - words are based on filtered tokens
-         * - bigrams (if enabled) are based on raw tokens + stopword rules (no bridging)
-         */
-        int ok = 0;
-        if (use_id_pipeline) {
-            ok = analyze_id_pipeline(&cx.filtered, &cx.raw, include_bigrams, &cx.sw,
-                                    &cx.page_words[i], include_bigrams ? &cx.page_bigrams[i] : NULL);
-            if (!ok) { cleanup_ctx(&cx); return fail(30, "ID pipeline failed (out of memory?)"); }
-        } else {
-            ok = analyze_string_pipeline(&cx.filtered, &cx.raw, include_bigrams, &cx.sw,
-                                         &cx.page_words[i], include_bigrams ? &cx.page_bigrams[i] : NULL);
-            if (!ok) { cleanup_ctx(&cx); return fail(31, "String pipeline failed (out of memory?)"); }
+        if (tfidf && !cx.engine->lists_in_state &&
+            !iddf_add_words(&cx.docfreq, &cx.df_dict, &cx.page_words[i])) {
+            cleanup_ctx(&cx);
+            return fail(11, "Out of memory");
         }
+    }
 
-        cx.pages_filled = i + 1;
+    if (!partial && deadline_exceeded(opts)) {
+        cleanup_ctx(&cx);
+        return fail(503, "analysis timeout (>10s)");
+    }
 
-        /* release current tokens (and clear flags!) */
-        free_tokens(&cx.filtered);
-        cx.filtered_live = false;
+    /* Domain-only Top-K: the threshold algorithm reads page lists in count
+     * order and stops once the bounds settle (no full domain list). Falls
+     * back to full aggregation when the bounds do not converge.
+     */
+    bool threshold_topk = false;
+    if (!approximate && !per_page && topk > 0 && !cx.engine->lists_in_state) {
+        threshold_topk = aggregate_top_k_words_ta(cx.page_words, n_pages, cx.engine->lists_lexsorted,
+                                                  topk, &cx.top_words);
+        if (threshold_topk && include_bigrams) {
+            threshold_topk = aggregate_top_k_bigrams_ta(cx.page_bigrams, n_pages, cx.engine->lists_lexsorted,
+                                                        topk, &cx.top_bigs);
+            if (!threshold_topk) free_top_k_words(&cx.top_words);
+        }
+        cx.top_words_live = threshold_topk;
+        cx.top_bigs_live = threshold_topk && include_bigrams;
+    }
 
-        free_tokens(&cx.raw);
-        cx.raw_live = false;
+    /* Approximate mode: the input is still available, so a second pass
+     * counts the monitored keys exactly (skipped when the deadline is near;
+     * estimates and error bounds are reported instead).
+     */
+    bool hh_verified = false;
+    bool words_exact = false, bigrams_exact = false;
+    if (approximate) {
+        if (!deadline_exceeded(opts)) {
+            hh_verify_begin(&cx.hh_words);
+            if (include_bigrams) hh_verify_begin(&cx.hh_bigrams);
+            hh_verified = true;
+            for (size_t i = 0; i < n_pages && hh_verified; i++) {
+                const char *t = pages[i].text ? pages[i].text : "";
+                cx.raw = sampling ? sample_tokenize(t, i, &sample, opts->max_token_bytes, NULL)
+                                  : tokenize_with_limit(t, NULL, opts->max_token_bytes);
+                cx.raw_live = true;
+                int fed = hh_add_tokens(&cx.hh_words, include_bigrams ? &cx.hh_bigrams : NULL, &cx.raw, &cx.sw);
+                free_tokens(&cx.raw);
+                cx.raw_live = false;
+                if (!fed) {
+                    cleanup_ctx(&cx);
+                    return fail(11, "Out of memory");
+                }
+                if (deadline_exceeded(opts)) {
+                    cleanup_ctx(&cx);
+                    return fail(503, "analysis timeout (>10s)");
+                }
+            }
+        }
 
+        cx.top_words_live = true;
+        if (!hh_top_k_words(&cx.hh_words, topk, &cx.top_words, &cx.top_word_errors, &words_exact)) {
+            cleanup_ctx(&cx);
+            return fail(11, "Out of memory");
+        }
+        if (include_bigrams) {
+            cx.top_bigs_live = true;
+            if (!hh_top_k_bigrams(&cx.hh_bigrams, topk, &cx.top_bigs, &cx.top_bigram_errors, &bigrams_exact)) {
+                cleanup_ctx(&cx);
+                return fail(11, "Out of memory");
+            }
+        }
     }
 
-    if (deadline_exceeded(opts)) {
-        cleanup_ctx(&cx);
-        return fail(503, "analysis timeout (>10s)");
+    /* AUTO: the workers' unit timings, then the merge's. */
+    CostReport report = {0};
+    if (job.model) {
+        for (unsigned w = 0; w < threads; w++) cost_report_add(&report, &job.reports[w]);
     }
 
-    /* Aggregation */
-    cx.domain_words = aggregate_word_counts(cx.page_words, n_pages);
-    cx.domain_words_live = true;
+    if (!approximate && !threshold_topk) {
+        /* Aggregation */
+        double t_merge0 = now_ms();
+        int merged = cx.engine->merge(cx.engine_state, cx.page_words,
+                                      include_bigrams ? cx.page_bigrams : NULL, n_pages,
+                                      &cx.domain_words, include_bigrams ? &cx.domain_bigrams : NULL);
+        cx.domain_words_live = true;
+        cx.domain_bigrams_live = include_bigrams;
+        if (!merged) {
+            cleanup_ctx(&cx);
+            return fail(11, "Out of memory");
+        }
 
-    if (include_bigrams) {
-        cx.domain_bigrams = aggregate_bigram_counts(cx.page_bigrams, n_pages);
-        cx.domain_bigrams_live = true;
-    } else {
-        cx.domain_bigrams = (BigramCountList){0};
-        cx.domain_bigrams_live = false;
+        /* Merges of lists in engine state are not measured (no entry counts). */
+        if (job.model && !cx.engine->lists_in_state) {
+            double word_entries = 0.0, bigram_entries = 0.0;
+            for (size_t i = 0; i < n_pages; i++) {
+                word_entries += (double)cx.page_words[i].count;
+                if (include_bigrams) bigram_entries += (double)cx.page_bigrams[i].count;
+            }
+            report.merge_ns = (now_ms() - t_merge0) * 1e6;
+            report.merge_pred = cost_merge_ns(&model, (size_t)pipeline_used,
+                                              word_entries, (double)cx.domain_words.count,
+                                              bigram_entries, include_bigrams ? (double)cx.domain_bigrams.count : 0.0);
+        }
+
+        if (stem && cx.engine->lists_in_state && !cx.engine->fold(cx.engine_state, &cx.stem)) {
+            cleanup_ctx(&cx);
+            return fail(11, "Out of memory");
+        }
+
+        if (!partial && deadline_exceeded(opts)) {
+            cleanup_ctx(&cx);
+            return fail(503, "analysis timeout (>10s)");
+        }
+
+        /* FULL output: rank the domain vocabulary once; domain and page lists
+         * are then ordered by integer keys. Without ranks (OOM) the engine's
+         * Top-K stage produces the same order.
+         */
+        if (topk == 0 && !cx.engine->lists_lexsorted && !cx.engine->lists_in_state) {
+            cx.rank_live = topk_lexrank_init(&cx.rank, &cx.domain_words,
+                                             include_bigrams ? &cx.domain_bigrams : NULL);
+        }
+
+        /* Apply Top-K after aggregation (0 means full lists). */
+        int ok = 1;
+        if (cx.rank_live) {
+            cx.top_words = top_k_words_ranked(&cx.rank, &cx.domain_words, cx.domain_words.count);
+        } else {
+            ok = cx.engine->topk_words(cx.engine_state, APP_ENGINE_DOMAIN, &cx.domain_words, topk,
+                                       &cx.top_words);
+        }
+        cx.top_words_live = true;
+
+        if (ok && include_bigrams) {
+            if (cx.rank_live) {
+                cx.top_bigs = top_k_bigrams_ranked(&cx.rank, &cx.domain_bigrams, cx.domain_bigrams.count);
+            } else {
+                ok = cx.engine->topk_bigrams(cx.engine_state, APP_ENGINE_DOMAIN, &cx.domain_bigrams, topk,
+                                             &cx.top_bigs);
+            }
+            cx.top_bigs_live = true;
+        }
+        if (!ok) {
+            cleanup_ctx(&cx);
+            return fail(cx.engine->fail_status, cx.engine->fail_message);
+        }
     }
 
-    if (deadline_exceeded(opts)) {
+    if (!partial && deadline_exceeded(opts)) {
         cleanup_ctx(&cx);
         return fail(503, "analysis timeout (>10s)");
     }
 
-    /* Apply Top-K after aggregation (0 means full lists). */
-    size_t k_words = (topk == 0) ? cx.domain_words.count : topk;
-    cx.top_words = top_k_words(&cx.domain_words, k_words);
-    cx.top_words_live = true;
-
-    if (include_bigrams) {
-        size_t k_bigs = (topk == 0) ? cx.domain_bigrams.count : topk;
-        cx.top_bigs = top_k_bigrams(&cx.domain_bigrams, k_bigs);
-        cx.top_bigs_live = true;
+    /* TF-IDF over the per-page document frequencies (full vocabulary, also
+     * after a threshold Top-K); only the k winners become strings.
+     */
+    if (tfidf) {
+        const Dict *names = &cx.df_dict;
+        const uint32_t *rank = NULL;
+        int ranked;
+        if (cx.engine->lists_in_state) {
+            ranked = cx.engine->doc_freq(cx.engine_state, &cx.docfreq, &names, &rank);
+        } else {
+            cx.df_ranks = topk_dict_ranks(&cx.df_dict);
+            rank = cx.df_ranks;
+            ranked = rank != NULL;
+        }
+        if (!ranked || !top_k_tfidf(names, rank, &cx.docfreq, topk ? topk : SIZE_MAX, &cx.top_tfidf)) {
+            cleanup_ctx(&cx);
+            return fail(11, "Out of memory");
+        }
     }
 
-    if (deadline_exceeded(opts)) {
+    for (unsigned n = 1; n <= ngram_max; n++) {
+        if (!idngrams_top_k(&cx.ngrams, &cx.id_dict, n, topk, &cx.top_ngrams[n - 1])) {
+            cleanup_ctx(&cx);
+            return fail(11, "Out of memory");
+        }
+    }
+    if (cooc_window > 0 &&
+        !idcooc_export(&cx.cooc, &cx.id_dict, (uint32_t)opts->cooc_min_count, topk, &cx.cooc_matrix)) {
         cleanup_ctx(&cx);
-        return fail(503, "analysis timeout (>10s)");
+        return fail(11, "Out of memory");
     }
 
     double runtime_analyze_ms = round3(now_ms() - t_analyze0);
 
+    /* Why this engine (and, for AUTO, which counters took the units);
+     * the request's measurements then refine the shared model.
+     */
+    char reason[256];
+    if (approximate) {
+        snprintf(reason, sizeof(reason), "approximate: engines bypassed");
+    } else if (!job.model) {
+        snprintf(reason, sizeof(reason), "requested");
+    } else {
+        cost_describe(&model, &choice, &report, reason, sizeof(reason));
+        cost_model_report(&report, pipeline_used);
+    }
+
     /* Build response JSON (schema aligned with response-analyse_example.json). */
     yyjson_mut_doc *resp = yyjson_mut_doc_new(NULL);
     if (!resp) {
@@ -381,9 +1361,170 @@ app_analyze_result_t app_analyze_pages(const app_page_t *pages, size_t n_pages,
 
     /* Expose pipeline selection for perf comparisons and debugging. */
     const char *req = pipeline_requested_str(opts);
-    const char *used = use_id_pipeline ? "id" : "string";
+    const char *used = approximate ? "approximate" : app_pipeline_to_str(pipeline_used);
     yyjson_mut_obj_add_strcpy(resp, meta, "pipelineRequested", req);
     yyjson_mut_obj_add_strcpy(resp, meta, "pipelineUsed", used);
+    yyjson_mut_obj_add_strcpy(resp, meta, "pipelineReason", reason);
+    yyjson_mut_obj_add_uint(resp, meta, "threads", threads);
+
+    /* Page stage scheduling: plan shape, steals and how much of the
+     * threads' wall time was spent in tasks (thread CPU time).
+     */
+    yyjson_mut_val *sc = yyjson_mut_obj(resp);
+    yyjson_mut_obj_add_uint(resp, sc, "tasks", (uint64_t)cx.plan.n_tasks);
+    yyjson_mut_obj_add_uint(resp, sc, "splitPages", (uint64_t)cx.plan.n_splits);
+    yyjson_mut_obj_add_uint(resp, sc, "chunks", (uint64_t)(cx.plan.n_slots - n_pages));
+    yyjson_mut_obj_add_uint(resp, sc, "batches", (uint64_t)cx.plan.batches);
+    yyjson_mut_obj_add_uint(resp, sc, "steals", (uint64_t)sched.steals);
+    yyjson_mut_obj_add_real(resp, sc, "wallMs", round3(sched.wall_ms));
+    yyjson_mut_obj_add_real(resp, sc, "utilization", round3(workers_utilization(&sched)));
+    yyjson_mut_val *wk = yyjson_mut_arr(resp);
+    for (unsigned w = 0; w < sched.threads; w++) {
+        yyjson_mut_val *wo = yyjson_mut_obj(resp);
+        yyjson_mut_obj_add_uint(resp, wo, "tasks", (uint64_t)sched.tasks[w]);
+        yyjson_mut_obj_add_real(resp, wo, "cpuMs", round3(sched.cpu_ms[w]));
+        yyjson_mut_arr_add_val(wk, wo);
+    }
+    yyjson_mut_obj_add_val(resp, sc, "workers", wk);
+    yyjson_mut_obj_add_val(resp, meta, "scheduler", sc);
+
+    /* Units (pages or chunks) counted by the small-page fast path. */
+    yyjson_mut_obj_add_uint(resp, meta, "smallPages", (uint64_t)atomic_load(&job.small_units));
+
+    /* String arenas of the request and the workers (sum of their peaks);
+     * blocks counts only those allocated by this request.
+     */
+    size_t arena_blocks = request->blocks + tokens->blocks;
+    size_t arena_peak = request->peak_reserved + tokens->peak_reserved;
+    for (unsigned k = 0; k < cx.n_own; k++) {
+        arena_blocks += cx.own_arenas[k].blocks;
+        arena_peak += cx.own_arenas[k].peak_reserved;
+    }
+    yyjson_mut_val *ar = yyjson_mut_obj(resp);
+    yyjson_mut_obj_add_uint(resp, ar, "blocks", (uint64_t)arena_blocks);
+    yyjson_mut_obj_add_uint(resp, ar, "peakKiB", (uint64_t)(arena_peak / 1024));
+    yyjson_mut_obj_add_val(resp, meta, "arena", ar);
+
+    /* Reused per-thread state: requests served so far and releases by
+     * the high-water trim (both 0 without a scratch).
+     */
+    yyjson_mut_val *scr = yyjson_mut_obj(resp);
+    yyjson_mut_obj_add_uint(resp, scr, "requests", (uint64_t)(scratch ? scratch->requests : 0));
+    yyjson_mut_obj_add_uint(resp, scr, "trims", (uint64_t)(scratch ? scratch->trims : 0));
+    yyjson_mut_obj_add_val(resp, meta, "scratch", scr);
+    yyjson_mut_obj_add_strcpy(resp, meta, "aggregation",
+                              approximate ? "approximate" : threshold_topk ? "threshold" : "full");
+
+    /* partialOnTimeout: whether the deadline cut pages (left out of the
+     * domain result, marked in pageResults).
+     */
+    if (partial) {
+        yyjson_mut_obj_add_bool(resp, meta, "partial", pages_cut > 0);
+        yyjson_mut_obj_add_uint(resp, meta, "pagesCompleted", (uint64_t)(n_pages - pages_cut));
+    }
+
+    /* Approximate mode: summary size and whether the Top-K is provably exact
+     * (keys outside the summary occur at most *Bound times).
+     */
+    if (approximate) {
+        yyjson_mut_val *ap = yyjson_mut_obj(resp);
+        yyjson_mut_obj_add_uint(resp, ap, "capacity", (uint64_t)cx.hh_words.capacity);
+        yyjson_mut_obj_add_bool(resp, ap, "verified", hh_verified);
+        yyjson_mut_obj_add_bool(resp, ap, "wordsExact", words_exact);
+        yyjson_mut_obj_add_uint(resp, ap, "wordsBound", (uint64_t)hh_unmonitored_bound(&cx.hh_words));
+        if (include_bigrams) {
+            yyjson_mut_obj_add_bool(resp, ap, "bigramsExact", bigrams_exact);
+            yyjson_mut_obj_add_uint(resp, ap, "bigramsBound", (uint64_t)hh_unmonitored_bound(&cx.hh_bigrams));
+        }
+        yyjson_mut_obj_add_val(resp, meta, "approximate", ap);
+    }
+
+    /* N-grams: table usage against the memory limit; truncated means new
+     * n-grams were refused (lists are then incomplete, counts stay exact).
+     */
+    if (ngram_max > 0) {
+        yyjson_mut_val *ng = yyjson_mut_obj(resp);
+        yyjson_mut_obj_add_uint(resp, ng, "maxN", ngram_max);
+        yyjson_mut_obj_add_uint(resp, ng, "entries", (uint64_t)cx.ngrams.size);
+        yyjson_mut_obj_add_uint(resp, ng, "limit", (uint64_t)cx.ngrams.limit);
+        yyjson_mut_obj_add_bool(resp, ng, "truncated", cx.ngrams.dropped > 0);
+        yyjson_mut_obj_add_uint(resp, ng, "dropped", (uint64_t)cx.ngrams.dropped);
+        yyjson_mut_obj_add_val(resp, meta, "ngrams", ng);
+    }
+
+    /* Co-occurrence: table usage and pruning; counts are lower bounds that
+     * miss at most maxUndercount occurrences once pruning ran.
+     */
+    if (cooc_window > 0) {
+        yyjson_mut_val *co = yyjson_mut_obj(resp);
+        yyjson_mut_obj_add_uint(resp, co, "window", cooc_window);
+        yyjson_mut_obj_add_uint(resp, co, "minCount", (uint64_t)(opts->cooc_min_count ? opts->cooc_min_count : 1));
+        yyjson_mut_obj_add_uint(resp, co, "entries", (uint64_t)cx.cooc.size);
+        yyjson_mut_obj_add_uint(resp, co, "limit", (uint64_t)cx.cooc.limit);
+        yyjson_mut_obj_add_uint(resp, co, "prunes", (uint64_t)cx.cooc.prunes);
+        yyjson_mut_obj_add_uint(resp, co, "maxUndercount", (uint64_t)cx.cooc.undercount);
+        yyjson_mut_obj_add_uint(resp, co, "dropped", (uint64_t)cx.cooc.dropped);
+        yyjson_mut_obj_add_val(resp, meta, "cooccurrence", co);
+    }
+
+    /* Stemming: distinct surface forms stemmed (once each) and stems. */
+    if (stem) {
+        yyjson_mut_val *st = yyjson_mut_obj(resp);
+        yyjson_mut_obj_add_strcpy(resp, st, "language", "de");
+        yyjson_mut_obj_add_uint(resp, st, "stemmed", (uint64_t)cx.stem.stemmed);
+        yyjson_mut_obj_add_uint(resp, st, "stems", (uint64_t)dict_size(&cx.stem.stems));
+        yyjson_mut_obj_add_val(resp, meta, "stemming", st);
+    }
+
+    /* TF-IDF: pages counted as documents and ranked vocabulary size. */
+    if (tfidf) {
+        size_t ranked = 0;
+        for (size_t i = 0; i < cx.docfreq.tf.cap; i++) ranked += cx.docfreq.tf.counts[i] != 0;
+        yyjson_mut_val *tf = yyjson_mut_obj(resp);
+        yyjson_mut_obj_add_uint(resp, tf, "documents", (uint64_t)cx.docfreq.n_docs);
+        yyjson_mut_obj_add_uint(resp, tf, "vocabulary", (uint64_t)ranked);
+        yyjson_mut_obj_add_val(resp, meta, "tfidf", tf);
+    }
+
+    /* Sampling: realized byte fraction, intervals for the domain entries;
+     * counts and metrics below are scaled back to full-text estimates.
+     */
+    double domain_fraction = 1.0;
+    if (sampling) {
+        SampleStats tot = {0};
+        for (size_t i = 0; i < n_pages; i++) {
+            tot.bytes_total   += cx.page_samples[i].bytes_total;
+            tot.bytes_kept    += cx.page_samples[i].bytes_kept;
+            tot.windows_total += cx.page_samples[i].windows_total;
+            tot.windows_kept  += cx.page_samples[i].windows_kept;
+        }
+        double fraction = sample_fraction(&tot);
+        domain_fraction = fraction;
+
+        yyjson_mut_val *sm = yyjson_mut_obj(resp);
+        yyjson_mut_obj_add_real(resp, sm, "rate", sample.rate);
+        yyjson_mut_obj_add_bool(resp, sm, "auto", sample_auto);
+        yyjson_mut_obj_add_uint(resp, sm, "seed", sample.seed);
+        yyjson_mut_obj_add_uint(resp, sm, "windowBytes", (uint64_t)sample.window_bytes);
+        yyjson_mut_obj_add_uint(resp, sm, "windowsTotal", (uint64_t)tot.windows_total);
+        yyjson_mut_obj_add_uint(resp, sm, "windowsSampled", (uint64_t)tot.windows_kept);
+        yyjson_mut_obj_add_real(resp, sm, "fraction", fraction);
+        yyjson_mut_obj_add_real(resp, sm, "confidence", SAMPLE_CONFIDENCE);
+
+        yyjson_mut_val *iw = yyjson_mut_arr(resp);
+        json_add_word_intervals(resp, iw, &cx.top_words, fraction);
+        yyjson_mut_obj_add_val(resp, sm, "words", iw);
+        if (include_bigrams) {
+            yyjson_mut_val *ib = yyjson_mut_arr(resp);
+            json_add_bigram_intervals(resp, ib, &cx.top_bigs, fraction);
+            yyjson_mut_obj_add_val(resp, sm, "bigrams", ib);
+        }
+        yyjson_mut_obj_add_val(resp, meta, "sampling", sm);
+
+        scale_word_list(&cx.top_words, cx.top_word_errors, fraction);
+        if (include_bigrams) scale_bigram_list(&cx.top_bigs, cx.top_bigram_errors, fraction);
+        domain_metrics = scale_metrics(domain_metrics, fraction);
+    }
 
     /* Measurement point: peak RSS of whole process at end of analysis. */
     yyjson_mut_obj_add_uint(resp, meta, "peakRssKiB", ta_peak_rss_kib());
@@ -396,15 +1537,39 @@ app_analyze_result_t app_analyze_pages(const app_page_t *pages, size_t n_pages,
     yyjson_mut_obj_add_uint(resp, domain, "wordCharCount", (uint64_t)domain_metrics.wordCharCount);
 
     yyjson_mut_val *words_arr = yyjson_mut_arr(resp);
-    json_add_word_list(resp, words_arr, &cx.top_words);
+    json_add_word_list(resp, words_arr, &cx.top_words, approximate ? cx.top_word_errors : NULL);
     yyjson_mut_obj_add_val(resp, domain, "words", words_arr);
 
     if (include_bigrams) {
         yyjson_mut_val *bigrams_arr = yyjson_mut_arr(resp);
-        json_add_bigram_list(resp, bigrams_arr, &cx.top_bigs);
+        json_add_bigram_list(resp, bigrams_arr, &cx.top_bigs, approximate ? cx.top_bigram_errors : NULL);
         yyjson_mut_obj_add_val(resp, domain, "bigrams", bigrams_arr);
     }
 
+    if (tfidf) {
+        yyjson_mut_val *tf = yyjson_mut_arr(resp);
+        json_add_tfidf_list(resp, tf, &cx.top_tfidf, domain_fraction);
+        yyjson_mut_obj_add_val(resp, domain, "tfidf", tf);
+    }
+
+    /* ngrams["1"].."N": same Top-K policy as words/bigrams. */
+    if (ngram_max > 0) {
+        static const char *const ngram_keys[NGRAM_MAX_N] = { "1", "2", "3", "4" };
+        yyjson_mut_val *ng = yyjson_mut_obj(resp);
+        for (unsigned n = 1; n <= ngram_max; n++) {
+            yyjson_mut_val *arr = yyjson_mut_arr(resp);
+            json_add_ngram_list(resp, arr, &cx.top_ngrams[n - 1], domain_fraction);
+            yyjson_mut_obj_add_val(resp, ng, ngram_keys[n - 1], arr);
+        }
+        yyjson_mut_obj_add_val(resp, domain, "ngrams", ng);
+    }
+
+    if (cooc_window > 0) {
+        yyjson_mut_val *co = yyjson_mut_obj(resp);
+        json_add_cooc_matrix(resp, co, &cx.cooc_matrix, domain_fraction);
+        yyjson_mut_obj_add_val(resp, domain, "cooccurrence", co);
+    }
+
     yyjson_mut_obj_add_val(resp, root, "domainResult", domain);
 
     if (per_page) {
@@ -416,26 +1581,53 @@ app_analyze_result_t app_analyze_pages(const app_page_t *pages, size_t n_pages,
             yyjson_mut_obj_add_sint(resp, p, "id", (int64_t)pages[i].id);
             if (pages[i].name) yyjson_mut_obj_add_strcpy(resp, p, "name", pages[i].name);
             if (pages[i].url)  yyjson_mut_obj_add_strcpy(resp, p, "url", pages[i].url);
-
-            yyjson_mut_obj_add_uint(resp, p, "charCount", (uint64_t)cx.page_metrics[i].charCount);
-            yyjson_mut_obj_add_uint(resp, p, "wordCount", (uint64_t)cx.page_metrics[i].wordCount);
-            yyjson_mut_obj_add_uint(resp, p, "wordCharCount", (uint64_t)cx.page_metrics[i].wordCharCount);
-
-            /* Per-page Top-K (0 means full list) for debugging and comparisons. */
-            size_t k_pw = (topk == 0) ? cx.page_words[i].count : topk;
-            WordCountList pw_top = top_k_words(&cx.page_words[i], k_pw);
-            yyjson_mut_val *pw = yyjson_mut_arr(resp);
-            json_add_word_list(resp, pw, &pw_top);
-            yyjson_mut_obj_add_val(resp, p, "words", pw);
-            free_top_k_words(&pw_top);
-
-            if (include_bigrams) {
-                size_t k_pb = (topk == 0) ? cx.page_bigrams[i].count : topk;
-                BigramCountList pb_top = top_k_bigrams(&cx.page_bigrams[i], k_pb);
-                yyjson_mut_val *pb = yyjson_mut_arr(resp);
-                json_add_bigram_list(resp, pb, &pb_top);
-                yyjson_mut_obj_add_val(resp, p, "bigrams", pb);
-                free_top_k_bigrams(&pb_top);
+            if (page_is_cut(&cx, i)) yyjson_mut_obj_add_bool(resp, p, "partial", true);
+
+            /* Sampled pages are scaled by their own byte fraction. */
+            double pf = sampling ? sample_fraction(&cx.page_samples[i]) : 1.0;
+            TextMetrics pm = sampling ? scale_metrics(cx.page_metrics[i], pf) : cx.page_metrics[i];
+            yyjson_mut_obj_add_uint(resp, p, "charCount", (uint64_t)pm.charCount);
+            yyjson_mut_obj_add_uint(resp, p, "wordCount", (uint64_t)pm.wordCount);
+            yyjson_mut_obj_add_uint(resp, p, "wordCharCount", (uint64_t)pm.wordCharCount);
+            if (sampling) yyjson_mut_obj_add_real(resp, p, "sampleFraction", pf);
+
+            /* Per-page Top-K (0 means full list) for debugging and comparisons.
+             * Approximate mode keeps no per-page lists (metrics only).
+             */
+            if (!approximate) {
+                WordCountList pw_top = (WordCountList){0};
+                BigramCountList pb_top = (BigramCountList){0};
+                int ok = 1;
+                if (cx.rank_live) {
+                    pw_top = top_k_words_ranked(&cx.rank, &cx.page_words[i], cx.page_words[i].count);
+                    if (include_bigrams) {
+                        pb_top = top_k_bigrams_ranked(&cx.rank, &cx.page_bigrams[i], cx.page_bigrams[i].count);
+                    }
+                } else {
+                    ok = cx.engine->topk_words(cx.engine_state, i, &cx.page_words[i], topk, &pw_top) &&
+                         (!include_bigrams ||
+                          cx.engine->topk_bigrams(cx.engine_state, i, &cx.page_bigrams[i], topk, &pb_top));
+                }
+                if (!ok) {
+                    free_top_k_words(&pw_top);
+                    yyjson_mut_doc_free(resp);
+                    cleanup_ctx(&cx);
+                    return fail(cx.engine->fail_status, cx.engine->fail_message);
+                }
+
+                if (sampling) scale_word_list(&pw_top, NULL, pf);
+                yyjson_mut_val *pw = yyjson_mut_arr(resp);
+                json_add_word_list(resp, pw, &pw_top, NULL);
+                yyjson_mut_obj_add_val(resp, p, "words", pw);
+                free_top_k_words(&pw_top);
+
+                if (include_bigrams) {
+                    if (sampling) scale_bigram_list(&pb_top, NULL, pf);
+                    yyjson_mut_val *pb = yyjson_mut_arr(resp);
+                    json_add_bigram_list(resp, pb, &pb_top, NULL);
+                    yyjson_mut_obj_add_val(resp, p, "bigrams", pb);
+                    free_top_k_bigrams(&pb_top);
+                }
             }
 
             yyjson_mut_arr_add_val(pages_arr, p);
@@ -452,3 +1644,36 @@ app_analyze_result_t app_analyze_pages(const app_page_t *pages, size_t n_pages,
     ok.response_doc = resp;
     return ok;
 }
+
+/* All strings of a request (tokens, list words, dict keys, Top-K copies)
+ * come from arenas and are released here in one go; the response
+ * document holds its own copies.
+ */
+app_analyze_result_t app_analyze_pages(const app_page_t *pages, size_t n_pages, const app_analyze_opts_t *opts) {
+    if (!pages || n_pages == 0) return fail(10, "No pages provided");
+
+    /* The calling thread's scratch keeps its arenas, stopwords and
+     * tables for the next request; without one (nested call, OOM) the
+     * request gets arenas of its own.
+     */
+    Scratch *s = scratch_begin();
+    Arena own_strings, own_tokens;
+    arena_init(&own_strings);
+    arena_init(&own_tokens);
+    Arena *request = s ? &s->strings : &own_strings;
+    Arena *tokens = s ? &s->tokens : &own_tokens;
+
+    /* Hot loops of all workers poll the request's deadline. */
+    Cancel cancel;
+    cancel_init(&cancel, opts ? opts->deadline_ms : 0.0);
+    Cancel *prev_cancel = cancel_bind(&cancel);
+
+    Arena *prev = arena_bind(request);
+    app_analyze_result_t res = analyze_pages(pages, n_pages, opts, s, request, tokens);
+    arena_bind(prev);
+    cancel_bind(prev_cancel);
+    arena_free(&own_strings);
+    arena_free(&own_tokens);
+    scratch_end(s);
+    return res;
+}
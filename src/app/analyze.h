@@ -2,44 +2,42 @@
 #pragma once
 #include <stdbool.h>
 #include <stddef.h>   // size_t
+#include <stdint.h>
 #include "yyjson.h"
 #include <string.h>
 
 /* Pipeline selection:
- * - AUTO: choose based on input size/threshold
+ * - AUTO: cost model per request and per page (app/cost_model.h)
  * - STRING: baseline string-based counting
  * - ID: dictionary/ID-based counting (better for large inputs)
+ * - SORT: dictionary IDs, counted via radix sort + run-length encoding
+ *   (sequential memory access for very large pages)
+ * - ART: adaptive radix trees keyed by token strings; lexicographically
+ *   ordered output makes the Top-K tie-break free
+ *
+ * Values index the engine registry (app/engine.h); engines registered
+ * beyond the named constants are reachable by name.
  */
 typedef enum {
   APP_PIPELINE_AUTO = 0,
   APP_PIPELINE_STRING = 1,
-  APP_PIPELINE_ID = 2
+  APP_PIPELINE_ID = 2,
+  APP_PIPELINE_SORT = 3,
+  APP_PIPELINE_ART = 4
 } app_pipeline_t;
 
-/* Parses pipeline selector from CLI/API ("auto"|"string"|"id").
+/* Parses pipeline selector from CLI/API ("auto" or a registered engine name).
  * ok is set to 0 on invalid input.
  */
-static inline app_pipeline_t app_pipeline_from_str(const char *s, int *ok) {
-    if (ok) *ok = 1;
-    if (!s || s[0] == '\0') return APP_PIPELINE_AUTO;
-
-    if (strcmp(s, "auto") == 0)   return APP_PIPELINE_AUTO;
-    if (strcmp(s, "string") == 0) return APP_PIPELINE_STRING;
-    if (strcmp(s, "id") == 0)     return APP_PIPELINE_ID;
-
-    if (ok) *ok = 0;
-    return APP_PIPELINE_AUTO;
-}
+app_pipeline_t app_pipeline_from_str(const char *s, int *ok);
 
 /* Stable string representation for meta.pipelineRequested/pipelineUsed. */
-static inline const char* app_pipeline_to_str(app_pipeline_t p) {
-    switch (p) {
-        case APP_PIPELINE_STRING: return "string";
-        case APP_PIPELINE_ID:     return "id";
-        case APP_PIPELINE_AUTO:
-        default:                  return "auto";
-    }
-}
+const char* app_pipeline_to_str(app_pipeline_t p);
+
+/* Accepted selectors for usage/error messages; keep in sync with the
+ * engine registry (engine.c).
+ */
+#define APP_PIPELINE_CHOICES "auto|string|id|sort|art"
 
 /* Input page unit shared by CLI/API. */
 typedef struct {
@@ -61,6 +59,63 @@ typedef struct {
     app_pipeline_t pipeline;
 
     double deadline_ms; // 0 = no timeout; otherwise absolute time (now_ms()) when to abort
+
+    /* On timeout, answer with the pages completed so far instead of 503:
+     * hot loops poll the deadline (core/cancel.h), cut pages stay empty
+     * and are marked; meta.partial tells. 503 when no page completed.
+     * Not in approximate mode or with n-grams/co-occurrence.
+     */
+    bool partial_on_timeout;
+    size_t max_token_bytes; // 0 = no limit; longer tokens are skipped
+
+    /* Approximate heavy hitters (Space-Saving): fixed memory per request,
+     * counts carry error bounds; no per-page word/bigram lists.
+     */
+    bool approximate;
+    size_t approximate_capacity; // 0 = HH_DEFAULT_CAPACITY (slots per summary)
+
+    /* Text sampling ahead of the tokenizer (core/sampling.h); counts are
+     * scaled back and meta.sampling reports confidence intervals.
+     */
+    double sample_rate;   // 0 = AUTO (only when the deadline would be missed), (0,1) = rate, >= 1 = off
+    uint64_t sample_seed; // 0 = SAMPLE_DEFAULT_SEED
+
+    /* Domain n-grams of order 1..ngram_max (core/id_ngrams.h), counted
+     * next to the engine; ngram_limit bounds the distinct entries.
+     */
+    unsigned ngram_max;   // 0 = off, 1..NGRAM_MAX_N
+    size_t ngram_limit;   // 0 = NGRAM_DEFAULT_LIMIT
+
+    /* Domain co-occurrence within +-cooc_window tokens (core/id_cooc.h),
+     * exported as a sparse matrix of pairs with count >= cooc_min_count.
+     */
+    unsigned cooc_window;  // 0 = off, 1..COOC_MAX_WINDOW
+    size_t cooc_min_count; // 0/1 = all pairs
+    size_t cooc_limit;     // 0 = COOC_DEFAULT_LIMIT (distinct pairs)
+
+    /* Fold word/bigram results onto light German stems (core/stem_de.h);
+     * each distinct word is stemmed once. Not applied in approximate mode
+     * or to n-grams/co-occurrence.
+     */
+    bool stem;
+
+    /* Domain TF-IDF ranking from per-page document frequencies
+     * (core/id_docfreq.h); same Top-K as words. Not in approximate mode.
+     */
+    bool tfidf;
+
+    /* Worker threads for the page stage (app/workers.h); output is the
+     * same for every count. Sequential with n-grams, co-occurrence or
+     * approximate mode (request-wide tables).
+     */
+    unsigned threads;  // 0/1 = sequential
+
+    /* Units up to SMALL_PAGE_MAX_TOKENS raw tokens are filtered and
+     * counted in one pass over a stack table (core/small_count.h) with
+     * engines that allow it; same output. Off: always the regular path
+     * (parity tests, benchmarks).
+     */
+    bool no_small_pages;
 } app_analyze_opts_t;
 
 /* Result container for API/CLI.
@@ -0,0 +1,477 @@
+#include "app/cost_model.h"
+#include "app/scratch.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "core/aggregate.h"
+#include "core/bigram_aggregate.h"
+#include "core/small_count.h"
+#include "core/stopwords.h"
+
+/* Small-page path: hashing per token, filter rules once per distinct token. */
+static const app_engine_cost_t g_small_cost = {
+  .per_token = 120.0,
+  .per_distinct = 1400.0,
+};
+
+#define BYTES_PER_TOKEN 7.2
+#define HEAPS_WORDS 4.0
+#define HEAPS_BIGRAMS 4.0
+#define HEAPS_BETA_WORDS 0.5
+#define HEAPS_BETA_BIGRAMS 0.6
+
+/* One report moves a scale by at most this factor (a preempted thread
+ * must not wreck the model).
+ */
+#define REPORT_MAX_RATIO 2.0
+#define SCALE_MIN (1.0 / 16.0)
+#define SCALE_MAX 16.0
+
+/* Calibration page: CALIB_TOKENS tokens (a third of them stopwords) over
+ * CALIB_VOCAB pseudo-words, skewed towards the first ones; merges read
+ * CALIB_PAGES such pages.
+ */
+#define CALIB_TOKENS 512
+#define CALIB_VOCAB 192
+#define CALIB_PAGES 8
+#define CALIB_RUNS 2
+
+static pthread_once_t g_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static CostModel g_model;
+static atomic_uint_fast64_t g_auto_requests;
+
+static void model_priors(CostModel *m, bool fixed) {
+  memset(m, 0, sizeof(*m));
+  for (size_t c = 0; c < COST_MAX_COUNTERS; c++) {
+    m->count_scale[c] = 1.0;
+    m->merge_scale[c] = 1.0;
+  }
+  m->bytes_per_token = BYTES_PER_TOKEN;
+  m->heaps_words = HEAPS_WORDS;
+  m->heaps_bigrams = HEAPS_BIGRAMS;
+  m->fixed = fixed;
+}
+
+static void model_init(void) {
+  const char *v = getenv("TA_AUTO_MODEL");
+  model_priors(&g_model, v && strcmp(v, "fixed") == 0);
+}
+
+void cost_model_snapshot(CostModel *m) {
+  pthread_once(&g_once, model_init);
+  pthread_mutex_lock(&g_lock);
+  *m = g_model;
+  pthread_mutex_unlock(&g_lock);
+}
+
+void cost_model_reset(void) {
+  pthread_once(&g_once, model_init);
+  pthread_mutex_lock(&g_lock);
+  model_priors(&g_model, g_model.fixed);
+  pthread_mutex_unlock(&g_lock);
+  atomic_store(&g_auto_requests, 0);
+}
+
+static const app_engine_cost_t *counter_cost(size_t c) {
+  if (c == COST_SMALL) return &g_small_cost;
+  const app_engine_t *e = app_engine_at(c);
+  return e ? e->auto_cost : NULL;
+}
+
+double cost_distinct_words(const CostModel *m, double tokens) {
+  double d = m->heaps_words * pow(tokens, HEAPS_BETA_WORDS);
+  return d < tokens ? d : tokens;
+}
+
+double cost_distinct_bigrams(const CostModel *m, double tokens) {
+  double d = m->heaps_bigrams * pow(tokens, HEAPS_BETA_BIGRAMS);
+  return d < tokens ? d : tokens;
+}
+
+double cost_count_ns(const CostModel *m, size_t c, double tokens, double distinct) {
+  const app_engine_cost_t *p = c < COST_MAX_COUNTERS ? counter_cost(c) : NULL;
+  if (!p) return HUGE_VAL;
+  double ns = p->per_token * tokens + p->per_distinct * distinct + p->per_lookup * tokens * distinct;
+  return m->count_scale[c] * ns;
+}
+
+double cost_merge_ns(const CostModel *m, size_t e,
+                     double word_entries, double domain_words,
+                     double bigram_entries, double domain_bigrams) {
+  const app_engine_cost_t *p = (e != COST_SMALL && e < COST_MAX_COUNTERS) ? counter_cost(e) : NULL;
+  if (!p) return HUGE_VAL;
+  double ns = p->merge_per_entry * (word_entries + bigram_entries)
+            + p->merge_per_lookup * (word_entries * domain_words + bigram_entries * domain_bigrams)
+            + p->per_request;
+  return m->merge_scale[e] * ns;
+}
+
+/* Counter c may count units for engine e: e itself, or a stateless engine
+ * whose lists e's merge takes (any order, or key order for lexsorted e).
+ */
+static bool counter_fits(size_t e, size_t c) {
+  if (c == e) return true;
+  const app_engine_t *E = app_engine_at(e);
+  const app_engine_t *C = app_engine_at(c);
+  if (!E || !C || !C->auto_cost) return false;
+  if (E->init || E->lists_in_state || C->init || C->lists_in_state) return false;
+  return !E->lists_lexsorted || C->lists_lexsorted;
+}
+
+static size_t n_counters(void) {
+  size_t n = app_engine_count();
+  return n < COST_MAX_COUNTERS ? n : COST_MAX_COUNTERS;
+}
+
+size_t cost_pick_counter(const CostModel *m, app_pipeline_t e, size_t tokens, bool small_ok,
+                         size_t *next) {
+  double t = (double)tokens;
+  double d = cost_distinct_words(m, t);
+  bool small_fits = tokens <= SMALL_PAGE_MAX_TOKENS;
+
+  size_t best = (size_t)e;
+  double best_ns = cost_count_ns(m, best, t, d);
+  for (size_t c = 0; c < n_counters(); c++) {
+    bool fits = (c == COST_SMALL) ? small_ok && small_fits : counter_fits((size_t)e, c);
+    if (!fits) continue;
+    double ns = cost_count_ns(m, c, t, d);
+    if (ns < best_ns) {
+      best = c;
+      best_ns = ns;
+    }
+  }
+
+  if (next) {
+    /* Shadow candidates need not fit e: their lists are dropped. */
+    size_t alt = best;
+    double alt_ns = HUGE_VAL;
+    for (size_t c = 0; c < n_counters(); c++) {
+      if (c == best || (c == COST_SMALL && !small_fits)) continue;
+      double ns = cost_count_ns(m, c, t, d);
+      if (ns < alt_ns) {
+        alt = c;
+        alt_ns = ns;
+      }
+    }
+    *next = alt;
+  }
+  return best;
+}
+
+/* Estimated ns of a request with engine e. */
+static double request_ns(const CostModel *m, size_t e, const size_t *page_bytes, size_t n_pages,
+                         double rate, unsigned threads, bool bigrams, bool small_ok) {
+  const app_engine_t *E = app_engine_at(e);
+  bool small = small_ok && E->small_pages;
+  double pages_ns = 0.0, tokens = 0.0, word_entries = 0.0, bigram_entries = 0.0;
+  for (size_t i = 0; i < n_pages; i++) {
+    double t = floor((double)page_bytes[i] * rate / m->bytes_per_token);
+    size_t c = cost_pick_counter(m, (app_pipeline_t)e, (size_t)t, small, NULL);
+    pages_ns += cost_count_ns(m, c, t, cost_distinct_words(m, t));
+    tokens += t;
+    word_entries += cost_distinct_words(m, t);
+    if (bigrams) bigram_entries += cost_distinct_bigrams(m, t);
+  }
+  double merge = cost_merge_ns(m, e, word_entries, cost_distinct_words(m, tokens),
+                               bigram_entries, bigrams ? cost_distinct_bigrams(m, tokens) : 0.0);
+  return pages_ns / (double)(threads ? threads : 1) + merge;
+}
+
+void cost_choose(const CostModel *m, const size_t *page_bytes, size_t n_pages, double rate,
+                 unsigned threads, bool bigrams, bool small_ok, CostChoice *out) {
+  memset(out, 0, sizeof(*out));
+  out->engine = out->best = out->next = APP_PIPELINE_AUTO;
+  out->engine_ns = out->best_ns = out->next_ns = HUGE_VAL;
+
+  app_pipeline_t deflt = APP_PIPELINE_AUTO;
+  double deflt_ns = HUGE_VAL;
+  for (size_t e = 1; e < n_counters(); e++) {
+    const app_engine_t *E = app_engine_at(e);
+    if (!E || !E->auto_cost) continue;
+    double ns = request_ns(m, e, page_bytes, n_pages, rate, threads, bigrams, small_ok);
+    if (deflt == APP_PIPELINE_AUTO) {
+      deflt = (app_pipeline_t)e;
+      deflt_ns = ns;
+    }
+    if (ns < out->best_ns) {
+      out->next = out->best;
+      out->next_ns = out->best_ns;
+      out->best = (app_pipeline_t)e;
+      out->best_ns = ns;
+    } else if (ns < out->next_ns) {
+      out->next = (app_pipeline_t)e;
+      out->next_ns = ns;
+    }
+  }
+
+  /* Hysteresis: small gains are within the model's error. */
+  double gain = deflt_ns - out->best_ns;
+  bool keep = gain < COST_MIN_GAIN * deflt_ns || gain < COST_MIN_GAIN_NS;
+  out->engine = keep ? deflt : out->best;
+  out->engine_ns = keep ? deflt_ns : out->best_ns;
+
+  out->shadow = !m->fixed &&
+                atomic_fetch_add(&g_auto_requests, 1) % COST_SHADOW_EVERY == 0;
+}
+
+void cost_report_unit(CostReport *r, const CostModel *m, size_t c, size_t tokens, size_t bytes,
+                      size_t words, size_t bigrams, double ns, bool shadow) {
+  if (c >= COST_MAX_COUNTERS) return;
+  double t = (double)tokens;
+  double d = (words == COST_UNKNOWN) ? cost_distinct_words(m, t) : (double)words;
+  r->count_ns[c] += ns;
+  r->count_pred[c] += cost_count_ns(m, c, t, d);
+  if (shadow) {
+    r->shadows++;
+    return;
+  }
+  r->units[c]++;
+  if (bytes > 0) {
+    r->bytes += (double)bytes;
+    r->tokens += t;
+  }
+  if (tokens == 0) return;
+  if (words != COST_UNKNOWN) {
+    r->heaps_words += d / pow(t, HEAPS_BETA_WORDS);
+    r->words_n++;
+  }
+  if (bigrams != COST_UNKNOWN) {
+    r->heaps_bigrams += (double)bigrams / pow(t, HEAPS_BETA_BIGRAMS);
+    r->bigrams_n++;
+  }
+}
+
+void cost_report_add(CostReport *into, const CostReport *from) {
+  for (size_t c = 0; c < COST_MAX_COUNTERS; c++) {
+    into->count_ns[c] += from->count_ns[c];
+    into->count_pred[c] += from->count_pred[c];
+    into->units[c] += from->units[c];
+  }
+  into->shadows += from->shadows;
+  into->tokens += from->tokens;
+  into->bytes += from->bytes;
+  into->heaps_words += from->heaps_words;
+  into->heaps_bigrams += from->heaps_bigrams;
+  into->words_n += from->words_n;
+  into->bigrams_n += from->bigrams_n;
+  into->merge_ns += from->merge_ns;
+  into->merge_pred += from->merge_pred;
+}
+
+static void move_scale(double *scale, double measured, double predicted) {
+  if (predicted < COST_REPORT_MIN_NS || measured <= 0.0) return;
+  double r = measured / predicted;
+  if (r > REPORT_MAX_RATIO) r = REPORT_MAX_RATIO;
+  if (r < 1.0 / REPORT_MAX_RATIO) r = 1.0 / REPORT_MAX_RATIO;
+  double s = *scale * ((1.0 - COST_EWMA) + COST_EWMA * r);
+  *scale = s < SCALE_MIN ? SCALE_MIN : s > SCALE_MAX ? SCALE_MAX : s;
+}
+
+static void move_mean(double *v, double sum, size_t n) {
+  if (n > 0) *v = (1.0 - COST_EWMA) * *v + COST_EWMA * (sum / (double)n);
+}
+
+void cost_model_report(const CostReport *r, app_pipeline_t e) {
+  pthread_once(&g_once, model_init);
+  pthread_mutex_lock(&g_lock);
+  if (!g_model.fixed) {
+    for (size_t c = 0; c < COST_MAX_COUNTERS; c++) {
+      move_scale(&g_model.count_scale[c], r->count_ns[c], r->count_pred[c]);
+    }
+    if ((size_t)e < COST_MAX_COUNTERS) move_scale(&g_model.merge_scale[e], r->merge_ns, r->merge_pred);
+    if (r->tokens > 0.0) move_mean(&g_model.bytes_per_token, r->bytes / r->tokens, 1);
+    move_mean(&g_model.heaps_words, r->heaps_words, r->words_n);
+    move_mean(&g_model.heaps_bigrams, r->heaps_bigrams, r->bigrams_n);
+    g_model.reports++;
+    g_model.shadows += r->shadows;
+  }
+  pthread_mutex_unlock(&g_lock);
+}
+
+static const char *counter_name(size_t c) {
+  if (c == COST_SMALL) return "small";
+  const app_engine_t *e = app_engine_at(c);
+  return e ? e->name : "?";
+}
+
+void cost_describe(const CostModel *m, const CostChoice *c, const CostReport *r, char *buf, size_t n) {
+  if (!buf || n == 0) return;
+  size_t len = 0;
+#define ADD(...) do { \
+    int w_ = snprintf(buf + len, n - len, __VA_ARGS__); \
+    if (w_ > 0) len = ((size_t)w_ < n - len) ? len + (size_t)w_ : n - 1; \
+  } while (0)
+
+  const char *used = app_pipeline_to_str(c->engine);
+  if (c->engine != c->best) {
+    ADD("auto: %s kept (%s est %.3f ms, %s %.3f ms: gain below %.0f%% or %.1f ms)",
+        used, app_pipeline_to_str(c->best), c->best_ns / 1e6, used, c->engine_ns / 1e6,
+        COST_MIN_GAIN * 100.0, COST_MIN_GAIN_NS / 1e6);
+  } else if (c->next != APP_PIPELINE_AUTO) {
+    ADD("auto: %s est %.3f ms, next %s %.3f ms",
+        used, c->engine_ns / 1e6, app_pipeline_to_str(c->next), c->next_ns / 1e6);
+  } else {
+    ADD("auto: %s est %.3f ms (only candidate)", used, c->engine_ns / 1e6);
+  }
+
+  const char *sep = "; units ";
+  for (size_t k = 0; k < COST_MAX_COUNTERS; k++) {
+    if (!r->units[k]) continue;
+    ADD("%s%s %zu", sep, counter_name(k), r->units[k]);
+    sep = ", ";
+  }
+  if (r->shadows) ADD("; shadow %zu", r->shadows);
+  ADD("; model %s, %llu reports", m->fixed ? "fixed" : m->calibrated ? "calibrated" : "priors",
+      (unsigned long long)m->reports);
+#undef ADD
+}
+
+/* ---------- Calibration ---------- */
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t lcg_next(uint32_t *s) {
+  *s = *s * 1664525u + 1013904223u;
+  return *s >> 8;
+}
+
+/* Pseudo-words from syllables, 2..4 syllables each. */
+static void calib_vocab(char words[CALIB_VOCAB][16]) {
+  static const char *const syl[] = { "ka", "ter", "ri", "mon", "sel", "ba", "lun", "ge",
+                                     "fa", "dor", "ni", "stra", "wel", "ho", "ben", "zu" };
+  uint32_t s = 7;
+  for (size_t i = 0; i < CALIB_VOCAB; i++) {
+    size_t n = 2 + lcg_next(&s) % 3;
+    words[i][0] = '\0';
+    for (size_t k = 0; k < n; k++) strcat(words[i], syl[lcg_next(&s) % 16]);
+  }
+}
+
+static void calib_page(TokenList *raw, char **items, char words[CALIB_VOCAB][16],
+                       const StopwordList *sw, uint32_t seed) {
+  for (size_t i = 0; i < CALIB_TOKENS; i++) {
+    uint32_t r = lcg_next(&seed);
+    if (sw->count > 0 && r % 3 == 0) {
+      items[i] = sw->items[lcg_next(&seed) % sw->count];
+    } else {
+      double u = (double)(lcg_next(&seed) % 4096) / 4096.0;
+      items[i] = words[(size_t)(u * u * CALIB_VOCAB)];
+    }
+  }
+  raw->items = items;
+  raw->count = CALIB_TOKENS;
+}
+
+/* Best-of-CALIB_RUNS ns of one counter on raw; *distinct = kept words. */
+static double calib_count(size_t c, const TokenList *raw, const StopwordList *sw, size_t *distinct) {
+  double best = HUGE_VAL;
+  for (int run = 0; run < CALIB_RUNS; run++) {
+    WordCountList w = {0};
+    BigramCountList b = {0};
+    const app_engine_t *e = (c == COST_SMALL) ? NULL : app_engine_at(c);
+    void *state = NULL;
+    if (e && e->init && !e->init(&state, 1)) return HUGE_VAL;
+
+    double t0 = now_ns();
+    int ok;
+    if (!e) {
+      ok = small_count_page(raw, sw, false, scratch_small_tables(scratch_get()), &w, &b);
+    } else {
+      TokenList filtered = filter_stopwords_list(raw, sw);
+      ok = e->count_page(state, 0, &filtered, raw, sw, &w, &b);
+      free_tokens(&filtered);
+    }
+    double ns = now_ns() - t0;
+
+    if (!e) *distinct = w.count;
+    free_word_counts(&w);
+    free_bigram_counts(&b);
+    if (e && e->destroy) e->destroy(state);
+    if (!ok) return HUGE_VAL;
+    if (ns < best) best = ns;
+  }
+  return best;
+}
+
+int cost_model_calibrate(const char *stopwords_path) {
+  pthread_once(&g_once, model_init);
+  pthread_mutex_lock(&g_lock);
+  bool done = g_model.calibrated || g_model.fixed;
+  pthread_mutex_unlock(&g_lock);
+  if (done) return 1;
+
+  StopwordList sw = {0};
+  bool sw_loaded = stopwords_path && stopwords_load(&sw, stopwords_path) == 0;
+
+  char words[CALIB_VOCAB][16];
+  calib_vocab(words);
+  char *items[CALIB_PAGES][CALIB_TOKENS];
+  TokenList pages[CALIB_PAGES];
+  for (size_t p = 0; p < CALIB_PAGES; p++) calib_page(&pages[p], items[p], words, &sw, 11u + (uint32_t)p);
+
+  CostModel prior;
+  model_priors(&prior, false);
+  double count_scale[COST_MAX_COUNTERS], merge_scale[COST_MAX_COUNTERS];
+  for (size_t c = 0; c < COST_MAX_COUNTERS; c++) count_scale[c] = merge_scale[c] = 1.0;
+
+  /* Counters on page 0 (the small path first: it reports the distinct count). */
+  size_t distinct = 0;
+  for (size_t c = 0; c < n_counters(); c++) {
+    if (!counter_cost(c)) continue;
+    double ns = calib_count(c, &pages[0], &sw, &distinct);
+    double pred = cost_count_ns(&prior, c, CALIB_TOKENS, (double)distinct);
+    if (ns < HUGE_VAL && pred > 0.0) count_scale[c] = ns / pred;
+  }
+
+  /* Stateless merges over key-sorted page lists (every such merge takes
+   * them); merges of engines with lists in state keep their priors.
+   */
+  WordCountList pw[CALIB_PAGES] = {{0}};
+  BigramCountList pb[CALIB_PAGES] = {{0}};
+  bool lists_ok = true;
+  double word_entries = 0.0, bigram_entries = 0.0;
+  for (size_t p = 0; p < CALIB_PAGES && lists_ok; p++) {
+    lists_ok = small_count_page(&pages[p], &sw, true, scratch_small_tables(scratch_get()), &pw[p], &pb[p]);
+    word_entries += (double)pw[p].count;
+    bigram_entries += (double)pb[p].count;
+  }
+  for (size_t e = 1; lists_ok && e < n_counters(); e++) {
+    const app_engine_t *E = app_engine_at(e);
+    if (!E || !E->auto_cost || E->init || E->lists_in_state) continue;
+    WordCountList dw = {0};
+    BigramCountList db = {0};
+    double t0 = now_ns();
+    int ok = E->merge(NULL, pw, pb, CALIB_PAGES, &dw, &db);
+    double ns = now_ns() - t0;
+    double pred = cost_merge_ns(&prior, e, word_entries, (double)dw.count,
+                                bigram_entries, (double)db.count);
+    free_aggregated_word_counts(&dw);
+    free_aggregated_bigram_counts(&db);
+    if (ok && pred > 0.0) merge_scale[e] = ns / pred;
+  }
+  for (size_t p = 0; p < CALIB_PAGES; p++) {
+    free_word_counts(&pw[p]);
+    free_bigram_counts(&pb[p]);
+  }
+  if (sw_loaded) stopwords_free(&sw);
+
+  pthread_mutex_lock(&g_lock);
+  for (size_t c = 0; c < COST_MAX_COUNTERS; c++) {
+    g_model.count_scale[c] = fmin(fmax(count_scale[c], SCALE_MIN), SCALE_MAX);
+    g_model.merge_scale[c] = fmin(fmax(merge_scale[c], SCALE_MIN), SCALE_MAX);
+  }
+  g_model.calibrated = true;
+  pthread_mutex_unlock(&g_lock);
+  return 1;
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "app/analyze.h"
+#include "app/engine.h"
+
+/*
+ * AUTO cost model (replaces the fixed 1000 KB switch to the ID engine).
+ *
+ * Predicts per engine the time to count each page and to merge the page
+ * lists from its prior (app_engine_cost_t): tokens from page bytes,
+ * distinct words and bigrams by Heaps' law. AUTO decides on two levels:
+ * - per request: the engine with the lowest estimate (page counting
+ *   spread over the threads, plus the sequential merge). The default
+ *   engine (first AUTO candidate in the registry) is kept unless another
+ *   one saves more than COST_MIN_GAIN of it and at least COST_MIN_GAIN_NS;
+ * - per unit (page or chunk), once its tokens are known: the cheapest
+ *   counter whose lists the request engine can merge: the engine itself,
+ *   the small-page path, or another stateless string-list engine (key
+ *   order only for lexsorted engines). Engines with lists in state count
+ *   every unit themselves.
+ *
+ * Every counter carries a scale factor on its prior (merges as well):
+ * - cost_model_calibrate times each counter and merge once on a
+ *   synthetic page (API and batch start-up);
+ * - AUTO requests report measured against predicted time for the
+ *   counters and merge they used, plus tokens per byte and distinct
+ *   counts. Every COST_SHADOW_EVERY-th AUTO request also counts one unit
+ *   with the runner-up counter and drops the result (shadow run), so
+ *   counters that lose keep being measured.
+ * A report moves each scale by COST_EWMA towards the measured ratio.
+ *
+ * TA_AUTO_MODEL=fixed keeps the priors (reproducible perf runs).
+ */
+
+/* Counter index: the engine's registry index; 0 (AUTO's slot) stands for
+ * the small-page path (core/small_count.h).
+ */
+#define COST_SMALL 0
+#define COST_MAX_COUNTERS 8
+
+#define COST_MIN_GAIN 0.10
+#define COST_MIN_GAIN_NS 500000.0      // 0.5 ms
+#define COST_EWMA 0.2
+#define COST_SHADOW_EVERY 32
+#define COST_SHADOW_MIN_TOKENS 256     // below: timer noise
+#define COST_SHADOW_MAX_NS 2000000.0   // predicted, per shadow count
+#define COST_REPORT_MIN_NS 50000.0     // shorter totals are not reported
+
+typedef struct {
+  double count_scale[COST_MAX_COUNTERS];
+  double merge_scale[COST_MAX_COUNTERS];
+  double bytes_per_token;
+  double heaps_words;    // distinct words   ~ heaps_words   * tokens^0.5
+  double heaps_bigrams;  // distinct bigrams ~ heaps_bigrams * tokens^0.6
+  bool calibrated;
+  bool fixed;            // TA_AUTO_MODEL=fixed
+  uint64_t reports;      // AUTO requests that refined the model
+  uint64_t shadows;      // shadow counts reported
+} CostModel;
+
+/* AUTO decision of one request. */
+typedef struct {
+  app_pipeline_t engine;     // engine used
+  app_pipeline_t best;       // lowest estimate (!= engine: default kept)
+  app_pipeline_t next;       // second lowest (AUTO when there is none)
+  double engine_ns, best_ns, next_ns;
+  bool shadow;               // run one shadow count in this request
+} CostChoice;
+
+/* Measurements of one request: per worker, summed by cost_report_add. */
+typedef struct {
+  double count_ns[COST_MAX_COUNTERS];    // measured
+  double count_pred[COST_MAX_COUNTERS];  // predicted for the same units
+  size_t units[COST_MAX_COUNTERS];       // units counted (without shadows)
+  size_t shadows;
+  double tokens, bytes;                  // unsampled units
+  double heaps_words, heaps_bigrams;     // sums of distinct / tokens^beta
+  size_t words_n, bigrams_n;
+  double merge_ns, merge_pred;
+} CostReport;
+
+/* Copy of the shared model; a request decides on its own copy. */
+void cost_model_snapshot(CostModel *m);
+
+/* Back to the priors (tests). */
+void cost_model_reset(void);
+
+/* Start-up microbenchmark: one synthetic page (stopwords from the given
+ * file, if it loads) through every counter, and page lists through every
+ * stateless merge. Later calls return at once. Returns 1 once calibrated
+ * (also with TA_AUTO_MODEL=fixed, which keeps the priors).
+ */
+int cost_model_calibrate(const char *stopwords_path);
+
+/* Heaps' law estimates (never above tokens). */
+double cost_distinct_words(const CostModel *m, double tokens);
+double cost_distinct_bigrams(const CostModel *m, double tokens);
+
+/* Predicted ns to count a unit with counter c (HUGE_VAL without a prior)
+ * and to merge page lists into domain lists with engine e.
+ */
+double cost_count_ns(const CostModel *m, size_t c, double tokens, double distinct);
+double cost_merge_ns(const CostModel *m, size_t e,
+                     double word_entries, double domain_words,
+                     double bigram_entries, double domain_bigrams);
+
+/* Counter for a unit of `tokens` raw tokens under request engine e
+ * (small_ok: the small-page path may count it). *next gets the cheapest
+ * other counter of any engine (shadow candidate), or the chosen one when
+ * there is none.
+ */
+size_t cost_pick_counter(const CostModel *m, app_pipeline_t e, size_t tokens, bool small_ok,
+                         size_t *next);
+
+/* Request decision over all AUTO candidates. page_bytes are scaled by
+ * rate (sampling); small_ok as for cost_pick_counter.
+ */
+void cost_choose(const CostModel *m, const size_t *page_bytes, size_t n_pages, double rate,
+                 unsigned threads, bool bigrams, bool small_ok, CostChoice *out);
+
+/* Record one counted unit with counter c: measured ns, bytes of its text
+ * (0: sampled), distinct words and bigrams of its lists (COST_UNKNOWN:
+ * lists in state, or bigrams disabled). Shadow counts only add timing.
+ */
+#define COST_UNKNOWN SIZE_MAX
+void cost_report_unit(CostReport *r, const CostModel *m, size_t c, size_t tokens, size_t bytes,
+                      size_t words, size_t bigrams, double ns, bool shadow);
+
+void cost_report_add(CostReport *into, const CostReport *from);
+
+/* Refine the shared model with the report of a request that used engine e. */
+void cost_model_report(const CostReport *r, app_pipeline_t e);
+
+/* meta.pipelineReason for an AUTO request (m: the request's copy). */
+void cost_describe(const CostModel *m, const CostChoice *c, const CostReport *r, char *buf, size_t n);
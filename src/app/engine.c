@@ -0,0 +1,84 @@
+#include "app/engine.h"
+
+#include <string.h>
+
+#include "core/aggregate.h"
+#include "core/bigram_aggregate.h"
+#include "view/topk.h"
+
+/* Engine registry. Index == app_pipeline_t value; slot 0 is AUTO.
+ * Keep APP_PIPELINE_CHOICES (analyze.h) in sync when adding a row.
+ */
+static const app_engine_t *const g_engines[] = {
+  NULL,
+  &app_engine_string,
+  &app_engine_id,
+  &app_engine_sort,
+  &app_engine_art,
+};
+
+#define N_ENGINES (sizeof(g_engines) / sizeof(g_engines[0]))
+
+size_t app_engine_count(void) {
+  return N_ENGINES;
+}
+
+const app_engine_t *app_engine_at(size_t i) {
+  return (i < N_ENGINES) ? g_engines[i] : NULL;
+}
+
+const app_engine_t *app_engine_get(app_pipeline_t p) {
+  return app_engine_at((size_t)p);
+}
+
+app_pipeline_t app_pipeline_from_str(const char *s, int *ok) {
+  if (ok) *ok = 1;
+  if (!s || s[0] == '\0') return APP_PIPELINE_AUTO;
+  if (strcmp(s, "auto") == 0) return APP_PIPELINE_AUTO;
+
+  for (size_t i = 1; i < N_ENGINES; i++) {
+    if (g_engines[i] && strcmp(s, g_engines[i]->name) == 0) return (app_pipeline_t)i;
+  }
+
+  if (ok) *ok = 0;
+  return APP_PIPELINE_AUTO;
+}
+
+const char* app_pipeline_to_str(app_pipeline_t p) {
+  const app_engine_t *e = app_engine_get(p);
+  return e ? e->name : "auto";
+}
+
+/* ---------- Default stages ---------- */
+
+int app_engine_merge_default(void *state,
+                             const WordCountList *page_words,
+                             const BigramCountList *page_bigrams,
+                             size_t n_pages,
+                             WordCountList *out_words,
+                             BigramCountList *out_bigrams) {
+  (void)state;
+  *out_words = aggregate_word_counts(page_words, n_pages);
+  if (out_bigrams) {
+    *out_bigrams = page_bigrams ? aggregate_bigram_counts(page_bigrams, n_pages)
+                                : (BigramCountList){0};
+  }
+  return 1;
+}
+
+/* The view of a non-empty list is never empty: no items means no memory. */
+int app_engine_topk_words_default(void *state, size_t which,
+                                  const WordCountList *list, size_t k, WordCountList *out) {
+  (void)state;
+  (void)which;
+  *out = top_k_words(list, (k == 0 && list) ? list->count : k);
+  return out->items || !list || list->count == 0;
+}
+
+int app_engine_topk_bigrams_default(void *state, size_t which,
+                                    const BigramCountList *list, size_t k, BigramCountList *out) {
+  (void)state;
+  (void)which;
+  *out = top_k_bigrams(list, (k == 0 && list) ? list->count : k);
+  return out->items || !list || list->count == 0;
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "app/analyze.h"
+#include "core/tokenizer.h"
+#include "core/stopwords.h"
+#include "core/freq.h"
+#include "core/bigrams.h"
+#include "core/stem_de.h"
+#include "core/id_docfreq.h"
+
+/*
+ * Counting-engine interface.
+ *
+ * app_analyze_pages drives every engine through the same stages:
+ *   init -> count_page (per page or chunk) -> join (split pages) -> merge
+ *   -> fold (options.stem) -> topk_words / topk_bigrams (domain lists)
+ *   -> doc_freq (options.tfidf) -> topk_words / topk_bigrams (page lists)
+ *   -> destroy.
+ * fold and doc_freq are only called with lists_in_state. Lists handed to
+ * merge and the Top-K hooks are always the engine's own count_page/merge
+ * output, so an engine may rely on its own list order.
+ * Top-K hooks also get the list's index (page index or APP_ENGINE_DOMAIN),
+ * so engines that keep their results in state can find them.
+ *
+ * A new engine provides one app_engine_t and a row in the registry
+ * (engine.c); analyze.c and the CLI/API need no changes.
+ */
+typedef struct app_engine {
+  const char *name;          // pipeline selector ("string", "id", ...)
+
+  int fail_status;           // status reported when count_page fails
+  const char *fail_message;  // static string
+
+  /* Lists are already sorted by key (topk hooks order them in O(n));
+   * the FULL-output rank pass in analyze.c is skipped.
+   */
+  bool lists_lexsorted;
+
+  /* count_page/merge keep their results in engine state and leave the
+   * string lists empty; topk hooks materialize only the selected entries
+   * (the FULL-output rank pass in analyze.c is skipped).
+   */
+  bool lists_in_state;
+
+  /* count_page produces plain string lists (first-occurrence order, or
+   * key order with lists_lexsorted), so units of at most
+   * SMALL_PAGE_MAX_TOKENS raw tokens may be filtered and counted by
+   * small_count_page (core/small_count.h) instead of count_page.
+   */
+  bool small_pages;
+
+  /* Optional per-request state (NULL hooks: stateless engine). n_slots
+   * counts the pages followed by the chunk slots of split pages.
+   */
+  int  (*init)(void **state, size_t n_slots);
+  void (*destroy)(void *state);
+
+  /* Count slot `page` (< n_slots): a page, or one chunk of a split page.
+   * out_bigrams is NULL when bigrams are disabled. On failure nothing is
+   * left allocated in the outputs. Called concurrently for different
+   * slots (opts.threads), so it may only touch per-slot state.
+   */
+  int (*count_page)(void *state,
+                    size_t page,
+                    const TokenList *filtered,
+                    const TokenList *raw,
+                    const StopwordList *sw,
+                    WordCountList *out_words,
+                    BigramCountList *out_bigrams);
+
+  /* Join the chunk slots [first, first + n) of page `page` into its page
+   * slot and release them; seams are the bigrams spanning two chunks
+   * (sorted by (w1, w2), no duplicates; NULL when bigrams are disabled).
+   * Required with lists_in_state; otherwise NULL and analyze.c combines
+   * the chunk lists and seams with merge. Called concurrently for
+   * different pages.
+   */
+  int (*join)(void *state, size_t page, size_t first, size_t n, const BigramCountList *seams);
+
+  /* Merge per-page lists into domain lists (page_bigrams/out_bigrams NULL
+   * when bigrams are disabled). Outputs are released with
+   * free_aggregated_word_counts / free_aggregated_bigram_counts.
+   */
+  int (*merge)(void *state,
+               const WordCountList *page_words,
+               const BigramCountList *page_bigrams,
+               size_t n_pages,
+               WordCountList *out_words,
+               BigramCountList *out_bigrams);
+
+  /* Top-K view of list `which` (count DESC, lexicographic tie-break);
+   * k == 0 means the full list. Called after merge. Returns 0 on
+   * failure (out of memory), *out is then empty.
+   */
+  int (*topk_words)(void *state, size_t which, const WordCountList *list, size_t k,
+                    WordCountList *out);
+  int (*topk_bigrams)(void *state, size_t which, const BigramCountList *list, size_t k,
+                      BigramCountList *out);
+
+  /* Fold domain and page results onto stems (options.stem), called after
+   * merge. Only used with lists_in_state; string lists are folded by
+   * analyze.c right after count_page.
+   */
+  int (*fold)(void *state, StemMemo *memo);
+
+  /* Document frequencies (options.tfidf), called after merge and fold:
+   * adds every page list to f and returns the Dict naming its IDs with
+   * lexicographic ranks. Only used with lists_in_state; string page
+   * lists are added by analyze.c.
+   */
+  int (*doc_freq)(void *state, IdDocFreq *f, const Dict **names, const uint32_t **rank_of_id);
+
+  /* AUTO cost prior (app/cost_model.h calibrates and refines it). NULL:
+   * engine is only used when requested explicitly.
+   */
+  const struct app_engine_cost *auto_cost;
+} app_engine_t;
+
+/* Cost prior of an engine in ns (single thread, bigrams on). Counting a
+ * unit of t raw tokens with d distinct words costs
+ *   per_token * t + per_distinct * d + per_lookup * t * d,
+ * merging E page-list entries into D domain entries
+ *   merge_per_entry * E + merge_per_lookup * E * D,
+ * plus per_request once.
+ */
+typedef struct app_engine_cost {
+  double per_token;         // filter + count, per raw token
+  double per_distinct;      // per distinct word of the unit
+  double per_lookup;        // linear lookups: per token x distinct word
+  double merge_per_entry;   // per page-list entry (words and bigrams)
+  double merge_per_lookup;  // linear merge: per entry x domain entry
+  double per_request;       // state setup and teardown
+} app_engine_cost_t;
+
+/* Top-K hook selector for the merged (domain) lists. */
+#define APP_ENGINE_DOMAIN ((size_t)-1)
+
+/* Registered engines, indexed by app_pipeline_t (index 0 = AUTO is empty). */
+size_t app_engine_count(void);
+const app_engine_t *app_engine_at(size_t i);
+
+/* Engine for an explicit selector; NULL for AUTO or unknown values. */
+const app_engine_t *app_engine_get(app_pipeline_t p);
+
+/* Default stages shared by most engines (linear merge, qsort-based Top-K). */
+int app_engine_merge_default(void *state,
+                             const WordCountList *page_words,
+                             const BigramCountList *page_bigrams,
+                             size_t n_pages,
+                             WordCountList *out_words,
+                             BigramCountList *out_bigrams);
+int app_engine_topk_words_default(void *state, size_t which,
+                                  const WordCountList *list, size_t k, WordCountList *out);
+int app_engine_topk_bigrams_default(void *state, size_t which,
+                                    const BigramCountList *list, size_t k, BigramCountList *out);
+
+/* Built-in engines (defined next to their pipeline entrypoints). */
+extern const app_engine_t app_engine_string;
+extern const app_engine_t app_engine_id;
+extern const app_engine_t app_engine_sort;
+extern const app_engine_t app_engine_art;
@@ -0,0 +1,124 @@
+#include "app/page_plan.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static int is_space(unsigned char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/* Next chunk end after `begin`: at least `chunk` bytes, then forward to
+ * whitespace (len when the rest has none).
+ */
+static size_t chunk_end(const char *text, size_t len, size_t begin, size_t chunk) {
+  if (len - begin <= chunk) return len;
+  size_t pos = begin + chunk;
+  while (pos < len && !is_space((unsigned char)text[pos])) pos++;
+  return pos;
+}
+
+/* Chunk size for one page (0: keep the page whole). */
+static size_t chunk_bytes_for(size_t len, unsigned threads, bool allow_split, const PagePlanLimits *lim) {
+  if (!allow_split || threads <= 1 || len <= lim->split_bytes) return 0;
+  size_t chunk = len / ((size_t)threads * PAGE_CHUNKS_PER_THREAD);
+  return chunk < lim->chunk_bytes ? lim->chunk_bytes : chunk;
+}
+
+static size_t count_chunks(const char *text, size_t len, size_t chunk) {
+  size_t n = 0;
+  for (size_t b = 0; b < len; b = chunk_end(text, len, b, chunk)) n++;
+  return n;
+}
+
+int page_plan_build(PagePlan *plan, const app_page_t *pages, size_t n_pages,
+                    unsigned threads, bool allow_split, const PagePlanLimits *lim) {
+  if (!plan) return 0;
+  memset(plan, 0, sizeof(*plan));
+
+  PagePlanLimits l = lim ? *lim : (PagePlanLimits){0};
+  if (!l.split_bytes) l.split_bytes = PAGE_SPLIT_BYTES;
+  if (!l.chunk_bytes) l.chunk_bytes = PAGE_CHUNK_BYTES;
+  if (!l.batch_bytes) l.batch_bytes = PAGE_BATCH_BYTES;
+
+  size_t *lens = (size_t*)malloc((n_pages ? n_pages : 1) * sizeof(size_t));
+  size_t *chunks = (size_t*)calloc(n_pages ? n_pages : 1, sizeof(size_t));
+  if (!lens || !chunks) goto fail;
+
+  /* Pass 1: sizes. A page without whitespace stays whole. */
+  size_t n_chunk_units = 0;
+  for (size_t i = 0; i < n_pages; i++) {
+    const char *t = pages[i].text ? pages[i].text : "";
+    lens[i] = strlen(t);
+    size_t cb = chunk_bytes_for(lens[i], threads, allow_split, &l);
+    if (cb) chunks[i] = count_chunks(t, lens[i], cb);
+    if (chunks[i] < 2) chunks[i] = 0;
+    if (chunks[i]) plan->n_splits++;
+    n_chunk_units += chunks[i];
+  }
+
+  size_t n_units = (n_pages - plan->n_splits) + n_chunk_units;
+  plan->units = (PageUnit*)malloc((n_units ? n_units : 1) * sizeof(PageUnit));
+  plan->tasks = (PageTask*)malloc((n_units ? n_units : 1) * sizeof(PageTask));
+  plan->task_bytes = (size_t*)malloc((n_units ? n_units : 1) * sizeof(size_t));
+  plan->splits = (PageSplit*)malloc((plan->n_splits ? plan->n_splits : 1) * sizeof(PageSplit));
+  if (!plan->units || !plan->tasks || !plan->task_bytes || !plan->splits) goto fail;
+
+  /* Pass 2: units in page order; chunks get one task each, whole pages
+   * are batched.
+   */
+  size_t slot = n_pages, s = 0;
+  PageTask *open = NULL;  // batch still taking pages
+  for (size_t i = 0; i < n_pages; i++) {
+    if (!chunks[i]) {
+      if (!open || open->bytes >= l.batch_bytes) {
+        if (open && open->n_units > 1) plan->batches++;
+        open = &plan->tasks[plan->n_tasks++];
+        *open = (PageTask){ .first_unit = plan->n_units };
+      }
+      plan->units[plan->n_units++] = (PageUnit){ i, i, PAGE_NO_SPLIT, 0, lens[i] };
+      open->n_units++;
+      open->bytes += lens[i];
+      continue;
+    }
+
+    /* Batches hold consecutive units only. */
+    if (open && open->n_units > 1) plan->batches++;
+    open = NULL;
+
+    const char *t = pages[i].text;
+    size_t cb = chunk_bytes_for(lens[i], threads, allow_split, &l);
+    plan->splits[s] = (PageSplit){ i, slot, chunks[i] };
+    for (size_t b = 0; b < lens[i];) {
+      size_t e = chunk_end(t, lens[i], b, cb);
+      plan->units[plan->n_units] = (PageUnit){ i, slot++, s, b, e };
+      plan->tasks[plan->n_tasks++] = (PageTask){ plan->n_units, 1, e - b };
+      plan->n_units++;
+      b = e;
+    }
+    s++;
+  }
+  if (open && open->n_units > 1) plan->batches++;
+  plan->n_slots = slot;
+
+  /* Empty pages still cost a little. */
+  for (size_t k = 0; k < plan->n_tasks; k++) plan->task_bytes[k] = plan->tasks[k].bytes + 1;
+
+  free(lens);
+  free(chunks);
+  return 1;
+
+fail:
+  free(lens);
+  free(chunks);
+  page_plan_free(plan);
+  return 0;
+}
+
+void page_plan_free(PagePlan *plan) {
+  if (!plan) return;
+  free(plan->units);
+  free(plan->tasks);
+  free(plan->task_bytes);
+  free(plan->splits);
+  memset(plan, 0, sizeof(*plan));
+}
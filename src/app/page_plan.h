@@ -0,0 +1,81 @@
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "app/analyze.h"
+
+/*
+ * Task plan for the page stage (app/workers.h schedules the tasks).
+ *
+ * Pages larger than split_bytes are cut into chunks of about
+ * len / (threads * PAGE_CHUNKS_PER_THREAD) bytes (at least chunk_bytes),
+ * each boundary moved forward to the next ASCII whitespace so no token
+ * is cut. Chunks are counted into their own slots after the n_pages page
+ * slots and joined into the page afterwards. Consecutive unsplit pages
+ * are batched into one task until batch_bytes are collected, so many
+ * tiny pages do not pay one scheduling round each. Units and tasks stay
+ * in page order.
+ */
+#ifndef PAGE_SPLIT_BYTES
+#define PAGE_SPLIT_BYTES ((size_t)256 * 1024)
+#endif
+#ifndef PAGE_CHUNK_BYTES
+#define PAGE_CHUNK_BYTES ((size_t)64 * 1024)
+#endif
+#ifndef PAGE_BATCH_BYTES
+#define PAGE_BATCH_BYTES ((size_t)64 * 1024)
+#endif
+#define PAGE_CHUNKS_PER_THREAD 4
+
+#define PAGE_NO_SPLIT ((size_t)-1)
+
+/* Size limits; 0 fields select the PAGE_* defaults. */
+typedef struct {
+  size_t split_bytes;
+  size_t chunk_bytes;
+  size_t batch_bytes;
+} PagePlanLimits;
+
+/* A byte span of one page counted into one slot. */
+typedef struct {
+  size_t page;
+  size_t slot;    // == page, or a chunk slot >= n_pages
+  size_t split;   // index into splits, PAGE_NO_SPLIT for whole pages
+  size_t begin;
+  size_t end;
+} PageUnit;
+
+/* Consecutive units run by one task. */
+typedef struct {
+  size_t first_unit;
+  size_t n_units;
+  size_t bytes;   // scheduler weight
+} PageTask;
+
+/* A split page: its chunks use slots [first_slot, first_slot + n_chunks). */
+typedef struct {
+  size_t page;
+  size_t first_slot;
+  size_t n_chunks;
+} PageSplit;
+
+typedef struct {
+  PageUnit *units;
+  size_t n_units;
+  PageTask *tasks;
+  size_t n_tasks;
+  size_t *task_bytes;   // tasks[i].bytes, as a weights array
+  PageSplit *splits;
+  size_t n_splits;
+  size_t n_slots;       // n_pages + chunks
+  size_t batches;       // tasks holding more than one page
+} PagePlan;
+
+/*
+ * Build the plan. Pages are only split with threads > 1 and allow_split
+ * (sampling tokenizes whole pages). lim may be NULL. 0 on OOM.
+ */
+int page_plan_build(PagePlan *plan, const app_page_t *pages, size_t n_pages,
+                    unsigned threads, bool allow_split, const PagePlanLimits *lim);
+
+void page_plan_free(PagePlan *plan);
@@ -0,0 +1,114 @@
+#include "app/pipeline_art.h"
+#include "app/engine.h"
+
+#include "core/art.h"
+#include "core/aggregate.h"
+#include "core/bigram_aggregate.h"
+#include "view/topk.h"
+
+int analyze_art_pipeline(
+  const TokenList *filtered,
+  const TokenList *raw,
+  bool include_bigrams,
+  const StopwordList *sw,
+  WordCountList *out_words,
+  BigramCountList *out_bigrams
+) {
+  if (!filtered || !out_words) return 0;
+
+  *out_words = (WordCountList){0};
+  if (out_bigrams) *out_bigrams = (BigramCountList){0};
+
+  /* ART pipeline: no token -> id dictionary, the trees are keyed by the
+   * strings themselves (shared prefixes stored once).
+   */
+
+  /* Words are counted from filtered tokens (stopwords/short/digits removed). */
+  if (!art_count_words(filtered, out_words)) {
+    free_word_counts(out_words);
+    return 0;
+  }
+
+  /* Bigrams are counted from raw tokens with stopword rules.
+   * No bridging: ignored tokens reset adjacency (see art.c).
+   */
+  if (include_bigrams && out_bigrams) {
+    if (!raw || !sw) {
+      free_word_counts(out_words);
+      return 0;
+    }
+
+    if (!art_count_bigrams_excluding_stopwords(raw, sw, out_bigrams)) {
+      free_word_counts(out_words);
+      free_bigram_counts(out_bigrams);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static int art_count_page(void *state,
+                          size_t page,
+                          const TokenList *filtered,
+                          const TokenList *raw,
+                          const StopwordList *sw,
+                          WordCountList *out_words,
+                          BigramCountList *out_bigrams) {
+  (void)state;
+  (void)page;
+  return analyze_art_pipeline(filtered, raw, out_bigrams != NULL, sw, out_words, out_bigrams);
+}
+
+/* Page lists are sorted by key; a k-way merge keeps the domain lists
+ * sorted as well, so every list reaching Top-K is in tie-break order.
+ */
+static int art_merge(void *state,
+                     const WordCountList *page_words,
+                     const BigramCountList *page_bigrams,
+                     size_t n_pages,
+                     WordCountList *out_words,
+                     BigramCountList *out_bigrams) {
+  (void)state;
+  *out_words = aggregate_word_counts_sorted(page_words, n_pages);
+  if (out_bigrams) {
+    *out_bigrams = page_bigrams ? aggregate_bigram_counts_sorted(page_bigrams, n_pages)
+                                : (BigramCountList){0};
+  }
+  return 1;
+}
+
+static int art_topk_words(void *state, size_t which,
+                          const WordCountList *list, size_t k, WordCountList *out) {
+  (void)state;
+  (void)which;
+  *out = top_k_words_lexsorted(list, (k == 0 && list) ? list->count : k);
+  return out->items || !list || list->count == 0;
+}
+
+static int art_topk_bigrams(void *state, size_t which,
+                            const BigramCountList *list, size_t k, BigramCountList *out) {
+  (void)state;
+  (void)which;
+  *out = top_k_bigrams_lexsorted(list, (k == 0 && list) ? list->count : k);
+  return out->items || !list || list->count == 0;
+}
+
+/* Trie per page; the k-way merge costs a heap step per entry. */
+static const app_engine_cost_t art_cost = {
+  .per_token = 5100.0,
+  .merge_per_entry = 300.0,
+};
+
+const app_engine_t app_engine_art = {
+  .name = "art",
+  .fail_status = 33,
+  .fail_message = "ART pipeline failed (out of memory?)",
+  .lists_lexsorted = true,
+  .small_pages = true,
+  .count_page = art_count_page,
+  .merge = art_merge,
+  .topk_words = art_topk_words,
+  .topk_bigrams = art_topk_bigrams,
+  .auto_cost = &art_cost,
+};
@@ -1,8 +1,14 @@
 #include "app/pipeline_id.h"
+#include "app/engine.h"
+#include "app/scratch.h"
 
 #include "core/dict.h"
 #include "core/id_freq.h"
 #include "core/id_bigrams.h"
+#include "view/topk.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 int analyze_id_pipeline(
   const TokenList *filtered,
@@ -52,3 +58,383 @@ int analyze_id_pipeline(
   dict_free(&dict);
   return 1;
 }
+
+/* ---------- Engine: results stay in ID space ----------
+ *
+ * Dictionaries and counting tables come from the calling thread's
+ * Scratch (app/scratch.h) and go back to it reset, so a thread that
+ * analyzes one request after another reuses them.
+ */
+
+/* One counted page: page-local IDs until merge remaps them to domain IDs. */
+typedef struct {
+  Dict dict;
+  bool dict_live;
+  IdCountList words;
+  IdPairCountList bigrams;
+} IdPage;
+
+typedef struct {
+  IdPage *pages;          // pages, then chunk slots of split pages
+  size_t n_slots;
+  size_t n_pages;         // slots that are pages (set by merge)
+
+  Dict dict;              // domain vocabulary (after merge)
+  bool dict_live;
+  IdCountList words;      // domain lists (after merge)
+  IdPairCountList bigrams;
+  Dict *names;            // words behind the IDs: &dict, or the stems after fold
+  uint32_t *rank_of_id;   // lexicographic ranks, built on first Top-K
+} IdEngine;
+
+static void id_page_free(IdPage *p) {
+  if (p->dict_live) scratch_dict_give(scratch_get(), &p->dict);
+  p->dict_live = false;
+  free_id_counts(&p->words);
+  free_id_pair_counts(&p->bigrams);
+}
+
+static int id_init(void **state, size_t n_slots) {
+  IdEngine *e = (IdEngine*)calloc(1, sizeof(IdEngine));
+  if (!e) return 0;
+  e->pages = (IdPage*)calloc(n_slots ? n_slots : 1, sizeof(IdPage));
+  if (!e->pages) { free(e); return 0; }
+  e->n_slots = n_slots;
+  e->n_pages = n_slots;
+  *state = e;
+  return 1;
+}
+
+static void id_destroy(void *state) {
+  IdEngine *e = (IdEngine*)state;
+  if (!e) return;
+  for (size_t i = 0; i < e->n_slots; i++) id_page_free(&e->pages[i]);
+  free(e->pages);
+  if (e->dict_live) scratch_dict_give(scratch_get(), &e->dict);
+  free_id_counts(&e->words);
+  free_id_pair_counts(&e->bigrams);
+  free(e->rank_of_id);
+  free(e);
+}
+
+/* Counts stay as (id, count) arrays; the string lists remain empty. */
+static int id_count_page(void *state,
+                         size_t page,
+                         const TokenList *filtered,
+                         const TokenList *raw,
+                         const StopwordList *sw,
+                         WordCountList *out_words,
+                         BigramCountList *out_bigrams) {
+  IdEngine *e = (IdEngine*)state;
+  if (!e || page >= e->n_slots || !filtered || !out_words) return 0;
+
+  *out_words = (WordCountList){0};
+  if (out_bigrams) *out_bigrams = (BigramCountList){0};
+
+  IdPage *p = &e->pages[page];
+  Scratch *s = scratch_get();
+  size_t hint = filtered->count + (raw ? raw->count : 0);
+  if (!scratch_dict_take(s, &p->dict, hint * 2 + 16)) return 0;
+  p->dict_live = true;
+
+  if (!id_count_word_ids(filtered, &p->dict, s ? &s->freq : NULL, &p->words)) goto fail;
+  if (out_bigrams) {
+    if (!raw || !sw) goto fail;
+    if (!id_count_bigram_ids(raw, sw, &p->dict, s ? &s->pairs : NULL, &p->bigrams)) goto fail;
+  }
+  return 1;
+
+fail:
+  id_page_free(p);
+  return 0;
+}
+
+/* Tokens per batched dict lookup round while remapping page IDs. */
+#define ID_MERGE_CHUNK 64
+
+/* Rewrite a page's IDs to domain IDs; the page dict is released. */
+static int id_remap_page(Dict *domain, IdPage *p) {
+  size_t v = dict_size(&p->dict);
+  uint32_t *map = (uint32_t*)malloc((v + 1) * sizeof(uint32_t));
+  if (!map) return 0;
+  map[0] = 0;
+
+  const char *chunk[ID_MERGE_CHUNK];
+  for (size_t base = 0; base < v; base += ID_MERGE_CHUNK) {
+    size_t c = v - base < ID_MERGE_CHUNK ? v - base : ID_MERGE_CHUNK;
+    for (size_t j = 0; j < c; j++) chunk[j] = dict_word(&p->dict, (uint32_t)(base + j + 1));
+    if (!dict_get_or_add_batch(domain, chunk, c, map + base + 1)) { free(map); return 0; }
+  }
+
+  for (size_t i = 0; i < p->words.count; i++) {
+    p->words.items[i].id = map[p->words.items[i].id];
+  }
+  for (size_t i = 0; i < p->bigrams.count; i++) {
+    p->bigrams.items[i].id1 = map[p->bigrams.items[i].id1];
+    p->bigrams.items[i].id2 = map[p->bigrams.items[i].id2];
+  }
+
+  free(map);
+  scratch_dict_give(scratch_get(), &p->dict);
+  p->dict_live = false;
+  return 1;
+}
+
+/* Leave the scratch tables empty again, or release the temporary ones. */
+static void id_sum_done(Scratch *s, IdFreq *wf, IdBigrams *bg, size_t n_ids) {
+  if (s) {
+    idfreq_clear(wf, n_ids);
+    if (bg) idbigrams_clear(bg);
+  } else {
+    idfreq_free(wf);
+    if (bg) idbigrams_free(bg);
+  }
+}
+
+/* Sum pages into one ID space: the first page's dict becomes `dict`
+ * (its IDs already match); later pages are remapped into it. Seam
+ * bigrams (string pairs) are added on top. Used for the domain (merge)
+ * and for the chunks of a split page (join).
+ */
+static int id_sum_pages(Dict *dict, bool *dict_live, IdPage *pages, size_t n,
+                        bool with_bigrams, const BigramCountList *seams,
+                        IdCountList *out_words, IdPairCountList *out_bigrams) {
+  Scratch *s = scratch_get();
+  IdFreq lf = {0}, *wf = s ? &s->freq : &lf;
+  IdBigrams lb = {0}, *bg = s ? &s->pairs : &lb;
+  bool bg_live = false;
+
+  size_t n_words = 0, n_pairs = seams ? seams->count : 0;
+  for (size_t i = 0; i < n; i++) {
+    n_words += pages[i].words.count;
+    n_pairs += pages[i].bigrams.count;
+  }
+  if (!idfreq_prepare(wf, n_words)) return 0;
+  if (with_bigrams) {
+    if (!idbigrams_prepare(bg, n_pairs * 2 + 64)) goto fail;
+    bg_live = true;
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    IdPage *p = &pages[i];
+    if (!*dict_live) {
+      if (p->dict_live) {
+        *dict = p->dict;
+        p->dict_live = false;
+      } else if (!scratch_dict_take(s, dict, 1024)) {
+        goto fail;
+      }
+      *dict_live = true;
+    } else if (p->dict_live) {
+      if (!id_remap_page(dict, p)) goto fail;
+    }
+
+    for (size_t j = 0; j < p->words.count; j++) {
+      const IdCount *ic = &p->words.items[j];
+      if (!idfreq_ensure(wf, ic->id)) goto fail;
+      wf->counts[ic->id - 1] += ic->count;
+    }
+    if (bg_live) {
+      for (size_t j = 0; j < p->bigrams.count; j++) {
+        const IdPairCount *pc = &p->bigrams.items[j];
+        if (!idbigrams_add(bg, pc->id1, pc->id2, pc->count)) goto fail;
+      }
+    }
+  }
+  if (!*dict_live) {
+    if (!scratch_dict_take(s, dict, 16)) goto fail;
+    *dict_live = true;
+  }
+
+  for (size_t i = 0; bg_live && seams && i < seams->count; i++) {
+    uint32_t id1 = dict_get_or_add(dict, seams->items[i].w1);
+    uint32_t id2 = dict_get_or_add(dict, seams->items[i].w2);
+    if (!id1 || !id2) goto fail;
+    uint32_t c = seams->items[i].count > UINT32_MAX ? UINT32_MAX : (uint32_t)seams->items[i].count;
+    if (!idbigrams_add(bg, id1, id2, c)) goto fail;
+  }
+
+  /* Collect words (ascending id), sized once. */
+  uint32_t n_ids = (uint32_t)dict_size(dict);
+  size_t distinct = 0;
+  for (uint32_t id = 1; id <= n_ids; id++) {
+    if (idfreq_get(wf, id)) distinct++;
+  }
+  if (distinct > 0) {
+    out_words->items = (IdCount*)malloc(distinct * sizeof(IdCount));
+    if (!out_words->items) goto fail;
+  }
+  for (uint32_t id = 1; id <= n_ids; id++) {
+    uint32_t c = idfreq_get(wf, id);
+    if (!c) continue;
+    out_words->items[out_words->count].id = id;
+    out_words->items[out_words->count].count = c;
+    out_words->count++;
+  }
+  if (bg_live && !idbigrams_collect(bg, out_bigrams)) goto fail;
+
+  id_sum_done(s, wf, bg_live ? bg : NULL, n_ids);
+  return 1;
+
+fail:
+  id_sum_done(s, wf, bg_live ? bg : NULL, *dict_live ? dict_size(dict) : 0);
+  free_id_counts(out_words);
+  free_id_pair_counts(out_bigrams);
+  return 0;
+}
+
+/* Chunk slots are summed into a fresh page dict; the page slot (empty,
+ * split pages are never counted as a whole) takes the result.
+ */
+static int id_join(void *state, size_t page, size_t first, size_t n, const BigramCountList *seams) {
+  IdEngine *e = (IdEngine*)state;
+  if (!e || page >= e->n_slots || first + n > e->n_slots) return 0;
+
+  IdPage *p = &e->pages[page];
+  id_page_free(p);
+  bool with_bigrams = seams != NULL;
+  int ok = id_sum_pages(&p->dict, &p->dict_live, &e->pages[first], n, with_bigrams,
+                        seams, &p->words, &p->bigrams);
+  for (size_t i = first; i < first + n; i++) id_page_free(&e->pages[i]);
+  if (!ok) id_page_free(p);
+  return ok;
+}
+
+/* Domain lists in ID space (see id_sum_pages). */
+static int id_merge(void *state,
+                    const WordCountList *page_words,
+                    const BigramCountList *page_bigrams,
+                    size_t n_pages,
+                    WordCountList *out_words,
+                    BigramCountList *out_bigrams) {
+  (void)page_words;
+  (void)page_bigrams;
+  IdEngine *e = (IdEngine*)state;
+  if (!e || n_pages > e->n_slots || !out_words) return 0;
+
+  *out_words = (WordCountList){0};
+  if (out_bigrams) *out_bigrams = (BigramCountList){0};
+
+  e->n_pages = n_pages;
+  if (!id_sum_pages(&e->dict, &e->dict_live, e->pages, n_pages, out_bigrams != NULL,
+                    NULL, &e->words, &e->bigrams)) {
+    return 0;
+  }
+  e->names = &e->dict;
+  return 1;
+}
+
+/* Domain IDs -> stem IDs: every distinct word is stemmed once (memo),
+ * then all lists are folded with the table; no token is revisited.
+ */
+static int id_fold(void *state, StemMemo *memo) {
+  IdEngine *e = (IdEngine*)state;
+  if (!e || !memo || !e->dict_live) return 0;
+
+  uint32_t *map = stem_memo_map_dict(memo, &e->dict);
+  uint32_t *slot = (uint32_t*)calloc(dict_size(&memo->stems) + 1, sizeof(uint32_t));
+  if (!map || !slot) {
+    free(map);
+    free(slot);
+    return 0;
+  }
+
+  int ok = 1;
+  id_counts_fold(&e->words, map, slot);
+  ok = ok && id_pairs_fold(&e->bigrams, map);
+  for (size_t i = 0; ok && i < e->n_pages; i++) {
+    id_counts_fold(&e->pages[i].words, map, slot);
+    ok = id_pairs_fold(&e->pages[i].bigrams, map);
+  }
+  free(map);
+  free(slot);
+  if (!ok) return 0;
+
+  /* Ranks belong to the naming Dict. */
+  free(e->rank_of_id);
+  e->rank_of_id = NULL;
+  e->names = &memo->stems;
+  return 1;
+}
+
+/* Lexicographic ranks of the domain vocabulary, computed once per request. */
+static const uint32_t *id_ranks(IdEngine *e) {
+  if (!e->dict_live || !e->names) return NULL;
+  if (!e->rank_of_id) e->rank_of_id = topk_dict_ranks(e->names);
+  return e->rank_of_id;
+}
+
+/* Page lists are in domain (or stem) IDs after merge; one pass each. */
+static int id_doc_freq(void *state, IdDocFreq *f, const Dict **names, const uint32_t **rank_of_id) {
+  IdEngine *e = (IdEngine*)state;
+  const uint32_t *rank = e ? id_ranks(e) : NULL;
+  if (!rank || !f || !names || !rank_of_id) return 0;
+
+  for (size_t i = 0; i < e->n_pages; i++) {
+    if (!iddf_add_page(f, &e->pages[i].words)) return 0;
+  }
+  *names = e->names;
+  *rank_of_id = rank;
+  return 1;
+}
+
+/* Ranks or the view failing on a non-empty list is out of memory. */
+static int id_topk_words(void *state, size_t which,
+                         const WordCountList *list, size_t k, WordCountList *out) {
+  (void)list;
+  IdEngine *e = (IdEngine*)state;
+  *out = (WordCountList){0};
+  if (!e) return 0;
+
+  const IdCountList *ids = NULL;
+  if (which == APP_ENGINE_DOMAIN) ids = &e->words;
+  else if (which < e->n_pages) ids = &e->pages[which].words;
+  if (!ids || ids->count == 0) return 1;
+
+  const uint32_t *rank = id_ranks(e);
+  if (!rank) return 0;
+  *out = top_k_word_ids(e->names, rank, ids, k ? k : ids->count);
+  return out->items != NULL;
+}
+
+static int id_topk_bigrams(void *state, size_t which,
+                           const BigramCountList *list, size_t k, BigramCountList *out) {
+  (void)list;
+  IdEngine *e = (IdEngine*)state;
+  *out = (BigramCountList){0};
+  if (!e) return 0;
+
+  const IdPairCountList *ids = NULL;
+  if (which == APP_ENGINE_DOMAIN) ids = &e->bigrams;
+  else if (which < e->n_pages) ids = &e->pages[which].bigrams;
+  if (!ids || ids->count == 0) return 1;
+
+  const uint32_t *rank = id_ranks(e);
+  if (!rank) return 0;
+  *out = top_k_bigram_ids(e->names, rank, ids, k ? k : ids->count);
+  return out->items != NULL;
+}
+
+/* Dict/table setup once per request; the merge remaps IDs by hash. */
+static const app_engine_cost_t id_cost = {
+  .per_token = 5000.0,
+  .merge_per_entry = 100.0,
+  .per_request = 20000.0,
+};
+
+const app_engine_t app_engine_id = {
+  .name = "id",
+  .fail_status = 30,
+  .fail_message = "ID pipeline failed (out of memory?)",
+  .lists_in_state = true,
+  .init = id_init,
+  .destroy = id_destroy,
+  .count_page = id_count_page,
+  .join = id_join,
+  .merge = id_merge,
+  .topk_words = id_topk_words,
+  .topk_bigrams = id_topk_bigrams,
+  .fold = id_fold,
+  .doc_freq = id_doc_freq,
+  .auto_cost = &id_cost,
+};
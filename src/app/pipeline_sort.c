@@ -0,0 +1,86 @@
+#include "app/pipeline_sort.h"
+#include "app/engine.h"
+
+#include "core/dict.h"
+#include "core/id_sort.h"
+
+int analyze_sort_pipeline(
+  const TokenList *filtered,
+  const TokenList *raw,
+  bool include_bigrams,
+  const StopwordList *sw,
+  WordCountList *out_words,
+  BigramCountList *out_bigrams
+) {
+  if (!filtered || !out_words) return 0;
+
+  *out_words = (WordCountList){0};
+  if (out_bigrams) *out_bigrams = (BigramCountList){0};
+
+  /* Sort-based pipeline: Dict still maps tokens to IDs (shared by words
+   * and bigrams); counting itself is sort + run-length encoding.
+   */
+  Dict dict;
+  size_t hint = filtered->count + (raw ? raw->count : 0);
+  if (!dict_init(&dict, hint * 2 + 16)) return 0;
+
+  /* Words are counted from filtered tokens (stopwords/short/digits removed). */
+  if (!sort_count_words(filtered, &dict, out_words)) {
+    dict_free(&dict);
+    free_word_counts(out_words);
+    return 0;
+  }
+
+  /* Bigrams are counted from raw tokens with stopword rules.
+   * No bridging: ignored tokens reset adjacency (see id_sort.c).
+   */
+  if (include_bigrams && out_bigrams) {
+    if (!raw || !sw) {
+      dict_free(&dict);
+      free_word_counts(out_words);
+      return 0;
+    }
+
+    if (!sort_count_bigrams_excluding_stopwords(raw, sw, &dict, out_bigrams)) {
+      dict_free(&dict);
+      free_word_counts(out_words);
+      free_bigram_counts(out_bigrams);
+      return 0;
+    }
+  }
+
+  dict_free(&dict);
+  return 1;
+}
+
+static int sort_count_page(void *state,
+                           size_t page,
+                           const TokenList *filtered,
+                           const TokenList *raw,
+                           const StopwordList *sw,
+                           WordCountList *out_words,
+                           BigramCountList *out_bigrams) {
+  (void)state;
+  (void)page;
+  return analyze_sort_pipeline(filtered, raw, out_bigrams != NULL, sw, out_words, out_bigrams);
+}
+
+/* Dict + sort per page; lists go through the linear default merge. */
+static const app_engine_cost_t sort_cost = {
+  .per_token = 5300.0,
+  .per_distinct = 40.0,
+  .merge_per_entry = 60.0,
+  .merge_per_lookup = 2.5,
+};
+
+const app_engine_t app_engine_sort = {
+  .name = "sort",
+  .fail_status = 32,
+  .fail_message = "Sort pipeline failed (out of memory?)",
+  .small_pages = true,
+  .count_page = sort_count_page,
+  .merge = app_engine_merge_default,
+  .topk_words = app_engine_topk_words_default,
+  .topk_bigrams = app_engine_topk_bigrams_default,
+  .auto_cost = &sort_cost,
+};
@@ -1,4 +1,7 @@
 #include "app/pipeline_string.h"
+#include "app/engine.h"
+
+#include "core/cancel.h"
 
 int analyze_string_pipeline(
   const TokenList *filtered,
@@ -12,7 +15,7 @@ int analyze_string_pipeline(
 
   /* Baseline string-based pipeline:
    * - words counted via linear string comparison
-   * - suitable for small inputs (AUTO may switch to ID for larger ones)
+   * - AUTO default; the cost model switches for many or large pages
    */
   *out_words = count_words(filtered);
 
@@ -26,5 +29,46 @@ int analyze_string_pipeline(
     *out_bigrams = (BigramCountList){0};
   }
 
+  /* Cut short by the deadline (core/cancel.h): lists are incomplete. */
+  if (cancel_requested()) {
+    free_word_counts(out_words);
+    if (out_bigrams) free_bigram_counts(out_bigrams);
+    return 0;
+  }
+
   return 1;
 }
+
+static int string_count_page(void *state,
+                             size_t page,
+                             const TokenList *filtered,
+                             const TokenList *raw,
+                             const StopwordList *sw,
+                             WordCountList *out_words,
+                             BigramCountList *out_bigrams) {
+  (void)state;
+  (void)page;
+  return analyze_string_pipeline(filtered, raw, out_bigrams != NULL, sw, out_words, out_bigrams);
+}
+
+/* Linear string lookups: no setup cost, but counting grows with tokens x
+ * distinct words and the linear merge with entries x domain entries.
+ */
+static const app_engine_cost_t string_cost = {
+  .per_token = 5100.0,
+  .per_lookup = 2.0,
+  .merge_per_entry = 60.0,
+  .merge_per_lookup = 2.5,
+};
+
+const app_engine_t app_engine_string = {
+  .name = "string",
+  .fail_status = 31,
+  .fail_message = "String pipeline failed (out of memory?)",
+  .small_pages = true,
+  .count_page = string_count_page,
+  .merge = app_engine_merge_default,
+  .topk_words = app_engine_topk_words_default,
+  .topk_bigrams = app_engine_topk_bigrams_default,
+  .auto_cost = &string_cost,
+};
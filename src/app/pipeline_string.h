@@ -14,7 +14,7 @@
  *   (original adjacency, no bridging over ignored tokens).
  *
  * Used directly when APP_PIPELINE_STRING is selected or when AUTO
- * chooses the string pipeline (typically for smaller inputs).
+ * chooses the string pipeline (default; app/cost_model.h).
  */
 int analyze_string_pipeline(
   const TokenList *filtered,
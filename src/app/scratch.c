@@ -0,0 +1,138 @@
+#include "app/scratch.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+static pthread_once_t g_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_key;
+static int g_key_ok;
+
+static void scratch_destroy(void *p) {
+  Scratch *s = (Scratch*)p;
+  if (!s) return;
+  arena_free(&s->strings);
+  arena_free(&s->tokens);
+  stopwords_free(&s->sw);
+  free(s->sw_path);
+  idfreq_free(&s->freq);
+  idbigrams_free(&s->pairs);
+  for (size_t i = 0; i < s->n_dicts; i++) dict_free(&s->dicts[i]);
+  small_count_tables_free(s->small);
+  free(s);
+}
+
+static void key_init(void) {
+  g_key_ok = pthread_key_create(&g_key, scratch_destroy) == 0;
+}
+
+Scratch *scratch_get(void) {
+  pthread_once(&g_once, key_init);
+  if (!g_key_ok) return NULL;
+
+  Scratch *s = (Scratch*)pthread_getspecific(g_key);
+  if (s) return s;
+  s = (Scratch*)calloc(1, sizeof(Scratch));
+  if (!s) return NULL;
+  arena_init(&s->strings);
+  arena_init(&s->tokens);
+  if (pthread_setspecific(g_key, s) != 0) {
+    free(s);
+    return NULL;
+  }
+  return s;
+}
+
+Scratch *scratch_begin(void) {
+  Scratch *s = scratch_get();
+  if (!s || s->in_request) return NULL;
+  s->in_request = true;
+  s->requests++;
+  arena_mark(&s->strings);
+  arena_mark(&s->tokens);
+  return s;
+}
+
+/* Rewind; an arena whose kept block is still above the limit goes. */
+static void arena_trim(Scratch *s, Arena *a) {
+  arena_reset(a);
+  if (a->reserved > SCRATCH_KEEP_BYTES) {
+    arena_free(a);
+    s->trims++;
+  }
+}
+
+void scratch_end(Scratch *s) {
+  if (!s) return;
+  arena_trim(s, &s->strings);
+  arena_trim(s, &s->tokens);
+  if (s->freq.cap * sizeof(uint32_t) > SCRATCH_KEEP_BYTES) {
+    idfreq_free(&s->freq);
+    s->trims++;
+  }
+  if (s->pairs.cap * s->pairs.key_bytes > SCRATCH_KEEP_BYTES) {
+    idbigrams_free(&s->pairs);
+    s->trims++;
+  }
+  s->in_request = false;
+}
+
+const StopwordList *scratch_stopwords(Scratch *s, const char *path) {
+  if (!s || !path) return NULL;
+  if (s->sw_path && strcmp(s->sw_path, path) == 0) return &s->sw;
+
+  /* The path outlives the request: heap, not the bound arena. */
+  size_t n = strlen(path);
+  char *p = (char*)malloc(n + 1);
+  if (!p) return NULL;
+  memcpy(p, path, n + 1);
+
+  StopwordList sw = {0};
+  if (stopwords_load(&sw, path) != 0) {
+    free(p);
+    return NULL;
+  }
+  stopwords_free(&s->sw);
+  free(s->sw_path);
+  s->sw = sw;
+  s->sw_path = p;
+  return &s->sw;
+}
+
+static size_t dict_bytes(const Dict *d) {
+  return d->cap * sizeof(DictEntry) + d->id_cap * sizeof(char*);
+}
+
+int scratch_dict_take(Scratch *s, Dict *d, size_t initial_cap) {
+  if (!s || s->n_dicts == 0) return dict_init(d, initial_cap);
+
+  /* Smallest table that fits initial_cap, else the largest one. */
+  size_t best = 0;
+  for (size_t i = 1; i < s->n_dicts; i++) {
+    size_t bc = s->dicts[best].cap, ic = s->dicts[i].cap;
+    bool fits_i = ic >= initial_cap, fits_b = bc >= initial_cap;
+    if (fits_i ? (!fits_b || ic < bc) : (!fits_b && ic > bc)) best = i;
+  }
+  *d = s->dicts[best];
+  s->dicts[best] = s->dicts[--s->n_dicts];
+  return 1;
+}
+
+void scratch_dict_give(Scratch *s, Dict *d) {
+  if (!d || !d->entries) return;
+  bool oversized = dict_bytes(d) > SCRATCH_KEEP_BYTES;
+  if (!s || s->n_dicts == SCRATCH_MAX_DICTS || oversized) {
+    if (s && oversized) s->trims++;
+    dict_free(d);
+    return;
+  }
+  dict_reset(d);
+  s->dicts[s->n_dicts++] = *d;
+  memset(d, 0, sizeof(*d));
+}
+
+SmallCountTables *scratch_small_tables(Scratch *s) {
+  if (!s) return NULL;
+  if (!s->small) s->small = small_count_tables_new();
+  return s->small;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "core/arena.h"
+#include "core/dict.h"
+#include "core/id_freq.h"
+#include "core/id_bigrams.h"
+#include "core/small_count.h"
+#include "core/stopwords.h"
+
+/*
+ * Per-thread scratch state kept across requests.
+ *
+ * A server thread analyzes one request after another. Instead of
+ * building and tearing down its arenas, stopword list and counting
+ * tables every time, it keeps them in a Scratch and resets them:
+ * arenas rewind, dictionaries advance their generation (core/dict.h),
+ * counting tables clear only what was used. After each request,
+ * anything that grew beyond SCRATCH_KEEP_BYTES is released (high-water
+ * trim), so one huge request does not pin its memory for good.
+ *
+ * Page-stage helper threads are started per request; their Scratch is
+ * released when they exit.
+ */
+#ifndef SCRATCH_KEEP_BYTES
+#define SCRATCH_KEEP_BYTES ((size_t)4 * 1024 * 1024)
+#endif
+#define SCRATCH_MAX_DICTS 16
+
+typedef struct {
+  bool in_request;     // strings/tokens are in use (scratch_begin .. end)
+  Arena strings;       // strings of the request (and of worker 0)
+  Arena tokens;        // tokens of the unit worker 0 is counting
+
+  StopwordList sw;     // last loaded list, for sw_path
+  char *sw_path;
+
+  IdFreq freq;         // page word counts (empty between calls)
+  IdBigrams pairs;     // page bigram counts (empty between calls)
+  Dict dicts[SCRATCH_MAX_DICTS];  // reset dictionaries ready for reuse
+  size_t n_dicts;
+  SmallCountTables *small;        // small_count_page tables, on first use
+
+  size_t requests;     // requests served from this scratch
+  size_t trims;        // tables/arenas released by the trim
+} Scratch;
+
+/* Scratch of the calling thread, created on first use (NULL on OOM). */
+Scratch *scratch_get(void);
+
+/*
+ * Claim the calling thread's arenas for one request: NULL when they are
+ * already in use (nested request) or on OOM; the caller then uses
+ * arenas of its own. Pair with scratch_end.
+ */
+Scratch *scratch_begin(void);
+
+/* Rewind the arenas and apply the high-water trim. */
+void scratch_end(Scratch *s);
+
+/* Stopword list for path, loaded once per thread and path (NULL on error). */
+const StopwordList *scratch_stopwords(Scratch *s, const char *path);
+
+/* A reset dictionary from the pool, or a new one with initial_cap. 0 on OOM. */
+int scratch_dict_take(Scratch *s, Dict *d, size_t initial_cap);
+
+/* Reset d and keep it for reuse (released when the pool is full). */
+void scratch_dict_give(Scratch *s, Dict *d);
+
+/* The thread's small_count_page tables (NULL on OOM: the call allocates). */
+SmallCountTables *scratch_small_tables(Scratch *s);
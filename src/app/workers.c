@@ -0,0 +1,199 @@
+#include "app/workers.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Unclaimed tasks [head, tail) of one worker; the owner takes from the
+ * front, thieves cut off the back half.
+ */
+typedef struct {
+  pthread_mutex_t lock;
+  size_t head;
+  size_t tail;
+} WorkersRange;
+
+typedef struct {
+  workers_fn fn;
+  void *ctx;
+  unsigned n_threads;
+  WorkersRange ranges[WORKERS_MAX];
+  atomic_int failed;      // set by the first failing task
+  atomic_size_t steals;
+  WorkersStats *stats;    // optional
+} WorkersJob;
+
+typedef struct {
+  WorkersJob *job;
+  unsigned worker;
+} WorkersArg;
+
+static double clock_ms(clockid_t id) {
+  struct timespec ts;
+  clock_gettime(id, &ts);
+  return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static int range_pop(WorkersRange *r, size_t *task) {
+  pthread_mutex_lock(&r->lock);
+  int ok = r->head < r->tail;
+  if (ok) *task = r->head++;
+  pthread_mutex_unlock(&r->lock);
+  return ok;
+}
+
+/* Move the back half of the fullest other range into `self` (which is
+ * empty, so only its owner could touch it and that is the caller).
+ */
+static int range_steal(WorkersJob *job, unsigned self) {
+  for (;;) {
+    unsigned victim = self;
+    size_t best = 0;
+    for (unsigned w = 0; w < job->n_threads; w++) {
+      if (w == self) continue;
+      WorkersRange *r = &job->ranges[w];
+      pthread_mutex_lock(&r->lock);
+      size_t left = r->tail - r->head;
+      pthread_mutex_unlock(&r->lock);
+      if (left > best) {
+        best = left;
+        victim = w;
+      }
+    }
+    if (victim == self) return 0;
+
+    WorkersRange *v = &job->ranges[victim];
+    pthread_mutex_lock(&v->lock);
+    size_t left = v->tail - v->head;
+    size_t take = left - left / 2;
+    size_t from = v->tail - take;
+    if (take > 0) v->tail = from;
+    pthread_mutex_unlock(&v->lock);
+    if (take == 0) continue;  // drained meanwhile: look again
+
+    WorkersRange *s = &job->ranges[self];
+    pthread_mutex_lock(&s->lock);
+    s->head = from;
+    s->tail = from + take;
+    pthread_mutex_unlock(&s->lock);
+    atomic_fetch_add_explicit(&job->steals, 1, memory_order_relaxed);
+    return 1;
+  }
+}
+
+static void workers_loop(WorkersJob *job, unsigned worker) {
+  WorkersRange *own = &job->ranges[worker];
+  double cpu = 0.0;
+  size_t ran = 0;
+  while (!atomic_load_explicit(&job->failed, memory_order_relaxed)) {
+    size_t t;
+    if (!range_pop(own, &t)) {
+      if (!range_steal(job, worker)) break;
+      continue;
+    }
+    double c0 = job->stats ? clock_ms(CLOCK_THREAD_CPUTIME_ID) : 0.0;
+    if (!job->fn(job->ctx, t, worker)) atomic_store(&job->failed, 1);
+    if (job->stats) cpu += clock_ms(CLOCK_THREAD_CPUTIME_ID) - c0;
+    ran++;
+  }
+  if (job->stats) {
+    job->stats->cpu_ms[worker] = cpu;
+    job->stats->tasks[worker] = ran;
+  }
+}
+
+static void *workers_main(void *p) {
+  WorkersArg *a = (WorkersArg*)p;
+  workers_loop(a->job, a->worker);
+  return NULL;
+}
+
+/* Contiguous ranges of about equal weight, in task order. */
+static void split_ranges(WorkersJob *job, size_t n_tasks, const size_t *weights) {
+  unsigned n = job->n_threads;
+  double total = 0.0;
+  for (size_t t = 0; t < n_tasks; t++) total += weights ? (double)weights[t] : 1.0;
+
+  size_t t = 0;
+  double acc = 0.0;
+  for (unsigned w = 0; w < n; w++) {
+    double bound = total * (double)(w + 1) / (double)n;
+    job->ranges[w].head = t;
+    while (t < n_tasks && (w == n - 1 || acc < bound)) {
+      acc += weights ? (double)weights[t] : 1.0;
+      t++;
+    }
+    job->ranges[w].tail = t;
+  }
+}
+
+int workers_run(unsigned n_threads, size_t n_tasks, workers_fn fn, void *ctx,
+                const size_t *weights, WorkersStats *stats) {
+  if (!fn) return 0;
+  if (stats) memset(stats, 0, sizeof(*stats));
+  if (n_tasks == 0) return 1;
+  if (n_threads < 1) n_threads = 1;
+  if (n_threads > WORKERS_MAX) n_threads = WORKERS_MAX;
+  if ((size_t)n_threads > n_tasks) n_threads = (unsigned)n_tasks;
+
+  double t0 = clock_ms(CLOCK_MONOTONIC);
+  WorkersJob *job = (WorkersJob*)calloc(1, sizeof(WorkersJob));
+  if (!job) return 0;
+  job->fn = fn;
+  job->ctx = ctx;
+  job->n_threads = n_threads;
+  job->stats = stats;
+  atomic_init(&job->failed, 0);
+  atomic_init(&job->steals, 0);
+  for (unsigned w = 0; w < n_threads; w++) pthread_mutex_init(&job->ranges[w].lock, NULL);
+  split_ranges(job, n_tasks, weights);
+
+  /* Helpers that fail to start are simply missing: their ranges are
+   * stolen by the remaining workers (at least the caller).
+   */
+  pthread_t tids[WORKERS_MAX];
+  WorkersArg args[WORKERS_MAX];
+  unsigned started = 0;
+  for (unsigned w = 1; w < n_threads; w++) {
+    args[started] = (WorkersArg){ job, w };
+    if (pthread_create(&tids[started], NULL, workers_main, &args[started]) != 0) break;
+    started++;
+  }
+
+  workers_loop(job, 0);
+  for (unsigned i = 0; i < started; i++) pthread_join(tids[i], NULL);
+
+  int ok = !atomic_load(&job->failed);
+  if (stats) {
+    stats->threads = started + 1;
+    stats->steals = atomic_load(&job->steals);
+    stats->wall_ms = clock_ms(CLOCK_MONOTONIC) - t0;
+  }
+  for (unsigned w = 0; w < n_threads; w++) pthread_mutex_destroy(&job->ranges[w].lock);
+  free(job);
+  return ok;
+}
+
+double workers_utilization(const WorkersStats *s) {
+  if (!s || s->threads == 0 || s->wall_ms <= 0.0) return 0.0;
+  double cpu = 0.0;
+  for (unsigned w = 0; w < s->threads && w < WORKERS_MAX; w++) cpu += s->cpu_ms[w];
+  double u = cpu / (s->wall_ms * (double)s->threads);
+  return u > 1.0 ? 1.0 : u;
+}
+
+unsigned workers_parse(const char *s) {
+  if (!s || !*s) return 1;
+  if (strcmp(s, "auto") == 0) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) return 1;
+    return n > WORKERS_MAX ? WORKERS_MAX : (unsigned)n;
+  }
+  char *end = NULL;
+  unsigned long v = strtoul(s, &end, 10);
+  if (end == s || *end != '\0' || v == 0) return 1;
+  return v > WORKERS_MAX ? WORKERS_MAX : (unsigned)v;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <stddef.h>
+
+/* Upper bound for configured thread counts. */
+#define WORKERS_MAX 64
+
+/*
+ * Work-stealing executor for per-request parallelism.
+ *
+ * workers_run calls fn(ctx, task, worker) for every task in [0, n_tasks)
+ * on up to n_threads threads. The calling thread is worker 0, so
+ * n_threads <= 1 runs everything inline without creating threads.
+ *
+ * Every worker starts with a contiguous range of tasks of about equal
+ * total weight (weights NULL: all equal) and runs it front to back. A
+ * worker whose range is empty steals the back half of the fullest other
+ * range, so one slow task does not hold back the tasks queued behind it.
+ * Tasks write to per-task slots, so results do not depend on scheduling.
+ * Once a task fails (fn returns 0), no further tasks are started.
+ *
+ * Returns 1 when every task ran and succeeded.
+ */
+typedef int (*workers_fn)(void *ctx, size_t task, unsigned worker);
+
+/* Per-run scheduling counters (meta.scheduler). */
+typedef struct {
+  unsigned threads;            // workers that ran
+  size_t steals;               // successful steals
+  double wall_ms;              // start of the run to the last join
+  double cpu_ms[WORKERS_MAX];  // thread CPU time spent in tasks
+  size_t tasks[WORKERS_MAX];   // tasks run per worker
+} WorkersStats;
+
+int workers_run(unsigned n_threads, size_t n_tasks, workers_fn fn, void *ctx,
+                const size_t *weights, WorkersStats *stats);
+
+/* Share of the run's core time spent in tasks:
+ * sum(cpu_ms) / (wall_ms * threads), clamped to 0..1.
+ */
+double workers_utilization(const WorkersStats *s);
+
+/*
+ * Thread count from a flag or env value: "auto" = online CPUs, a number
+ * is clamped to 1..WORKERS_MAX, NULL/empty/invalid = 1 (sequential).
+ */
+unsigned workers_parse(const char *s);
@@ -14,6 +14,7 @@
 
 #include "yyjson.h"
 #include "input/request_validate.h"
+#include "app/cost_model.h"
 
 static int ends_with_json(const char *name) {
     size_t n = strlen(name);
@@ -117,6 +118,9 @@ int cli_run_batch(const char *in_dir, const char *out_dir, int continue_on_error
     const char *sw = getenv("STOPWORDS_FILE");
     if (!sw) sw = "data/stopwords_de.txt";
 
+    /* AUTO runs on every file: calibrate its cost model once up front. */
+    cost_model_calibrate(sw);
+
     /* Shared boundary validation with CLI/batch relaxed limits. */
     req_validate_cfg_t vcfg = {
         .max_pages = 0,
@@ -175,7 +179,18 @@ int cli_run_batch(const char *in_dir, const char *out_dir, int continue_on_error
             .stopwords_path   = sw,
             .top_k            = 0,
             .domain           = req.domain,
-            .pipeline         = APP_PIPELINE_AUTO
+            .pipeline         = APP_PIPELINE_AUTO,
+            .approximate      = req.approximate,
+            .approximate_capacity = req.approximate_capacity,
+            .sample_rate      = req.sample_rate,
+            .sample_seed      = req.sample_seed,
+            .ngram_max        = req.ngram_max,
+            .ngram_limit      = req.ngram_limit,
+            .cooc_window      = req.cooc_window,
+            .cooc_min_count   = req.cooc_min_count,
+            .cooc_limit       = req.cooc_limit,
+            .stem             = req.stem,
+            .tfidf            = req.tfidf
         };
 
         app_analyze_result_t res = app_analyze_pages(req.pages, req.page_count, &opts);
@@ -11,6 +11,8 @@
  * This keeps output JSON, meta fields, and pipeline selection consistent.
  */
 #include "app/analyze.h"
+#include "app/engine.h"
+#include "app/workers.h"
 #include "cli/batch.h"
 #include "input/request_validate.h"
 
@@ -78,6 +80,15 @@ typedef struct {
 
 int main(int argc, char **argv) {
 
+    /* Subcommand listing registered engines (benchmark/parity harness). */
+    if (argc >= 2 && strcmp(argv[1], "pipelines") == 0) {
+        for (size_t i = 0; i < app_engine_count(); i++) {
+            const app_engine_t *e = app_engine_at(i);
+            if (e) fprintf(stdout, "%s\n", e->name);
+        }
+        return 0;
+    }
+
     /* Subcommand used for bulk perf/regression runs. */
     if (argc >= 2 && strcmp(argv[1], "batch") == 0) {
         const char *in_dir  = "data/batch_in";
@@ -104,7 +115,7 @@ int main(int argc, char **argv) {
     }
 
     if (argc < 2) {
-        fprintf(stderr, "Usage: %s <input.json> [--out output.json] [--pipeline auto|string|id]\n", argv[0]);
+        fprintf(stderr, "Usage: %s <input.json> [--out output.json] [--pipeline " APP_PIPELINE_CHOICES "]\n", argv[0]);
         return 2;
     }
 
@@ -113,6 +124,8 @@ int main(int argc, char **argv) {
     app_pipeline_t pipeline = APP_PIPELINE_AUTO;
 
     size_t top_k_cli = 0;  // 0 => full output (no Top-K truncation)
+    size_t max_token_bytes = 0;  // 0 => no limit
+    unsigned threads = 1;        // page-stage workers ("auto" = online CPUs)
 
     for (int i = 2; i < argc; i++) {
         if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
@@ -121,7 +134,7 @@ int main(int argc, char **argv) {
             int ok = 1;
             pipeline = app_pipeline_from_str(argv[++i], &ok);
             if (!ok) {
-                fprintf(stderr, "Unknown pipeline '%s' (use auto|string|id)\n", argv[i]);
+                fprintf(stderr, "Unknown pipeline '%s' (use " APP_PIPELINE_CHOICES ")\n", argv[i]);
                 return 2;
             }
         } else if ((strcmp(argv[i], "--topk") == 0 || strcmp(argv[i], "--k") == 0) && i + 1 < argc) {
@@ -132,16 +145,34 @@ int main(int argc, char **argv) {
                 fprintf(stderr, "Invalid value for %s: '%s'\n", argv[i-1], s);
                 fprintf(stderr,
                     "Usage: %s <input.json> [--out output.json] "
-                    "[--pipeline auto|string|id] [--topk K]\n",
+                    "[--pipeline " APP_PIPELINE_CHOICES "] [--topk K] [--max-token-len N] [--threads N|auto]\n",
                     argv[0]);
                 return 2;
             }
             top_k_cli = (size_t)v;  // 0 allowed (full)
+        } else if (strcmp(argv[i], "--max-token-len") == 0 && i + 1 < argc) {
+            const char *s = argv[++i];
+            char *end = NULL;
+            unsigned long v = strtoul(s, &end, 10);
+            if (s[0] == '\0' || (end && *end != '\0')) {
+                fprintf(stderr, "Invalid value for %s: '%s'\n", argv[i-1], s);
+                return 2;
+            }
+            max_token_bytes = (size_t)v;  // 0 => no limit
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            const char *s = argv[++i];
+            char *end = NULL;
+            unsigned long v = strtoul(s, &end, 10);
+            if (strcmp(s, "auto") != 0 && (s[0] == '\0' || (end && *end != '\0') || v == 0)) {
+                fprintf(stderr, "Invalid value for %s: '%s'\n", argv[i-1], s);
+                return 2;
+            }
+            threads = workers_parse(s);
         } else {
             fprintf(stderr, "Unknown arg: %s\n", argv[i]);
             fprintf(stderr,
                 "Usage: %s <input.json> [--out output.json] "
-                "[--pipeline auto|string|id] [--topk K]\n",
+                "[--pipeline " APP_PIPELINE_CHOICES "] [--topk K] [--max-token-len N] [--threads N|auto]\n",
                 argv[0]);
             return 2;
         }
@@ -184,7 +215,20 @@ int main(int argc, char **argv) {
         .stopwords_path    = sw,
         .top_k             = top_k_cli,
         .domain            = req.domain,  // optional
-        .pipeline          = pipeline     // pipeline override (auto|string|id)
+        .pipeline          = pipeline,    // pipeline override (APP_PIPELINE_CHOICES)
+        .max_token_bytes   = max_token_bytes,
+        .approximate       = req.approximate,
+        .approximate_capacity = req.approximate_capacity,
+        .sample_rate       = req.sample_rate,
+        .sample_seed       = req.sample_seed,
+        .ngram_max         = req.ngram_max,
+        .ngram_limit       = req.ngram_limit,
+        .cooc_window       = req.cooc_window,
+        .cooc_min_count    = req.cooc_min_count,
+        .cooc_limit        = req.cooc_limit,
+        .stem              = req.stem,
+        .tfidf             = req.tfidf,
+        .threads           = threads
     };
 
     /* Analysis stage (core pipeline switch happens inside app_analyze_pages). */
@@ -1,18 +1,10 @@
 #include "core/aggregate.h"
+#include "core/arena.h"
+#include "core/cancel.h"
 
 #include <stdlib.h>
 #include <string.h>
 
-/* Aggregation output owns its own copies of word strings. */
-static char *dup_cstr(const char *s) {
-    if (!s) return NULL;
-    size_t n = strlen(s);
-    char *out = (char *)malloc(n + 1);
-    if (!out) return NULL;
-    memcpy(out, s, n + 1);
-    return out;
-}
-
 WordCountList aggregate_word_counts(
     const WordCountList *lists,
     size_t list_count
@@ -27,9 +19,12 @@ WordCountList aggregate_word_counts(
     out.items = (WordCount *)calloc(cap, sizeof(WordCount));
     if (!out.items) return (WordCountList){0};
 
+    /* Every entry scans the list: poll more often. */
+    size_t seen = 0;
     for (size_t i = 0; i < list_count; i++) {
         const WordCountList *src = &lists[i];
         for (size_t j = 0; j < src->count; j++) {
+            if (cancel_poll_every(++seen, CANCEL_POLL_EVERY_SCAN)) return out;
             const char *word = src->items[j].word;
             size_t cnt = src->items[j].count;
 
@@ -61,7 +56,7 @@ WordCountList aggregate_word_counts(
                 out.items = tmp;
             }
 
-            out.items[out.count].word = dup_cstr(word);
+            out.items[out.count].word = str_dup(word);
             out.items[out.count].count = cnt;
             out.count++;
         }
@@ -70,11 +65,90 @@ WordCountList aggregate_word_counts(
     return out;
 }
 
+/* Heap of list cursors, ordered by the current word of each list. */
+typedef struct {
+    const WordCountList *lists;
+    size_t *pos;   // cursor per list
+    size_t *heap;  // list indices
+    size_t n;
+} WordMergeHeap;
+
+static int heap_less(const WordMergeHeap *h, size_t a, size_t b) {
+    const char *wa = h->lists[a].items[h->pos[a]].word;
+    const char *wb = h->lists[b].items[h->pos[b]].word;
+    return strcmp(wa ? wa : "", wb ? wb : "") < 0;
+}
+
+static void heap_sift_down(WordMergeHeap *h, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1, m = i;
+        if (l < h->n && heap_less(h, h->heap[l], h->heap[m])) m = l;
+        if (l + 1 < h->n && heap_less(h, h->heap[l + 1], h->heap[m])) m = l + 1;
+        if (m == i) return;
+        size_t t = h->heap[i]; h->heap[i] = h->heap[m]; h->heap[m] = t;
+        i = m;
+    }
+}
+
+WordCountList aggregate_word_counts_sorted(
+    const WordCountList *lists,
+    size_t list_count
+) {
+    WordCountList out = (WordCountList){0};
+    if (!lists || list_count == 0) return out;
+
+    size_t total = 0;
+    for (size_t i = 0; i < list_count; i++) total += lists[i].count;
+    if (total == 0) return out;
+
+    WordMergeHeap h = { lists, NULL, NULL, 0 };
+    h.pos = (size_t *)calloc(list_count, sizeof(size_t));
+    h.heap = (size_t *)malloc(list_count * sizeof(size_t));
+    out.items = (WordCount *)calloc(total, sizeof(WordCount));
+    if (!h.pos || !h.heap || !out.items) goto fail;
+
+    for (size_t i = 0; i < list_count; i++) {
+        if (lists[i].count > 0) h.heap[h.n++] = i;
+    }
+    for (size_t i = h.n / 2; i-- > 0; ) heap_sift_down(&h, i);
+
+    /* Pop the smallest word; equal words arrive back to back. */
+    size_t popped = 0;
+    while (h.n > 0) {
+        if (cancel_poll(++popped)) break;
+        size_t li = h.heap[0];
+        const WordCount *wc = &lists[li].items[h.pos[li]];
+        const char *word = wc->word ? wc->word : "";
+
+        if (out.count > 0 && strcmp(out.items[out.count - 1].word, word) == 0) {
+            out.items[out.count - 1].count += wc->count;
+        } else {
+            out.items[out.count].word = str_dup(word);
+            if (!out.items[out.count].word) goto fail;
+            out.items[out.count].count = wc->count;
+            out.count++;
+        }
+
+        if (++h.pos[li] == lists[li].count) h.heap[0] = h.heap[--h.n];
+        heap_sift_down(&h, 0);
+    }
+
+    free(h.pos);
+    free(h.heap);
+    return out;
+
+fail:
+    free(h.pos);
+    free(h.heap);
+    free_aggregated_word_counts(&out);
+    return (WordCountList){0};
+}
+
 /* Free helper for aggregated (domain-level) word list. */
 void free_aggregated_word_counts(WordCountList *list) {
     if (!list || !list->items) return;
     for (size_t i = 0; i < list->count; i++) {
-        free(list->items[i].word);
+        str_free(list->items[i].word);
     }
     free(list->items);
     list->items = NULL;
@@ -7,12 +7,23 @@
 /*
  * Domain-level aggregation for word frequencies.
  * Merges per-page WordCountLists into a single combined list.
+ * Stops early once the bound deadline passes (core/cancel.h), as does
+ * the sorted merge below.
  */
 WordCountList aggregate_word_counts(
     const WordCountList *lists,
     size_t list_count
 );
 
+/*
+ * Same result for input lists that are each sorted by word (strcmp ASC,
+ * no duplicates): k-way heap merge, output stays sorted by word.
+ */
+WordCountList aggregate_word_counts_sorted(
+    const WordCountList *lists,
+    size_t list_count
+);
+
 /* Release memory of an aggregated WordCountList. */
 void free_aggregated_word_counts(WordCountList *list);
 
@@ -0,0 +1,445 @@
+#include "core/aggregate_ta.h"
+#include "core/arena.h"
+#include "core/hash_seed.h"
+#include "core/id_sort.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Key operations of one list type (WordCount / BigramCount). */
+typedef struct {
+    size_t stride;
+    uint64_t (*hash)(const void *item, uint64_t seed);
+    int (*cmp)(const void *a, const void *b);  // key order, 0 = same key
+    size_t (*count)(const void *item);
+} TaOps;
+
+/* One page list: count-DESC read order (prefix, extended on demand) plus
+ * a lazily built hash index for random access.
+ */
+typedef struct {
+    const char *items;
+    size_t n;
+    size_t max;        // largest count
+    size_t *order;     // sorted access; order[0..n_ordered) valid
+    size_t n_ordered;
+    size_t *slots;     // random access: item index + 1, 0 = empty
+    size_t mask;
+} TaList;
+
+/* Keys seen by sorted access so far (open addressing on item pointers). */
+typedef struct {
+    const void **slots;
+    size_t mask;
+    size_t size;
+} TaSeen;
+
+/* ---------- Hashing ---------- */
+
+#define TA_FNV_BASIS 1469598103934665603ULL
+#define TA_FNV_PRIME 1099511628211ULL
+
+static uint64_t fnv_step(uint64_t h, const char *s) {
+    for (const unsigned char *p = (const unsigned char *)(s ? s : ""); *p; ++p) {
+        h ^= (uint64_t)(*p);
+        h *= TA_FNV_PRIME;
+    }
+    return h;
+}
+
+/* Final avalanche: probing uses the low bits. */
+static uint64_t fnv_finish(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static size_t next_pow2(size_t x) {
+    size_t p = 16;
+    while (p < x) p <<= 1;
+    return p;
+}
+
+static unsigned bit_width(uint64_t v) {
+    unsigned b = 0;
+    while (v) { b++; v >>= 1; }
+    return b;
+}
+
+/* ---------- Words / bigrams ---------- */
+
+static int cmp_str(const char *a, const char *b) {
+    return strcmp(a ? a : "", b ? b : "");
+}
+
+static uint64_t word_hash(const void *item, uint64_t seed) {
+    return fnv_finish(fnv_step(TA_FNV_BASIS ^ seed, ((const WordCount *)item)->word));
+}
+
+static int word_cmp(const void *a, const void *b) {
+    return cmp_str(((const WordCount *)a)->word, ((const WordCount *)b)->word);
+}
+
+static size_t word_count(const void *item) {
+    return ((const WordCount *)item)->count;
+}
+
+/* 0xff never occurs in UTF-8, so it separates w1 from w2 unambiguously. */
+static uint64_t bigram_hash(const void *item, uint64_t seed) {
+    const BigramCount *bc = (const BigramCount *)item;
+    uint64_t h = fnv_step(TA_FNV_BASIS ^ seed, bc->w1);
+    h = (h ^ 0xffu) * TA_FNV_PRIME;
+    return fnv_finish(fnv_step(h, bc->w2));
+}
+
+static int bigram_cmp(const void *a, const void *b) {
+    const BigramCount *x = (const BigramCount *)a;
+    const BigramCount *y = (const BigramCount *)b;
+    int c = cmp_str(x->w1, y->w1);
+    return c != 0 ? c : cmp_str(x->w2, y->w2);
+}
+
+static size_t bigram_count(const void *item) {
+    return ((const BigramCount *)item)->count;
+}
+
+static const TaOps WORD_OPS = { sizeof(WordCount), word_hash, word_cmp, word_count };
+static const TaOps BIGRAM_OPS = { sizeof(BigramCount), bigram_hash, bigram_cmp, bigram_count };
+
+/* ---------- Per-page structures ---------- */
+
+/* First prefix selected per page; later prefixes grow by TA_PREFIX_GROWTH. */
+#define TA_PREFIX_MIN 64
+#define TA_PREFIX_GROWTH 4
+
+/* Read-order key: count DESC, then list position. */
+static uint64_t ta_key(const TaList *l, const TaOps *ops, size_t i) {
+    size_t c = ops->count(l->items + i * ops->stride);
+    return ((uint64_t)(l->max - c) << 32) | (uint64_t)i;
+}
+
+static void ta_key_sift_down(uint64_t *h, size_t n, size_t i) {
+    for (;;) {
+        size_t c = 2 * i + 1, m = i;
+        if (c < n && h[c] > h[m]) m = c;
+        if (c + 1 < n && h[c + 1] > h[m]) m = c + 1;
+        if (m == i) return;
+        uint64_t t = h[i]; h[i] = h[m]; h[m] = t;
+        i = m;
+    }
+}
+
+/* Extend the read order to cover position depth. Prefixes are the m
+ * smallest keys (bounded heap over the counts, no string access); from
+ * n / TA_PREFIX_GROWTH on, the whole list is radix-sorted instead.
+ */
+static int ta_order(TaList *l, const TaOps *ops, size_t depth) {
+    if (depth < l->n_ordered) return 1;
+
+    size_t n = l->n;
+    if (!l->order) {
+        for (size_t i = 0; i < n; i++) {
+            size_t c = ops->count(l->items + i * ops->stride);
+            if (c > l->max) l->max = c;
+        }
+        if ((uint64_t)l->max > UINT32_MAX || (uint64_t)n > UINT32_MAX) return 0;
+        l->order = (size_t *)malloc((n ? n : 1) * sizeof(size_t));
+        if (!l->order) return 0;
+    }
+
+    size_t m = l->n_ordered ? l->n_ordered * TA_PREFIX_GROWTH : TA_PREFIX_MIN;
+    while (m <= depth) m *= TA_PREFIX_GROWTH;
+    if (m > n / TA_PREFIX_GROWTH) m = n;
+
+    uint64_t *keys = (uint64_t *)malloc((m ? m : 1) * sizeof(uint64_t));
+    if (!keys) return 0;
+
+    if (m == n) {
+        uint64_t *tmp = (uint64_t *)malloc((n ? n : 1) * sizeof(uint64_t));
+        if (!tmp) { free(keys); return 0; }
+        for (size_t i = 0; i < n; i++) keys[i] = ta_key(l, ops, i);
+        int sorted = radix_sort_u64(keys, tmp, n, 32 + bit_width(l->max));
+        free(tmp);
+        if (!sorted) { free(keys); return 0; }
+    } else {
+        for (size_t i = 0; i < m; i++) keys[i] = ta_key(l, ops, i);
+        for (size_t i = m / 2; i-- > 0; ) ta_key_sift_down(keys, m, i);
+        for (size_t i = m; i < n; i++) {
+            uint64_t k = ta_key(l, ops, i);
+            if (k < keys[0]) {
+                keys[0] = k;
+                ta_key_sift_down(keys, m, 0);
+            }
+        }
+        for (size_t end = m; end > 1; end--) {
+            uint64_t t = keys[0]; keys[0] = keys[end - 1]; keys[end - 1] = t;
+            ta_key_sift_down(keys, end - 1, 0);
+        }
+    }
+
+    for (size_t i = 0; i < m; i++) l->order[i] = (size_t)(keys[i] & 0xffffffffu);
+    l->n_ordered = m;
+    free(keys);
+    return 1;
+}
+
+static int ta_index(TaList *l, const TaOps *ops, uint64_t seed) {
+    size_t cap = next_pow2(l->n * 2 + 1);
+    l->slots = (size_t *)calloc(cap, sizeof(size_t));
+    if (!l->slots) return 0;
+    l->mask = cap - 1;
+
+    for (size_t i = 0; i < l->n; i++) {
+        size_t pos = (size_t)ops->hash(l->items + i * ops->stride, seed) & l->mask;
+        while (l->slots[pos]) pos = (pos + 1) & l->mask;
+        l->slots[pos] = i + 1;
+    }
+    return 1;
+}
+
+/* Count of key in this page (0 if absent); h = ops->hash(key, seed). */
+static size_t ta_lookup(const TaList *l, const TaOps *ops, const void *key, uint64_t h) {
+    for (size_t pos = (size_t)h & l->mask; l->slots[pos]; pos = (pos + 1) & l->mask) {
+        const void *item = l->items + (l->slots[pos] - 1) * ops->stride;
+        if (ops->cmp(item, key) == 0) return ops->count(item);
+    }
+    return 0;
+}
+
+/* Random access into a key-sorted list: binary search, no index. */
+static size_t ta_lookup_sorted(const TaList *l, const TaOps *ops, const void *key) {
+    size_t lo = 0, hi = l->n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const void *item = l->items + mid * ops->stride;
+        int c = ops->cmp(item, key);
+        if (c == 0) return ops->count(item);
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return 0;
+}
+
+/* 1: newly seen, 0: seen before, -1: OOM. Grows at 0.5 load. */
+static int ta_seen_add(TaSeen *s, const TaOps *ops, const void *key, uint64_t h, uint64_t seed) {
+    if (!s->slots || (s->size + 1) * 2 > s->mask + 1) {
+        size_t cap = s->slots ? (s->mask + 1) * 2 : 1024;
+        const void **ns = (const void **)calloc(cap, sizeof(*ns));
+        if (!ns) return -1;
+        for (size_t i = 0; s->slots && i <= s->mask; i++) {
+            if (!s->slots[i]) continue;
+            size_t pos = (size_t)ops->hash(s->slots[i], seed) & (cap - 1);
+            while (ns[pos]) pos = (pos + 1) & (cap - 1);
+            ns[pos] = s->slots[i];
+        }
+        free(s->slots);
+        s->slots = ns;
+        s->mask = cap - 1;
+    }
+
+    size_t pos = (size_t)h & s->mask;
+    for (; s->slots[pos]; pos = (pos + 1) & s->mask) {
+        if (ops->cmp(s->slots[pos], key) == 0) return 0;
+    }
+    s->slots[pos] = key;
+    s->size++;
+    return 1;
+}
+
+/* ---------- Winner heap (worst of the k best at the root) ---------- */
+
+/* a ranks before b: higher total, then smaller key. */
+static int ta_better(const TaOps *ops, const void *a, size_t ta, const void *b, size_t tb) {
+    if (ta != tb) return ta > tb;
+    return ops->cmp(a, b) < 0;
+}
+
+static void ta_swap(const void **key, size_t *tot, size_t i, size_t j) {
+    const void *k = key[i]; key[i] = key[j]; key[j] = k;
+    size_t t = tot[i]; tot[i] = tot[j]; tot[j] = t;
+}
+
+static void ta_sift_down(const TaOps *ops, const void **key, size_t *tot, size_t n, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1, m = i;
+        if (l < n && ta_better(ops, key[m], tot[m], key[l], tot[l])) m = l;
+        if (l + 1 < n && ta_better(ops, key[m], tot[m], key[l + 1], tot[l + 1])) m = l + 1;
+        if (m == i) return;
+        ta_swap(key, tot, i, m);
+        i = m;
+    }
+}
+
+static void ta_sift_up(const TaOps *ops, const void **key, size_t *tot, size_t i) {
+    while (i > 0) {
+        size_t p = (i - 1) / 2;
+        if (!ta_better(ops, key[p], tot[p], key[i], tot[i])) return;
+        ta_swap(key, tot, i, p);
+        i = p;
+    }
+}
+
+/* ---------- Threshold algorithm ---------- */
+
+/* Selects up to k winners (best first) into win/win_tot. 0 if the read
+ * budget is exhausted before the bounds converge, or on OOM.
+ */
+static int ta_select(const TaOps *ops, TaList *lists, size_t n_lists, bool sorted,
+                     size_t k, const void **win, size_t *win_tot, size_t *n_win) {
+    uint64_t seed = hash_seed();
+    size_t entries = 0, depth_max = 0;
+    for (size_t p = 0; p < n_lists; p++) {
+        entries += lists[p].n;
+        if (lists[p].n > depth_max) depth_max = lists[p].n;
+    }
+
+    size_t budget = entries / AGG_TA_READ_DIV;
+    size_t read = 0, hn = 0;
+    TaSeen seen = {0};
+    int ok = 0;
+
+    for (size_t d = 0; d < depth_max; d++) {
+        size_t threshold = 0;
+
+        for (size_t p = 0; p < n_lists; p++) {
+            TaList *l = &lists[p];
+            if (d >= l->n) continue;
+            if (read++ >= budget) goto done;
+            if (!ta_order(l, ops, d)) goto done;
+
+            const void *item = l->items + l->order[d] * ops->stride;
+            size_t total = ops->count(item);
+            threshold += total;
+
+            uint64_t h = ops->hash(item, seed);
+            int fresh = ta_seen_add(&seen, ops, item, h, seed);
+            if (fresh < 0) goto done;
+            if (!fresh) continue;
+
+            /* Random access: pages read to the end hold no unseen keys. */
+            for (size_t q = 0; q < n_lists; q++) {
+                if (q == p || d >= lists[q].n) continue;
+                if (sorted) {
+                    total += ta_lookup_sorted(&lists[q], ops, item);
+                    continue;
+                }
+                if (!lists[q].slots && !ta_index(&lists[q], ops, seed)) goto done;
+                total += ta_lookup(&lists[q], ops, item, h);
+            }
+
+            if (hn < k) {
+                win[hn] = item;
+                win_tot[hn] = total;
+                ta_sift_up(ops, win, win_tot, hn++);
+            } else if (ta_better(ops, item, total, win[0], win_tot[0])) {
+                win[0] = item;
+                win_tot[0] = total;
+                ta_sift_down(ops, win, win_tot, hn, 0);
+            }
+        }
+
+        /* Strict bound: an unseen key could tie and win on the tie-break. */
+        if (hn == k && win_tot[0] > threshold) break;
+    }
+
+    /* Heap sort: repeatedly move the worst winner to the back. */
+    for (size_t end = hn; end > 1; end--) {
+        ta_swap(win, win_tot, 0, end - 1);
+        ta_sift_down(ops, win, win_tot, end - 1, 0);
+    }
+    *n_win = hn;
+    ok = 1;
+
+done:
+    free(seen.slots);
+    return ok;
+}
+
+static void ta_lists_free(TaList *lists, size_t n) {
+    for (size_t i = 0; lists && i < n; i++) {
+        free(lists[i].order);
+        free(lists[i].slots);
+    }
+    free(lists);
+}
+
+int aggregate_top_k_words_ta(const WordCountList *lists, size_t list_count,
+                             bool lists_sorted, size_t k, WordCountList *out) {
+    if (!out) return 0;
+    *out = (WordCountList){0};
+    if (!lists || k == 0) return 0;
+
+    TaList *tl = (TaList *)calloc(list_count ? list_count : 1, sizeof(TaList));
+    const void **win = (const void **)malloc(k * sizeof(*win));
+    size_t *win_tot = (size_t *)malloc(k * sizeof(size_t));
+    size_t n_win = 0;
+    int ok = tl && win && win_tot;
+
+    if (ok) {
+        for (size_t i = 0; i < list_count; i++) {
+            tl[i].items = (const char *)lists[i].items;
+            tl[i].n = lists[i].items ? lists[i].count : 0;
+        }
+        ok = ta_select(&WORD_OPS, tl, list_count, lists_sorted, k, win, win_tot, &n_win);
+    }
+
+    if (ok && n_win > 0) {
+        out->items = (WordCount *)calloc(n_win, sizeof(WordCount));
+        ok = out->items != NULL;
+        for (size_t i = 0; ok && i < n_win; i++) {
+            const WordCount *wc = (const WordCount *)win[i];
+            out->items[i].word = str_dup(wc->word ? wc->word : "");
+            out->items[i].count = win_tot[i];
+            out->count = i + 1;
+            ok = out->items[i].word != NULL;
+        }
+        if (!ok) free_word_counts(out);
+    }
+
+    ta_lists_free(tl, list_count);
+    free(win);
+    free(win_tot);
+    return ok;
+}
+
+int aggregate_top_k_bigrams_ta(const BigramCountList *lists, size_t list_count,
+                               bool lists_sorted, size_t k, BigramCountList *out) {
+    if (!out) return 0;
+    *out = (BigramCountList){0};
+    if (!lists || k == 0) return 0;
+
+    TaList *tl = (TaList *)calloc(list_count ? list_count : 1, sizeof(TaList));
+    const void **win = (const void **)malloc(k * sizeof(*win));
+    size_t *win_tot = (size_t *)malloc(k * sizeof(size_t));
+    size_t n_win = 0;
+    int ok = tl && win && win_tot;
+
+    if (ok) {
+        for (size_t i = 0; i < list_count; i++) {
+            tl[i].items = (const char *)lists[i].items;
+            tl[i].n = lists[i].items ? lists[i].count : 0;
+        }
+        ok = ta_select(&BIGRAM_OPS, tl, list_count, lists_sorted, k, win, win_tot, &n_win);
+    }
+
+    if (ok && n_win > 0) {
+        out->items = (BigramCount *)calloc(n_win, sizeof(BigramCount));
+        ok = out->items != NULL;
+        for (size_t i = 0; ok && i < n_win; i++) {
+            const BigramCount *bc = (const BigramCount *)win[i];
+            out->items[i].w1 = str_dup(bc->w1 ? bc->w1 : "");
+            out->items[i].w2 = str_dup(bc->w2 ? bc->w2 : "");
+            out->items[i].count = win_tot[i];
+            out->count = i + 1;
+            ok = out->items[i].w1 && out->items[i].w2;
+        }
+        if (!ok) free_bigram_counts(out);
+    }
+
+    ta_lists_free(tl, list_count);
+    free(win);
+    free(win_tot);
+    return ok;
+}
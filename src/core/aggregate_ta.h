@@ -0,0 +1,33 @@
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "core/freq.h"
+#include "core/bigrams.h"
+
+/*
+ * Domain Top-K without a full domain list (threshold algorithm, Fagin).
+ *
+ * Page lists are read depth by depth in count-DESC order (sorted access;
+ * only the prefix read so far is ordered). A newly seen key is completed
+ * by random access to the other pages and competes for the k result
+ * slots. Random access uses binary search when the lists are sorted by
+ * key (lists_sorted, e.g. ART output), otherwise a per-page hash index.
+ * Reading stops as soon as the k-th best total exceeds the sum of the
+ * counts at the current depth: no unseen key can reach it.
+ *
+ * Output equals Top-K over the aggregated list (count DESC, lexicographic
+ * ASC, at most k items; release with free_top_k_words/_bigrams).
+ *
+ * Returns 0 (and an empty list) when the bounds do not converge within
+ * AGG_TA_READ_DIV of all entries or on OOM; callers then aggregate in full.
+ */
+#ifndef AGG_TA_READ_DIV
+#define AGG_TA_READ_DIV 2  // give up after reading 1/AGG_TA_READ_DIV of the entries
+#endif
+
+int aggregate_top_k_words_ta(const WordCountList *lists, size_t list_count,
+                             bool lists_sorted, size_t k, WordCountList *out);
+
+int aggregate_top_k_bigrams_ta(const BigramCountList *lists, size_t list_count,
+                               bool lists_sorted, size_t k, BigramCountList *out);
@@ -0,0 +1,144 @@
+#include "core/arena.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct ArenaBlock {
+  ArenaBlock *next;
+  size_t cap;
+  size_t pos;
+  /* data follows */
+};
+
+#define BLOCK_DATA(b) ((unsigned char*)((b) + 1))
+
+static _Thread_local Arena *g_bound;
+
+void arena_init(Arena *a) {
+  if (!a) return;
+  memset(a, 0, sizeof(*a));
+  a->next_bytes = ARENA_BLOCK_BYTES;
+}
+
+/* Offset of the next `align`-aligned byte in b, or SIZE_MAX if `bytes`
+ * do not fit behind it.
+ */
+static size_t block_fit(const ArenaBlock *b, size_t bytes, size_t align) {
+  uintptr_t base = (uintptr_t)BLOCK_DATA(b);
+  size_t off = (size_t)(((base + b->pos + align - 1) & ~(uintptr_t)(align - 1)) - base);
+  return (off <= b->cap && bytes <= b->cap - off) ? off : SIZE_MAX;
+}
+
+/* New block with room for `need` bytes. Requests larger than a quarter
+ * block get a block of their own behind the head, so a long string does
+ * not end the head block early.
+ */
+static ArenaBlock *arena_grow(Arena *a, size_t need) {
+  size_t cap = a->next_bytes ? a->next_bytes : ARENA_BLOCK_BYTES;
+  bool own = need > cap / 4;
+  if (own) cap = need;
+  else if (a->next_bytes < ARENA_BLOCK_MAX_BYTES) a->next_bytes = cap * 2;
+
+  ArenaBlock *b = (ArenaBlock*)malloc(sizeof(ArenaBlock) + cap);
+  if (!b) return NULL;
+  b->cap = cap;
+  b->pos = 0;
+  if (own && a->head) {
+    b->next = a->head->next;
+    a->head->next = b;
+  } else {
+    b->next = a->head;
+    a->head = b;
+  }
+  a->reserved += cap;
+  if (a->reserved > a->peak_reserved) a->peak_reserved = a->reserved;
+  a->blocks++;
+  return b;
+}
+
+void *arena_alloc(Arena *a, size_t bytes, size_t align) {
+  if (!a) return NULL;
+  if (align == 0) align = 1;
+  if (bytes == 0) bytes = 1;
+
+  ArenaBlock *b = a->head;
+  size_t off = b ? block_fit(b, bytes, align) : SIZE_MAX;
+  if (off == SIZE_MAX) {
+    b = arena_grow(a, bytes + align - 1);
+    if (!b) return NULL;
+    off = block_fit(b, bytes, align);
+  }
+  b->pos = off + bytes;
+  a->used += bytes;
+  return BLOCK_DATA(b) + off;
+}
+
+void arena_reset(Arena *a) {
+  if (!a || !a->head) return;
+  ArenaBlock *keep = a->head;
+  ArenaBlock *b = keep->next;
+  while (b) {
+    ArenaBlock *n = b->next;
+    a->reserved -= b->cap;
+    free(b);
+    b = n;
+  }
+  keep->next = NULL;
+  keep->pos = 0;
+  a->used = 0;
+}
+
+void arena_free(Arena *a) {
+  if (!a) return;
+  ArenaBlock *b = a->head;
+  while (b) {
+    ArenaBlock *n = b->next;
+    free(b);
+    b = n;
+  }
+  a->head = NULL;
+  a->next_bytes = ARENA_BLOCK_BYTES;
+  a->used = 0;
+  a->reserved = 0;
+}
+
+void arena_mark(Arena *a) {
+  if (!a) return;
+  a->blocks = 0;
+  a->peak_reserved = a->reserved;
+}
+
+Arena *arena_bind(Arena *a) {
+  Arena *prev = g_bound;
+  g_bound = a;
+  return prev;
+}
+
+Arena *arena_bound(void) {
+  return g_bound;
+}
+
+/* ---------- String hooks ---------- */
+
+char *str_alloc(size_t bytes) {
+  Arena *a = g_bound;
+  return a ? (char*)arena_alloc(a, bytes, 1) : (char*)malloc(bytes ? bytes : 1);
+}
+
+char *str_dupn(const char *s, size_t n) {
+  char *out = str_alloc(n + 1);
+  if (!out) return NULL;
+  memcpy(out, s, n);
+  out[n] = '\0';
+  return out;
+}
+
+char *str_dup(const char *s) {
+  return s ? str_dupn(s, strlen(s)) : NULL;
+}
+
+void str_free(char *s) {
+  if (!g_bound) free(s);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <stddef.h>
+
+/*
+ * Request-scoped bump arena and the string hooks that allocate from it.
+ *
+ * An analysis request allocates millions of short strings (tokens,
+ * words in count lists, Top-K copies, dict keys) that all die with the
+ * request. They are taken from an Arena: blocks of growing size that are
+ * filled front to back and released in one arena_free/arena_reset.
+ *
+ * Core modules allocate these strings through str_alloc/str_dup and
+ * release them through str_free. While an arena is bound to the calling
+ * thread (arena_bind), the hooks serve from that arena and str_free is a
+ * no-op; unbound, they fall back to malloc/free. A string must therefore
+ * be released under the same binding state it was allocated in: bound
+ * (any arena of the request) or unbound. Arrays that grow with realloc
+ * (list items, token arrays, hash tables) stay on the heap.
+ */
+#ifndef ARENA_BLOCK_BYTES
+#define ARENA_BLOCK_BYTES ((size_t)64 * 1024)       // first block
+#endif
+#ifndef ARENA_BLOCK_MAX_BYTES
+#define ARENA_BLOCK_MAX_BYTES ((size_t)4 * 1024 * 1024)  // growth stops here
+#endif
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+  ArenaBlock *head;     // current block (newest first)
+  size_t next_bytes;    // size of the next block
+  size_t used;          // bytes handed out since the last reset
+  size_t reserved;      // bytes held in blocks
+  size_t peak_reserved; // since arena_init or arena_mark
+  size_t blocks;        // blocks allocated since arena_init or arena_mark
+} Arena;
+
+/* Empty arena; no memory until the first allocation. */
+void arena_init(Arena *a);
+
+/* `bytes` bytes aligned to `align` (a power of two); NULL on OOM. */
+void *arena_alloc(Arena *a, size_t bytes, size_t align);
+
+/* Drop every allocation at once; the newest block is kept for reuse. */
+void arena_reset(Arena *a);
+
+/* Release all blocks; the arena can be used again (starts small). */
+void arena_free(Arena *a);
+
+/* Restart the statistics (blocks, peak_reserved) at the current state,
+ * e.g. per request for an arena that is reused across requests.
+ */
+void arena_mark(Arena *a);
+
+/* Bind `a` (NULL: unbind) to the calling thread; returns the previous one. */
+Arena *arena_bind(Arena *a);
+
+/* Arena bound to the calling thread (NULL when unbound). */
+Arena *arena_bound(void);
+
+/* String hooks (see above). str_alloc returns room for `bytes` chars. */
+char *str_alloc(size_t bytes);
+char *str_dup(const char *s);
+char *str_dupn(const char *s, size_t n);
+void str_free(char *s);
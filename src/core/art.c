@@ -0,0 +1,535 @@
+#include "core/art.h"
+#include "core/arena.h"
+#include "core/cancel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Node kinds; ART_N0 is a leaf-only node without child slots. */
+enum { ART_N0 = 0, ART_N4, ART_N16, ART_N48, ART_N256 };
+
+/* Common header of all node kinds (16 bytes). */
+struct ArtNode {
+  uint8_t type;
+  uint8_t prefix_len;                   // compressed path bytes in prefix[]
+  uint16_t n;                           // number of children
+  uint32_t count;                       // occurrences of the key ending here
+  unsigned char prefix[ART_PREFIX_CAP];
+};
+
+typedef struct { ArtNode h; unsigned char keys[4];  ArtNode *child[4];  } ArtNode4;
+typedef struct { ArtNode h; unsigned char keys[16]; ArtNode *child[16]; } ArtNode16;
+typedef struct { ArtNode h; unsigned char index[256]; ArtNode *child[48]; } ArtNode48;  // index = slot + 1
+typedef struct { ArtNode h; ArtNode *child[256]; } ArtNode256;
+
+static size_t node_size(uint8_t type) {
+  switch (type) {
+    case ART_N4:   return sizeof(ArtNode4);
+    case ART_N16:  return sizeof(ArtNode16);
+    case ART_N48:  return sizeof(ArtNode48);
+    case ART_N256: return sizeof(ArtNode256);
+    default:       return sizeof(ArtNode);
+  }
+}
+
+static ArtNode *node_new(ArtTree *t, uint8_t type) {
+  ArtNode *n = (ArtNode*)calloc(1, node_size(type));
+  if (!n) return NULL;
+  n->type = type;
+  t->node_bytes += node_size(type);
+  return n;
+}
+
+/* Child at position i in traversal order (c receives the edge byte);
+ * NULL when i is past the last child. *i is advanced past empty slots.
+ */
+static ArtNode *child_at(const ArtNode *n, int *i, unsigned char *c) {
+  switch (n->type) {
+    case ART_N4:
+      if (*i >= n->n) return NULL;
+      *c = ((const ArtNode4*)n)->keys[*i];
+      return ((const ArtNode4*)n)->child[*i];
+    case ART_N16:
+      if (*i >= n->n) return NULL;
+      *c = ((const ArtNode16*)n)->keys[*i];
+      return ((const ArtNode16*)n)->child[*i];
+    case ART_N48: {
+      const ArtNode48 *m = (const ArtNode48*)n;
+      while (*i < 256 && !m->index[*i]) (*i)++;
+      if (*i >= 256) return NULL;
+      *c = (unsigned char)*i;
+      return m->child[m->index[*i] - 1];
+    }
+    case ART_N256: {
+      const ArtNode256 *m = (const ArtNode256*)n;
+      while (*i < 256 && !m->child[*i]) (*i)++;
+      if (*i >= 256) return NULL;
+      *c = (unsigned char)*i;
+      return m->child[*i];
+    }
+    default:
+      return NULL;
+  }
+}
+
+/* Explicit traversal stack: long keys chain many nodes, so no recursion. */
+typedef struct {
+  const ArtNode *n;
+  int next;      // next child position
+  size_t depth;  // key length up to and including n's prefix
+} ArtFrame;
+
+typedef struct {
+  ArtFrame *items;
+  size_t count, cap;
+} ArtStack;
+
+static int stack_push(ArtStack *st, const ArtNode *n, size_t depth) {
+  if (st->count == st->cap) {
+    size_t cap = st->cap ? st->cap * 2 : 32;
+    ArtFrame *nf = (ArtFrame*)realloc(st->items, cap * sizeof(ArtFrame));
+    if (!nf) return 0;
+    st->items = nf;
+    st->cap = cap;
+  }
+  st->items[st->count++] = (ArtFrame){ n, 0, depth };
+  return 1;
+}
+
+static void node_free_all(ArtNode *root) {
+  /* Post-order free with an explicit stack (long key chains). */
+  ArtStack st = {0};
+  if (!root || !stack_push(&st, root, 0)) { free(root); return; }
+
+  while (st.count > 0) {
+    ArtFrame *f = &st.items[st.count - 1];
+    unsigned char c;
+    ArtNode *child = child_at(f->n, &f->next, &c);
+    if (child) {
+      f->next++;
+      if (!stack_push(&st, child, 0)) free(child);  // OOM: only the subtree root is released
+      continue;
+    }
+    free((void*)f->n);
+    st.count--;
+  }
+  free(st.items);
+}
+
+void art_init(ArtTree *t) {
+  if (t) memset(t, 0, sizeof(*t));
+}
+
+void art_free(ArtTree *t) {
+  if (!t) return;
+  node_free_all(t->root);
+  memset(t, 0, sizeof(*t));
+}
+
+/* Child slot for edge byte c, or NULL. */
+static ArtNode **find_child(ArtNode *n, unsigned char c) {
+  switch (n->type) {
+    case ART_N4: {
+      ArtNode4 *m = (ArtNode4*)n;
+      for (int i = 0; i < n->n; i++) if (m->keys[i] == c) return &m->child[i];
+      return NULL;
+    }
+    case ART_N16: {
+      ArtNode16 *m = (ArtNode16*)n;
+      for (int i = 0; i < n->n; i++) if (m->keys[i] == c) return &m->child[i];
+      return NULL;
+    }
+    case ART_N48: {
+      ArtNode48 *m = (ArtNode48*)n;
+      return m->index[c] ? &m->child[m->index[c] - 1] : NULL;
+    }
+    case ART_N256: {
+      ArtNode256 *m = (ArtNode256*)n;
+      return m->child[c] ? &m->child[c] : NULL;
+    }
+    default:
+      return NULL;
+  }
+}
+
+/* Copy the header into a node of the next larger kind and move children. */
+static ArtNode *node_grow(ArtTree *t, ArtNode *n) {
+  uint8_t next = (uint8_t)(n->type + 1);
+  ArtNode *g = node_new(t, next);
+  if (!g) return NULL;
+  memcpy(g, n, sizeof(ArtNode));
+  g->type = next;
+
+  switch (n->type) {
+    case ART_N0:
+      break;
+    case ART_N4: {
+      ArtNode4 *s = (ArtNode4*)n;
+      ArtNode16 *d = (ArtNode16*)g;
+      memcpy(d->keys, s->keys, n->n);
+      memcpy(d->child, s->child, n->n * sizeof(ArtNode*));
+      break;
+    }
+    case ART_N16: {
+      ArtNode16 *s = (ArtNode16*)n;
+      ArtNode48 *d = (ArtNode48*)g;
+      for (int i = 0; i < n->n; i++) {
+        d->index[s->keys[i]] = (unsigned char)(i + 1);
+        d->child[i] = s->child[i];
+      }
+      break;
+    }
+    case ART_N48: {
+      ArtNode48 *s = (ArtNode48*)n;
+      ArtNode256 *d = (ArtNode256*)g;
+      for (int c = 0; c < 256; c++) {
+        if (s->index[c]) d->child[c] = s->child[s->index[c] - 1];
+      }
+      break;
+    }
+    default:
+      break;
+  }
+
+  t->node_bytes -= node_size(n->type);
+  free(n);
+  return g;
+}
+
+/* Insert child under edge byte c (absent so far); may replace *ref. */
+static int add_child(ArtTree *t, ArtNode **ref, unsigned char c, ArtNode *child) {
+  ArtNode *n = *ref;
+  int full = (n->type == ART_N0) ||
+             (n->type == ART_N4 && n->n == 4) ||
+             (n->type == ART_N16 && n->n == 16) ||
+             (n->type == ART_N48 && n->n == 48);
+  if (full) {
+    n = node_grow(t, n);
+    if (!n) return 0;
+    *ref = n;
+  }
+
+  switch (n->type) {
+    case ART_N4:
+    case ART_N16: {
+      /* Keys stay sorted so traversal is ordered without extra work. */
+      unsigned char *keys = (n->type == ART_N4) ? ((ArtNode4*)n)->keys : ((ArtNode16*)n)->keys;
+      ArtNode **kids = (n->type == ART_N4) ? ((ArtNode4*)n)->child : ((ArtNode16*)n)->child;
+      int i = n->n;
+      while (i > 0 && keys[i - 1] > c) {
+        keys[i] = keys[i - 1];
+        kids[i] = kids[i - 1];
+        i--;
+      }
+      keys[i] = c;
+      kids[i] = child;
+      break;
+    }
+    case ART_N48: {
+      ArtNode48 *m = (ArtNode48*)n;
+      m->child[n->n] = child;
+      m->index[c] = (unsigned char)(n->n + 1);
+      break;
+    }
+    default:
+      ((ArtNode256*)n)->child[c] = child;
+      break;
+  }
+  n->n++;
+  return 1;
+}
+
+/* New path for the remaining key bytes, ending in a node with count 1.
+ * Suffixes longer than ART_PREFIX_CAP continue in single-child nodes.
+ */
+static ArtNode *make_path(ArtTree *t, const unsigned char *s, size_t len) {
+  ArtNode *head = NULL;
+  ArtNode **link = &head;
+
+  for (;;) {
+    size_t take = len < ART_PREFIX_CAP ? len : ART_PREFIX_CAP;
+    int more = len > take;
+
+    ArtNode *n = node_new(t, more ? ART_N4 : ART_N0);
+    if (!n) { node_free_all(head); return NULL; }
+    n->prefix_len = (uint8_t)take;
+    memcpy(n->prefix, s, take);
+    *link = n;
+
+    if (!more) {
+      n->count = 1;
+      return head;
+    }
+
+    ArtNode4 *m = (ArtNode4*)n;
+    m->keys[0] = s[take];
+    n->n = 1;
+    link = &m->child[0];
+    s += take + 1;
+    len -= take + 1;
+  }
+}
+
+int art_inc(ArtTree *t, const unsigned char *key, size_t len) {
+  if (!t || (!key && len)) return 0;
+
+  ArtNode **ref = &t->root;
+  size_t depth = 0;
+
+  for (;;) {
+    ArtNode *n = *ref;
+    if (!n) {
+      n = make_path(t, key + depth, len - depth);
+      if (!n) return 0;
+      *ref = n;
+      t->size++;
+      return 1;
+    }
+
+    /* Compare the compressed path. */
+    size_t p = 0;
+    while (p < n->prefix_len && depth + p < len && n->prefix[p] == key[depth + p]) p++;
+
+    if (p < n->prefix_len) {
+      /* Mismatch inside the path: split into a new parent holding the
+       * common part; the old node keeps the tail after the edge byte.
+       */
+      ArtNode *parent = node_new(t, ART_N4);
+      if (!parent) return 0;
+      parent->prefix_len = (uint8_t)p;
+      memcpy(parent->prefix, n->prefix, p);
+
+      unsigned char edge = n->prefix[p];
+      n->prefix_len = (uint8_t)(n->prefix_len - p - 1);
+      memmove(n->prefix, n->prefix + p + 1, n->prefix_len);
+
+      ArtNode4 *m = (ArtNode4*)parent;
+      m->keys[0] = edge;
+      m->child[0] = n;
+      parent->n = 1;
+      *ref = parent;
+
+      depth += p;
+      if (depth == len) {
+        parent->count = 1;
+        t->size++;
+        return 1;
+      }
+      ArtNode *leaf = make_path(t, key + depth + 1, len - depth - 1);
+      if (!leaf) return 0;
+      if (!add_child(t, ref, key[depth], leaf)) { node_free_all(leaf); return 0; }
+      t->size++;
+      return 1;
+    }
+
+    depth += n->prefix_len;
+    if (depth == len) {
+      if (n->count == 0) t->size++;
+      n->count++;
+      return 1;
+    }
+
+    ArtNode **child = find_child(n, key[depth]);
+    if (child) {
+      ref = child;
+      depth++;
+      continue;
+    }
+
+    ArtNode *leaf = make_path(t, key + depth + 1, len - depth - 1);
+    if (!leaf) return 0;
+    if (!add_child(t, ref, key[depth], leaf)) { node_free_all(leaf); return 0; }
+    t->size++;
+    return 1;
+  }
+}
+
+uint32_t art_get(const ArtTree *t, const unsigned char *key, size_t len) {
+  if (!t || (!key && len)) return 0;
+
+  ArtNode *n = t->root;
+  size_t depth = 0;
+  while (n) {
+    if (n->prefix_len > len - depth) return 0;
+    if (memcmp(n->prefix, key + depth, n->prefix_len) != 0) return 0;
+    depth += n->prefix_len;
+    if (depth == len) return n->count;
+
+    ArtNode **child = find_child(n, key[depth]);
+    if (!child) return 0;
+    n = *child;
+    depth++;
+  }
+  return 0;
+}
+
+static int buf_reserve(unsigned char **buf, size_t *cap, size_t need) {
+  if (need <= *cap) return 1;
+  size_t c = *cap ? *cap : 64;
+  while (c < need) c *= 2;
+  unsigned char *nb = (unsigned char*)realloc(*buf, c);
+  if (!nb) return 0;
+  *buf = nb;
+  *cap = c;
+  return 1;
+}
+
+int art_iter(const ArtTree *t, art_visit_fn fn, void *ctx) {
+  if (!t || !fn) return 0;
+  if (!t->root) return 1;
+
+  unsigned char *buf = NULL;
+  size_t cap = 0;
+  ArtStack st = {0};
+  int ok = 1;
+
+  /* Enter a node: append its prefix, visit a key ending here first
+   * (it is a prefix of everything below), then walk children in order.
+   */
+  const ArtNode *n = t->root;
+  size_t depth = 0;
+  for (;;) {
+    if (n) {
+      if (!buf_reserve(&buf, &cap, depth + n->prefix_len + 1)) { ok = 0; break; }
+      memcpy(buf + depth, n->prefix, n->prefix_len);
+      depth += n->prefix_len;
+      if (n->count && !fn(ctx, buf, depth, n->count)) { ok = 0; break; }
+      if (!stack_push(&st, n, depth)) { ok = 0; break; }
+      n = NULL;
+    }
+    if (st.count == 0) break;
+
+    ArtFrame *f = &st.items[st.count - 1];
+    unsigned char c;
+    const ArtNode *child = child_at(f->n, &f->next, &c);
+    if (!child) {
+      st.count--;
+      continue;
+    }
+    f->next++;
+    buf[f->depth] = c;
+    depth = f->depth + 1;
+    n = child;
+  }
+
+  free(st.items);
+  free(buf);
+  return ok;
+}
+
+/* ---------- Counting stages ---------- */
+
+/* Visitor output: list preallocated with tree size entries. */
+static int emit_word(void *ctx, const unsigned char *key, size_t len, uint32_t count) {
+  WordCountList *l = (WordCountList*)ctx;
+  WordCount *wc = &l->items[l->count];
+  wc->word = str_dupn((const char*)key, len);
+  if (!wc->word) return 0;
+  wc->count = count;
+  l->count++;
+  return 1;
+}
+
+int art_count_words(const TokenList *filtered, WordCountList *out_words) {
+  if (!filtered || !out_words) return 0;
+  *out_words = (WordCountList){0};
+
+  ArtTree t;
+  art_init(&t);
+  for (size_t i = 0; i < filtered->count; i++) {
+    if (cancel_poll(i)) goto fail;
+    const char *w = filtered->items[i];
+    if (!w || !*w) continue;
+    if (!art_inc(&t, (const unsigned char*)w, strlen(w))) goto fail;
+  }
+
+  /* In-order traversal: words come out lexicographically sorted. */
+  if (t.size > 0) {
+    out_words->items = (WordCount*)calloc(t.size, sizeof(WordCount));
+    if (!out_words->items) goto fail;
+    if (!art_iter(&t, emit_word, out_words)) goto fail;
+  }
+
+  art_free(&t);
+  return 1;
+
+fail:
+  art_free(&t);
+  free_word_counts(out_words);
+  return 0;
+}
+
+/* Bigram keys are "w1\0w2": NUL sorts below every token byte, so key
+ * order equals (w1, w2) order.
+ */
+static int emit_bigram(void *ctx, const unsigned char *key, size_t len, uint32_t count) {
+  BigramCountList *l = (BigramCountList*)ctx;
+  const unsigned char *sep = (const unsigned char*)memchr(key, '\0', len);
+  if (!sep) return 1;
+
+  size_t n1 = (size_t)(sep - key);
+  BigramCount *bc = &l->items[l->count];
+  bc->w1 = str_dupn((const char*)key, n1);
+  bc->w2 = str_dupn((const char*)sep + 1, len - n1 - 1);
+  l->count++;
+  if (!bc->w1 || !bc->w2) return 0;
+  bc->count = count;
+  return 1;
+}
+
+int art_count_bigrams_excluding_stopwords(const TokenList *raw,
+                                          const StopwordList *sw,
+                                          BigramCountList *out_bigrams) {
+  if (!raw || !sw || !out_bigrams) return 0;
+  *out_bigrams = (BigramCountList){0};
+
+  ArtTree t;
+  art_init(&t);
+  unsigned char *key = NULL;
+  size_t key_cap = 0;
+
+  const char *prev = NULL;
+  size_t prev_len = 0;
+  for (size_t i = 0; i < raw->count; i++) {
+    if (cancel_poll(i)) goto fail;
+    const char *tok = raw->items[i];
+
+    /* No bridging across dropped tokens (keeps bigrams local to valid runs). */
+    if (bigram_token_ignored(tok, sw)) { prev = NULL; continue; }
+
+    size_t len = strlen(tok);
+    if (prev) {
+      size_t need = prev_len + 1 + len;
+      if (need > key_cap) {
+        size_t cap = key_cap ? key_cap : 64;
+        while (cap < need) cap *= 2;
+        unsigned char *nk = (unsigned char*)realloc(key, cap);
+        if (!nk) goto fail;
+        key = nk;
+        key_cap = cap;
+      }
+      memcpy(key, prev, prev_len);
+      key[prev_len] = '\0';
+      memcpy(key + prev_len + 1, tok, len);
+      if (!art_inc(&t, key, need)) goto fail;
+    }
+    prev = tok;
+    prev_len = len;
+  }
+
+  if (t.size > 0) {
+    out_bigrams->items = (BigramCount*)calloc(t.size, sizeof(BigramCount));
+    if (!out_bigrams->items) goto fail;
+    if (!art_iter(&t, emit_bigram, out_bigrams)) goto fail;
+  }
+
+  free(key);
+  art_free(&t);
+  return 1;
+
+fail:
+  free(key);
+  art_free(&t);
+  free_bigram_counts(out_bigrams);
+  return 0;
+}
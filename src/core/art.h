@@ -0,0 +1,62 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/tokenizer.h"
+#include "core/stopwords.h"
+#include "core/freq.h"
+#include "core/bigrams.h"
+
+/*
+ * Adaptive radix tree (ART) counter for byte-string keys.
+ *
+ * Inner nodes adapt their fan-out (4 / 16 / 48 / 256 children) and keep
+ * up to ART_PREFIX_CAP compressed path bytes; longer unique suffixes are
+ * chained through single-child nodes. A key ends at the node whose path
+ * spells it, so shared prefixes (German compounds, inflections) are stored
+ * once instead of once per malloc'd string.
+ *
+ * In-order traversal visits keys in lexicographic (memcmp) order, which is
+ * exactly the tie-break order of the Top-K view.
+ */
+#ifndef ART_PREFIX_CAP
+#define ART_PREFIX_CAP 8
+#endif
+
+typedef struct ArtNode ArtNode;
+
+typedef struct {
+  ArtNode *root;
+  size_t size;        // distinct keys
+  size_t node_bytes;  // bytes held by nodes (measurement point)
+} ArtTree;
+
+/* Initialize an empty tree. */
+void art_init(ArtTree *t);
+
+/* Release all nodes. */
+void art_free(ArtTree *t);
+
+/* Increment the count of key (len bytes, may contain NUL). 0 on OOM. */
+int art_inc(ArtTree *t, const unsigned char *key, size_t len);
+
+/* Count of key (0 if absent). */
+uint32_t art_get(const ArtTree *t, const unsigned char *key, size_t len);
+
+/* Visitor for art_iter; return 0 to stop the traversal. */
+typedef int (*art_visit_fn)(void *ctx, const unsigned char *key, size_t len, uint32_t count);
+
+/* Visit all keys in lexicographic order. Returns 0 if stopped or on OOM. */
+int art_iter(const ArtTree *t, art_visit_fn fn, void *ctx);
+
+/*
+ * Counting stages of the ART pipeline. Output lists are sorted
+ * lexicographically (words; bigrams by w1, then w2). Fail once the
+ * bound deadline passes (core/cancel.h).
+ */
+int art_count_words(const TokenList *filtered, WordCountList *out_words);
+
+/* Same adjacency rules as the hash engine (no bridging over dropped tokens). */
+int art_count_bigrams_excluding_stopwords(const TokenList *raw,
+                                          const StopwordList *sw,
+                                          BigramCountList *out_bigrams);
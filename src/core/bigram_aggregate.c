@@ -1,18 +1,10 @@
 #include "core/bigram_aggregate.h"
+#include "core/arena.h"
+#include "core/cancel.h"
 
 #include <stdlib.h>
 #include <string.h>
 
-/* Aggregation output owns its own copies of strings. */
-static char *dup_cstr(const char *s) {
-    if (!s) return NULL;
-    size_t n = strlen(s);
-    char *out = (char *)malloc(n + 1);
-    if (!out) return NULL;
-    memcpy(out, s, n + 1);
-    return out;
-}
-
 /* Compare helper for (w1,w2) matching during merge. */
 static int bigram_equals_parts(const BigramCount *b, const char *w1, const char *w2) {
     return b && b->w1 && b->w2 && w1 && w2 &&
@@ -31,9 +23,12 @@ BigramCountList aggregate_bigram_counts(
     out.items = (BigramCount *)calloc(cap, sizeof(BigramCount));
     if (!out.items) return (BigramCountList){0};
 
+    /* Every entry scans the list: poll more often. */
+    size_t seen = 0;
     for (size_t i = 0; i < list_count; i++) {
         const BigramCountList *src = &lists[i];
         for (size_t j = 0; j < src->count; j++) {
+            if (cancel_poll_every(++seen, CANCEL_POLL_EVERY_SCAN)) return out;
             const char *w1 = src->items[j].w1;
             const char *w2 = src->items[j].w2;
             size_t cnt = src->items[j].count;
@@ -67,8 +62,8 @@ BigramCountList aggregate_bigram_counts(
                 out.items = tmp;
             }
 
-            out.items[out.count].w1 = dup_cstr(w1);
-            out.items[out.count].w2 = dup_cstr(w2);
+            out.items[out.count].w1 = str_dup(w1);
+            out.items[out.count].w2 = str_dup(w2);
             if (!out.items[out.count].w1 || !out.items[out.count].w2) {
                 free_aggregated_bigram_counts(&out);
                 return (BigramCountList){0};
@@ -81,12 +76,99 @@ BigramCountList aggregate_bigram_counts(
     return out;
 }
 
+/* Heap of list cursors, ordered by the current (w1, w2) of each list. */
+typedef struct {
+    const BigramCountList *lists;
+    size_t *pos;   // cursor per list
+    size_t *heap;  // list indices
+    size_t n;
+} BigramMergeHeap;
+
+static int bigram_cmp_parts(const BigramCount *a, const BigramCount *b) {
+    int c = strcmp(a->w1 ? a->w1 : "", b->w1 ? b->w1 : "");
+    if (c != 0) return c;
+    return strcmp(a->w2 ? a->w2 : "", b->w2 ? b->w2 : "");
+}
+
+static int heap_less(const BigramMergeHeap *h, size_t a, size_t b) {
+    return bigram_cmp_parts(&h->lists[a].items[h->pos[a]], &h->lists[b].items[h->pos[b]]) < 0;
+}
+
+static void heap_sift_down(BigramMergeHeap *h, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1, m = i;
+        if (l < h->n && heap_less(h, h->heap[l], h->heap[m])) m = l;
+        if (l + 1 < h->n && heap_less(h, h->heap[l + 1], h->heap[m])) m = l + 1;
+        if (m == i) return;
+        size_t t = h->heap[i]; h->heap[i] = h->heap[m]; h->heap[m] = t;
+        i = m;
+    }
+}
+
+BigramCountList aggregate_bigram_counts_sorted(
+    const BigramCountList *lists,
+    size_t list_count
+) {
+    BigramCountList out = (BigramCountList){0};
+    if (!lists || list_count == 0) return out;
+
+    size_t total = 0;
+    for (size_t i = 0; i < list_count; i++) total += lists[i].count;
+    if (total == 0) return out;
+
+    BigramMergeHeap h = { lists, NULL, NULL, 0 };
+    h.pos = (size_t *)calloc(list_count, sizeof(size_t));
+    h.heap = (size_t *)malloc(list_count * sizeof(size_t));
+    out.items = (BigramCount *)calloc(total, sizeof(BigramCount));
+    if (!h.pos || !h.heap || !out.items) goto fail;
+
+    for (size_t i = 0; i < list_count; i++) {
+        if (lists[i].count > 0) h.heap[h.n++] = i;
+    }
+    for (size_t i = h.n / 2; i-- > 0; ) heap_sift_down(&h, i);
+
+    /* Pop the smallest pair; equal pairs arrive back to back. */
+    size_t popped = 0;
+    while (h.n > 0) {
+        if (cancel_poll(++popped)) break;
+        size_t li = h.heap[0];
+        const BigramCount *bc = &lists[li].items[h.pos[li]];
+
+        /* Same skip rules as aggregate_bigram_counts. */
+        if (bc->w1 && bc->w2 && bc->w1[0] != '\0' && bc->w2[0] != '\0' && bc->count > 0) {
+            if (out.count > 0 && bigram_cmp_parts(&out.items[out.count - 1], bc) == 0) {
+                out.items[out.count - 1].count += bc->count;
+            } else {
+                BigramCount *dst = &out.items[out.count];
+                dst->w1 = str_dup(bc->w1);
+                dst->w2 = str_dup(bc->w2);
+                out.count++;
+                if (!dst->w1 || !dst->w2) goto fail;
+                dst->count = bc->count;
+            }
+        }
+
+        if (++h.pos[li] == lists[li].count) h.heap[0] = h.heap[--h.n];
+        heap_sift_down(&h, 0);
+    }
+
+    free(h.pos);
+    free(h.heap);
+    return out;
+
+fail:
+    free(h.pos);
+    free(h.heap);
+    free_aggregated_bigram_counts(&out);
+    return (BigramCountList){0};
+}
+
 /* Free helper for aggregated (domain-level) bigram list. */
 void free_aggregated_bigram_counts(BigramCountList *list) {
     if (!list || !list->items) return;
     for (size_t i = 0; i < list->count; i++) {
-        free(list->items[i].w1);
-        free(list->items[i].w2);
+        str_free(list->items[i].w1);
+        str_free(list->items[i].w2);
         list->items[i].w1 = NULL;
         list->items[i].w2 = NULL;
         list->items[i].count = 0;
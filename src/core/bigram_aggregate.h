@@ -7,12 +7,23 @@
 /*
  * Domain-level aggregation for bigram results.
  * Merges per-page BigramCountLists into a single combined list.
+ * Stops early once the bound deadline passes (core/cancel.h), as does
+ * the sorted merge below.
  */
 BigramCountList aggregate_bigram_counts(
     const BigramCountList *lists,
     size_t list_count
 );
 
+/*
+ * Same result for input lists that are each sorted by (w1, w2) ASC
+ * without duplicates: k-way heap merge, output stays sorted.
+ */
+BigramCountList aggregate_bigram_counts_sorted(
+    const BigramCountList *lists,
+    size_t list_count
+);
+
 /* Release memory of an aggregated BigramCountList. */
 void free_aggregated_bigram_counts(BigramCountList *list);
 
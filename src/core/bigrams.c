@@ -1,19 +1,11 @@
 #include "core/bigrams.h"
+#include "core/arena.h"
+#include "core/cancel.h"
 
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
-/* Local helper: output owns its own copies of token strings. */
-static char *dup_cstr(const char *s) {
-    if (!s) return NULL;
-    size_t n = strlen(s);
-    char *out = (char *)malloc(n + 1);
-    if (!out) return NULL;
-    memcpy(out, s, n + 1);
-    return out;
-}
-
 /* Compares a stored bigram entry against (w1,w2). */
 static int bigram_equals(const BigramCount *b, const char *w1, const char *w2) {
     return b && b->w1 && b->w2 && w1 && w2 &&
@@ -31,7 +23,7 @@ static int is_all_digits(const char *s) {
 /* Shared token validity rules for bigram counting.
  * Matches the filtering stage (minlen, digits-only, stopwords).
  */
-static int token_should_be_ignored(const char *tok, const StopwordList *sw) {
+int bigram_token_ignored(const char *tok, const StopwordList *sw) {
     if (!tok || tok[0] == '\0') return 1;
 
     /* Min length guard to avoid noisy tokens ("e", ...). */
@@ -90,8 +82,8 @@ BigramCountList count_bigrams(const TokenList *tokens) {
             out.items = tmp;
         }
 
-        out.items[out.count].w1 = dup_cstr(w1);
-        out.items[out.count].w2 = dup_cstr(w2);
+        out.items[out.count].w1 = str_dup(w1);
+        out.items[out.count].w2 = str_dup(w2);
         if (!out.items[out.count].w1 || !out.items[out.count].w2) {
             free_bigram_counts(&out);
             return (BigramCountList){0};
@@ -116,10 +108,13 @@ BigramCountList count_bigrams_excluding_stopwords(const TokenList *tokens,
     if (!out.items) return (BigramCountList){0};
 
     for (size_t i = 0; i + 1 < tokens->count; i++) {
+        /* Every pair scans the list: poll more often. */
+        if (cancel_poll_every(i, CANCEL_POLL_EVERY_SCAN)) break;
+
         const char *w1 = tokens->items[i];
         const char *w2 = tokens->items[i + 1];
 
-        if (token_should_be_ignored(w1, sw) || token_should_be_ignored(w2, sw)) {
+        if (bigram_token_ignored(w1, sw) || bigram_token_ignored(w2, sw)) {
             continue;
         }
 
@@ -148,8 +143,8 @@ BigramCountList count_bigrams_excluding_stopwords(const TokenList *tokens,
             out.items = tmp;
         }
 
-        out.items[out.count].w1 = dup_cstr(w1);
-        out.items[out.count].w2 = dup_cstr(w2);
+        out.items[out.count].w1 = str_dup(w1);
+        out.items[out.count].w2 = str_dup(w2);
         if (!out.items[out.count].w1 || !out.items[out.count].w2) {
             free_bigram_counts(&out);
             return (BigramCountList){0};
@@ -176,8 +171,8 @@ void free_bigram_counts(BigramCountList *list) {
     if (!list || !list->items) return;
 
     for (size_t i = 0; i < list->count; i++) {
-        free(list->items[i].w1);
-        free(list->items[i].w2);
+        str_free(list->items[i].w1);
+        str_free(list->items[i].w2);
         list->items[i].w1 = NULL;
         list->items[i].w2 = NULL;
         list->items[i].count = 0;
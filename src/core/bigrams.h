@@ -29,10 +29,19 @@ BigramCountList count_bigrams(const TokenList *tokens);
 /*
  * Count bigrams while excluding stopwords and invalid tokens.
  * No bridging: dropped tokens break adjacency (keeps original runs intact).
+ * Stops early once the bound deadline passes (core/cancel.h).
  */
 BigramCountList count_bigrams_excluding_stopwords(const TokenList *tokens,
                                                   const StopwordList *sw);
 
+/*
+ * Token rule shared by all counters that skip tokens inline (bigram
+ * counters, ID streams, approximate summaries): non-zero if tok is
+ * dropped (empty, shorter than 2 bytes, digits-only, stopword) and breaks
+ * adjacency. Same rule as the filter stage.
+ */
+int bigram_token_ignored(const char *tok, const StopwordList *sw);
+
 /* Release memory owned by BigramCountList. */
 void free_bigram_counts(BigramCountList *list);
 
@@ -0,0 +1,45 @@
+#include "core/cancel.h"
+
+#include <time.h>
+
+static _Thread_local Cancel *g_bound;
+
+void cancel_init(Cancel *c, double deadline_ms) {
+  if (!c) return;
+  c->deadline_ms = deadline_ms;
+  atomic_init(&c->tripped, false);
+}
+
+Cancel *cancel_bind(Cancel *c) {
+  Cancel *prev = g_bound;
+  g_bound = c;
+  return prev;
+}
+
+Cancel *cancel_bound(void) {
+  return g_bound;
+}
+
+double cancel_now_ms(void) {
+#if defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+#else
+  return (double)clock() * 1000.0 / (double)CLOCKS_PER_SEC;
+#endif
+}
+
+bool cancel_check(void) {
+  Cancel *c = g_bound;
+  if (!c) return false;
+  if (atomic_load_explicit(&c->tripped, memory_order_relaxed)) return true;
+  if (c->deadline_ms <= 0.0 || cancel_now_ms() <= c->deadline_ms) return false;
+  atomic_store_explicit(&c->tripped, true, memory_order_relaxed);
+  return true;
+}
+
+bool cancel_requested(void) {
+  Cancel *c = g_bound;
+  return c && atomic_load_explicit(&c->tripped, memory_order_relaxed);
+}
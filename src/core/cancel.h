@@ -0,0 +1,56 @@
+#pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Cooperative cancellation of hot loops.
+ *
+ * Deadline checks between stages do not bound a request: one huge page
+ * spends seconds inside the tokenizer, a counting loop, a sort or the
+ * domain merge. Those loops poll the Cancel bound to the calling thread
+ * (cancel_bind) every CANCEL_POLL_EVERY iterations, one clock read per
+ * poll, and stop once its deadline has passed:
+ * - functions returning int fail (0, nothing left allocated);
+ * - functions returning a list return the part built so far.
+ * Either way the caller checks cancel_requested() and discards the
+ * result. A tripped Cancel stays tripped, so the other threads bound to
+ * it stop at their next poll. Unbound threads never stop.
+ */
+#define CANCEL_POLL_EVERY ((size_t)1 << 16)
+
+/* For loops whose iterations scan a list (linear lookups). */
+#define CANCEL_POLL_EVERY_SCAN ((size_t)1 << 10)
+
+typedef struct {
+  double deadline_ms;    // cancel_now_ms() clock; 0 = none
+  atomic_bool tripped;
+} Cancel;
+
+void cancel_init(Cancel *c, double deadline_ms);
+
+/* Bind `c` (NULL: unbind) to the calling thread; returns the previous one. */
+Cancel *cancel_bind(Cancel *c);
+
+/* Cancel bound to the calling thread (NULL when unbound). */
+Cancel *cancel_bound(void);
+
+/* Monotonic clock (ms) of deadline_ms. */
+double cancel_now_ms(void);
+
+/* Reads the clock; trips the bound Cancel once its deadline has passed. */
+bool cancel_check(void);
+
+/* Whether the bound Cancel has tripped (no clock read). */
+bool cancel_requested(void);
+
+/* Poll point of a loop at position i: every `every` (a power of two)
+ * positions, not at 0. Chunked loops pass their chunk base.
+ */
+static inline bool cancel_poll_every(size_t i, size_t every) {
+  return i != 0 && (i & (every - 1)) == 0 && cancel_check();
+}
+
+static inline bool cancel_poll(size_t i) {
+  return cancel_poll_every(i, CANCEL_POLL_EVERY);
+}
@@ -1,26 +1,25 @@
 #include "core/dict.h"
+#include "core/arena.h"
+#include "core/table_alloc.h"
+#include "core/hash_seed.h"
 #include <stdlib.h>
 #include <string.h>
 
-/* Hash function for token keys (stable across runs). */
-static uint64_t fnv1a64(const char *s) {
-  uint64_t h = 1469598103934665603ULL;
+/* Seeded hash for token keys: FNV-1a over a seeded basis plus a final
+ * avalanche, so crafted inputs cannot target the low (mask) bits.
+ */
+static uint64_t fnv1a64(const char *s, uint64_t seed) {
+  uint64_t h = 1469598103934665603ULL ^ seed;
   for (const unsigned char *p = (const unsigned char*)s; *p; ++p) {
     h ^= (uint64_t)(*p);
     h *= 1099511628211ULL;
   }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
   return h;
 }
 
-/* Duplicate token string for dictionary ownership. */
-static char *dup_cstr(const char *s) {
-  size_t n = strlen(s);
-  char *out = (char*)malloc(n + 1);
-  if (!out) return NULL;
-  memcpy(out, s, n + 1);
-  return out;
-}
-
 /* Utility for power-of-two capacity (mask-based probing). */
 static size_t next_pow2(size_t x) {
   size_t p = 1;
@@ -28,7 +27,20 @@ static size_t next_pow2(size_t x) {
   return p;
 }
 
-static int dict_grow(Dict *d);
+/* Old buckets migrated per dict_get_or_add call while a rehash is running.
+ * Any value >= 2 drains the old table before the new one hits 0.7 load.
+ */
+#define DICT_REHASH_STEP 16
+
+/* Probe length that counts as a collision attack (or a bad seed). The
+ * insert then rekeys the table once with a fresh seed and retries.
+ */
+#ifndef DICT_MAX_PROBE
+#define DICT_MAX_PROBE 512
+#endif
+
+static int dict_grow(Dict *d, size_t new_cap);
+static void dict_rehash_step(Dict *d, size_t max_buckets);
 
 int dict_init(Dict *d, size_t initial_cap) {
   if (!d) return 0;
@@ -36,34 +48,64 @@ int dict_init(Dict *d, size_t initial_cap) {
 
   /* Hash table for word → id, open addressing. */
   d->cap = next_pow2(initial_cap < 16 ? 16 : initial_cap);
-  d->entries = (DictEntry*)calloc(d->cap, sizeof(DictEntry));
+  d->seed = hash_seed();
+  d->gen = 1;
+  d->entries = (DictEntry*)table_alloc(d->cap * sizeof(DictEntry));
   if (!d->entries) return 0;
 
   /* Dense id → word lookup (index = id - 1). */
   d->id_cap = 16;
-  d->id_to_word = (char**)calloc(d->id_cap, sizeof(char*));
-  if (!d->id_to_word) { free(d->entries); memset(d,0,sizeof(*d)); return 0; }
+  d->id_to_word = (char**)table_alloc(d->id_cap * sizeof(char*));
+  if (!d->id_to_word) {
+    table_free(d->entries, d->cap * sizeof(DictEntry));
+    memset(d, 0, sizeof(*d));
+    return 0;
+  }
   return 1;
 }
 
+/* Every key appears once in id_to_word (both tables point to it).
+ * Keys from a bound arena go with the arena; skip the walk.
+ */
+static void dict_free_keys(Dict *d) {
+  if (arena_bound()) return;
+  for (size_t i = 0; i < d->id_size; i++) free(d->id_to_word[i]);
+}
+
 void dict_free(Dict *d) {
   if (!d) return;
 
-  if (d->entries) {
-    for (size_t i = 0; i < d->cap; i++) {
-      if (d->entries[i].used) free(d->entries[i].key);
-    }
-    free(d->entries);
-  }
-
   if (d->id_to_word) {
-    /* id_to_word points to the same owned strings as entries[].key. */
-    free(d->id_to_word);
+    dict_free_keys(d);
+    table_free(d->id_to_word, d->id_cap * sizeof(char*));
   }
+  if (d->entries) table_free(d->entries, d->cap * sizeof(DictEntry));
+  if (d->old_entries) table_free(d->old_entries, d->old_cap * sizeof(DictEntry));
 
   memset(d, 0, sizeof(*d));
 }
 
+void dict_reset(Dict *d) {
+  if (!d || !d->entries) return;
+  dict_free_keys(d);
+
+  if (d->old_entries) {
+    table_free(d->old_entries, d->old_cap * sizeof(DictEntry));
+    d->old_entries = NULL;
+    d->old_cap = 0;
+    d->rehash_pos = 0;
+  }
+
+  /* Stale entries read as free; clear only when the counter wraps. */
+  if (++d->gen == 0) {
+    memset(d->entries, 0, d->cap * sizeof(DictEntry));
+    d->gen = 1;
+  }
+  d->size = 0;
+  d->id_size = 0;
+  d->seed = hash_seed_next(d->seed);
+}
+
 size_t dict_size(const Dict *d) { return d ? d->size : 0; }
 
 const char *dict_word(const Dict *d, uint32_t id) {
@@ -79,46 +121,98 @@ static int ensure_id_cap(Dict *d, size_t need) {
   size_t new_cap = d->id_cap;
   while (new_cap < need) new_cap *= 2;
 
-  char **nw = (char**)realloc(d->id_to_word, new_cap * sizeof(char*));
+  /* New region comes back zeroed (NULL) for deterministic access. */
+  char **nw = (char**)table_grow(d->id_to_word, d->id_cap * sizeof(char*),
+                                 new_cap * sizeof(char*));
   if (!nw) return 0;
-
-  /* Zero new region for deterministic access. */
-  for (size_t i = d->id_cap; i < new_cap; i++) nw[i] = NULL;
   d->id_to_word = nw;
   d->id_cap = new_cap;
   return 1;
 }
 
+/* Lookup in the previous table during an incremental rehash.
+ * Buckets below rehash_pos are already migrated (and cleared), so probing
+ * skips them; a key in a cleared bucket lives in the new table. A chain
+ * that wraps past the end continues behind the cleared prefix, up to its
+ * home bucket; one that starts inside the prefix ends at the wrap.
+ */
+static DictEntry *dict_find_old(Dict *d, const char *word) {
+  if (!d->old_entries) return NULL;
+
+  uint64_t h = fnv1a64(word, d->old_seed);
+  size_t mask = d->old_cap - 1;
+  size_t home = (size_t)h & mask;
+  size_t pos = home < d->rehash_pos ? d->rehash_pos : home;
+
+  while (d->old_entries[pos].gen == d->gen) {
+    if (strcmp(d->old_entries[pos].key, word) == 0) return &d->old_entries[pos];
+    pos = (pos + 1) & mask;
+    if (pos < d->rehash_pos) {
+      if (home < d->rehash_pos) return NULL;
+      pos = d->rehash_pos;
+    }
+    if (pos == home) return NULL;
+  }
+  return NULL;
+}
+
 /* Lookup or insert a word, returning a stable ID (>= 1).
  * Central operation for ID-based word and bigram counting.
+ * h is the word hash under h_seed; it is recomputed if the table has
+ * been rekeyed since (grow/rekey always switch to a new seed).
  */
-static int dict_insert(Dict *d, const char *word, uint32_t *out_id) {
+static int dict_insert(Dict *d, const char *word, uint64_t h, uint64_t h_seed,
+                       uint32_t *out_id) {
+  /* Amortized rehash: move a bounded number of old buckets per call. */
+  if (d->old_entries) dict_rehash_step(d, DICT_REHASH_STEP);
+
   /* Grow at ~0.7 load factor to keep probing cheap. */
   if (d->size * 10 >= d->cap * 7) {
-    if (!dict_grow(d)) return 0;
+    if (!dict_grow(d, d->cap * 2)) return 0;
   }
 
-  uint64_t h = fnv1a64(word);
-  size_t mask = d->cap - 1;
-  size_t pos = (size_t)h & mask;
+  int rekeyed = 0;
+  size_t mask, pos, probes;
+probe:
+  if (h_seed != d->seed) {
+    h = fnv1a64(word, d->seed);
+    h_seed = d->seed;
+  }
+  mask = d->cap - 1;
+  pos = (size_t)h & mask;
+  probes = 0;
 
-  while (d->entries[pos].used) {
+  while (d->entries[pos].gen == d->gen) {
     if (strcmp(d->entries[pos].key, word) == 0) {
       *out_id = d->entries[pos].id;
       return 1;
     }
     pos = (pos + 1) & mask;
+
+    /* Pathological cluster: rekey at the same capacity, at most once. */
+    if (++probes > DICT_MAX_PROBE && !rekeyed) {
+      if (!dict_grow(d, d->cap)) return 0;
+      rekeyed = 1;
+      goto probe;
+    }
+  }
+
+  /* Not yet migrated words are still found in the previous table. */
+  DictEntry *old = dict_find_old(d, word);
+  if (old) {
+    *out_id = old->id;
+    return 1;
   }
 
-  char *k = dup_cstr(word);
+  char *k = str_dup(word);
   if (!k) return 0;
 
   uint32_t id = (uint32_t)(d->id_size + 1);
-  if (!ensure_id_cap(d, d->id_size + 1)) { free(k); return 0; }
+  if (!ensure_id_cap(d, d->id_size + 1)) { str_free(k); return 0; }
 
   d->entries[pos].key = k;
   d->entries[pos].id = id;
-  d->entries[pos].used = 1;
+  d->entries[pos].gen = d->gen;
   d->size++;
 
   /* Maintain reverse mapping (id → word). */
@@ -129,41 +223,96 @@ static int dict_insert(Dict *d, const char *word, uint32_t *out_id) {
   return 1;
 }
 
+size_t dict_bucket(const Dict *d, const char *word) {
+  return (size_t)fnv1a64(word, d->seed) & (d->cap - 1);
+}
+
 uint32_t dict_get_or_add(Dict *d, const char *word) {
   if (!d || !word || !*word) return 0;
   uint32_t id = 0;
-  if (!dict_insert(d, word, &id)) return 0;
+  if (!dict_insert(d, word, fnv1a64(word, d->seed), d->seed, &id)) return 0;
   return id;
 }
 
-/* Rehash into a larger table (measurement point for memory/rehash overhead). */
-static int dict_grow(Dict *d) {
-  size_t old_cap = d->cap;
-  DictEntry *old = d->entries;
+int dict_get_or_add_batch(Dict *d, const char *const *words, size_t n, uint32_t *out_ids) {
+  if (!d || (n > 0 && (!words || !out_ids))) return 0;
 
-  size_t new_cap = old_cap * 2;
-  DictEntry *ne = (DictEntry*)calloc(new_cap, sizeof(DictEntry));
-  if (!ne) return 0;
+  uint64_t hs[DICT_BATCH_WINDOW];
+  for (size_t base = 0; base < n; base += DICT_BATCH_WINDOW) {
+    size_t m = n - base < DICT_BATCH_WINDOW ? n - base : DICT_BATCH_WINDOW;
+    const char *const *w = words + base;
 
-  d->entries = ne;
-  d->cap = new_cap;
-  d->size = 0;
+    /* Stage 1: hash the window and pull home slots into cache. */
+    uint64_t seed = d->seed;
+    size_t mask = d->cap - 1;
+    for (size_t i = 0; i < m; i++) {
+      if (!w[i] || !*w[i]) continue;
+      hs[i] = fnv1a64(w[i], seed);
+      TABLE_PREFETCH(&d->entries[(size_t)hs[i] & mask]);
+    }
+
+    /* Stage 2: resolve in input order (keeps ID assignment stable). */
+    for (size_t i = 0; i < m; i++) {
+      out_ids[base + i] = 0;
+      if (!w[i] || !*w[i]) continue;
+      if (!dict_insert(d, w[i], hs[i], seed, &out_ids[base + i])) return 0;
+    }
+  }
+  return 1;
+}
+
+/* Migrate up to max_buckets old buckets into the current table.
+ * Keys are moved, not copied (IDs and id_to_word stay valid).
+ */
+static void dict_rehash_step(Dict *d, size_t max_buckets) {
+  size_t mask = d->cap - 1;
+  size_t start = d->rehash_pos;
 
-  /* Reinsert by reusing existing keys (no duplication, keeps IDs stable). */
-  for (size_t i = 0; i < old_cap; i++) {
-    if (!old[i].used) continue;
+  while (max_buckets > 0 && d->rehash_pos < d->old_cap) {
+    DictEntry *e = &d->old_entries[d->rehash_pos++];
+    max_buckets--;
+    if (e->gen != d->gen) continue;
 
-    uint64_t h = fnv1a64(old[i].key);
-    size_t mask = d->cap - 1;
-    size_t pos = (size_t)h & mask;
+    size_t pos = (size_t)fnv1a64(e->key, d->seed) & mask;
+    while (d->entries[pos].gen == d->gen) pos = (pos + 1) & mask;
+
+    d->entries[pos] = *e;
+    e->gen = 0;
+    e->key = NULL;
+  }
 
-    while (d->entries[pos].used) pos = (pos + 1) & mask;
+  /* Migrated buckets read as empty; large old tables return them early. */
+  size_t old_bytes = d->old_cap * sizeof(DictEntry);
+  table_release_prefix(d->old_entries, old_bytes,
+                       start * sizeof(DictEntry), d->rehash_pos * sizeof(DictEntry));
 
-    d->entries[pos] = old[i];
-    d->entries[pos].used = 1;
-    d->size++;
+  if (d->rehash_pos >= d->old_cap) {
+    table_free(d->old_entries, old_bytes);
+    d->old_entries = NULL;
+    d->old_cap = 0;
+    d->rehash_pos = 0;
   }
+}
+
+/* Start an incremental rehash into a table of new_cap buckets
+ * (measurement point for memory/rehash overhead). The old table is
+ * drained by dict_rehash_step instead of being rehashed in one go.
+ * Each table generation gets a fresh seed; new_cap == cap just rekeys.
+ */
+static int dict_grow(Dict *d, size_t new_cap) {
+  /* A previous rehash must be complete before the next one starts. */
+  if (d->old_entries) dict_rehash_step(d, d->old_cap);
+
+  DictEntry *ne = (DictEntry*)table_alloc(new_cap * sizeof(DictEntry));
+  if (!ne) return 0;
+
+  d->old_entries = d->entries;
+  d->old_cap = d->cap;
+  d->rehash_pos = 0;
+  d->old_seed = d->seed;
 
-  free(old);
+  d->entries = ne;
+  d->cap = new_cap;
+  d->seed = hash_seed_next(d->seed);
   return 1;
 }
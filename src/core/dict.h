@@ -7,9 +7,9 @@
  * Used in the ID-based analysis pipeline.
  */
 typedef struct {
-  char *key;        // owned string (malloc)
+  char *key;        // owned string (str_dup, see core/arena.h)
   uint32_t id;      // stable ID (>= 1)
-  int used;         // open addressing marker
+  uint32_t gen;     // occupied iff == Dict.gen (0: never used)
 } DictEntry;
 
 /*
@@ -22,11 +22,21 @@ typedef struct {
 typedef struct {
   DictEntry *entries;
   size_t cap;       // power-of-two capacity (hash table)
-  size_t size;      // number of active entries
+  size_t size;      // number of active entries (both tables while rehashing)
+  uint64_t seed;    // per-table hash seed (renewed on every rehash)
+
+  /* Incremental rehash: previous table stays readable until all of its
+   * buckets have been migrated (a few buckets per insert). */
+  DictEntry *old_entries;
+  size_t old_cap;
+  size_t rehash_pos;  // next old bucket to migrate
+  uint64_t old_seed;  // seed the previous table was built with
 
   char **id_to_word;  // index = id - 1
   size_t id_cap;
   size_t id_size;     // equals number of assigned IDs
+
+  uint32_t gen;       // current generation; dict_reset advances it
 } Dict;
 
 /* Initialize dictionary (hash-based, power-of-two capacity). */
@@ -35,12 +45,33 @@ int dict_init(Dict *d, size_t initial_cap);
 /* Release all allocated dictionary memory. */
 void dict_free(Dict *d);
 
+/*
+ * Empty the dictionary but keep its tables for reuse. Entries of the
+ * previous generation read as free, so the table is not cleared (only
+ * when the generation counter wraps). Keys are released as by dict_free;
+ * IDs restart at 1.
+ */
+void dict_reset(Dict *d);
+
 /*
  * Get existing ID or assign new one.
  * IDs are stable and start at 1.
  */
 uint32_t dict_get_or_add(Dict *d, const char *word);
 
+/* Keys hashed and prefetched ahead of resolution by the batch API. */
+#define DICT_BATCH_WINDOW 16
+
+/*
+ * Batched dict_get_or_add: hashes a window of words, prefetches their
+ * home slots, then resolves them in order (same IDs as one-by-one calls).
+ * NULL/empty words yield id 0. Returns 0 on allocation failure.
+ */
+int dict_get_or_add_batch(Dict *d, const char *const *words, size_t n, uint32_t *out_ids);
+
+/* Home bucket of `word` in the current table (layout checks in tests). */
+size_t dict_bucket(const Dict *d, const char *word);
+
 /* Resolve ID back to word (owned by dictionary). */
 const char *dict_word(const Dict *d, uint32_t id);
 
@@ -1,18 +1,10 @@
 #include "core/freq.h"
+#include "core/arena.h"
+#include "core/cancel.h"
 
 #include <stdlib.h>
 #include <string.h>
 
-/* Local helper to duplicate tokens for ownership in WordCountList. */
-static char *dup_cstr(const char *s) {
-    if (!s) return NULL;
-    size_t n = strlen(s);
-    char *out = (char *)malloc(n + 1);
-    if (!out) return NULL;
-    memcpy(out, s, n + 1);
-    return out;
-}
-
 WordCountList count_words(const TokenList *tokens) {
     WordCountList out = (WordCountList){0};
     if (!tokens || !tokens->items || tokens->count == 0) return out;
@@ -25,6 +17,9 @@ WordCountList count_words(const TokenList *tokens) {
     if (!out.items) return (WordCountList){0};
 
     for (size_t i = 0; i < tokens->count; i++) {
+        /* Every token scans the list: poll more often. */
+        if (cancel_poll_every(i, CANCEL_POLL_EVERY_SCAN)) break;
+
         const char *tok = tokens->items[i];
         if (!tok || tok[0] == '\0') continue;
 
@@ -55,7 +50,7 @@ WordCountList count_words(const TokenList *tokens) {
             out.items = tmp;
         }
 
-        out.items[out.count].word = dup_cstr(tok);
+        out.items[out.count].word = str_dup(tok);
         if (!out.items[out.count].word) {
             free_word_counts(&out);
             return (WordCountList){0};
@@ -82,7 +77,7 @@ size_t get_word_count(const WordCountList *list, const char *word) {
 void free_word_counts(WordCountList *list) {
     if (!list || !list->items) return;
     for (size_t i = 0; i < list->count; i++) {
-        free(list->items[i].word);
+        str_free(list->items[i].word);
         list->items[i].word = NULL;
         list->items[i].count = 0;
     }
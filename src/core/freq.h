@@ -22,6 +22,7 @@ typedef struct {
  * Count word frequencies from tokens.
  * Tokens remain unchanged.
  * Implementation uses linear lookup (sufficient for small datasets).
+ * Stops early once the bound deadline passes (core/cancel.h).
  */
 WordCountList count_words(const TokenList *tokens);
 
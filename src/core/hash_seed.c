@@ -0,0 +1,56 @@
+#include "core/hash_seed.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* 0 = not initialized yet; set once via compare-exchange (thread-safe). */
+static _Atomic uint64_t g_seed;
+
+static uint64_t splitmix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+static uint64_t seed_from_env_or_os(void) {
+  const char *env = getenv("TA_HASH_SEED");
+  if (env && env[0] != '\0') {
+    char *end = NULL;
+    unsigned long long v = strtoull(env, &end, 0);
+    if (end && *end == '\0') return (uint64_t)v;
+  }
+
+  uint64_t s = 0;
+#if defined(__unix__) || defined(__APPLE__)
+  FILE *f = fopen("/dev/urandom", "rb");
+  if (f) {
+    if (fread(&s, 1, sizeof(s), f) != sizeof(s)) s = 0;
+    fclose(f);
+  }
+#endif
+
+  /* Fallback entropy: time, clock and ASLR address bits. */
+  s ^= (uint64_t)time(NULL);
+  s ^= (uint64_t)clock() << 17;
+  s ^= (uint64_t)(uintptr_t)&s;
+  return splitmix64(s);
+}
+
+uint64_t hash_seed(void) {
+  uint64_t s = atomic_load_explicit(&g_seed, memory_order_acquire);
+  if (s != 0) return s;
+
+  uint64_t fresh = seed_from_env_or_os();
+  if (fresh == 0) fresh = 0x9e3779b97f4a7c15ULL;
+
+  uint64_t expected = 0;
+  if (atomic_compare_exchange_strong(&g_seed, &expected, fresh)) return fresh;
+  return expected;  // another thread won the race
+}
+
+uint64_t hash_seed_next(uint64_t seed) {
+  return splitmix64(seed);
+}
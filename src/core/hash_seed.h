@@ -0,0 +1,17 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * Per-process random seed for hash tables (Dict, IdBigrams).
+ *
+ * Unseeded hashes let a crafted page force long linear-probe chains
+ * (hash flooding). The seed is drawn once per process on first use and
+ * stays stable afterwards, so results remain deterministic: only the
+ * internal table layout changes between runs, never the output.
+ *
+ * TA_HASH_SEED=<u64> pins the seed (reproducible perf runs).
+ */
+uint64_t hash_seed(void);
+
+/* Derives the seed for the next table generation (used on rehash). */
+uint64_t hash_seed_next(uint64_t seed);
@@ -0,0 +1,358 @@
+#include "core/heavy_hitters.h"
+#include "core/arena.h"
+#include "core/hash_seed.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define HH_FNV_BASIS 1469598103934665603ULL
+#define HH_FNV_PRIME 1099511628211ULL
+
+static uint64_t hh_hash(uint64_t seed, const char *key, size_t len) {
+  uint64_t h = HH_FNV_BASIS ^ seed;
+  for (size_t i = 0; i < len; i++) {
+    h ^= (uint64_t)(unsigned char)key[i];
+    h *= HH_FNV_PRIME;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return h;
+}
+
+int hh_init(HeavyHitters *hh, size_t capacity) {
+  if (!hh) return 0;
+  memset(hh, 0, sizeof(*hh));
+  if (capacity == 0) capacity = HH_DEFAULT_CAPACITY;
+  if (capacity > UINT32_MAX / 2) return 0;
+
+  size_t n_slots = 16;
+  while (n_slots < capacity * 2) n_slots <<= 1;
+
+  hh->entries = (HhEntry*)calloc(capacity, sizeof(HhEntry));
+  hh->heap = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+  hh->slots = (uint32_t*)calloc(n_slots, sizeof(uint32_t));
+  if (!hh->entries || !hh->heap || !hh->slots) {
+    hh_free(hh);
+    return 0;
+  }
+  hh->mask = n_slots - 1;
+  hh->capacity = capacity;
+  hh->seed = hash_seed();
+  return 1;
+}
+
+void hh_free(HeavyHitters *hh) {
+  if (!hh) return;
+  if (hh->entries) {
+    for (size_t i = 0; i < hh->size; i++) free(hh->entries[i].key);
+  }
+  free(hh->entries);
+  free(hh->heap);
+  free(hh->slots);
+  memset(hh, 0, sizeof(*hh));
+}
+
+/* ---------- Min-heap by count ---------- */
+
+static void heap_swap(HeavyHitters *hh, size_t a, size_t b) {
+  uint32_t t = hh->heap[a];
+  hh->heap[a] = hh->heap[b];
+  hh->heap[b] = t;
+  hh->entries[hh->heap[a]].heap_pos = (uint32_t)a;
+  hh->entries[hh->heap[b]].heap_pos = (uint32_t)b;
+}
+
+static size_t heap_count(const HeavyHitters *hh, size_t pos) {
+  return hh->entries[hh->heap[pos]].count;
+}
+
+static void heap_sift_down(HeavyHitters *hh, size_t i) {
+  size_t n = hh->size;
+  for (;;) {
+    size_t c = 2 * i + 1, m = i;
+    if (c < n && heap_count(hh, c) < heap_count(hh, m)) m = c;
+    if (c + 1 < n && heap_count(hh, c + 1) < heap_count(hh, m)) m = c + 1;
+    if (m == i) return;
+    heap_swap(hh, i, m);
+    i = m;
+  }
+}
+
+static void heap_sift_up(HeavyHitters *hh, size_t i) {
+  while (i > 0) {
+    size_t p = (i - 1) / 2;
+    if (heap_count(hh, p) <= heap_count(hh, i)) return;
+    heap_swap(hh, i, p);
+    i = p;
+  }
+}
+
+/* ---------- Hash index (linear probing) ---------- */
+
+/* Remove entry idx from the index; backward shift keeps probe chains intact. */
+static void index_remove(HeavyHitters *hh, uint32_t idx) {
+  size_t mask = hh->mask;
+  size_t i = (size_t)hh->entries[idx].hash & mask;
+  while (hh->slots[i] != idx + 1) i = (i + 1) & mask;
+
+  size_t j = i;
+  for (;;) {
+    j = (j + 1) & mask;
+    uint32_t s = hh->slots[j];
+    if (!s) break;
+    size_t home = (size_t)hh->entries[s - 1].hash & mask;
+    /* Move s into the hole unless its home lies cyclically in (i, j]. */
+    bool stays = (i <= j) ? (home > i && home <= j) : (home > i || home <= j);
+    if (!stays) {
+      hh->slots[i] = s;
+      i = j;
+    }
+  }
+  hh->slots[i] = 0;
+}
+
+static void index_insert(HeavyHitters *hh, uint32_t idx) {
+  size_t i = (size_t)hh->entries[idx].hash & hh->mask;
+  while (hh->slots[i]) i = (i + 1) & hh->mask;
+  hh->slots[i] = idx + 1;
+}
+
+/* ---------- Counting ---------- */
+
+int hh_add(HeavyHitters *hh, const char *key, size_t len) {
+  if (!hh || !hh->entries || !key) return 0;
+  if (len >= UINT32_MAX) return 1;  // cannot occur with the tokenizer limit
+
+  uint64_t h = hh_hash(hh->seed, key, len);
+  for (size_t i = (size_t)h & hh->mask; hh->slots[i]; i = (i + 1) & hh->mask) {
+    HhEntry *e = &hh->entries[hh->slots[i] - 1];
+    if (e->hash == h && e->len == len && memcmp(e->key, key, len) == 0) {
+      e->count++;
+      if (!hh->verifying) {
+        hh->total++;
+        heap_sift_down(hh, e->heap_pos);
+      }
+      return 1;
+    }
+  }
+  if (hh->verifying) return 1;
+
+  /* Unmonitored key: take a free slot or evict the minimum. Key storage
+   * is secured first so OOM leaves the summary unchanged.
+   */
+  uint32_t idx = (hh->size < hh->capacity) ? (uint32_t)hh->size : hh->heap[0];
+  HhEntry *e = &hh->entries[idx];
+  if ((size_t)e->key_cap < len + 1) {
+    char *k = (char*)realloc(e->key, len + 1);
+    if (!k) return 0;
+    e->key = k;
+    e->key_cap = (uint32_t)(len + 1);
+  }
+
+  size_t base = 0;
+  if (idx == hh->size) {
+    hh->heap[idx] = idx;
+    e->heap_pos = idx;
+    hh->size++;
+  } else {
+    base = e->count;
+    index_remove(hh, idx);
+  }
+
+  memcpy(e->key, key, len);
+  e->key[len] = '\0';
+  e->len = (uint32_t)len;
+  e->hash = h;
+  e->count = base + 1;
+  e->error = base;
+  index_insert(hh, idx);
+
+  hh->total++;
+  if (base == 0) heap_sift_up(hh, e->heap_pos);
+  else heap_sift_down(hh, e->heap_pos);
+  return 1;
+}
+
+int hh_add_tokens(HeavyHitters *words, HeavyHitters *bigrams,
+                  const TokenList *raw, const StopwordList *sw) {
+  if (!words || !raw) return 0;
+
+  char *key = NULL;
+  size_t key_cap = 0;
+  int ok = 1;
+
+  const char *prev = NULL;
+  size_t prev_len = 0;
+  for (size_t i = 0; i < raw->count && ok; i++) {
+    const char *tok = raw->items[i];
+
+    /* No bridging across dropped tokens (keeps bigrams local to valid runs). */
+    if (bigram_token_ignored(tok, sw)) { prev = NULL; continue; }
+
+    size_t len = strlen(tok);
+    ok = hh_add(words, tok, len);
+
+    if (ok && bigrams && prev) {
+      size_t need = prev_len + 1 + len;
+      if (need > key_cap) {
+        size_t cap = key_cap ? key_cap : 64;
+        while (cap < need) cap *= 2;
+        char *nk = (char*)realloc(key, cap);
+        if (!nk) { ok = 0; break; }
+        key = nk;
+        key_cap = cap;
+      }
+      memcpy(key, prev, prev_len);
+      key[prev_len] = '\0';
+      memcpy(key + prev_len + 1, tok, len);
+      ok = hh_add(bigrams, key, need);
+    }
+    prev = tok;
+    prev_len = len;
+  }
+
+  free(key);
+  return ok;
+}
+
+size_t hh_unmonitored_bound(const HeavyHitters *hh) {
+  if (!hh) return 0;
+  if (hh->verifying) return hh->floor;
+  return (hh->size < hh->capacity) ? 0 : hh->entries[hh->heap[0]].count;
+}
+
+void hh_verify_begin(HeavyHitters *hh) {
+  if (!hh || hh->verifying) return;
+  hh->floor = hh_unmonitored_bound(hh);
+  for (size_t i = 0; i < hh->size; i++) {
+    hh->entries[i].count = 0;
+    hh->entries[i].error = 0;
+  }
+  hh->verifying = true;
+}
+
+/* ---------- Top-K views ---------- */
+
+/* Key order equals (w1, w2) order for bigram keys: NUL sorts first. */
+static int entry_better(const HhEntry *a, const HhEntry *b) {
+  if (a->count != b->count) return a->count > b->count;
+  size_t n = (a->len < b->len) ? a->len : b->len;
+  int c = memcmp(a->key, b->key, n);
+  if (c != 0) return c < 0;
+  return a->len < b->len;
+}
+
+static int cmp_entry_ptr(const void *pa, const void *pb) {
+  const HhEntry *a = *(const HhEntry *const *)pa;
+  const HhEntry *b = *(const HhEntry *const *)pb;
+  if (entry_better(a, b)) return -1;
+  if (entry_better(b, a)) return 1;
+  return 0;
+}
+
+/* Selected entries, best first (n_out <= k; k == 0: all). */
+static const HhEntry **hh_select(const HeavyHitters *hh, size_t k, size_t *n_out) {
+  *n_out = 0;
+  const HhEntry **sel = (const HhEntry**)malloc((hh->size ? hh->size : 1) * sizeof(*sel));
+  if (!sel) return NULL;
+
+  size_t n = 0;
+  for (size_t i = 0; i < hh->size; i++) {
+    const HhEntry *e = &hh->entries[i];
+    if (e->count > 0) sel[n++] = e;
+  }
+  /* Bounded by the capacity: a plain sort is cheap here. */
+  qsort(sel, n, sizeof(*sel), cmp_entry_ptr);
+  *n_out = (k > 0 && k < n) ? k : n;
+  return sel;
+}
+
+static bool hh_exact(const HeavyHitters *hh, size_t k, const HhEntry **sel, size_t n) {
+  size_t bound = hh_unmonitored_bound(hh);
+  if (bound == 0) return true;  // never evicted: all keys monitored, no errors
+  if (!hh->verifying || k == 0 || n < k) return false;
+  return sel[n - 1]->count > bound;
+}
+
+int hh_top_k_words(const HeavyHitters *hh, size_t k, WordCountList *out,
+                   size_t **errors, bool *exact) {
+  if (!hh || !out) return 0;
+  *out = (WordCountList){0};
+  if (errors) *errors = NULL;
+
+  size_t n = 0;
+  const HhEntry **sel = hh_select(hh, k, &n);
+  if (!sel) return 0;
+  if (exact) *exact = hh_exact(hh, k, sel, n);
+
+  if (n > 0) {
+    out->items = (WordCount*)calloc(n, sizeof(WordCount));
+    size_t *err = errors ? (size_t*)calloc(n, sizeof(size_t)) : NULL;
+    if (!out->items || (errors && !err)) {
+      free(out->items);
+      out->items = NULL;
+      free(err);
+      free(sel);
+      return 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+      out->items[i].word = str_dupn(sel[i]->key, sel[i]->len);
+      out->items[i].count = sel[i]->count;
+      out->count++;
+      if (!out->items[i].word) {
+        free_word_counts(out);
+        free(err);
+        free(sel);
+        return 0;
+      }
+      if (err) err[i] = sel[i]->error;
+    }
+    if (errors) *errors = err;
+  }
+  free(sel);
+  return 1;
+}
+
+int hh_top_k_bigrams(const HeavyHitters *hh, size_t k, BigramCountList *out,
+                     size_t **errors, bool *exact) {
+  if (!hh || !out) return 0;
+  *out = (BigramCountList){0};
+  if (errors) *errors = NULL;
+
+  size_t n = 0;
+  const HhEntry **sel = hh_select(hh, k, &n);
+  if (!sel) return 0;
+  if (exact) *exact = hh_exact(hh, k, sel, n);
+
+  if (n > 0) {
+    out->items = (BigramCount*)calloc(n, sizeof(BigramCount));
+    size_t *err = errors ? (size_t*)calloc(n, sizeof(size_t)) : NULL;
+    if (!out->items || (errors && !err)) {
+      free(out->items);
+      out->items = NULL;
+      free(err);
+      free(sel);
+      return 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+      const HhEntry *e = sel[i];
+      size_t n1 = strlen(e->key);  // key is "w1\0w2"
+      BigramCount *bc = &out->items[i];
+      bc->w1 = str_dupn(e->key, n1);
+      bc->w2 = str_dupn(e->key + n1 + 1, (n1 < e->len) ? e->len - n1 - 1 : 0);
+      bc->count = e->count;
+      out->count++;
+      if (!bc->w1 || !bc->w2) {
+        free_bigram_counts(out);
+        free(err);
+        free(sel);
+        return 0;
+      }
+      if (err) err[i] = e->error;
+    }
+    if (errors) *errors = err;
+  }
+  free(sel);
+  return 1;
+}
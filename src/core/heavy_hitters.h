@@ -0,0 +1,88 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "core/tokenizer.h"
+#include "core/stopwords.h"
+#include "core/freq.h"
+#include "core/bigrams.h"
+
+/*
+ * Space-Saving heavy-hitters summary (Metwally et al.) over byte-string
+ * keys with a fixed number of slots.
+ *
+ * A new key takes over the slot with the smallest count c and starts at
+ * c + 1 with error c, so every estimate is an upper bound:
+ *   count - error <= true count <= count.
+ * Keys with a true count above total / capacity are always monitored, and
+ * an unmonitored key occurs at most min_count times. Memory depends only
+ * on the capacity (and the token length limit), not on the input size.
+ *
+ * Verification: hh_verify_begin zeroes all slots, a second pass over the
+ * same stream (hh_add_tokens) then counts only the monitored keys, which
+ * makes their counts exact (error 0).
+ *
+ * Bigram keys are "w1\0w2" (same key shape as art.c).
+ */
+#ifndef HH_DEFAULT_CAPACITY
+#define HH_DEFAULT_CAPACITY 4096  // slots per summary (words, bigrams)
+#endif
+
+typedef struct {
+  char *key;         // owned, len bytes (+ NUL)
+  uint32_t len;
+  uint32_t key_cap;  // bytes allocated for key (reused on eviction)
+  uint32_t heap_pos; // position in the min-heap
+  uint64_t hash;
+  size_t count;      // estimate (upper bound)
+  size_t error;      // overestimation bound
+} HhEntry;
+
+typedef struct {
+  HhEntry *entries;  // capacity slots, stable indices
+  uint32_t *heap;    // entry indices, min-heap by count
+  uint32_t *slots;   // hash index: entry index + 1, 0 = empty
+  size_t mask;
+  size_t size;       // monitored keys (<= capacity)
+  size_t capacity;
+  uint64_t seed;
+
+  size_t total;      // stream length of the counting pass
+  size_t floor;      // verification: bound for unmonitored keys
+  bool verifying;    // second pass: count monitored keys only
+} HeavyHitters;
+
+/* Initialize with `capacity` slots (0 = HH_DEFAULT_CAPACITY). 0 on OOM. */
+int hh_init(HeavyHitters *hh, size_t capacity);
+
+/* Release all memory. */
+void hh_free(HeavyHitters *hh);
+
+/* Count one occurrence of key. 0 on OOM. */
+int hh_add(HeavyHitters *hh, const char *key, size_t len);
+
+/* Feed one page: words are raw tokens that survive the filter stage,
+ * bigrams follow the engines' adjacency rules (no bridging over dropped
+ * tokens). bigrams may be NULL. 0 on OOM.
+ */
+int hh_add_tokens(HeavyHitters *words, HeavyHitters *bigrams,
+                  const TokenList *raw, const StopwordList *sw);
+
+/* Start the exact second pass (see above). */
+void hh_verify_begin(HeavyHitters *hh);
+
+/* Smallest count a key outside the summary could have (0 if all keys fit). */
+size_t hh_unmonitored_bound(const HeavyHitters *hh);
+
+/*
+ * Top-K views (count DESC, lexicographic ASC; k == 0: all monitored keys).
+ * errors (optional) receives a malloc'd array parallel to the items.
+ * Release lists with free_word_counts/free_bigram_counts.
+ * *exact is set when the k results are provably the true Top-K: verified
+ * counts and the last count above hh_unmonitored_bound.
+ */
+int hh_top_k_words(const HeavyHitters *hh, size_t k, WordCountList *out,
+                   size_t **errors, bool *exact);
+int hh_top_k_bigrams(const HeavyHitters *hh, size_t k, BigramCountList *out,
+                     size_t **errors, bool *exact);
@@ -1,7 +1,11 @@
 #include "core/id_bigrams.h"
+#include "core/arena.h"
+#include "core/cancel.h"
+#include "core/table_alloc.h"
+#include "core/hash_seed.h"
+#include "core/id_freq.h"
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 #include "core/stopwords.h"
 #include "core/bigrams.h"
 #include "core/dict.h"
@@ -13,8 +17,11 @@ static size_t next_pow2(size_t x) {
   return p;
 }
 
-/* 64-bit mix for stable hashing of (id1,id2) packed keys. */
-static uint64_t mix64(uint64_t x) {
+/* 64-bit mix of (id1,id2) packed keys; the seed keeps bucket positions
+ * unpredictable for crafted inputs.
+ */
+static uint64_t mix64(uint64_t x, uint64_t seed) {
+  x ^= seed;
   x ^= x >> 33;
   x *= 0xff51afd7ed558ccdULL;
   x ^= x >> 33;
@@ -23,123 +30,446 @@ static uint64_t mix64(uint64_t x) {
   return x;
 }
 
-static int idbigrams_grow(IdBigrams *b);
+/* Old buckets migrated per idbigrams_inc call while a rehash is running
+ * (>= 2 drains the old table before the new one hits 0.7 load).
+ */
+#define IDBIGRAMS_REHASH_STEP 16
+
+/* Probe length treated as a collision attack; the insert rekeys once. */
+#ifndef IDBIGRAMS_MAX_PROBE
+#define IDBIGRAMS_MAX_PROBE 512
+#endif
+
+static int idbigrams_grow(IdBigrams *b, size_t new_cap, unsigned new_key_bytes);
+static void idbigrams_rehash_step(IdBigrams *b, size_t max_buckets);
+
+/* Pack (id1,id2) into one key to avoid string concatenation.
+ * This 64-bit form is what gets hashed, independent of the slot width.
+ */
+static uint64_t pair_key(uint32_t id1, uint32_t id2) {
+  return ((uint64_t)id1 << 32) | (uint64_t)id2;
+}
+
+/* Both IDs < 65536: the pair fits a 4-byte slot key. */
+static int key_fits32(uint64_t key) {
+  return (key >> 48) == 0 && (key & 0xffff0000ULL) == 0;
+}
+
+/* Stored slot value for a 64-bit pair key at the given width. */
+static uint64_t key_pack(uint64_t key, unsigned key_bytes) {
+  if (key_bytes == 8) return key;
+  return ((key >> 32) << 16) | (key & 0xffffULL);
+}
+
+/* Raw stored value of slot i (0 = empty). */
+static uint64_t slot_raw(const void *keys, unsigned key_bytes, size_t i) {
+  if (key_bytes == 4) return ((const uint32_t*)keys)[i];
+  return ((const uint64_t*)keys)[i];
+}
+
+static void slot_put(void *keys, unsigned key_bytes, size_t i, uint64_t raw) {
+  if (key_bytes == 4) ((uint32_t*)keys)[i] = (uint32_t)raw;
+  else ((uint64_t*)keys)[i] = raw;
+}
+
+/* Slot value back to the 64-bit pair key (0 stays 0). */
+static uint64_t key_unpack(uint64_t raw, unsigned key_bytes) {
+  if (key_bytes == 8 || raw == 0) return raw;
+  return ((raw >> 16) << 32) | (raw & 0xffffULL);
+}
+
+static int slots_alloc(void **keys, uint32_t **counts, size_t cap, unsigned key_bytes) {
+  *keys = table_alloc(cap * key_bytes);
+  *counts = (uint32_t*)table_alloc(cap * sizeof(uint32_t));
+  if (*keys && *counts) return 1;
+  table_free(*keys, cap * key_bytes);
+  table_free(*counts, cap * sizeof(uint32_t));
+  *keys = NULL;
+  *counts = NULL;
+  return 0;
+}
+
+static void slots_free(void *keys, uint32_t *counts, size_t cap, unsigned key_bytes) {
+  table_free(keys, cap * key_bytes);
+  table_free(counts, cap * sizeof(uint32_t));
+}
 
 int idbigrams_init(IdBigrams *b, size_t initial_cap) {
   if (!b) return 0;
   memset(b, 0, sizeof(*b));
 
-  /* ID-bigram table: open addressing, power-of-two capacity. */
+  /* ID-bigram table: open addressing, power-of-two capacity.
+   * Starts narrow; widens on the first ID >= 65536. */
   b->cap = next_pow2(initial_cap < 64 ? 64 : initial_cap);
-  b->entries = (BigEntry*)calloc(b->cap, sizeof(BigEntry));
-  return b->entries != NULL;
+  b->key_bytes = 4;
+  b->seed = hash_seed();
+  return slots_alloc(&b->keys, &b->counts, b->cap, b->key_bytes);
 }
 
 void idbigrams_free(IdBigrams *b) {
   if (!b) return;
-  free(b->entries);
+  slots_free(b->keys, b->counts, b->cap, b->key_bytes);
+  slots_free(b->old_keys, b->old_counts, b->old_cap, b->old_key_bytes);
   memset(b, 0, sizeof(*b));
 }
 
-int idbigrams_inc(IdBigrams *b, uint32_t id1, uint32_t id2) {
-  if (!b || id1 == 0 || id2 == 0) return 0;
+int idbigrams_prepare(IdBigrams *b, size_t need) {
+  if (!b) return 0;
+  if (b->keys && !ID_SCRATCH_OVERSIZED(b->cap, need, b->key_bytes)) return 1;
+  idbigrams_free(b);
+  return idbigrams_init(b, need);
+}
+
+/* Counts are written when a slot is claimed, so only keys are cleared. */
+void idbigrams_clear(IdBigrams *b) {
+  if (!b || !b->keys) return;
+  slots_free(b->old_keys, b->old_counts, b->old_cap, b->old_key_bytes);
+  b->old_keys = NULL;
+  b->old_counts = NULL;
+  b->old_cap = 0;
+  b->rehash_pos = 0;
+  memset(b->keys, 0, b->cap * b->key_bytes);
+  b->size = 0;
+  b->seed = hash_seed_next(b->seed);
+}
+
+/* Lookup in the previous table during an incremental rehash.
+ * Buckets below rehash_pos are already migrated (and cleared) and are
+ * skipped, also by chains that wrap past the end (see dict_find_old).
+ */
+static uint32_t *idbigrams_find_old(IdBigrams *b, uint64_t key) {
+  if (!b->old_keys) return NULL;
+  if (b->old_key_bytes == 4 && !key_fits32(key)) return NULL;
+
+  uint64_t raw = key_pack(key, b->old_key_bytes);
+  size_t mask = b->old_cap - 1;
+  size_t home = (size_t)mix64(key, b->old_seed) & mask;
+  size_t pos = home < b->rehash_pos ? b->rehash_pos : home;
+
+  uint64_t cur;
+  while ((cur = slot_raw(b->old_keys, b->old_key_bytes, pos)) != 0) {
+    if (cur == raw) return &b->old_counts[pos];
+    pos = (pos + 1) & mask;
+    if (pos < b->rehash_pos) {
+      if (home < b->rehash_pos) return NULL;
+      pos = b->rehash_pos;
+    }
+    if (pos == home) return NULL;
+  }
+  return NULL;
+}
+
+/* Add n to one packed pair; h is its hash under h_seed (recomputed after a
+ * grow/rekey switched the table to a new seed).
+ */
+static int idbigrams_inc_key(IdBigrams *b, uint64_t key, uint64_t h, uint64_t h_seed, uint32_t n) {
+  /* Amortized rehash: move a bounded number of old buckets per call. */
+  if (b->old_keys) idbigrams_rehash_step(b, IDBIGRAMS_REHASH_STEP);
+
+  /* Vocabulary outgrew 16-bit IDs: widen keys (same capacity). */
+  if (b->key_bytes == 4 && !key_fits32(key)) {
+    if (!idbigrams_grow(b, b->cap, 8)) return 0;
+  }
 
   /* Grow at ~0.7 load factor to keep probing cheap. */
   if (b->size * 10 >= b->cap * 7) {
-    if (!idbigrams_grow(b)) return 0;
+    if (!idbigrams_grow(b, b->cap * 2, b->key_bytes)) return 0;
   }
 
-  /* Pack (id1,id2) into one key to avoid string concatenation. */
-  uint64_t key = ((uint64_t)id1 << 32) | (uint64_t)id2;
-  uint64_t h = mix64(key);
-  size_t mask = b->cap - 1;
-  size_t pos = (size_t)h & mask;
+  int rekeyed = 0;
+  size_t mask, pos, probes;
+  uint64_t raw, cur;
+probe:
+  if (h_seed != b->seed) {
+    h = mix64(key, b->seed);
+    h_seed = b->seed;
+  }
+  raw = key_pack(key, b->key_bytes);
+  mask = b->cap - 1;
+  pos = (size_t)h & mask;
+  probes = 0;
 
-  while (b->entries[pos].used) {
-    if (b->entries[pos].key == key) {
-      b->entries[pos].count++;
+  while ((cur = slot_raw(b->keys, b->key_bytes, pos)) != 0) {
+    if (cur == raw) {
+      b->counts[pos] += n;
       return 1;
     }
     pos = (pos + 1) & mask;
+
+    /* Pathological cluster: rekey at the same capacity, at most once. */
+    if (++probes > IDBIGRAMS_MAX_PROBE && !rekeyed) {
+      if (!idbigrams_grow(b, b->cap, b->key_bytes)) return 0;
+      rekeyed = 1;
+      goto probe;
+    }
+  }
+
+  /* Not yet migrated pairs are counted in place in the previous table. */
+  uint32_t *old = idbigrams_find_old(b, key);
+  if (old) {
+    *old += n;
+    return 1;
   }
 
-  b->entries[pos].used = 1;
-  b->entries[pos].key = key;
-  b->entries[pos].count = 1;
+  slot_put(b->keys, b->key_bytes, pos, raw);
+  b->counts[pos] = n;
   b->size++;
   return 1;
 }
 
-/* Rehash into a table with doubled capacity (measurement point for peak RSS). */
-static int idbigrams_grow(IdBigrams *b) {
-  size_t old_cap = b->cap;
-  BigEntry *old = b->entries;
+size_t idbigrams_bucket(const IdBigrams *b, uint32_t id1, uint32_t id2) {
+  return (size_t)mix64(pair_key(id1, id2), b->seed) & (b->cap - 1);
+}
+
+int idbigrams_inc(IdBigrams *b, uint32_t id1, uint32_t id2) {
+  if (!b || id1 == 0 || id2 == 0) return 0;
+  uint64_t key = pair_key(id1, id2);
+  return idbigrams_inc_key(b, key, mix64(key, b->seed), b->seed, 1);
+}
 
-  size_t new_cap = old_cap * 2;
-  BigEntry *ne = (BigEntry*)calloc(new_cap, sizeof(BigEntry));
-  if (!ne) return 0;
+int idbigrams_add(IdBigrams *b, uint32_t id1, uint32_t id2, uint32_t n) {
+  if (!b || id1 == 0 || id2 == 0) return 0;
+  uint64_t key = pair_key(id1, id2);
+  return idbigrams_inc_key(b, key, mix64(key, b->seed), b->seed, n);
+}
 
-  b->entries = ne;
-  b->cap = new_cap;
-  b->size = 0;
+int idbigrams_inc_batch(IdBigrams *b, const uint32_t *id1, const uint32_t *id2, size_t n) {
+  if (!b || (n > 0 && (!id1 || !id2))) return 0;
 
-  for (size_t i = 0; i < old_cap; i++) {
-    if (!old[i].used) continue;
+  uint64_t keys[IDBIGRAMS_BATCH_WINDOW];
+  uint64_t hs[IDBIGRAMS_BATCH_WINDOW];
+  for (size_t base = 0; base < n; base += IDBIGRAMS_BATCH_WINDOW) {
+    size_t m = n - base < IDBIGRAMS_BATCH_WINDOW ? n - base : IDBIGRAMS_BATCH_WINDOW;
 
-    uint64_t key = old[i].key;
-    uint64_t h = mix64(key);
+    /* Stage 1: hash the window and pull home slots into cache. */
+    uint64_t seed = b->seed;
     size_t mask = b->cap - 1;
-    size_t pos = (size_t)h & mask;
+    for (size_t i = 0; i < m; i++) {
+      if (id1[base + i] == 0 || id2[base + i] == 0) return 0;
+      keys[i] = pair_key(id1[base + i], id2[base + i]);
+      hs[i] = mix64(keys[i], seed);
+      size_t slot = (size_t)hs[i] & mask;
+      TABLE_PREFETCH((char*)b->keys + slot * b->key_bytes);
+      TABLE_PREFETCH(&b->counts[slot]);
+    }
 
-    while (b->entries[pos].used) pos = (pos + 1) & mask;
-    b->entries[pos] = old[i];
-    b->entries[pos].used = 1;
-    b->size++;
+    /* Stage 2: count in input order. */
+    for (size_t i = 0; i < m; i++) {
+      if (!idbigrams_inc_key(b, keys[i], hs[i], seed, 1)) return 0;
+    }
   }
+  return 1;
+}
+
+int idbigrams_next(const IdBigrams *b, size_t *cursor,
+                   uint32_t *id1, uint32_t *id2, uint32_t *count) {
+  if (!b || !cursor) return 0;
+
+  /* Cursor runs over [0, cap) of the current table, then the old one. */
+  while (*cursor < b->cap + b->old_cap) {
+    size_t i = (*cursor)++;
+    int in_old = i >= b->cap;
+    if (in_old) i -= b->cap;
 
-  free(old);
+    const void *keys = in_old ? b->old_keys : b->keys;
+    unsigned kb = in_old ? b->old_key_bytes : b->key_bytes;
+    uint64_t key = key_unpack(slot_raw(keys, kb, i), kb);
+    if (key == 0) continue;
+
+    if (id1) *id1 = (uint32_t)(key >> 32);
+    if (id2) *id2 = (uint32_t)(key & 0xffffffffu);
+    if (count) *count = in_old ? b->old_counts[i] : b->counts[i];
+    return 1;
+  }
+  return 0;
+}
+
+/* Migrate up to max_buckets old buckets into the current table
+ * (re-encoding keys if the width changed).
+ */
+static void idbigrams_rehash_step(IdBigrams *b, size_t max_buckets) {
+  size_t mask = b->cap - 1;
+  size_t start = b->rehash_pos;
+
+  while (max_buckets > 0 && b->rehash_pos < b->old_cap) {
+    size_t i = b->rehash_pos++;
+    max_buckets--;
+    uint64_t key = key_unpack(slot_raw(b->old_keys, b->old_key_bytes, i), b->old_key_bytes);
+    if (key == 0) continue;
+
+    size_t pos = (size_t)mix64(key, b->seed) & mask;
+    while (slot_raw(b->keys, b->key_bytes, pos) != 0) pos = (pos + 1) & mask;
+
+    slot_put(b->keys, b->key_bytes, pos, key_pack(key, b->key_bytes));
+    b->counts[pos] = b->old_counts[i];
+    slot_put(b->old_keys, b->old_key_bytes, i, 0);
+  }
+
+  /* Migrated buckets read as empty; large old tables return them early. */
+  size_t kb = b->old_key_bytes;
+  table_release_prefix(b->old_keys, b->old_cap * kb, start * kb, b->rehash_pos * kb);
+  table_release_prefix(b->old_counts, b->old_cap * sizeof(uint32_t),
+                       start * sizeof(uint32_t), b->rehash_pos * sizeof(uint32_t));
+
+  if (b->rehash_pos >= b->old_cap) {
+    slots_free(b->old_keys, b->old_counts, b->old_cap, b->old_key_bytes);
+    b->old_keys = NULL;
+    b->old_counts = NULL;
+    b->old_cap = 0;
+    b->old_key_bytes = 0;
+    b->rehash_pos = 0;
+  }
+}
+
+/* Start an incremental rehash into a table of new_cap buckets with
+ * new_key_bytes wide keys (measurement point for peak RSS). The old table
+ * is drained by idbigrams_rehash_step, so no single insert pays for a full
+ * rehash. Same cap and width only rekeys with the next generation seed.
+ */
+static int idbigrams_grow(IdBigrams *b, size_t new_cap, unsigned new_key_bytes) {
+  /* A previous rehash must be complete before the next one starts. */
+  if (b->old_keys) idbigrams_rehash_step(b, b->old_cap);
+
+  void *nk;
+  uint32_t *nc;
+  if (!slots_alloc(&nk, &nc, new_cap, new_key_bytes)) return 0;
+
+  if (b->size == 0) {
+    /* Nothing to migrate (e.g. widening an unused table). */
+    slots_free(b->keys, b->counts, b->cap, b->key_bytes);
+  } else {
+    b->old_keys = b->keys;
+    b->old_counts = b->counts;
+    b->old_cap = b->cap;
+    b->old_key_bytes = b->key_bytes;
+    b->rehash_pos = 0;
+    b->old_seed = b->seed;
+  }
+
+  b->keys = nk;
+  b->counts = nc;
+  b->cap = new_cap;
+  b->key_bytes = new_key_bytes;
+  b->seed = hash_seed_next(b->seed);
   return 1;
 }
 
-/* Local helper: duplicate dict words when materializing output. */
-static char *dup_cstr2(const char *s) {
-  if (!s) return NULL;
-  size_t n = strlen(s);
-  char *out = (char*)malloc(n + 1);
-  if (!out) return NULL;
-  memcpy(out, s, n + 1);
-  return out;
-}
-
-/* Materialize (id1,id2,count) into string-based BigramCountList. */
-static int append_bigram(BigramCountList *list, const char *w1, const char *w2, uint32_t count) {
-  size_t n = list->count + 1;
-  BigramCount *nb = (BigramCount*)realloc(list->items, n * sizeof(BigramCount));
-  if (!nb) return 0;
-  list->items = nb;
-  list->items[list->count].w1 = dup_cstr2(w1);
-  list->items[list->count].w2 = dup_cstr2(w2);
-  if (!list->items[list->count].w1 || !list->items[list->count].w2) return 0;
-  list->items[list->count].count = (size_t)count;
-  list->count = n;
+/* Tokens per batched lookup round in the counting loop. */
+#define ID_BIGRAMS_CHUNK 64
+
+int id_count_bigram_ids(const TokenList *raw,
+                        const StopwordList *sw,
+                        Dict *dict,
+                        IdBigrams *scratch,
+                        IdPairCountList *out) {
+  if (!raw || !sw || !dict || !out) return 0;
+  *out = (IdPairCountList){0};
+
+  /* ID-based bigram counting stage (memory-optimized pipeline). */
+  size_t need = raw->count * 2 + 64;
+  IdBigrams local = {0}, *bg = scratch ? scratch : &local;
+  if (!idbigrams_prepare(bg, need)) return 0;
+
+  /* Tokens are resolved in chunks so dict and pair lookups can be
+   * batched (prefetched) instead of stalling on every cache miss.
+   */
+  const char *chunk[ID_BIGRAMS_CHUNK];
+  uint32_t ids[ID_BIGRAMS_CHUNK];
+  uint32_t p1[ID_BIGRAMS_CHUNK], p2[ID_BIGRAMS_CHUNK];
+
+  uint32_t prev = 0;
+  for (size_t base = 0; base < raw->count; base += ID_BIGRAMS_CHUNK) {
+    if (cancel_poll(base)) goto fail;
+    size_t m = raw->count - base;
+    if (m > ID_BIGRAMS_CHUNK) m = ID_BIGRAMS_CHUNK;
+
+    for (size_t j = 0; j < m; j++) {
+      const char *t = raw->items[base + j];
+      chunk[j] = bigram_token_ignored(t, sw) ? NULL : t;
+    }
+    if (!dict_get_or_add_batch(dict, chunk, m, ids)) goto fail;
+
+    size_t np = 0;
+    for (size_t j = 0; j < m; j++) {
+      /* No bridging across dropped tokens (keeps bigrams local to valid runs). */
+      if (!chunk[j]) { prev = 0; continue; }
+      if (ids[j] == 0) goto fail;
+
+      if (prev != 0) {
+        p1[np] = prev;
+        p2[np] = ids[j];
+        np++;
+      }
+      prev = ids[j];
+    }
+    if (!idbigrams_inc_batch(bg, p1, p2, np)) goto fail;
+  }
+
+  if (!idbigrams_collect(bg, out)) goto fail;
+
+  if (scratch) idbigrams_clear(bg);
+  else idbigrams_free(bg);
   return 1;
+
+fail:
+  if (scratch) idbigrams_clear(bg);
+  else idbigrams_free(bg);
+  free_id_pair_counts(out);
+  return 0;
 }
 
-static int is_all_digits_local(const char *s) {
-  if (!s || !*s) return 0;
-  for (; *s; s++) if (!isdigit((unsigned char)*s)) return 0;
+int idbigrams_collect(const IdBigrams *b, IdPairCountList *out) {
+  if (!b || !out) return 0;
+  *out = (IdPairCountList){0};
+
+  /* size covers both tables while a rehash is still running. */
+  if (b->size > 0) {
+    out->items = (IdPairCount*)malloc(b->size * sizeof(IdPairCount));
+    if (!out->items) return 0;
+  }
+
+  size_t cursor = 0;
+  uint32_t id1, id2, count;
+  while (out->count < b->size && idbigrams_next(b, &cursor, &id1, &id2, &count)) {
+    IdPairCount *pc = &out->items[out->count++];
+    pc->id1 = id1;
+    pc->id2 = id2;
+    pc->count = count;
+  }
   return 1;
 }
 
-/* Same drop rules as word filtering: short tokens, digits-only, stopwords. */
-static int ignore_tok(const char *tok, const StopwordList *sw) {
-  if (!tok || !*tok) return 1;
-  if (strlen(tok) < 2) return 1;
-  if (is_all_digits_local(tok)) return 1;
-  if (sw && stopwords_contains(sw, tok)) return 1;
-  return 0;
+void free_id_pair_counts(IdPairCountList *list) {
+  if (!list) return;
+  free(list->items);
+  list->items = NULL;
+  list->count = 0;
 }
 
+int id_pairs_fold(IdPairCountList *list, const uint32_t *map) {
+  if (!list || !map) return 0;
+  if (list->count == 0) return 1;
+
+  IdBigrams bg;
+  if (!idbigrams_init(&bg, list->count * 2)) return 0;
+  for (size_t i = 0; i < list->count; i++) {
+    const IdPairCount *pc = &list->items[i];
+    if (!idbigrams_add(&bg, map[pc->id1], map[pc->id2], pc->count)) {
+      idbigrams_free(&bg);
+      return 0;
+    }
+  }
+
+  IdPairCountList folded;
+  int ok = idbigrams_collect(&bg, &folded);
+  idbigrams_free(&bg);
+  if (!ok) return 0;
+  free_id_pair_counts(list);
+  *list = folded;
+  return 1;
+}
+
+/* String-based variant: all counted pairs are materialized in one list. */
 int id_count_bigrams_excluding_stopwords(const TokenList *raw,
                                         const StopwordList *sw,
                                         Dict *dict,
@@ -147,43 +477,31 @@ int id_count_bigrams_excluding_stopwords(const TokenList *raw,
   if (!raw || !sw || !dict || !out_bigrams) return 0;
   *out_bigrams = (BigramCountList){0};
 
-  /* ID-based bigram counting stage (memory-optimized pipeline). */
-  IdBigrams bg;
-  if (!idbigrams_init(&bg, raw->count * 2 + 64)) return 0;
-
-  uint32_t prev = 0;
-  for (size_t i = 0; i < raw->count; i++) {
-    const char *t = raw->items[i];
-
-    /* No bridging across dropped tokens (keeps bigrams local to valid runs). */
-    if (ignore_tok(t, sw)) { prev = 0; continue; }
-
-    uint32_t id = dict_get_or_add(dict, t);
-    if (id == 0) goto fail;
+  IdPairCountList pairs;
+  if (!id_count_bigram_ids(raw, sw, dict, NULL, &pairs)) return 0;
 
-    if (prev != 0) {
-      if (!idbigrams_inc(&bg, prev, id)) goto fail;
-    }
-    prev = id;
+  if (pairs.count > 0) {
+    out_bigrams->items = (BigramCount*)calloc(pairs.count, sizeof(BigramCount));
+    if (!out_bigrams->items) goto fail;
   }
-
-  /* Materialize hash table into output list (string-based API contract). */
-  for (size_t i = 0; i < bg.cap; i++) {
-    if (!bg.entries[i].used) continue;
-    uint64_t key = bg.entries[i].key;
-    uint32_t id1 = (uint32_t)(key >> 32);
-    uint32_t id2 = (uint32_t)(key & 0xffffffffu);
-    const char *w1 = dict_word(dict, id1);
-    const char *w2 = dict_word(dict, id2);
+  for (size_t i = 0; i < pairs.count; i++) {
+    const char *w1 = dict_word(dict, pairs.items[i].id1);
+    const char *w2 = dict_word(dict, pairs.items[i].id2);
     if (!w1 || !w2) continue;
-    if (!append_bigram(out_bigrams, w1, w2, bg.entries[i].count)) goto fail;
+
+    BigramCount *bc = &out_bigrams->items[out_bigrams->count];
+    bc->w1 = str_dup(w1);
+    bc->w2 = str_dup(w2);
+    out_bigrams->count++;
+    if (!bc->w1 || !bc->w2) goto fail;
+    bc->count = (size_t)pairs.items[i].count;
   }
 
-  idbigrams_free(&bg);
+  free_id_pair_counts(&pairs);
   return 1;
 
 fail:
-  idbigrams_free(&bg);
+  free_id_pair_counts(&pairs);
   free_bigram_counts(out_bigrams);
   return 0;
 }
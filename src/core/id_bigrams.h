@@ -7,24 +7,33 @@
 #include "core/bigrams.h"
 #include "core/dict.h"
 
-/*
- * Single bigram entry in ID-based representation.
- * key encodes (id1, id2) into one 64-bit value.
- */
-typedef struct {
-  uint64_t key;   // (id1 << 32) | id2
-  uint32_t count;
-  int used;       // open addressing marker
-} BigEntry;
-
 /*
  * Hash table for ID-based bigram counting.
  * Power-of-two capacity enables efficient masking.
+ *
+ * Slots are stored struct-of-arrays (keys[] and counts[]); key 0 marks an
+ * empty slot (IDs start at 1). The key width is chosen at runtime:
+ * - 4 bytes: (id1 << 16) | id2 while both IDs are < 65536 (typical pages)
+ * - 8 bytes: (id1 << 32) | id2, switched to transparently (via rehash)
+ *   once a larger ID shows up
+ * Hashing always uses the 64-bit form, so it does not depend on the width.
  */
 typedef struct {
-  BigEntry *entries;
-  size_t cap;   // must remain power of two
-  size_t size;  // number of used entries
+  void *keys;          // uint32_t[cap] or uint64_t[cap], 0 = empty
+  uint32_t *counts;    // parallel to keys
+  size_t cap;          // must remain power of two
+  size_t size;         // number of used slots (both tables while rehashing)
+  unsigned key_bytes;  // 4 or 8
+  uint64_t seed;       // per-table hash seed (renewed on every rehash)
+
+  /* Incremental rehash: previous table is drained a few buckets per
+   * idbigrams_inc call and consulted by lookups until empty. */
+  void *old_keys;
+  uint32_t *old_counts;
+  size_t old_cap;
+  unsigned old_key_bytes;
+  size_t rehash_pos;  // next old bucket to migrate
+  uint64_t old_seed;  // seed the previous table was built with
 } IdBigrams;
 
 /* Initialize ID-based bigram table. */
@@ -33,9 +42,79 @@ int idbigrams_init(IdBigrams *b, size_t initial_cap);
 /* Release bigram table memory. */
 void idbigrams_free(IdBigrams *b);
 
+/*
+ * Make b an empty table for about `need` pairs, reusing it when it is
+ * allocated and not oversized (see ID_SCRATCH_OVERSIZED in
+ * core/id_freq.h). An all-zero IdBigrams gets its first table here.
+ * 0 on OOM.
+ */
+int idbigrams_prepare(IdBigrams *b, size_t need);
+
+/* Empty the table but keep it for reuse (clears the keys only). */
+void idbigrams_clear(IdBigrams *b);
+
 /* Increment bigram frequency for (id1, id2). */
 int idbigrams_inc(IdBigrams *b, uint32_t id1, uint32_t id2);
 
+/* Home bucket of (id1, id2) in the current table (layout checks in tests). */
+size_t idbigrams_bucket(const IdBigrams *b, uint32_t id1, uint32_t id2);
+
+/* Add n to the frequency of (id1, id2) (merging counted lists). */
+int idbigrams_add(IdBigrams *b, uint32_t id1, uint32_t id2, uint32_t n);
+
+/* Pairs hashed and prefetched ahead of resolution by the batch API. */
+#define IDBIGRAMS_BATCH_WINDOW 16
+
+/*
+ * Batched idbigrams_inc for pairs (id1[i], id2[i]): hashes a window,
+ * prefetches home slots, then increments in order.
+ */
+int idbigrams_inc_batch(IdBigrams *b, const uint32_t *id1, const uint32_t *id2, size_t n);
+
+/*
+ * Iterate counted pairs (including a not yet drained previous table).
+ * *cursor starts at 0; returns 0 once all pairs have been visited.
+ */
+int idbigrams_next(const IdBigrams *b, size_t *cursor,
+                   uint32_t *id1, uint32_t *id2, uint32_t *count);
+
+/*
+ * Counted bigrams in ID space: (id1, id2, count) triples, table order.
+ * Strings stay in the Dict; only Top-K winners are materialized later.
+ */
+typedef struct {
+  uint32_t id1;
+  uint32_t id2;
+  uint32_t count;
+} IdPairCount;
+
+typedef struct {
+  IdPairCount *items;
+  size_t count;
+} IdPairCountList;
+
+/* Copy all counted pairs of a table into one list (sized once). */
+int idbigrams_collect(const IdBigrams *b, IdPairCountList *out);
+
+/* Release an IdPairCountList. */
+void free_id_pair_counts(IdPairCountList *list);
+
+/* Fold both IDs of every pair through map (see id_counts_fold); pairs
+ * that meet are summed. 0 on OOM (list unchanged).
+ */
+int id_pairs_fold(IdPairCountList *list, const uint32_t *map);
+
+/*
+ * Same counting stage as below, without materialization. scratch is an
+ * empty table reused across calls (emptied again on return) or NULL for
+ * a temporary one. Fails once the bound deadline passes (core/cancel.h).
+ */
+int id_count_bigram_ids(const TokenList *raw,
+                        const StopwordList *sw,
+                        Dict *dict,
+                        IdBigrams *scratch,
+                        IdPairCountList *out);
+
 /*
  * ID-based bigram counting stage.
  *
@@ -0,0 +1,322 @@
+#include "core/id_cooc.h"
+#include "core/table_alloc.h"
+#include "core/hash_seed.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* 64-bit mix (same finalizer as id_bigrams.c); seeded per table. */
+static uint64_t mix64(uint64_t x, uint64_t seed) {
+  x ^= seed;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+/* Unordered pair: smaller ID in the high half. */
+static uint64_t pair_key(uint32_t a, uint32_t b) {
+  return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+
+/* Counts up to this value are histogrammed to pick the pruning floor. */
+#define COOC_PRUNE_HIST 256
+
+static int slots_alloc(uint64_t **keys, uint32_t **counts, size_t cap) {
+  *keys = (uint64_t*)table_alloc(cap * sizeof(uint64_t));
+  *counts = (uint32_t*)table_alloc(cap * sizeof(uint32_t));
+  if (*keys && *counts) return 1;
+  table_free(*keys, cap * sizeof(uint64_t));
+  table_free(*counts, cap * sizeof(uint32_t));
+  *keys = NULL;
+  *counts = NULL;
+  return 0;
+}
+
+static void slots_free(uint64_t *keys, uint32_t *counts, size_t cap) {
+  table_free(keys, cap * sizeof(uint64_t));
+  table_free(counts, cap * sizeof(uint32_t));
+}
+
+int idcooc_init(IdCooc *c, unsigned window, size_t limit) {
+  if (!c || window == 0 || window > COOC_MAX_WINDOW) return 0;
+  memset(c, 0, sizeof(*c));
+  c->window = window;
+  c->limit = limit ? limit : COOC_DEFAULT_LIMIT;
+  c->cap = 1024;
+  c->seed = hash_seed();
+  return slots_alloc(&c->keys, &c->counts, c->cap);
+}
+
+void idcooc_free(IdCooc *c) {
+  if (!c) return;
+  slots_free(c->keys, c->counts, c->cap);
+  memset(c, 0, sizeof(*c));
+}
+
+/* Rebuild into new_cap slots, keeping pairs with count > floor. */
+static int idcooc_rebuild(IdCooc *c, size_t new_cap, uint32_t floor) {
+  uint64_t *nk;
+  uint32_t *nc;
+  if (!slots_alloc(&nk, &nc, new_cap)) return 0;
+
+  uint64_t seed = hash_seed_next(c->seed);
+  size_t mask = new_cap - 1;
+  size_t size = 0;
+  for (size_t i = 0; i < c->cap; i++) {
+    if (c->keys[i] == 0 || c->counts[i] <= floor) continue;
+    size_t pos = (size_t)mix64(c->keys[i], seed) & mask;
+    while (nk[pos] != 0) pos = (pos + 1) & mask;
+    nk[pos] = c->keys[i];
+    nc[pos] = c->counts[i];
+    size++;
+  }
+
+  slots_free(c->keys, c->counts, c->cap);
+  c->keys = nk;
+  c->counts = nc;
+  c->cap = new_cap;
+  c->size = size;
+  c->seed = seed;
+  return 1;
+}
+
+/* Table full: drop pairs with count <= floor, the smallest floor that
+ * frees about half of the entries (at most COOC_PRUNE_HIST). A pass that
+ * would free less than 1/16 of the table is skipped; counts only grow, so
+ * new pairs are refused from then on (dropped > 0).
+ */
+static int idcooc_prune(IdCooc *c) {
+  size_t hist[COOC_PRUNE_HIST + 1] = {0};
+  for (size_t i = 0; i < c->cap; i++) {
+    if (c->keys[i] != 0 && c->counts[i] <= COOC_PRUNE_HIST) hist[c->counts[i]]++;
+  }
+
+  uint32_t floor = 0;
+  size_t freed = 0;
+  while (floor < COOC_PRUNE_HIST && freed < c->size / 2) freed += hist[++floor];
+  if (freed < c->size / 16 + 1) return 1;
+
+  if (!idcooc_rebuild(c, c->cap, floor)) return 0;
+  c->prunes++;
+  c->undercount += floor;
+  return 1;
+}
+
+static size_t find_slot(const IdCooc *c, uint64_t key) {
+  size_t mask = c->cap - 1;
+  size_t pos = (size_t)mix64(key, c->seed) & mask;
+  while (c->keys[pos] != 0 && c->keys[pos] != key) pos = (pos + 1) & mask;
+  return pos;
+}
+
+int idcooc_add(IdCooc *c, uint32_t a, uint32_t b, uint32_t n) {
+  if (!c || a == 0 || b == 0 || a == b) return 0;
+  uint64_t key = pair_key(a, b);
+
+  size_t pos = find_slot(c, key);
+  if (c->keys[pos] == key) {
+    c->counts[pos] += n;
+    return 1;
+  }
+
+  if (c->size >= c->limit) {
+    if (c->dropped == 0 && !idcooc_prune(c)) return 0;
+    if (c->size >= c->limit) {
+      c->dropped++;
+      return 1;
+    }
+    pos = find_slot(c, key);
+  }
+
+  /* Grow at ~0.7 load factor to keep probing cheap. */
+  if ((c->size + 1) * 10 >= c->cap * 7) {
+    if (!idcooc_rebuild(c, c->cap * 2, 0)) return 0;
+    pos = find_slot(c, key);
+  }
+
+  c->keys[pos] = key;
+  c->counts[pos] = n;
+  c->size++;
+  return 1;
+}
+
+uint32_t idcooc_get(const IdCooc *c, uint32_t a, uint32_t b) {
+  if (!c || !c->keys || a == 0 || b == 0 || a == b) return 0;
+  uint64_t key = pair_key(a, b);
+  size_t pos = find_slot(c, key);
+  return c->keys[pos] == key ? c->counts[pos] : 0;
+}
+
+int idcooc_count_ids(IdCooc *c, const uint32_t *ids, size_t n_ids) {
+  if (!c || (n_ids > 0 && !ids)) return 0;
+
+  size_t seam = 0;  // first position after the last sampling seam
+  for (size_t i = 0; i < n_ids; i++) {
+    uint32_t id = ids[i];
+    if (id == ID_STREAM_BREAK) { seam = i + 1; continue; }
+    if (id == 0) continue;
+
+    /* Look back at most `window` positions, never across a seam. */
+    size_t from = (i - seam > c->window) ? i - c->window : seam;
+    for (size_t j = from; j < i; j++) {
+      uint32_t other = ids[j];
+      if (other == 0 || other == id) continue;
+      if (!idcooc_add(c, id, other, 1)) return 0;
+    }
+  }
+  return 1;
+}
+
+/* ---------- Export ---------- */
+
+typedef struct {
+  const char *w1;  // w1 < w2 lexicographically
+  const char *w2;
+  uint32_t id1;
+  uint32_t id2;
+  uint32_t count;
+} CoocPair;
+
+static int cmp_pair(const void *a, const void *b) {
+  const CoocPair *x = (const CoocPair*)a;
+  const CoocPair *y = (const CoocPair*)b;
+  if (x->count != y->count) return (x->count < y->count) ? 1 : -1;
+  int c = strcmp(x->w1, y->w1);
+  if (c != 0) return c;
+  return strcmp(x->w2, y->w2);
+}
+
+typedef struct {
+  const char *w;
+  uint32_t id;
+} VocabRef;
+
+static int cmp_vocab(const void *a, const void *b) {
+  return strcmp(((const VocabRef*)a)->w, ((const VocabRef*)b)->w);
+}
+
+/* Sift-down for a min-heap of counts (Top-K threshold). */
+static void heap_down(uint32_t *h, size_t n, size_t i) {
+  for (;;) {
+    size_t l = 2 * i + 1, s = i;
+    if (l < n && h[l] < h[s]) s = l;
+    if (l + 1 < n && h[l + 1] < h[s]) s = l + 1;
+    if (s == i) return;
+    uint32_t t = h[i]; h[i] = h[s]; h[s] = t;
+    i = s;
+  }
+}
+
+int idcooc_export(const IdCooc *c, const Dict *dict, uint32_t min_count, size_t k,
+                  CoocMatrix *out) {
+  if (!c || !dict || !out) return 0;
+  *out = (CoocMatrix){0};
+  if (min_count == 0) min_count = 1;
+
+  /* Raise the threshold to the k-th largest count (bounded min-heap). */
+  if (k > 0) {
+    uint32_t *heap = (uint32_t*)malloc(k * sizeof(uint32_t));
+    if (!heap) return 0;
+    size_t m = 0;
+    for (size_t i = 0; i < c->cap; i++) {
+      if (c->keys[i] == 0 || c->counts[i] < min_count) continue;
+      if (m < k) {
+        heap[m++] = c->counts[i];
+        if (m == k) {
+          for (size_t j = k / 2; j-- > 0;) heap_down(heap, k, j);
+        }
+      } else if (c->counts[i] > heap[0]) {
+        heap[0] = c->counts[i];
+        heap_down(heap, k, 0);
+      }
+    }
+    if (m == k && heap[0] > min_count) min_count = heap[0];
+    free(heap);
+  }
+
+  size_t cand = 0;
+  for (size_t i = 0; i < c->cap; i++) {
+    if (c->keys[i] != 0 && c->counts[i] >= min_count) cand++;
+  }
+  if (cand == 0) return 1;
+
+  CoocPair *pairs = (CoocPair*)malloc(cand * sizeof(CoocPair));
+  uint32_t *index = (uint32_t*)malloc((dict_size(dict) + 1) * sizeof(uint32_t));
+  VocabRef *refs = (VocabRef*)malloc(2 * cand * sizeof(VocabRef));
+  if (!pairs || !index || !refs) goto fail;
+
+  size_t np = 0;
+  for (size_t i = 0; i < c->cap; i++) {
+    if (c->keys[i] == 0 || c->counts[i] < min_count) continue;
+    uint32_t a = (uint32_t)(c->keys[i] >> 32), b = (uint32_t)c->keys[i];
+    const char *wa = dict_word(dict, a), *wb = dict_word(dict, b);
+    if (!wa || !wb) continue;
+    CoocPair *p = &pairs[np++];
+    int swap = strcmp(wa, wb) > 0;
+    p->w1 = swap ? wb : wa;
+    p->w2 = swap ? wa : wb;
+    p->id1 = swap ? b : a;
+    p->id2 = swap ? a : b;
+    p->count = c->counts[i];
+  }
+  qsort(pairs, np, sizeof(CoocPair), cmp_pair);
+  if (k > 0 && np > k) np = k;
+
+  /* Vocabulary of the kept pairs, sorted, so rows < cols. */
+  memset(index, 0xff, (dict_size(dict) + 1) * sizeof(uint32_t));
+  size_t nv = 0;
+  for (size_t i = 0; i < np; i++) {
+    uint32_t ids[2] = { pairs[i].id1, pairs[i].id2 };
+    const char *ws[2] = { pairs[i].w1, pairs[i].w2 };
+    for (int j = 0; j < 2; j++) {
+      if (index[ids[j]] != UINT32_MAX) continue;
+      index[ids[j]] = 0;
+      refs[nv].w = ws[j];
+      refs[nv].id = ids[j];
+      nv++;
+    }
+  }
+  qsort(refs, nv, sizeof(VocabRef), cmp_vocab);
+
+  out->vocab = (const char**)malloc(nv * sizeof(const char*));
+  out->rows = (uint32_t*)malloc(np * sizeof(uint32_t));
+  out->cols = (uint32_t*)malloc(np * sizeof(uint32_t));
+  out->counts = (uint32_t*)malloc(np * sizeof(uint32_t));
+  if (!out->vocab || !out->rows || !out->cols || !out->counts) goto fail;
+
+  for (size_t v = 0; v < nv; v++) {
+    out->vocab[v] = refs[v].w;
+    index[refs[v].id] = (uint32_t)v;
+  }
+  for (size_t i = 0; i < np; i++) {
+    out->rows[i] = index[pairs[i].id1];
+    out->cols[i] = index[pairs[i].id2];
+    out->counts[i] = pairs[i].count;
+  }
+  out->n_vocab = nv;
+  out->nnz = np;
+
+  free(pairs);
+  free(index);
+  free(refs);
+  return 1;
+
+fail:
+  free(pairs);
+  free(index);
+  free(refs);
+  free_cooc_matrix(out);
+  return 0;
+}
+
+void free_cooc_matrix(CoocMatrix *m) {
+  if (!m) return;
+  free(m->vocab);
+  free(m->rows);
+  free(m->cols);
+  free(m->counts);
+  memset(m, 0, sizeof(*m));
+}
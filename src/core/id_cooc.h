@@ -0,0 +1,81 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/dict.h"
+#include "core/id_stream.h"
+
+/*
+ * Windowed co-occurrence (skip-gram) counts over Dict IDs.
+ *
+ * Two valid tokens co-occur when at most `window` raw token positions
+ * apart (ignored tokens take up positions but never pair; sampling seams
+ * end the window). Pairs are unordered and packed like bigram keys,
+ * (min_id << 32) | max_id, in one open-addressing table; a word never
+ * pairs with itself. Each position looks back at most `window` tokens, so
+ * the work is linear in the input.
+ *
+ * Memory limit: the table holds at most `limit` distinct pairs. When full,
+ * a pruning pass drops the rare pairs (count <= floor, chosen so that
+ * about half the table is freed, as in lossy counting). Reported counts
+ * are then lower bounds: a pair may miss at most `undercount` occurrences
+ * (the sum of all pruning floors).
+ */
+#ifndef COOC_MAX_WINDOW
+#define COOC_MAX_WINDOW 16
+#endif
+
+#ifndef COOC_DEFAULT_LIMIT
+#define COOC_DEFAULT_LIMIT ((size_t)1 << 20)  // distinct pairs (~24 MiB of slots)
+#endif
+
+typedef struct {
+  uint64_t *keys;     // packed pair, 0 = empty (IDs start at 1)
+  uint32_t *counts;   // parallel to keys
+  size_t cap;         // power of two
+  size_t size;
+  size_t limit;
+  unsigned window;
+  uint64_t seed;
+
+  size_t prunes;      // pruning passes at the limit
+  size_t undercount;  // max occurrences lost by any pair
+  size_t dropped;     // new pairs refused (pruning could not free enough)
+} IdCooc;
+
+/* Initialize (window 1..COOC_MAX_WINDOW, limit 0 = COOC_DEFAULT_LIMIT). */
+int idcooc_init(IdCooc *c, unsigned window, size_t limit);
+
+/* Release table memory. */
+void idcooc_free(IdCooc *c);
+
+/* Add n to the unordered pair (a, b); a != b, both non-zero. 0 on OOM. */
+int idcooc_add(IdCooc *c, uint32_t a, uint32_t b, uint32_t n);
+
+/* Count of the unordered pair (0 if absent). */
+uint32_t idcooc_get(const IdCooc *c, uint32_t a, uint32_t b);
+
+/* One pass over a resolved page (IdStream positions). 0 on OOM. */
+int idcooc_count_ids(IdCooc *c, const uint32_t *ids, size_t n_ids);
+
+/*
+ * Sparse export in coordinate (COO) form: vocab is sorted
+ * lexicographically, entry i is the pair (vocab[rows[i]], vocab[cols[i]])
+ * with rows[i] < cols[i]. Entries are ordered count DESC, then row, col
+ * (the Top-K order of bigram lists). Words point into the Dict.
+ */
+typedef struct {
+  const char **vocab;
+  size_t n_vocab;
+  uint32_t *rows;
+  uint32_t *cols;
+  uint32_t *counts;
+  size_t nnz;
+} CoocMatrix;
+
+/* Pairs with count >= min_count; k > 0 keeps the k strongest. */
+int idcooc_export(const IdCooc *c, const Dict *dict, uint32_t min_count, size_t k,
+                  CoocMatrix *out);
+
+/* Release a CoocMatrix. */
+void free_cooc_matrix(CoocMatrix *m);
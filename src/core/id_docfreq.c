@@ -0,0 +1,81 @@
+#include "core/id_docfreq.h"
+#include "core/arena.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+int iddf_init(IdDocFreq *f, size_t initial_ids) {
+  if (!f) return 0;
+  memset(f, 0, sizeof(*f));
+  if (!idfreq_init(&f->tf, initial_ids)) return 0;
+  if (!idfreq_init(&f->df, initial_ids)) {
+    idfreq_free(&f->tf);
+    return 0;
+  }
+  return 1;
+}
+
+void iddf_free(IdDocFreq *f) {
+  if (!f) return;
+  idfreq_free(&f->tf);
+  idfreq_free(&f->df);
+  memset(f, 0, sizeof(*f));
+}
+
+/* Counts and presence of one ID; both vectors grow together. */
+static int iddf_add(IdDocFreq *f, uint32_t id, uint32_t count) {
+  if (!idfreq_ensure(&f->tf, id) || !idfreq_ensure(&f->df, id)) return 0;
+  f->tf.counts[id - 1] += count;
+  f->df.counts[id - 1] += 1;
+  return 1;
+}
+
+int iddf_add_page(IdDocFreq *f, const IdCountList *page) {
+  if (!f || !page) return 0;
+  for (size_t i = 0; i < page->count; i++) {
+    if (page->items[i].count == 0) continue;
+    if (!iddf_add(f, page->items[i].id, page->items[i].count)) return 0;
+  }
+  f->n_docs++;
+  return 1;
+}
+
+/* Words per batched dict lookup round (as in id_freq.c). */
+#define IDDF_CHUNK 64
+
+int iddf_add_words(IdDocFreq *f, Dict *dict, const WordCountList *page) {
+  if (!f || !dict || !page) return 0;
+
+  const char *chunk[IDDF_CHUNK];
+  uint32_t ids[IDDF_CHUNK];
+  for (size_t base = 0; base < page->count; base += IDDF_CHUNK) {
+    size_t m = page->count - base;
+    if (m > IDDF_CHUNK) m = IDDF_CHUNK;
+
+    for (size_t j = 0; j < m; j++) chunk[j] = page->items[base + j].word;
+    if (!dict_get_or_add_batch(dict, chunk, m, ids)) return 0;
+
+    for (size_t j = 0; j < m; j++) {
+      size_t c = page->items[base + j].count;
+      if (!chunk[j] || c == 0) continue;
+      if (ids[j] == 0) return 0;
+      if (!iddf_add(f, ids[j], c > UINT32_MAX ? UINT32_MAX : (uint32_t)c)) return 0;
+    }
+  }
+  f->n_docs++;
+  return 1;
+}
+
+double iddf_idf(const IdDocFreq *f, uint32_t df) {
+  double n = f ? (double)f->n_docs : 0.0;
+  return log((1.0 + n) / (1.0 + (double)df)) + 1.0;
+}
+
+void free_tfidf_list(TfidfList *l) {
+  if (!l) return;
+  for (size_t i = 0; i < l->count; i++) str_free(l->items[i].word);
+  free(l->items);
+  l->items = NULL;
+  l->count = 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/dict.h"
+#include "core/freq.h"
+#include "core/id_freq.h"
+
+/*
+ * Document frequencies over Dict IDs (options.tfidf).
+ *
+ * Every page list is added once: its counts are summed into tf and each
+ * ID it contains adds 1 to df (page lists hold every ID at most once).
+ * Both are dense IdFreq vectors, so no strings are touched until the
+ * Top-K winners are materialized.
+ *
+ * Ranking uses the smoothed inverse document frequency
+ *   idf = ln((1 + N) / (1 + df)) + 1,   score = tf * idf
+ * with N pages: words on every page keep weight 1, rarer words gain.
+ */
+typedef struct {
+  IdFreq tf;      // summed counts, index id - 1
+  IdFreq df;      // pages with count > 0, index id - 1
+  size_t n_docs;  // pages added
+} IdDocFreq;
+
+/* Initialize / release. */
+int iddf_init(IdDocFreq *f, size_t initial_ids);
+void iddf_free(IdDocFreq *f);
+
+/* Add one page counted in ID space. 0 on OOM. */
+int iddf_add_page(IdDocFreq *f, const IdCountList *page);
+
+/* Add one string page list; words are resolved through dict. 0 on OOM. */
+int iddf_add_words(IdDocFreq *f, Dict *dict, const WordCountList *page);
+
+/* Smoothed idf for a document frequency. */
+double iddf_idf(const IdDocFreq *f, uint32_t df);
+
+/* One ranked word (domainResult.tfidf). */
+typedef struct {
+  char *word;
+  uint32_t count;  // tf: summed occurrences
+  uint32_t df;     // pages containing the word
+  double idf;
+  double score;    // count * idf
+} TfidfEntry;
+
+typedef struct {
+  TfidfEntry *items;
+  size_t count;
+} TfidfList;
+
+/* Release a TfidfList. */
+void free_tfidf_list(TfidfList *l);
@@ -1,4 +1,7 @@
 #include "core/id_freq.h"
+#include "core/arena.h"
+#include "core/cancel.h"
+#include "core/table_alloc.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -9,20 +12,21 @@ int idfreq_init(IdFreq *f, size_t initial_ids) {
   if (!f) return 0;
   memset(f, 0, sizeof(*f));
   f->cap = initial_ids < 16 ? 16 : initial_ids;
-  f->counts = (uint32_t*)calloc(f->cap, sizeof(uint32_t));
+  f->counts = (uint32_t*)table_alloc(f->cap * sizeof(uint32_t));
   return f->counts != NULL;
 }
 
 /* Release frequency table memory. */
 void idfreq_free(IdFreq *f) {
   if (!f) return;
-  free(f->counts);
+  table_free(f->counts, f->cap * sizeof(uint32_t));
   f->counts = NULL;
   f->cap = 0;
 }
 
 /* Ensure capacity for given ID.
- * Grows exponentially to keep amortized O(1) insert cost.
+ * Grows exponentially to keep amortized O(1) insert cost; large tables
+ * are remapped rather than copied (see table_alloc.h).
  */
 int idfreq_ensure(IdFreq *f, uint32_t id) {
   if (!f || id == 0) return 0;
@@ -32,16 +36,28 @@ int idfreq_ensure(IdFreq *f, uint32_t id) {
   size_t new_cap = f->cap;
   while (new_cap < need) new_cap *= 2;
 
-  uint32_t *nw = (uint32_t*)realloc(f->counts, new_cap * sizeof(uint32_t));
+  /* Newly added region comes back zeroed (correct initial counts). */
+  uint32_t *nw = (uint32_t*)table_grow(f->counts, f->cap * sizeof(uint32_t),
+                                       new_cap * sizeof(uint32_t));
   if (!nw) return 0;
-
-  /* Zero newly allocated region to maintain correct counts. */
-  memset(nw + f->cap, 0, (new_cap - f->cap) * sizeof(uint32_t));
   f->counts = nw;
   f->cap = new_cap;
   return 1;
 }
 
+int idfreq_prepare(IdFreq *f, size_t need) {
+  if (!f) return 0;
+  if (f->counts && !ID_SCRATCH_OVERSIZED(f->cap, need, sizeof(uint32_t))) return 1;
+  idfreq_free(f);
+  return idfreq_init(f, 1024);
+}
+
+/* Counted IDs are all <= n_ids: zero just that prefix. */
+void idfreq_clear(IdFreq *f, size_t n_ids) {
+  if (!f || !f->counts) return;
+  memset(f->counts, 0, (n_ids < f->cap ? n_ids : f->cap) * sizeof(uint32_t));
+}
+
 /* Increment counter for ID (id >= 1). */
 int idfreq_inc(IdFreq *f, uint32_t id) {
   if (!idfreq_ensure(f, id)) return 0;
@@ -61,76 +77,129 @@ uint32_t idfreq_get(const IdFreq *f, uint32_t id) {
 #include "core/dict.h"
 #include "core/tokenizer.h"
 
-/* Local helper to duplicate dictionary words
- * when converting ID-based counts back to string-based results.
- */
-static char *dup_cstr(const char *s) {
-  if (!s) return NULL;
-  size_t n = strlen(s);
-  char *out = (char*)malloc(n + 1);
-  if (!out) return NULL;
-  memcpy(out, s, n + 1);
-  return out;
-}
-
-/* Append word/count pair to WordCountList.
- * Final materialization step of ID-based pipeline.
- */
-static int append_word(WordCountList *list, const char *word, uint32_t count) {
-  size_t n = list->count + 1;
-  WordCount *nw = (WordCount*)realloc(list->items, n * sizeof(WordCount));
-  if (!nw) return 0;
-  list->items = nw;
-
-  list->items[list->count].word = dup_cstr(word);
-  if (!list->items[list->count].word) return 0;
-
-  list->items[list->count].count = (size_t)count;
-  list->count = n;
-  return 1;
-}
+/* Tokens per batched dict lookup round in id_count_word_ids. */
+#define ID_FREQ_CHUNK 64
 
 /*
  * ID-based word counting.
  *
  * Pipeline:
  *   filtered tokens → dict (token→id) → dense IdFreq table
- *   → materialize WordCountList (string-based output)
+ *   → (id, count) pairs
  *
  * Reduces memory overhead compared to string-keyed hash maps.
  */
-int id_count_words(const TokenList *filtered, Dict *dict, WordCountList *out_words) {
-  if (!filtered || !dict || !out_words) return 0;
-  *out_words = (WordCountList){0};
+int id_count_word_ids(const TokenList *filtered, Dict *dict, IdFreq *scratch, IdCountList *out) {
+  if (!filtered || !dict || !out) return 0;
+  *out = (IdCountList){0};
+
+  /* A page has at most one new ID per token (plus what the dict holds). */
+  size_t need = dict_size(dict) + filtered->count + 16;
+  IdFreq local = {0}, *wf = scratch ? scratch : &local;
+  if (!idfreq_prepare(wf, need)) return 0;
+
+  /* Counting stage: token → id → increment dense table.
+   * Dict lookups run in chunks (batched, prefetched home slots).
+   */
+  uint32_t ids[ID_FREQ_CHUNK];
+  for (size_t base = 0; base < filtered->count; base += ID_FREQ_CHUNK) {
+    if (cancel_poll(base)) goto fail;
+    size_t m = filtered->count - base;
+    if (m > ID_FREQ_CHUNK) m = ID_FREQ_CHUNK;
+
+    const char *const *chunk = (const char *const *)&filtered->items[base];
+    if (!dict_get_or_add_batch(dict, chunk, m, ids)) goto fail;
+
+    for (size_t j = 0; j < m; j++) {
+      if (!chunk[j] || !*chunk[j]) continue;
+      if (ids[j] == 0) goto fail;
+      if (!idfreq_inc(wf, ids[j])) goto fail;
+    }
+  }
 
-  IdFreq wf;
-  if (!idfreq_init(&wf, 1024)) return 0;
+  /* Collection stage: counted IDs sized once (no per-entry growth). */
+  uint32_t n_ids = (uint32_t)dict_size(dict);
+  size_t distinct = 0;
+  for (uint32_t id = 1; id <= n_ids; id++) {
+    if (idfreq_get(wf, id)) distinct++;
+  }
+  if (distinct > 0) {
+    out->items = (IdCount*)malloc(distinct * sizeof(IdCount));
+    if (!out->items) goto fail;
+  }
+  for (uint32_t id = 1; id <= n_ids; id++) {
+    uint32_t c = idfreq_get(wf, id);
+    if (!c) continue;
+    out->items[out->count].id = id;
+    out->items[out->count].count = c;
+    out->count++;
+  }
 
-  /* Counting stage: token → id → increment dense table. */
-  for (size_t i = 0; i < filtered->count; i++) {
-    const char *t = filtered->items[i];
-    if (!t || !*t) continue;
+  if (scratch) idfreq_clear(wf, n_ids);
+  else idfreq_free(wf);
+  return 1;
+
+fail:
+  if (scratch) idfreq_clear(wf, dict_size(dict));
+  else idfreq_free(wf);
+  free_id_counts(out);
+  return 0;
+}
 
-    uint32_t id = dict_get_or_add(dict, t);
-    if (id == 0) goto fail;
+void free_id_counts(IdCountList *list) {
+  if (!list) return;
+  free(list->items);
+  list->items = NULL;
+  list->count = 0;
+}
 
-    if (!idfreq_inc(&wf, id)) goto fail;
+void id_counts_fold(IdCountList *list, const uint32_t *map, uint32_t *slot) {
+  if (!list || !map || !slot) return;
+
+  /* slot[new id] = output position + 1; the write index never passes
+   * the read index, so the list is compacted in one pass.
+   */
+  size_t w = 0;
+  for (size_t i = 0; i < list->count; i++) {
+    uint32_t id = map[list->items[i].id];
+    uint32_t count = list->items[i].count;
+    if (slot[id] != 0) {
+      list->items[slot[id] - 1].count += count;
+      continue;
+    }
+    list->items[w].id = id;
+    list->items[w].count = count;
+    slot[id] = (uint32_t)++w;
   }
+  list->count = w;
+  for (size_t i = 0; i < w; i++) slot[list->items[i].id] = 0;
+}
 
-  /* Materialization stage: rebuild string-based result list. */
-  for (uint32_t id = 1; id <= (uint32_t)dict_size(dict); id++) {
-    uint32_t c = idfreq_get(&wf, id);
-    if (!c) continue;
+/* String-based variant: all counted words are materialized in one list. */
+int id_count_words(const TokenList *filtered, Dict *dict, WordCountList *out_words) {
+  if (!filtered || !dict || !out_words) return 0;
+  *out_words = (WordCountList){0};
 
-    const char *w = dict_word(dict, id);
-    if (!append_word(out_words, w, c)) goto fail;
+  IdCountList ids;
+  if (!id_count_word_ids(filtered, dict, NULL, &ids)) return 0;
+
+  if (ids.count > 0) {
+    out_words->items = (WordCount*)calloc(ids.count, sizeof(WordCount));
+    if (!out_words->items) goto fail;
+  }
+  for (size_t i = 0; i < ids.count; i++) {
+    WordCount *wc = &out_words->items[out_words->count];
+    wc->word = str_dup(dict_word(dict, ids.items[i].id));
+    if (!wc->word) goto fail;
+    wc->count = (size_t)ids.items[i].count;
+    out_words->count++;
   }
 
-  idfreq_free(&wf);
+  free_id_counts(&ids);
   return 1;
 
 fail:
-  idfreq_free(&wf);
+  free_id_counts(&ids);
   free_word_counts(out_words);
   return 0;
 }
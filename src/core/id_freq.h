@@ -6,6 +6,15 @@
 #include "core/tokenizer.h"
 #include "core/freq.h"
 
+/*
+ * Dense frequency table indexed by (id - 1).
+ * Eliminates string lookups during counting.
+ */
+typedef struct {
+  uint32_t *counts;  // index = id - 1
+  size_t cap;        // allocated capacity (number of IDs supported)
+} IdFreq;
+
 /*
  * ID-based word counting stage.
  *
@@ -16,13 +25,52 @@
 int id_count_words(const TokenList *filtered, Dict *dict, WordCountList *out_words);
 
 /*
- * Dense frequency table indexed by (id - 1).
- * Eliminates string lookups during counting.
+ * Counted words in ID space: (id, count) pairs, ascending id.
+ * Strings stay in the Dict; only Top-K winners are materialized later.
  */
 typedef struct {
-  uint32_t *counts;  // index = id - 1
-  size_t cap;        // allocated capacity (number of IDs supported)
-} IdFreq;
+  uint32_t id;
+  uint32_t count;
+} IdCount;
+
+typedef struct {
+  IdCount *items;
+  size_t count;
+} IdCountList;
+
+/*
+ * Same counting stage as id_count_words, without materialization.
+ * scratch is a zeroed table reused across calls (zeroed again on return)
+ * or NULL for a temporary one. Fails once the bound deadline passes
+ * (core/cancel.h).
+ */
+int id_count_word_ids(const TokenList *filtered, Dict *dict, IdFreq *scratch, IdCountList *out);
+
+/*
+ * Trim rule for reused scratch tables: a table above ID_SCRATCH_KEEP_BYTES
+ * that is more than ID_SCRATCH_SHRINK_FACTOR times larger than a call
+ * needs is reallocated to fit, so one huge page does not pin its
+ * high-water size (and clearing cost) for all later ones.
+ */
+#ifndef ID_SCRATCH_KEEP_BYTES
+#define ID_SCRATCH_KEEP_BYTES ((size_t)256 * 1024)
+#endif
+#ifndef ID_SCRATCH_SHRINK_FACTOR
+#define ID_SCRATCH_SHRINK_FACTOR 8
+#endif
+#define ID_SCRATCH_OVERSIZED(cap, need, slot_bytes) \
+  ((cap) * (slot_bytes) > ID_SCRATCH_KEEP_BYTES && (cap) > (need) * ID_SCRATCH_SHRINK_FACTOR)
+
+/* Release an IdCountList. */
+void free_id_counts(IdCountList *list);
+
+/*
+ * Fold a list onto new IDs in place (map[id] = new ID, e.g. a stem):
+ * entries sharing a new ID are summed. slot is a zeroed scratch table
+ * indexed by new ID and is zeroed again on return. The list keeps
+ * first-seen order (no longer ascending id).
+ */
+void id_counts_fold(IdCountList *list, const uint32_t *map, uint32_t *slot);
 
 /* Initialize frequency table for ID-based pipeline. */
 int idfreq_init(IdFreq *f, size_t initial_ids);
@@ -30,6 +78,16 @@ int idfreq_init(IdFreq *f, size_t initial_ids);
 /* Release memory of frequency table. */
 void idfreq_free(IdFreq *f);
 
+/*
+ * Make f a zeroed table for about `need` IDs, reusing it when it is
+ * allocated and not oversized (see ID_SCRATCH_OVERSIZED). An all-zero
+ * IdFreq gets its first table here. 0 on OOM.
+ */
+int idfreq_prepare(IdFreq *f, size_t need);
+
+/* Zero the counts of IDs 1..n_ids again; the table stays allocated. */
+void idfreq_clear(IdFreq *f, size_t n_ids);
+
 /* Ensure internal capacity can store the given ID. */
 int idfreq_ensure(IdFreq *f, uint32_t id);
 
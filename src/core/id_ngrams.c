@@ -0,0 +1,263 @@
+#include "core/id_ngrams.h"
+#include "core/table_alloc.h"
+#include "core/hash_seed.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Utility: ensure power-of-two capacity for mask-based probing. */
+static size_t next_pow2(size_t x) {
+  size_t p = 1;
+  while (p < x) p <<= 1;
+  return p;
+}
+
+/* 64-bit mix (same finalizer as id_bigrams.c); seeded per table. */
+static uint64_t mix64(uint64_t x, uint64_t seed) {
+  x ^= seed;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+/* Hash of the 128-bit key as two packed halves (id1|id2, id3|id4). */
+static uint64_t key_hash(const uint32_t *k, uint64_t seed) {
+  uint64_t lo = ((uint64_t)k[0] << 32) | k[1];
+  uint64_t hi = ((uint64_t)k[2] << 32) | k[3];
+  return mix64(lo ^ mix64(hi, seed), seed);
+}
+
+static int key_eq(const uint32_t *a, const uint32_t *b) {
+  return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+}
+
+static unsigned key_order(const uint32_t *k) {
+  unsigned n = 0;
+  while (n < NGRAM_MAX_N && k[n] != 0) n++;
+  return n;
+}
+
+int idngrams_init(IdNgrams *g, size_t initial_cap, size_t limit) {
+  if (!g) return 0;
+  memset(g, 0, sizeof(*g));
+  g->limit = limit ? limit : NGRAM_DEFAULT_LIMIT;
+  g->cap = next_pow2(initial_cap < 64 ? 64 : initial_cap);
+  g->seed = hash_seed();
+  g->slots = (IdNgram*)table_alloc(g->cap * sizeof(IdNgram));
+  return g->slots != NULL;
+}
+
+void idngrams_free(IdNgrams *g) {
+  if (!g) return;
+  table_free(g->slots, g->cap * sizeof(IdNgram));
+  memset(g, 0, sizeof(*g));
+}
+
+/* Rehash into twice the capacity (the size limit bounds the final table). */
+static int idngrams_grow(IdNgrams *g) {
+  size_t ncap = g->cap * 2;
+  IdNgram *ns = (IdNgram*)table_alloc(ncap * sizeof(IdNgram));
+  if (!ns) return 0;
+
+  uint64_t seed = hash_seed_next(g->seed);
+  size_t mask = ncap - 1;
+  for (size_t i = 0; i < g->cap; i++) {
+    const IdNgram *e = &g->slots[i];
+    if (e->ids[0] == 0) continue;
+    size_t pos = (size_t)key_hash(e->ids, seed) & mask;
+    while (ns[pos].ids[0] != 0) pos = (pos + 1) & mask;
+    ns[pos] = *e;
+  }
+
+  table_free(g->slots, g->cap * sizeof(IdNgram));
+  g->slots = ns;
+  g->cap = ncap;
+  g->seed = seed;
+  return 1;
+}
+
+/* Slot holding key k, or the empty slot where it would go. */
+static size_t find_slot(const IdNgrams *g, const uint32_t *k) {
+  size_t mask = g->cap - 1;
+  size_t pos = (size_t)key_hash(k, g->seed) & mask;
+  while (g->slots[pos].ids[0] != 0 && !key_eq(g->slots[pos].ids, k)) pos = (pos + 1) & mask;
+  return pos;
+}
+
+/* Build the zero-padded key; 0 if n or an ID is out of range. */
+static int make_key(uint32_t *k, const uint32_t *ids, unsigned n) {
+  if (!ids || n == 0 || n > NGRAM_MAX_N) return 0;
+  memset(k, 0, NGRAM_MAX_N * sizeof(uint32_t));
+  for (unsigned i = 0; i < n; i++) {
+    if (ids[i] == 0) return 0;
+    k[i] = ids[i];
+  }
+  return 1;
+}
+
+static int inc_key(IdNgrams *g, const uint32_t *k) {
+  size_t pos = find_slot(g, k);
+  if (g->slots[pos].ids[0] != 0) {
+    g->slots[pos].count++;
+    return 1;
+  }
+
+  /* Memory bound reached: new n-grams are only tallied. */
+  if (g->size >= g->limit) {
+    g->dropped++;
+    return 1;
+  }
+
+  /* Grow at ~0.7 load factor to keep probing cheap. */
+  if ((g->size + 1) * 10 >= g->cap * 7) {
+    if (!idngrams_grow(g)) return 0;
+    pos = find_slot(g, k);
+  }
+
+  memcpy(g->slots[pos].ids, k, sizeof(g->slots[pos].ids));
+  g->slots[pos].count = 1;
+  g->size++;
+  return 1;
+}
+
+int idngrams_inc(IdNgrams *g, const uint32_t *ids, unsigned n) {
+  uint32_t k[NGRAM_MAX_N];
+  if (!g || !make_key(k, ids, n)) return 0;
+  return inc_key(g, k);
+}
+
+uint32_t idngrams_get(const IdNgrams *g, const uint32_t *ids, unsigned n) {
+  uint32_t k[NGRAM_MAX_N];
+  if (!g || !g->slots || !make_key(k, ids, n)) return 0;
+  const IdNgram *e = &g->slots[find_slot(g, k)];
+  return e->ids[0] != 0 ? e->count : 0;
+}
+
+int idngrams_count_ids(IdNgrams *g, const uint32_t *ids, size_t n_ids, unsigned max_n) {
+  if (!g || (n_ids > 0 && !ids) || max_n == 0 || max_n > NGRAM_MAX_N) return 0;
+
+  /* win holds the last NGRAM_MAX_N IDs (newest last); run counts the valid
+   * tokens since the last reset, capped at max_n.
+   */
+  uint32_t win[NGRAM_MAX_N] = {0};
+  unsigned run = 0;
+  uint32_t k[NGRAM_MAX_N];
+
+  for (size_t i = 0; i < n_ids; i++) {
+    /* No bridging across dropped tokens or sampling seams. */
+    uint32_t id = ids[i];
+    if (id == 0 || id == ID_STREAM_BREAK) { run = 0; continue; }
+
+    memmove(win, win + 1, (NGRAM_MAX_N - 1) * sizeof(uint32_t));
+    win[NGRAM_MAX_N - 1] = id;
+    if (run < max_n) run++;
+
+    /* Every order the run allows ends at this token. */
+    for (unsigned n = 1; n <= run; n++) {
+      memset(k, 0, sizeof(k));
+      memcpy(k, win + NGRAM_MAX_N - n, n * sizeof(uint32_t));
+      if (!inc_key(g, k)) return 0;
+    }
+  }
+  return 1;
+}
+
+int idngrams_count_tokens(IdNgrams *g, Dict *dict, const TokenList *raw,
+                          const StopwordList *sw, unsigned max_n) {
+  IdStream st = {0};
+  int ok = id_stream_resolve(&st, dict, raw, sw) && idngrams_count_ids(g, st.ids, st.count, max_n);
+  id_stream_free(&st);
+  return ok;
+}
+
+static int cmp_ngram(const void *a, const void *b) {
+  const NgramCount *x = (const NgramCount*)a;
+  const NgramCount *y = (const NgramCount*)b;
+  if (x->count != y->count) return (x->count < y->count) ? 1 : -1;
+  for (unsigned i = 0; i < x->n; i++) {
+    int c = strcmp(x->words[i], y->words[i]);
+    if (c != 0) return c;
+  }
+  return 0;
+}
+
+/* Sift-down for a min-heap of counts (Top-K threshold). */
+static void heap_down(uint32_t *h, size_t n, size_t i) {
+  for (;;) {
+    size_t l = 2 * i + 1, s = i;
+    if (l < n && h[l] < h[s]) s = l;
+    if (l + 1 < n && h[l + 1] < h[s]) s = l + 1;
+    if (s == i) return;
+    uint32_t t = h[i]; h[i] = h[s]; h[s] = t;
+    i = s;
+  }
+}
+
+int idngrams_top_k(const IdNgrams *g, const Dict *dict, unsigned n, size_t k,
+                   NgramCountList *out) {
+  if (!g || !dict || !out || n == 0 || n > NGRAM_MAX_N) return 0;
+  *out = (NgramCountList){0};
+
+  /* Count threshold: the k-th largest count of this order (bounded
+   * min-heap), so only candidates at or above it are materialized.
+   */
+  uint32_t min_count = 1;
+  size_t m = 0;
+  if (k > 0) {
+    uint32_t *heap = (uint32_t*)malloc(k * sizeof(uint32_t));
+    if (!heap) return 0;
+    for (size_t i = 0; i < g->cap; i++) {
+      const IdNgram *e = &g->slots[i];
+      if (e->ids[0] == 0 || key_order(e->ids) != n) continue;
+      if (m < k) {
+        heap[m++] = e->count;
+        if (m == k) {
+          for (size_t j = k / 2; j-- > 0;) heap_down(heap, k, j);
+        }
+      } else if (e->count > heap[0]) {
+        heap[0] = e->count;
+        heap_down(heap, k, 0);
+      }
+    }
+    if (m == k) {
+      min_count = heap[0];
+    }
+    free(heap);
+  }
+
+  size_t cand = 0;
+  for (size_t i = 0; i < g->cap; i++) {
+    const IdNgram *e = &g->slots[i];
+    if (e->ids[0] != 0 && e->count >= min_count && key_order(e->ids) == n) cand++;
+  }
+  if (cand == 0) return 1;
+
+  out->items = (NgramCount*)malloc(cand * sizeof(NgramCount));
+  if (!out->items) return 0;
+  for (size_t i = 0; i < g->cap; i++) {
+    const IdNgram *e = &g->slots[i];
+    if (e->ids[0] == 0 || e->count < min_count || key_order(e->ids) != n) continue;
+    NgramCount *nc = &out->items[out->count++];
+    memset(nc->words, 0, sizeof(nc->words));
+    nc->n = n;
+    nc->count = e->count;
+    for (unsigned j = 0; j < n; j++) {
+      const char *w = dict_word(dict, e->ids[j]);
+      nc->words[j] = w ? w : "";
+    }
+  }
+
+  qsort(out->items, out->count, sizeof(NgramCount), cmp_ngram);
+  if (k > 0 && out->count > k) out->count = k;
+  return 1;
+}
+
+void free_ngram_counts(NgramCountList *list) {
+  if (!list) return;
+  free(list->items);
+  list->items = NULL;
+  list->count = 0;
+}
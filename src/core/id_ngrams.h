@@ -0,0 +1,90 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "core/tokenizer.h"
+#include "core/stopwords.h"
+#include "core/dict.h"
+#include "core/id_stream.h"
+
+/*
+ * ID-based n-gram counting (n = 1..NGRAM_MAX_N) in one hash table.
+ *
+ * Keys are the packed 128-bit generalization of the bigram key
+ * ((id1 << 32) | id2, see id_bigrams.h): up to four uint32 Dict IDs, the
+ * unused tail is 0 (IDs start at 1), so n is implied by the key and one
+ * table holds every order. ids[0] == 0 marks an empty slot.
+ *
+ * Counting is a single sliding-window pass over the ID stream: each valid
+ * token closes one n-gram of every order the current run allows. Same
+ * rules as bigrams: ignored tokens (short, digits-only, stopwords) reset
+ * the window, so no n-gram bridges them.
+ *
+ * Memory limit: at most `limit` distinct n-grams are stored. Once full,
+ * known n-grams keep counting exactly; occurrences of new ones are only
+ * tallied in `dropped` (the result is then incomplete, never inflated).
+ */
+#define NGRAM_MAX_N 4
+
+#ifndef NGRAM_DEFAULT_LIMIT
+#define NGRAM_DEFAULT_LIMIT ((size_t)1 << 20)  // distinct n-grams (~40 MiB of slots)
+#endif
+
+typedef struct {
+  uint32_t ids[NGRAM_MAX_N];  // id1..idn, tail 0
+  uint32_t count;
+} IdNgram;
+
+typedef struct {
+  IdNgram *slots;
+  size_t cap;        // power of two
+  size_t size;       // distinct n-grams stored
+  size_t limit;      // max size (memory bound)
+  size_t dropped;    // occurrences of n-grams refused at the limit
+  uint64_t seed;
+} IdNgrams;
+
+/* Initialize (limit 0 = NGRAM_DEFAULT_LIMIT). 0 on OOM. */
+int idngrams_init(IdNgrams *g, size_t initial_cap, size_t limit);
+
+/* Release table memory. */
+void idngrams_free(IdNgrams *g);
+
+/* Count one n-gram (ids[0..n), all non-zero). 0 on OOM or invalid input. */
+int idngrams_inc(IdNgrams *g, const uint32_t *ids, unsigned n);
+
+/* Count of an n-gram (0 if absent). */
+uint32_t idngrams_get(const IdNgrams *g, const uint32_t *ids, unsigned n);
+
+/*
+ * Sliding-window pass over one resolved page (IdStream positions): counts
+ * n-grams of order 1..max_n; ignored tokens and breaks reset the window.
+ */
+int idngrams_count_ids(IdNgrams *g, const uint32_t *ids, size_t n_ids, unsigned max_n);
+
+/* Same, resolving raw tokens in dict first (IDs shared across pages). */
+int idngrams_count_tokens(IdNgrams *g, Dict *dict, const TokenList *raw,
+                          const StopwordList *sw, unsigned max_n);
+
+/* Materialized n-gram: words point into the Dict (not owned). */
+typedef struct {
+  const char *words[NGRAM_MAX_N];
+  unsigned n;
+  size_t count;
+} NgramCount;
+
+typedef struct {
+  NgramCount *items;
+  size_t count;
+} NgramCountList;
+
+/*
+ * Top-K n-grams of order n (count DESC, then word by word ASC, the same
+ * order as bigram lists; k == 0: all). Words stay valid while dict lives.
+ */
+int idngrams_top_k(const IdNgrams *g, const Dict *dict, unsigned n, size_t k,
+                   NgramCountList *out);
+
+/* Release an NgramCountList. */
+void free_ngram_counts(NgramCountList *list);
@@ -0,0 +1,251 @@
+#include "core/id_sort.h"
+#include "core/arena.h"
+#include "core/cancel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Tokens per batched dict lookup round (see dict_get_or_add_batch). */
+#define ID_SORT_CHUNK 64
+
+int radix_sort_u64(uint64_t *keys, uint64_t *tmp, size_t n, unsigned key_bits) {
+  if (!keys || !tmp || n < 2) return 1;
+
+  /* Polls only while counting, so a cancelled sort never leaves a
+   * half-scattered pass behind.
+   */
+  int done = 1;
+  uint64_t *src = keys, *dst = tmp;
+  for (unsigned shift = 0; done && shift < key_bits; shift += 8) {
+    size_t hist[256] = {0};
+    for (size_t i = 0; i < n; i++) {
+      if (cancel_poll(i)) { done = 0; break; }
+      hist[(src[i] >> shift) & 0xff]++;
+    }
+    if (!done) break;
+
+    /* All keys share this digit: the pass would not reorder anything. */
+    if (hist[(src[0] >> shift) & 0xff] == n) continue;
+
+    size_t sum = 0;
+    for (int b = 0; b < 256; b++) {
+      size_t c = hist[b];
+      hist[b] = sum;
+      sum += c;
+    }
+    for (size_t i = 0; i < n; i++) dst[hist[(src[i] >> shift) & 0xff]++] = src[i];
+
+    uint64_t *t = src; src = dst; dst = t;
+  }
+
+  if (src != keys) memcpy(keys, src, n * sizeof(uint64_t));
+  return done;
+}
+
+/* Number of bits needed to represent v (0 for v == 0). */
+static unsigned bit_width(uint64_t v) {
+  unsigned b = 0;
+  while (v) { b++; v >>= 1; }
+  return b;
+}
+
+/* Number of distinct values in a sorted array. */
+static size_t count_runs(const uint64_t *a, size_t n) {
+  size_t runs = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (i == 0 || a[i] != a[i - 1]) runs++;
+  }
+  return runs;
+}
+
+int sort_count_words(const TokenList *filtered, Dict *dict, WordCountList *out_words) {
+  if (!filtered || !dict || !out_words) return 0;
+  *out_words = (WordCountList){0};
+
+  size_t n = filtered->count;
+  uint64_t *ids = (uint64_t*)malloc((n ? n : 1) * sizeof(uint64_t));
+  uint64_t *tmp = (uint64_t*)malloc((n ? n : 1) * sizeof(uint64_t));
+  if (!ids || !tmp) goto fail;
+
+  /* Collection stage: token → id, appended in input order. */
+  size_t m = 0;
+  uint32_t chunk_ids[ID_SORT_CHUNK];
+  for (size_t base = 0; base < n; base += ID_SORT_CHUNK) {
+    if (cancel_poll(base)) goto fail;
+    size_t c = n - base < ID_SORT_CHUNK ? n - base : ID_SORT_CHUNK;
+    const char *const *chunk = (const char *const *)&filtered->items[base];
+    if (!dict_get_or_add_batch(dict, chunk, c, chunk_ids)) goto fail;
+
+    for (size_t j = 0; j < c; j++) {
+      if (!chunk[j] || !*chunk[j]) continue;
+      if (chunk_ids[j] == 0) goto fail;
+      ids[m++] = chunk_ids[j];
+    }
+  }
+
+  if (!radix_sort_u64(ids, tmp, m, bit_width(dict_size(dict)))) goto fail;
+
+  /* Run-length encoding: one WordCount per distinct id (ascending). */
+  size_t runs = count_runs(ids, m);
+  if (runs > 0) {
+    out_words->items = (WordCount*)calloc(runs, sizeof(WordCount));
+    if (!out_words->items) goto fail;
+  }
+  for (size_t i = 0; i < m; ) {
+    size_t j = i + 1;
+    while (j < m && ids[j] == ids[i]) j++;
+
+    WordCount *wc = &out_words->items[out_words->count];
+    wc->word = str_dup(dict_word(dict, (uint32_t)ids[i]));
+    if (!wc->word) goto fail;
+    wc->count = j - i;
+    out_words->count++;
+    i = j;
+  }
+
+  free(ids);
+  free(tmp);
+  return 1;
+
+fail:
+  free(ids);
+  free(tmp);
+  free_word_counts(out_words);
+  return 0;
+}
+
+void idbigram_csr_free(IdBigramCSR *g) {
+  if (!g) return;
+  free(g->row);
+  free(g->next);
+  free(g->counts);
+  memset(g, 0, sizeof(*g));
+}
+
+int sort_build_bigram_csr(const TokenList *raw, const StopwordList *sw,
+                          Dict *dict, IdBigramCSR *out) {
+  if (!raw || !sw || !dict || !out) return 0;
+  memset(out, 0, sizeof(*out));
+
+  /* Collection stage: adjacent valid ids, stored as (id1, id2) pairs.
+   * Pairs are packed once the final id width is known.
+   */
+  size_t n = raw->count;
+  uint32_t *pairs = (uint32_t*)malloc((n ? n : 1) * 2 * sizeof(uint32_t));
+  if (!pairs) return 0;
+
+  const char *chunk[ID_SORT_CHUNK];
+  uint32_t ids[ID_SORT_CHUNK];
+  size_t np = 0;
+  uint32_t prev = 0;
+  for (size_t base = 0; base < n; base += ID_SORT_CHUNK) {
+    if (cancel_poll(base)) { free(pairs); return 0; }
+    size_t c = n - base < ID_SORT_CHUNK ? n - base : ID_SORT_CHUNK;
+    for (size_t j = 0; j < c; j++) {
+      const char *t = raw->items[base + j];
+      chunk[j] = bigram_token_ignored(t, sw) ? NULL : t;
+    }
+    if (!dict_get_or_add_batch(dict, chunk, c, ids)) { free(pairs); return 0; }
+
+    for (size_t j = 0; j < c; j++) {
+      /* No bridging across dropped tokens (keeps bigrams local to valid runs). */
+      if (!chunk[j]) { prev = 0; continue; }
+      if (ids[j] == 0) { free(pairs); return 0; }
+      if (prev != 0) {
+        pairs[2 * np] = prev;
+        pairs[2 * np + 1] = ids[j];
+        np++;
+      }
+      prev = ids[j];
+    }
+  }
+
+  /* Pack (id1, id2) into bits-wide halves so radix passes stay minimal. */
+  unsigned bits = bit_width(dict_size(dict));
+  uint64_t *keys = (uint64_t*)malloc((np ? np : 1) * sizeof(uint64_t));
+  uint64_t *tmp = (uint64_t*)malloc((np ? np : 1) * sizeof(uint64_t));
+  if (!keys || !tmp) goto fail;
+
+  for (size_t i = 0; i < np; i++) {
+    keys[i] = ((uint64_t)pairs[2 * i] << bits) | pairs[2 * i + 1];
+  }
+  free(pairs);
+  pairs = NULL;
+
+  int sorted = radix_sort_u64(keys, tmp, np, 2 * bits);
+  free(tmp);
+  tmp = NULL;
+  if (!sorted) goto fail;
+
+  /* Run-length encode into CSR: rows are first-word ids (sorted major). */
+  uint64_t lo_mask = (bits == 0) ? 0 : ((uint64_t)1 << bits) - 1;
+  out->n_rows = np ? (size_t)(keys[np - 1] >> bits) : 0;
+  out->n_edges = count_runs(keys, np);
+  out->row = (uint32_t*)calloc(out->n_rows + 1, sizeof(uint32_t));
+  out->next = (uint32_t*)malloc((out->n_edges ? out->n_edges : 1) * sizeof(uint32_t));
+  out->counts = (uint32_t*)malloc((out->n_edges ? out->n_edges : 1) * sizeof(uint32_t));
+  if (!out->row || !out->next || !out->counts) goto fail;
+
+  size_t e = 0;
+  for (size_t i = 0; i < np; ) {
+    size_t j = i + 1;
+    while (j < np && keys[j] == keys[i]) j++;
+
+    uint32_t id1 = (uint32_t)(keys[i] >> bits);
+    out->next[e] = (uint32_t)(keys[i] & lo_mask);
+    out->counts[e] = (uint32_t)(j - i);
+    out->row[id1]++;  // degree of id1, turned into offsets below
+    e++;
+    i = j;
+  }
+  for (size_t r = 1; r <= out->n_rows; r++) out->row[r] += out->row[r - 1];
+
+  free(keys);
+  return 1;
+
+fail:
+  free(pairs);
+  free(keys);
+  free(tmp);
+  idbigram_csr_free(out);
+  return 0;
+}
+
+int sort_count_bigrams_excluding_stopwords(const TokenList *raw,
+                                           const StopwordList *sw,
+                                           Dict *dict,
+                                           BigramCountList *out_bigrams) {
+  if (!out_bigrams) return 0;
+  *out_bigrams = (BigramCountList){0};
+
+  IdBigramCSR g;
+  if (!sort_build_bigram_csr(raw, sw, dict, &g)) return 0;
+
+  /* Materialize CSR rows into the string-based result list. */
+  if (g.n_edges > 0) {
+    out_bigrams->items = (BigramCount*)calloc(g.n_edges, sizeof(BigramCount));
+    if (!out_bigrams->items) goto fail;
+  }
+  for (size_t r = 1; r <= g.n_rows; r++) {
+    const char *w1 = dict_word(dict, (uint32_t)r);
+    for (uint32_t e = g.row[r - 1]; e < g.row[r]; e++) {
+      const char *w2 = dict_word(dict, g.next[e]);
+      if (!w1 || !w2) continue;
+
+      BigramCount *bc = &out_bigrams->items[out_bigrams->count];
+      bc->w1 = str_dup(w1);
+      bc->w2 = str_dup(w2);
+      out_bigrams->count++;
+      if (!bc->w1 || !bc->w2) goto fail;
+      bc->count = g.counts[e];
+    }
+  }
+
+  idbigram_csr_free(&g);
+  return 1;
+
+fail:
+  idbigram_csr_free(&g);
+  free_bigram_counts(out_bigrams);
+  return 0;
+}
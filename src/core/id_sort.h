@@ -0,0 +1,61 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/dict.h"
+#include "core/tokenizer.h"
+#include "core/stopwords.h"
+#include "core/freq.h"
+#include "core/bigrams.h"
+
+/*
+ * Sort-based counting (alternative to the IdFreq / IdBigrams hash tables).
+ *
+ * Word IDs and packed bigram keys are collected into flat arrays,
+ * LSD-radix-sorted and run-length encoded into counts. All passes are
+ * sequential over memory, which pays off for very large pages where the
+ * hash tables no longer fit into cache.
+ */
+
+/*
+ * LSD radix sort (8-bit digits) of n keys; only the low key_bits bits are
+ * significant. tmp must hold n elements; the result ends up in keys.
+ * Digits that are equal for all keys are skipped. Returns 0 when the
+ * bound deadline passed (core/cancel.h): keys are then a permutation of
+ * the input, not sorted.
+ */
+int radix_sort_u64(uint64_t *keys, uint64_t *tmp, size_t n, unsigned key_bits);
+
+/*
+ * Counted bigrams in CSR (compressed sparse row) layout:
+ * followers of first word id w are next[row[w-1] .. row[w]),
+ * ascending by ID, with counts[] parallel to next[].
+ */
+typedef struct {
+  uint32_t *row;     // n_rows + 1 offsets
+  uint32_t *next;    // follower word IDs
+  uint32_t *counts;  // pair counts
+  size_t n_rows;     // highest first-word ID
+  size_t n_edges;    // distinct bigrams
+} IdBigramCSR;
+
+/* Word counting: filtered tokens → IDs → sort → runs. This and the
+ * bigram stages fail once the bound deadline passes (core/cancel.h).
+ */
+int sort_count_words(const TokenList *filtered, Dict *dict, WordCountList *out_words);
+
+/*
+ * Bigram counting into CSR form. Same adjacency rules as the hash engine
+ * (raw tokens, no bridging over stopwords/short/digits-only tokens).
+ */
+int sort_build_bigram_csr(const TokenList *raw, const StopwordList *sw,
+                          Dict *dict, IdBigramCSR *out);
+
+/* Release CSR arrays. */
+void idbigram_csr_free(IdBigramCSR *g);
+
+/* Bigram counting stage producing the string-based result list. */
+int sort_count_bigrams_excluding_stopwords(const TokenList *raw,
+                                           const StopwordList *sw,
+                                           Dict *dict,
+                                           BigramCountList *out_bigrams);
@@ -0,0 +1,49 @@
+#include "core/id_stream.h"
+#include "core/bigrams.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Tokens per batched dict lookup round (as in id_bigrams.c). */
+#define ID_STREAM_CHUNK 64
+
+int id_stream_resolve(IdStream *s, Dict *dict, const TokenList *raw, const StopwordList *sw) {
+  if (!s || !dict || !raw) return 0;
+  s->count = 0;
+
+  if (raw->count > s->cap) {
+    uint32_t *n = (uint32_t*)realloc(s->ids, raw->count * sizeof(uint32_t));
+    if (!n) return 0;
+    s->ids = n;
+    s->cap = raw->count;
+  }
+
+  const char *chunk[ID_STREAM_CHUNK];
+  for (size_t base = 0; base < raw->count; base += ID_STREAM_CHUNK) {
+    size_t m = raw->count - base;
+    if (m > ID_STREAM_CHUNK) m = ID_STREAM_CHUNK;
+
+    for (size_t j = 0; j < m; j++) {
+      const char *t = raw->items[base + j];
+      chunk[j] = bigram_token_ignored(t, sw) ? NULL : t;
+    }
+    if (!dict_get_or_add_batch(dict, chunk, m, s->ids + base)) return 0;
+
+    for (size_t j = 0; j < m; j++) {
+      const char *t = raw->items[base + j];
+      if (!chunk[j]) {
+        s->ids[base + j] = (!t || !*t) ? ID_STREAM_BREAK : 0;
+      } else if (s->ids[base + j] == 0) {
+        return 0;
+      }
+    }
+  }
+  s->count = raw->count;
+  return 1;
+}
+
+void id_stream_free(IdStream *s) {
+  if (!s) return;
+  free(s->ids);
+  memset(s, 0, sizeof(*s));
+}
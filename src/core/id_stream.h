@@ -0,0 +1,31 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/tokenizer.h"
+#include "core/stopwords.h"
+#include "core/dict.h"
+
+/*
+ * Page token stream resolved to Dict IDs once, for counters that work on
+ * token positions (n-grams, co-occurrence windows).
+ *
+ * Positions keep the raw token order:
+ * - id >= 1: valid token
+ * - 0: ignored token (short, digits-only, stopword; same rules as bigrams)
+ * - ID_STREAM_BREAK: empty token, i.e. a sampling seam between
+ *   non-adjacent text spans (core/sampling.h); no window crosses it
+ */
+#define ID_STREAM_BREAK UINT32_MAX
+
+typedef struct {
+  uint32_t *ids;
+  size_t count;
+  size_t cap;   // buffer is reused across pages
+} IdStream;
+
+/* Resolve one page (replaces the previous content). 0 on OOM. */
+int id_stream_resolve(IdStream *s, Dict *dict, const TokenList *raw, const StopwordList *sw);
+
+/* Release the buffer. */
+void id_stream_free(IdStream *s);
@@ -0,0 +1,173 @@
+#include "core/sampling.h"
+#include "core/arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static uint64_t mix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+static int keep_window(const SampleSpec *spec, size_t page, size_t window) {
+  uint64_t h = mix64(spec->seed ^ mix64((uint64_t)page) ^ mix64(~(uint64_t)window));
+  /* Top 53 bits as a uniform double in [0, 1). */
+  return (double)(h >> 11) * (1.0 / 9007199254740992.0) < spec->rate;
+}
+
+static int is_space(unsigned char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+/* First window start at or after pos: just past the next whitespace byte,
+ * at most one window ahead (then cut on a UTF-8 lead byte instead).
+ */
+static size_t snap_boundary(const char *text, size_t len, size_t pos, size_t window) {
+  if (pos >= len) return len;
+  size_t limit = (len - pos > window) ? pos + window : len;
+  for (size_t i = pos; i < limit; i++) {
+    if (is_space((unsigned char)text[i])) return i + 1;
+  }
+  size_t i = pos;
+  while (i < len && ((unsigned char)text[i] & 0xC0) == 0x80) i++;
+  return i;
+}
+
+static size_t utf8_count(const char *s, size_t n) {
+  size_t c = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (((unsigned char)s[i] & 0xC0) != 0x80) c++;
+  }
+  return c;
+}
+
+/* Append span tokens (and a separator before them if out is non-empty). */
+static int append_span(TokenList *out, size_t *cap, const char *text, size_t from, size_t to,
+                       size_t max_token_bytes, char **buf, size_t *buf_cap) {
+  size_t n = to - from;
+  if (n + 1 > *buf_cap) {
+    char *nb = (char*)realloc(*buf, n + 1);
+    if (!nb) return 0;
+    *buf = nb;
+    *buf_cap = n + 1;
+  }
+  memcpy(*buf, text + from, n);
+  (*buf)[n] = '\0';
+
+  TokenList span = tokenize_with_limit(*buf, NULL, max_token_bytes);
+  size_t need = out->count + span.count + 1;
+  if (need > *cap) {
+    size_t nc = *cap ? *cap : 256;
+    while (nc < need) nc *= 2;
+    char **ni = (char**)realloc(out->items, nc * sizeof(char*));
+    if (!ni) {
+      free_tokens(&span);
+      return 0;
+    }
+    out->items = ni;
+    *cap = nc;
+  }
+
+  if (out->count > 0 && span.count > 0) {
+    char *sep = str_alloc(1);
+    if (!sep) {
+      free_tokens(&span);
+      return 0;
+    }
+    sep[0] = '\0';
+    out->items[out->count++] = sep;
+  }
+  if (span.count > 0) {
+    memcpy(out->items + out->count, span.items, span.count * sizeof(char*));
+    out->count += span.count;
+  }
+  free(span.items);  // token strings moved into out
+  return 1;
+}
+
+double sample_rate_for_budget(double est_ms, double budget_ms) {
+  if (est_ms <= 0.0 || est_ms <= budget_ms * SAMPLE_DEADLINE_SHARE) return 1.0;
+  double r = (budget_ms > 0.0) ? budget_ms * SAMPLE_DEADLINE_SHARE / est_ms : 0.0;
+  return (r < SAMPLE_RATE_MIN) ? SAMPLE_RATE_MIN : r;
+}
+
+size_t sample_scale_count(size_t sampled, double fraction) {
+  if (fraction <= 0.0 || fraction >= 1.0) return sampled;
+  return (size_t)llround((double)sampled / fraction);
+}
+
+void sample_interval(size_t sampled, double fraction, size_t *low, size_t *high) {
+  if (fraction <= 0.0 || fraction >= 1.0) {
+    *low = *high = sampled;
+    return;
+  }
+  double est = (double)sampled / fraction;
+  double hw = SAMPLE_Z * sqrt((double)sampled * (1.0 - fraction)) / fraction;
+  double lo = est - hw;
+  *low = (lo > (double)sampled) ? (size_t)floor(lo) : sampled;
+  *high = (size_t)ceil(est + hw);
+}
+
+TokenList sample_tokenize(const char *text, size_t page, const SampleSpec *spec,
+                          size_t max_token_bytes, SampleStats *st) {
+  const char *t = text ? text : "";
+  size_t len = strlen(t);
+  if (st) memset(st, 0, sizeof(*st));
+
+  if (!spec || spec->rate >= 1.0) {
+    if (st) {
+      st->bytes_total = st->bytes_kept = len;
+      st->chars_kept = utf8_count(t, len);
+      st->windows_total = st->windows_kept = 1;
+    }
+    return tokenize_with_limit(t, NULL, max_token_bytes);
+  }
+
+  TokenList out = (TokenList){0};
+  if (len == 0) return out;
+
+  size_t window = spec->window_bytes ? spec->window_bytes : SAMPLE_WINDOW_BYTES;
+  size_t cap = 0;
+  char *buf = NULL;
+  size_t buf_cap = 0;
+
+  size_t span_from = 0, span_to = 0;  // pending run of adjacent kept windows
+  int have_span = 0;
+  for (size_t start = 0, w = 0; start < len; w++) {
+    size_t end = snap_boundary(t, len, (len - start > window) ? start + window : len, window);
+
+    int keep = keep_window(spec, page, w);
+    if (st) {
+      st->bytes_total += end - start;
+      st->windows_total++;
+    }
+    if (keep) {
+      if (st) {
+        st->bytes_kept += end - start;
+        st->chars_kept += utf8_count(t + start, end - start);
+        st->windows_kept++;
+      }
+      if (!have_span) span_from = start;
+      span_to = end;
+      have_span = 1;
+    } else if (have_span) {
+      if (!append_span(&out, &cap, t, span_from, span_to, max_token_bytes, &buf, &buf_cap)) goto oom;
+      have_span = 0;
+    }
+    start = end;
+  }
+  if (have_span && !append_span(&out, &cap, t, span_from, span_to, max_token_bytes, &buf, &buf_cap)) {
+    goto oom;
+  }
+
+  free(buf);
+  return out;
+
+oom:
+  free(buf);
+  free_tokens(&out);
+  return (TokenList){0};
+}
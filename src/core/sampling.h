@@ -0,0 +1,73 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/tokenizer.h"
+
+/*
+ * Deterministic text sampling ahead of the tokenizer.
+ *
+ * Each page is cut into windows of SAMPLE_WINDOW_BYTES (snapped forward to
+ * the next ASCII whitespace, so tokens are not split). A window is kept
+ * when a hash of (seed, page, window) falls below the rate; skipped
+ * windows are never scanned. Pages shorter than one window are sampled as
+ * a whole, so many small pages degrade to page sampling.
+ *
+ * Non-adjacent kept spans are joined with an empty token: every filter
+ * and bigram stage drops it, so no bigram bridges a skipped window.
+ */
+#ifndef SAMPLE_WINDOW_BYTES
+#define SAMPLE_WINDOW_BYTES ((size_t)16 * 1024)
+#endif
+
+#ifndef SAMPLE_DEFAULT_SEED
+#define SAMPLE_DEFAULT_SEED 0x5eed5eedULL
+#endif
+
+/* AUTO trigger: analysis cost per input byte (tokenize + filter + count)
+ * and the share of the remaining deadline the estimate may use.
+ */
+#ifndef SAMPLE_COST_NS_PER_BYTE
+#define SAMPLE_COST_NS_PER_BYTE 750.0
+#endif
+#define SAMPLE_DEADLINE_SHARE 0.8
+#define SAMPLE_RATE_MIN 0.01
+
+typedef struct {
+  double rate;          // (0, 1): fraction of windows kept; >= 1: keep all
+  uint64_t seed;
+  size_t window_bytes;  // 0 = SAMPLE_WINDOW_BYTES
+} SampleSpec;
+
+/* Per-page (or accumulated) sampling counters. */
+typedef struct {
+  size_t bytes_total;
+  size_t bytes_kept;
+  size_t chars_kept;      // UTF-8 code points in kept spans
+  size_t windows_total;
+  size_t windows_kept;
+} SampleStats;
+
+/* Two-sided 95% interval (normal approximation). */
+#define SAMPLE_CONFIDENCE 0.95
+#define SAMPLE_Z 1.96
+
+/* Rate that fits est_ms into budget_ms (1.0 when it already fits). */
+double sample_rate_for_budget(double est_ms, double budget_ms);
+
+/*
+ * Tokenize the kept windows of text (page index feeds the hash).
+ * st (optional) is filled for this page. Returns an empty list on OOM.
+ */
+TokenList sample_tokenize(const char *text, size_t page, const SampleSpec *spec,
+                          size_t max_token_bytes, SampleStats *st);
+
+/* Scale a sampled count by 1/fraction (rounded). */
+size_t sample_scale_count(size_t sampled, double fraction);
+
+/*
+ * SAMPLE_CONFIDENCE interval for the full-text count of a key seen
+ * `sampled` times in the kept fraction (Poisson approximation on the
+ * sample; the lower end never drops below the sampled count).
+ */
+void sample_interval(size_t sampled, double fraction, size_t *low, size_t *high);
@@ -0,0 +1,193 @@
+#include "core/small_count.h"
+#include "core/arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Load factor <= 1/2 for a page at the token limit. */
+#define SMALL_SLOTS (2 * SMALL_PAGE_MAX_TOKENS)
+#define SMALL_MIN_SLOTS 64
+#define NO_WORD UINT32_MAX
+
+typedef struct {
+  const char *tok;   // first occurrence in raw
+  uint32_t hash;
+  uint32_t count;    // occurrences (kept words only)
+  bool drop;         // filter decision, made once per distinct token
+} SmallWord;
+
+struct SmallCountTables {
+  SmallWord words[SMALL_PAGE_MAX_TOKENS];
+  uint16_t word_slot[SMALL_SLOTS];      // word index + 1, 0 = empty
+  uint32_t pair_key[SMALL_SLOTS];       // packed (w1, w2) + 1, 0 = empty
+  uint16_t pair_slot[SMALL_SLOTS];      // pair index
+  uint32_t pairs[SMALL_PAGE_MAX_TOKENS];  // packed keys, first-occurrence order
+  uint32_t pair_count[SMALL_PAGE_MAX_TOKENS];
+};
+
+/* Uninitialized: every call clears the part it uses. */
+SmallCountTables *small_count_tables_new(void) {
+  return (SmallCountTables*)malloc(sizeof(SmallCountTables));
+}
+
+void small_count_tables_free(SmallCountTables *t) {
+  free(t);
+}
+
+/* Unseeded FNV-1a: the table is bounded, so a crafted page cannot cost
+ * more than the linear lookups it replaces.
+ */
+static uint32_t fnv1a32(const char *s) {
+  uint32_t h = 2166136261u;
+  for (; *s; s++) {
+    h ^= (unsigned char)*s;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static uint32_t mix32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x45d9f3bu;
+  x ^= x >> 16;
+  return x;
+}
+
+static int cmp_word(const void *a, const void *b) {
+  return strcmp(((const WordCount*)a)->word, ((const WordCount*)b)->word);
+}
+
+static int cmp_bigram(const void *a, const void *b) {
+  const BigramCount *x = (const BigramCount*)a;
+  const BigramCount *y = (const BigramCount*)b;
+  int c = strcmp(x->w1, y->w1);
+  return c ? c : strcmp(x->w2, y->w2);
+}
+
+static int small_count(const TokenList *raw,
+                       const StopwordList *sw,
+                       bool lexsorted,
+                       SmallCountTables *t,
+                       WordCountList *out_words,
+                       BigramCountList *out_bigrams) {
+  SmallWord *words = t->words;
+  uint16_t *word_slot = t->word_slot;
+  uint32_t *pair_key = t->pair_key;
+  uint16_t *pair_slot = t->pair_slot;
+  uint32_t *pairs = t->pairs;
+  uint32_t *pair_count = t->pair_count;
+
+  /* Only the prefix sized to this page is used (and cleared). */
+  size_t slots = SMALL_MIN_SLOTS;
+  while (slots < 2 * raw->count) slots *= 2;
+  size_t mask = slots - 1;
+  memset(word_slot, 0, slots * sizeof(word_slot[0]));
+  if (out_bigrams) memset(pair_key, 0, slots * sizeof(pair_key[0]));
+
+  size_t n_words = 0, n_kept = 0, n_pairs = 0;
+  uint32_t prev = NO_WORD;
+  for (size_t i = 0; i < raw->count; i++) {
+    const char *tok = raw->items[i];
+    if (!tok || !*tok) {
+      prev = NO_WORD;
+      continue;
+    }
+
+    uint32_t h = fnv1a32(tok);
+    size_t pos = h & mask;
+    uint32_t w = NO_WORD;
+    while (word_slot[pos]) {
+      const SmallWord *e = &words[word_slot[pos] - 1];
+      if (e->hash == h && strcmp(e->tok, tok) == 0) {
+        w = word_slot[pos] - 1u;
+        break;
+      }
+      pos = (pos + 1) & mask;
+    }
+    if (w == NO_WORD) {
+      w = (uint32_t)n_words++;
+      /* Same rules as the filter stage (length, digits, stopwords). */
+      words[w] = (SmallWord){ tok, h, 0, bigram_token_ignored(tok, sw) != 0 };
+      word_slot[pos] = (uint16_t)(w + 1);
+      if (!words[w].drop) n_kept++;
+    }
+
+    /* Dropped tokens are not counted and break adjacency (no bridging). */
+    if (words[w].drop) {
+      prev = NO_WORD;
+      continue;
+    }
+    words[w].count++;
+
+    if (out_bigrams && prev != NO_WORD) {
+      uint32_t key = ((prev << 16) | w) + 1u;
+      size_t p = mix32(key) & mask;
+      while (pair_key[p] && pair_key[p] != key) p = (p + 1) & mask;
+      if (pair_key[p]) {
+        pair_count[pair_slot[p]]++;
+      } else {
+        pair_key[p] = key;
+        pair_slot[p] = (uint16_t)n_pairs;
+        pairs[n_pairs] = key - 1u;
+        pair_count[n_pairs] = 1;
+        n_pairs++;
+      }
+    }
+    prev = w;
+  }
+
+  if (n_kept > 0) {
+    out_words->items = (WordCount*)calloc(n_kept, sizeof(WordCount));
+    if (!out_words->items) return 0;
+    for (size_t w = 0; w < n_words; w++) {
+      if (words[w].drop) continue;
+      WordCount *wc = &out_words->items[out_words->count];
+      wc->word = str_dup(words[w].tok);
+      if (!wc->word) goto fail;
+      wc->count = words[w].count;
+      out_words->count++;
+    }
+    if (lexsorted && n_kept > 1) qsort(out_words->items, n_kept, sizeof(WordCount), cmp_word);
+  }
+
+  if (out_bigrams && n_pairs > 0) {
+    out_bigrams->items = (BigramCount*)calloc(n_pairs, sizeof(BigramCount));
+    if (!out_bigrams->items) goto fail;
+    for (size_t p = 0; p < n_pairs; p++) {
+      BigramCount *bc = &out_bigrams->items[p];
+      bc->w1 = str_dup(words[pairs[p] >> 16].tok);
+      bc->w2 = str_dup(words[pairs[p] & 0xFFFFu].tok);
+      bc->count = pair_count[p];
+      out_bigrams->count = p + 1;
+      if (!bc->w1 || !bc->w2) goto fail;
+    }
+    if (lexsorted && n_pairs > 1) qsort(out_bigrams->items, n_pairs, sizeof(BigramCount), cmp_bigram);
+  }
+  return 1;
+
+fail:
+  free_word_counts(out_words);
+  if (out_bigrams) free_bigram_counts(out_bigrams);
+  return 0;
+}
+
+int small_count_page(const TokenList *raw,
+                     const StopwordList *sw,
+                     bool lexsorted,
+                     SmallCountTables *t,
+                     WordCountList *out_words,
+                     BigramCountList *out_bigrams) {
+  if (!raw || !out_words) return 0;
+  *out_words = (WordCountList){0};
+  if (out_bigrams) *out_bigrams = (BigramCountList){0};
+  if (raw->count > SMALL_PAGE_MAX_TOKENS) return 0;
+  if (raw->count == 0 || !raw->items) return 1;
+
+  if (t) return small_count(raw, sw, lexsorted, t, out_words, out_bigrams);
+  SmallCountTables *own = small_count_tables_new();
+  if (!own) return 0;
+  int ok = small_count(raw, sw, lexsorted, own, out_words, out_bigrams);
+  small_count_tables_free(own);
+  return ok;
+}
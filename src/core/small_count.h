@@ -0,0 +1,49 @@
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "core/tokenizer.h"
+#include "core/stopwords.h"
+#include "core/freq.h"
+#include "core/bigrams.h"
+
+/*
+ * Small-page fast path.
+ *
+ * Most API pages have a few hundred tokens, yet the regular path filters
+ * them into a copy, checks every token against the stopword list twice
+ * (filter, bigrams) and looks words up linearly. Up to
+ * SMALL_PAGE_MAX_TOKENS raw tokens, filtering and counting run in one
+ * pass instead: distinct tokens go into a fixed-size open-addressing
+ * table (SmallCountTables), sized to the page, and the filter rules are
+ * applied once per distinct token. Words and bigrams are counted by
+ * table index; only the output lists and their strings are allocated.
+ *
+ * Output equals count_words(filtered) and
+ * count_bigrams_excluding_stopwords(raw): same entries and counts, in
+ * first-occurrence order, or sorted by key when `lexsorted`.
+ */
+#define SMALL_PAGE_MAX_TOKENS 2048
+
+/*
+ * Tables of one call (about 96 KB, too much for a thread's stack). The
+ * caller keeps them for reuse, one per thread (app/scratch.h); only the
+ * prefix a page needs is cleared per call.
+ */
+typedef struct SmallCountTables SmallCountTables;
+
+SmallCountTables *small_count_tables_new(void);
+void small_count_tables_free(SmallCountTables *t);
+
+/*
+ * Count words (filter rules applied) and bigrams (no bridging) of raw.
+ * out_bigrams may be NULL; t == NULL allocates tables for this call.
+ * Returns 0 when raw has more than SMALL_PAGE_MAX_TOKENS tokens or on
+ * OOM; nothing is left allocated then.
+ */
+int small_count_page(const TokenList *raw,
+                     const StopwordList *sw,
+                     bool lexsorted,
+                     SmallCountTables *t,
+                     WordCountList *out_words,
+                     BigramCountList *out_bigrams);
@@ -0,0 +1,295 @@
+#include "core/stem_de.h"
+#include "core/arena.h"
+#include "core/id_bigrams.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Working buffer bound: longer tokens are returned unchanged. */
+#define STEM_MAX_BYTES 256
+
+/* UTF-8 code points in s[0..n). */
+static size_t char_len(const char *s, size_t n) {
+  size_t c = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (((unsigned char)s[i] & 0xC0) != 0x80) c++;
+  }
+  return c;
+}
+
+/* Replace every occurrence of pat (left to right) by rep, in place. */
+static size_t replace_all(char *s, size_t n, const char *pat, const char *rep) {
+  size_t pl = strlen(pat), rl = strlen(rep);  // rl <= pl
+  size_t w = 0;
+  for (size_t i = 0; i < n;) {
+    if (i + pl <= n && memcmp(s + i, pat, pl) == 0) {
+      memcpy(s + w, rep, rl);
+      w += rl;
+      i += pl;
+    } else {
+      s[w++] = s[i++];
+    }
+  }
+  return w;
+}
+
+static int ends_with(const char *s, size_t n, const char *suf) {
+  size_t l = strlen(suf);
+  return n >= l && memcmp(s + n - l, suf, l) == 0;
+}
+
+size_t stem_de(const char *word, char *out, size_t out_cap) {
+  if (!word || !out || out_cap == 0) return 0;
+  size_t wl = strlen(word);
+
+  /* Umlaut folding may grow the word (ß -> ss). */
+  char buf[2 * STEM_MAX_BYTES];
+  size_t n = 0;
+  if (wl > STEM_MAX_BYTES) {
+    if (wl + 1 > out_cap) return 0;
+    memcpy(out, word, wl + 1);
+    return wl;
+  }
+  for (size_t i = 0; i < wl; i++) {
+    unsigned char c = (unsigned char)word[i];
+    if (c == 0xC3 && i + 1 < wl) {
+      unsigned char d = (unsigned char)word[i + 1];
+      char r = 0;
+      if (d == 0xA4 || d == 0x84) r = 'a';
+      else if (d == 0xB6 || d == 0x96) r = 'o';
+      else if (d == 0xBC || d == 0x9C) r = 'u';
+      if (r) { buf[n++] = r; i++; continue; }
+      if (d == 0x9F) { buf[n++] = 's'; buf[n++] = 's'; i++; continue; }
+    }
+    buf[n++] = (char)c;
+  }
+
+  /* ge-prefix of words with at least four more characters. */
+  if (n >= 2 && buf[0] == 'g' && buf[1] == 'e' && char_len(buf + 2, n - 2) >= 4) {
+    memmove(buf, buf + 2, n - 2);
+    n -= 2;
+  }
+
+  /* Digraphs count as one character while stripping. */
+  n = replace_all(buf, n, "sch", "$");
+  n = replace_all(buf, n, "ei", "%");
+  n = replace_all(buf, n, "ie", "&");
+
+  /* Doubled letters: second one becomes '*'. */
+  for (size_t i = 0; i + 1 < n; i++) {
+    if (buf[i] == buf[i + 1] && buf[i] != '*') {
+      buf[i + 1] = '*';
+      i++;
+    }
+  }
+
+  size_t chars = char_len(buf, n);
+  while (chars > 3) {
+    if (chars > 5 && (ends_with(buf, n, "em") || ends_with(buf, n, "er") || ends_with(buf, n, "nd"))) {
+      n -= 2;
+      chars -= 2;
+    } else if (ends_with(buf, n, "t") || ends_with(buf, n, "e") ||
+               ends_with(buf, n, "s") || ends_with(buf, n, "n")) {
+      n -= 1;
+      chars -= 1;
+    } else {
+      break;
+    }
+  }
+
+  /* Undo the placeholders. */
+  size_t w = 0;
+  for (size_t i = 1; i < n; i++) {
+    if (buf[i] == '*') buf[i] = buf[i - 1];
+  }
+  for (size_t i = 0; i < n; i++) {
+    char one[2] = { buf[i], 0 };
+    const char *rep = one;
+    if (buf[i] == '$') rep = "sch";
+    else if (buf[i] == '%') rep = "ei";
+    else if (buf[i] == '&') rep = "ie";
+    size_t rl = strlen(rep);
+    if (w + rl + 1 > out_cap) return 0;
+    memcpy(out + w, rep, rl);
+    w += rl;
+  }
+  out[w] = '\0';
+  return w;
+}
+
+/* ---------- Memo ---------- */
+
+int stem_memo_init(StemMemo *m) {
+  if (!m) return 0;
+  memset(m, 0, sizeof(*m));
+  if (!dict_init(&m->words, 1024)) return 0;
+  if (!dict_init(&m->stems, 1024)) {
+    dict_free(&m->words);
+    return 0;
+  }
+  return 1;
+}
+
+void stem_memo_free(StemMemo *m) {
+  if (!m) return;
+  dict_free(&m->words);
+  dict_free(&m->stems);
+  free(m->stem_of);
+  free(m->slot_of);
+  memset(m, 0, sizeof(*m));
+}
+
+/* Grow an ID-indexed uint32 table to hold index id (zeroed tail). */
+static int ensure_u32(uint32_t **t, size_t *cap, uint32_t id) {
+  if ((size_t)id < *cap) return 1;
+  size_t nc = *cap ? *cap : 1024;
+  while (nc <= (size_t)id) nc *= 2;
+  uint32_t *nt = (uint32_t*)realloc(*t, nc * sizeof(uint32_t));
+  if (!nt) return 0;
+  memset(nt + *cap, 0, (nc - *cap) * sizeof(uint32_t));
+  *t = nt;
+  *cap = nc;
+  return 1;
+}
+
+uint32_t stem_memo_word(StemMemo *m, const char *word) {
+  if (!m || !word) return 0;
+  uint32_t wid = dict_get_or_add(&m->words, word);
+  if (wid == 0 || !ensure_u32(&m->stem_of, &m->cap, wid)) return 0;
+  if (m->stem_of[wid] != 0) return m->stem_of[wid];
+
+  char buf[STEM_MAX_BYTES + 1];
+  const char *stem = (stem_de(word, buf, sizeof(buf)) > 0) ? buf : word;
+  uint32_t sid = dict_get_or_add(&m->stems, stem);
+  if (sid == 0) return 0;
+  m->stem_of[wid] = sid;
+  m->stemmed++;
+  return sid;
+}
+
+uint32_t *stem_memo_map_dict(StemMemo *m, const Dict *d) {
+  if (!m || !d) return NULL;
+  size_t v = dict_size(d);
+  uint32_t *map = (uint32_t*)malloc((v + 1) * sizeof(uint32_t));
+  if (!map) return NULL;
+  map[0] = 0;
+  for (size_t id = 1; id <= v; id++) {
+    map[id] = stem_memo_word(m, dict_word(d, (uint32_t)id));
+    if (map[id] == 0) {
+      free(map);
+      return NULL;
+    }
+  }
+  return map;
+}
+
+/* ---------- Folding string lists ---------- */
+
+static int cmp_word(const void *a, const void *b) {
+  return strcmp(((const WordCount*)a)->word, ((const WordCount*)b)->word);
+}
+
+static int cmp_bigram(const void *a, const void *b) {
+  const BigramCount *x = (const BigramCount*)a;
+  const BigramCount *y = (const BigramCount*)b;
+  int c = strcmp(x->w1, y->w1);
+  return c ? c : strcmp(x->w2, y->w2);
+}
+
+int stem_fold_words(StemMemo *m, WordCountList *list, bool sorted) {
+  if (!m || !list) return 0;
+  if (list->count == 0) return 1;
+
+  /* Stem IDs first, so a failure leaves the list untouched. */
+  uint32_t *sids = (uint32_t*)malloc(list->count * sizeof(uint32_t));
+  if (!sids) return 0;
+  for (size_t i = 0; i < list->count; i++) {
+    sids[i] = stem_memo_word(m, list->items[i].word);
+    if (sids[i] == 0 || !ensure_u32(&m->slot_of, &m->slot_cap, sids[i])) {
+      free(sids);
+      return 0;
+    }
+  }
+
+  /* slot_of[stem] = output position + 1; the write index never passes
+   * the read index, so the list is compacted in one pass.
+   */
+  size_t w = 0;
+  int ok = 1;
+  for (size_t i = 0; i < list->count; i++) {
+    WordCount wc = list->items[i];
+    uint32_t sid = sids[i];
+    if (m->slot_of[sid] != 0) {
+      list->items[m->slot_of[sid] - 1].count += wc.count;
+      str_free(wc.word);
+      continue;
+    }
+    const char *stem = dict_word(&m->stems, sid);
+    if (ok && strcmp(stem, wc.word) != 0) {
+      char *dup = str_dup(stem);
+      if (dup) {
+        str_free(wc.word);
+        wc.word = dup;
+      } else {
+        ok = 0;  // keeps the surface form; list stays consistent
+      }
+    }
+    list->items[w] = wc;
+    sids[w] = sid;
+    m->slot_of[sid] = (uint32_t)++w;
+  }
+  list->count = w;
+
+  for (size_t i = 0; i < w; i++) m->slot_of[sids[i]] = 0;
+  free(sids);
+  if (sorted && w > 1) qsort(list->items, w, sizeof(WordCount), cmp_word);
+  return ok;
+}
+
+int stem_fold_bigrams(StemMemo *m, BigramCountList *list, bool sorted) {
+  if (!m || !list) return 0;
+  if (list->count == 0) return 1;
+
+  /* Pairs of stem IDs are summed in an ID bigram table. */
+  IdBigrams bg;
+  if (!idbigrams_init(&bg, list->count * 2)) return 0;
+  for (size_t i = 0; i < list->count; i++) {
+    uint32_t s1 = stem_memo_word(m, list->items[i].w1);
+    uint32_t s2 = stem_memo_word(m, list->items[i].w2);
+    if (!s1 || !s2 || !idbigrams_add(&bg, s1, s2, (uint32_t)list->items[i].count)) {
+      idbigrams_free(&bg);
+      return 0;
+    }
+  }
+
+  IdPairCountList pairs;
+  int ok = idbigrams_collect(&bg, &pairs);
+  idbigrams_free(&bg);
+  if (!ok) return 0;
+
+  BigramCount *items = (BigramCount*)calloc(pairs.count ? pairs.count : 1, sizeof(BigramCount));
+  if (!items) {
+    free_id_pair_counts(&pairs);
+    return 0;
+  }
+  size_t n = 0;
+  for (size_t i = 0; i < pairs.count; i++) {
+    items[n].w1 = str_dup(dict_word(&m->stems, pairs.items[i].id1));
+    items[n].w2 = str_dup(dict_word(&m->stems, pairs.items[i].id2));
+    items[n].count = pairs.items[i].count;
+    n++;
+    if (!items[n - 1].w1 || !items[n - 1].w2) {
+      BigramCountList tmp = { items, n };
+      free_bigram_counts(&tmp);
+      free_id_pair_counts(&pairs);
+      return 0;
+    }
+  }
+  free_id_pair_counts(&pairs);
+
+  free_bigram_counts(list);
+  list->items = items;
+  list->count = n;
+  if (sorted && n > 1) qsort(list->items, n, sizeof(BigramCount), cmp_bigram);
+  return 1;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "core/dict.h"
+#include "core/freq.h"
+#include "core/bigrams.h"
+
+/*
+ * Light German stemmer (CISTEM, Weissweiler & Fraser 2017) on lowercased
+ * UTF-8 tokens: umlauts are folded (ä->a, ö->o, ü->u, ß->ss), a "ge"
+ * prefix is dropped from longer words, then the suffixes -em/-er/-nd,
+ * -t and -e/-s/-n are stripped while more than three characters remain.
+ * "analyse" and "analysen" both become "analy".
+ *
+ * Writes at most out_cap - 1 bytes plus NUL; returns the stem length
+ * (0 if out_cap is too small).
+ */
+size_t stem_de(const char *word, char *out, size_t out_cap);
+
+/*
+ * Memoized stemming: every distinct surface form is stemmed once per
+ * request, later lookups cost one Dict probe. Stems get their own IDs, so
+ * counted lists can be folded with an ID -> stem ID table in one pass.
+ */
+typedef struct {
+  Dict words;         // surface form -> word ID
+  Dict stems;         // stem -> stem ID (names of folded results)
+  uint32_t *stem_of;  // index = word ID, 0 = not stemmed yet
+  size_t cap;         // entries in stem_of
+  size_t stemmed;     // stemmer calls (= distinct surface forms)
+  uint32_t *slot_of;  // fold scratch, index = stem ID (zero between folds)
+  size_t slot_cap;
+} StemMemo;
+
+/* Initialize / release a memo. */
+int stem_memo_init(StemMemo *m);
+void stem_memo_free(StemMemo *m);
+
+/* Stem ID of word (stems it on first sight). 0 on OOM. */
+uint32_t stem_memo_word(StemMemo *m, const char *word);
+
+/*
+ * Stem ID per ID of d (index = id, [0] = 0), stemming only surface forms
+ * not seen before. Caller frees the table. NULL on OOM.
+ */
+uint32_t *stem_memo_map_dict(StemMemo *m, const Dict *d);
+
+/*
+ * Fold a counted string list onto stems in place: entries sharing a stem
+ * are summed (dense table indexed by stem ID, one pass). sorted keeps
+ * the list in key order (engines with lexsorted lists).
+ */
+int stem_fold_words(StemMemo *m, WordCountList *list, bool sorted);
+int stem_fold_bigrams(StemMemo *m, BigramCountList *list, bool sorted);
@@ -1,4 +1,6 @@
 #include "core/stopwords.h"
+#include "core/arena.h"
+#include "core/cancel.h"
 
 #include <ctype.h>
 #include <stdio.h>
@@ -150,7 +152,7 @@ int filter_stopwords(TokenList *tokens, const char *stopwords_file_path) {
         if (!tok) continue;
 
         if (should_drop_token(tok, &sw)) {
-            free(tok);
+            str_free(tok);
             tokens->items[read] = NULL;
         } else {
             tokens->items[write++] = tok;
@@ -167,50 +169,51 @@ int filter_stopwords(TokenList *tokens, const char *stopwords_file_path) {
 }
 
 TokenList filter_stopwords_copy(const TokenList *in, const char *stopwords_file_path) {
-    TokenList out = (TokenList){0};
-    if (!in || !in->items || in->count == 0) return out;
+    if (!in || !in->items || in->count == 0) return (TokenList){0};
 
     /* Non-destructive variant for pipelines that must keep original tokens. */
     StopwordList sw = {0};
     if (stopwords_load(&sw, stopwords_file_path) != 0) {
         return (TokenList){0};
     }
+    TokenList out = filter_stopwords_list(in, &sw);
+    stopwords_free(&sw);
+    return out;
+}
+
+TokenList filter_stopwords_list(const TokenList *in, const StopwordList *sw) {
+    TokenList out = (TokenList){0};
+    if (!in || !in->items || in->count == 0) return out;
 
     /* Pass 1: count kept tokens to size the output array exactly. */
     size_t allowed = 0;
     for (size_t i = 0; i < in->count; i++) {
         const char *tok = in->items[i];
-        if (!should_drop_token(tok, &sw)) allowed++;
+        if (!should_drop_token(tok, sw)) allowed++;
+        if (cancel_poll(i)) return out;
     }
 
-    if (allowed == 0) {
-        stopwords_free(&sw);
-        return out;
-    }
+    if (allowed == 0) return out;
 
     out.items = (char **)calloc(allowed, sizeof(char *));
-    if (!out.items) {
-        stopwords_free(&sw);
-        return (TokenList){0};
-    }
+    if (!out.items) return (TokenList){0};
 
     /* Pass 2: duplicate kept tokens (ownership belongs to out). */
     size_t wi = 0;
     for (size_t i = 0; i < in->count; i++) {
+        if (cancel_poll(i)) break;
         const char *tok = in->items[i];
-        if (should_drop_token(tok, &sw)) continue;
+        if (should_drop_token(tok, sw)) continue;
 
-        out.items[wi] = dup_cstr(tok);
+        out.items[wi] = str_dup(tok);
         if (!out.items[wi]) {
             out.count = wi;
             free_tokens(&out);
-            stopwords_free(&sw);
             return (TokenList){0};
         }
         wi++;
     }
 
     out.count = wi;
-    stopwords_free(&sw);
     return out;
 }
@@ -45,4 +45,11 @@ int filter_stopwords(TokenList *tokens, const char *stopwords_file_path);
  */
 TokenList filter_stopwords_copy(const TokenList *in, const char *stopwords_file_path);
 
+/*
+ * Same filter with an already loaded list (callers that filter many
+ * token lists load the stopwords once). Stops early once the bound
+ * deadline passes (core/cancel.h).
+ */
+TokenList filter_stopwords_list(const TokenList *in, const StopwordList *sw);
+
 #endif
@@ -0,0 +1,118 @@
+#define _GNU_SOURCE  // mremap (Linux)
+#include "core/table_alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <sys/mman.h>
+  #define TABLE_HAVE_MMAP 1
+#endif
+
+#if defined(TABLE_HAVE_MMAP)
+
+static int is_mapped(size_t bytes) {
+  return bytes >= TABLE_MMAP_THRESHOLD_BYTES;
+}
+
+/* Anonymous mappings are zero-filled and only consume RSS once touched. */
+static void *map_zeroed(size_t bytes) {
+  void *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) return NULL;
+#if defined(MADV_HUGEPAGE)
+  (void)madvise(p, bytes, MADV_HUGEPAGE);  // advisory only
+#endif
+  return p;
+}
+
+void *table_alloc(size_t bytes) {
+  if (bytes == 0) return NULL;
+  if (is_mapped(bytes)) return map_zeroed(bytes);
+  return calloc(1, bytes);
+}
+
+void *table_grow(void *p, size_t old_bytes, size_t new_bytes) {
+  if (!p) return table_alloc(new_bytes);
+  if (new_bytes <= old_bytes) return p;
+
+  /* Heap → heap: plain realloc, zero the new tail. */
+  if (!is_mapped(new_bytes)) {
+    unsigned char *np = (unsigned char*)realloc(p, new_bytes);
+    if (!np) return NULL;
+    memset(np + old_bytes, 0, new_bytes - old_bytes);
+    return np;
+  }
+
+  /* Mapped → mapped: remap pages instead of copying them. */
+  if (is_mapped(old_bytes)) {
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+    void *np = mremap(p, old_bytes, new_bytes, MREMAP_MAYMOVE);
+    if (np == MAP_FAILED) return NULL;
+  #if defined(MADV_HUGEPAGE)
+    (void)madvise(np, new_bytes, MADV_HUGEPAGE);
+  #endif
+    return np;
+#else
+    void *np = map_zeroed(new_bytes);
+    if (!np) return NULL;
+    memcpy(np, p, old_bytes);
+    munmap(p, old_bytes);
+    return np;
+#endif
+  }
+
+  /* Heap → mapped: one copy when crossing the threshold. */
+  void *np = map_zeroed(new_bytes);
+  if (!np) return NULL;
+  memcpy(np, p, old_bytes);
+  free(p);
+  return np;
+}
+
+void table_free(void *p, size_t bytes) {
+  if (!p) return;
+  if (is_mapped(bytes)) munmap(p, bytes);
+  else free(p);
+}
+
+void table_release_prefix(void *p, size_t bytes, size_t done_before, size_t done_after) {
+#if defined(MADV_DONTNEED)
+  if (!p || !is_mapped(bytes)) return;
+
+  /* Act once per huge-page sized chunk to keep syscalls rare. */
+  const size_t chunk = TABLE_MMAP_THRESHOLD_BYTES;
+  size_t from = done_before / chunk;
+  size_t to = done_after / chunk;
+  if (to <= from) return;
+
+  (void)madvise((unsigned char*)p + from * chunk, (to - from) * chunk, MADV_DONTNEED);
+#else
+  (void)p; (void)bytes; (void)done_before; (void)done_after;
+#endif
+}
+
+#else /* !TABLE_HAVE_MMAP */
+
+void *table_alloc(size_t bytes) {
+  if (bytes == 0) return NULL;
+  return calloc(1, bytes);
+}
+
+void *table_grow(void *p, size_t old_bytes, size_t new_bytes) {
+  if (new_bytes <= old_bytes) return p;
+  unsigned char *np = (unsigned char*)realloc(p, new_bytes);
+  if (!np) return NULL;
+  memset(np + old_bytes, 0, new_bytes - old_bytes);
+  return np;
+}
+
+void table_free(void *p, size_t bytes) {
+  (void)bytes;
+  free(p);
+}
+
+void table_release_prefix(void *p, size_t bytes, size_t done_before, size_t done_after) {
+  (void)p; (void)bytes; (void)done_before; (void)done_after;
+}
+
+#endif
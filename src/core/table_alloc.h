@@ -0,0 +1,46 @@
+#pragma once
+#include <stddef.h>
+
+/*
+ * Zeroed storage for large counting tables (Dict, IdBigrams, IdFreq).
+ *
+ * Small tables use calloc/realloc. Tables of at least
+ * TABLE_MMAP_THRESHOLD_BYTES are backed by anonymous mmap regions:
+ * - transparent huge pages are advised (fewer TLB misses on random probes)
+ * - growth uses mremap where available (no copy of the existing data)
+ * - fresh pages are zero-filled by the kernel (no memset on growth)
+ *
+ * The backing kind is derived from the byte size, so callers pass the
+ * same size to table_grow/table_free that they allocated with.
+ */
+#ifndef TABLE_MMAP_THRESHOLD_BYTES
+#define TABLE_MMAP_THRESHOLD_BYTES ((size_t)2 * 1024 * 1024)  // 2 MiB (one huge page)
+#endif
+
+/* Allocate `bytes` of zeroed memory (NULL on failure). */
+void *table_alloc(size_t bytes);
+
+/* Grow a table to new_bytes; the added tail is zeroed.
+ * Returns the (possibly moved) pointer, or NULL (old table stays valid).
+ */
+void *table_grow(void *p, size_t old_bytes, size_t new_bytes);
+
+/* Release a table allocated with table_alloc/table_grow. */
+void table_free(void *p, size_t bytes);
+
+/*
+ * Hint that the prefix [0, done_after) of a table is no longer needed
+ * and reads as zero from now on (e.g. migrated buckets of an old hash
+ * table). Whole pages are returned to the OS for mmap-backed tables once
+ * the prefix crosses a huge-page boundary; heap-backed tables are untouched.
+ */
+void table_release_prefix(void *p, size_t bytes, size_t done_before, size_t done_after);
+
+/* Prefetch a probe slot for writing (batched lookups hide cache misses).
+ * No-op on compilers without __builtin_prefetch.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define TABLE_PREFETCH(p) __builtin_prefetch((p), 1, 3)
+#else
+#define TABLE_PREFETCH(p) ((void)(p))
+#endif
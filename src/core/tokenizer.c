@@ -1,6 +1,9 @@
 #include "core/tokenizer.h"
+#include "core/arena.h"
+#include "core/cancel.h"
 
 #include <ctype.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -31,17 +34,21 @@ static size_t utf8_strlen_n(const char *s, size_t n) {
     return count;
 }
 
-TokenList tokenize_with_stats(const char *text, TokenStats *stats) {
+TokenList tokenize_span(const char *text, size_t len, TokenStats *stats,
+                        size_t max_token_bytes) {
     TokenList out = (TokenList){0};
+    if (max_token_bytes == 0) max_token_bytes = SIZE_MAX;  // no limit
 
     /* Tokenizer is the first processing stage.
      * Stats include stopwords (filtering happens later).
      */
-    if (stats) { stats->wordCount = 0; stats->wordCharCount = 0; }
+    if (stats) {
+        stats->wordCount = 0;
+        stats->wordCharCount = 0;
+        stats->tokensTooLong = 0;
+    }
     if (!text) return out;
 
-    size_t len = strlen(text);
-
     /* Pass 1: count tokens (no allocations yet).
      * Allows exact-sized allocation for token array.
      */
@@ -66,8 +73,11 @@ TokenList tokenize_with_stats(const char *text, TokenStats *stats) {
         }
 
         size_t tlen = i - start;
-        if (utf8_strlen_n(&text[start], tlen) >= 2) count++;
+        if (tlen > max_token_bytes) continue;
+        if (utf8_strlen_n(&text[start], tlen) < 2) continue;
 
+        /* Deadline passed (core/cancel.h): no tokens. */
+        if (cancel_poll(++count)) return out;
     }
 
     if (count == 0) return out;
@@ -103,10 +113,16 @@ TokenList tokenize_with_stats(const char *text, TokenStats *stats) {
         size_t end = i;
         size_t tlen = end - start;
 
+        /* Over-long tokens are dropped, not truncated (no false words). */
+        if (tlen > max_token_bytes) {
+            if (stats) stats->tokensTooLong += 1;
+            continue;
+        }
+
         size_t ulen = utf8_strlen_n(&text[start], tlen);
         if (ulen < 2) continue;
 
-        char *tok = (char *)malloc(tlen + 1);
+        char *tok = str_alloc(tlen + 1);
         if (!tok) {
             /* Allocation failure aborts tokenization safely. */
             out.count = ti;
@@ -128,12 +144,24 @@ TokenList tokenize_with_stats(const char *text, TokenStats *stats) {
             stats->wordCount += 1;
             stats->wordCharCount += ulen;
         }
+
+        /* Deadline passed: the tokens so far. */
+        if (cancel_poll(ti)) break;
     }
 
     out.count = ti;
     return out;
 }
 
+TokenList tokenize_with_limit(const char *text, TokenStats *stats,
+                              size_t max_token_bytes) {
+    return tokenize_span(text, text ? strlen(text) : 0, stats, max_token_bytes);
+}
+
+TokenList tokenize_with_stats(const char *text, TokenStats *stats) {
+    return tokenize_with_limit(text, stats, 0);
+}
+
 /* Convenience wrapper for the default string-based pipeline. */
 TokenList tokenize(const char *text) {
     return tokenize_with_stats(text, NULL);
@@ -144,7 +172,7 @@ void free_tokens(TokenList *list) {
     if (!list || !list->items) return;
 
     for (size_t i = 0; i < list->count; i++) {
-        free(list->items[i]);
+        str_free(list->items[i]);
     }
     free(list->items);
 
@@ -3,6 +3,17 @@
 
 #include <stddef.h>
 
+/*
+ * Suggested upper bound for a single token in bytes, for callers facing
+ * untrusted input (the API server applies it by default). Longer runs
+ * without a separator (base64 blobs, minified data, crafted input) are
+ * skipped so a single giant token cannot dominate hashing and allocation
+ * cost.
+ */
+#ifndef TOKENIZER_MAX_TOKEN_BYTES
+#define TOKENIZER_MAX_TOKEN_BYTES 256
+#endif
+
 /*
  * Token container produced by the tokenizer stage.
  * Represents the first transformation step in the analysis pipeline.
@@ -28,6 +39,7 @@ typedef struct {
     size_t splitUtf8DashCount;    // UTF-8 dash splits
     size_t tokenAllocs;           // number of token allocations
     size_t tokenBytesAllocated;   // total allocated token bytes
+    size_t tokensTooLong;         // tokens skipped by the length limit
 } TokenStats;
 
 /*
@@ -45,6 +57,21 @@ TokenList tokenize(const char *text);
  */
 TokenList tokenize_with_stats(const char *text, TokenStats *stats);
 
+/*
+ * Tokenizer with explicit token length limit (bytes).
+ * max_token_bytes == 0 means no limit.
+ */
+TokenList tokenize_with_limit(const char *text, TokenStats *stats,
+                              size_t max_token_bytes);
+
+/*
+ * Tokenizer over the first len bytes of text (no NUL needed). Spans cut
+ * at ASCII whitespace yield the same tokens as the whole text.
+ * Stops early once the bound deadline passes (core/cancel.h).
+ */
+TokenList tokenize_span(const char *text, size_t len, TokenStats *stats,
+                        size_t max_token_bytes);
+
 /*
  * Releases memory owned by a TokenList.
  */
@@ -1,4 +1,6 @@
 #include "input/request_validate.h"
+#include "core/id_ngrams.h"
+#include "core/id_cooc.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -62,6 +64,91 @@ bool request_parse_and_validate(char *json,
         yyjson_val *opt = yyjson_obj_get(root, "options");
         out->include_bigrams  = json_get_bool(opt, "includeBigrams", out->include_bigrams);
         out->per_page_results = json_get_bool(opt, "perPageResults", out->per_page_results);
+        out->approximate      = json_get_bool(opt, "approximate", false);
+        out->stem             = json_get_bool(opt, "stem", false);
+        out->tfidf            = json_get_bool(opt, "tfidf", false);
+        out->partial_on_timeout = json_get_bool(opt, "partialOnTimeout", false);
+
+        /* Optional summary size for approximate mode (positive integer). */
+        yyjson_val *cap = opt && yyjson_is_obj(opt) ? yyjson_obj_get(opt, "approximateCapacity") : NULL;
+        if (cap) {
+            if (!yyjson_is_uint(cap) || yyjson_get_uint(cap) == 0 || yyjson_get_uint(cap) > (1u << 24)) {
+                yyjson_doc_free(doc);
+                set_err(err, 400, "invalid options.approximateCapacity (1..16777216)");
+                return false;
+            }
+            out->approximate_capacity = (size_t)yyjson_get_uint(cap);
+        }
+
+        /* Optional sampling: fraction of text analyzed, stable seed. */
+        yyjson_val *rate = opt && yyjson_is_obj(opt) ? yyjson_obj_get(opt, "sampleRate") : NULL;
+        if (rate) {
+            double r = yyjson_is_num(rate) ? yyjson_get_num(rate) : 0.0;
+            if (!(r > 0.0 && r <= 1.0)) {
+                yyjson_doc_free(doc);
+                set_err(err, 400, "invalid options.sampleRate (0 < rate <= 1)");
+                return false;
+            }
+            out->sample_rate = r;
+        }
+        yyjson_val *seed = opt && yyjson_is_obj(opt) ? yyjson_obj_get(opt, "sampleSeed") : NULL;
+        if (seed) {
+            if (!yyjson_is_uint(seed)) {
+                yyjson_doc_free(doc);
+                set_err(err, 400, "invalid options.sampleSeed (unsigned integer)");
+                return false;
+            }
+            out->sample_seed = yyjson_get_uint(seed);
+        }
+
+        /* Optional n-grams: highest order (1..4) and distinct-entry limit. */
+        yyjson_val *ng = opt && yyjson_is_obj(opt) ? yyjson_obj_get(opt, "ngrams") : NULL;
+        if (ng) {
+            if (!yyjson_is_uint(ng) || yyjson_get_uint(ng) > NGRAM_MAX_N) {
+                yyjson_doc_free(doc);
+                set_err(err, 400, "invalid options.ngrams (0..4)");
+                return false;
+            }
+            out->ngram_max = (unsigned)yyjson_get_uint(ng);
+        }
+        yyjson_val *ngl = opt && yyjson_is_obj(opt) ? yyjson_obj_get(opt, "ngramLimit") : NULL;
+        if (ngl) {
+            if (!yyjson_is_uint(ngl) || yyjson_get_uint(ngl) == 0 || yyjson_get_uint(ngl) > (1u << 24)) {
+                yyjson_doc_free(doc);
+                set_err(err, 400, "invalid options.ngramLimit (1..16777216)");
+                return false;
+            }
+            out->ngram_limit = (size_t)yyjson_get_uint(ngl);
+        }
+
+        /* Optional co-occurrence: window (1..16), pruning and memory limit. */
+        yyjson_val *cw = opt && yyjson_is_obj(opt) ? yyjson_obj_get(opt, "cooccurrenceWindow") : NULL;
+        if (cw) {
+            if (!yyjson_is_uint(cw) || yyjson_get_uint(cw) > COOC_MAX_WINDOW) {
+                yyjson_doc_free(doc);
+                set_err(err, 400, "invalid options.cooccurrenceWindow (0..16)");
+                return false;
+            }
+            out->cooc_window = (unsigned)yyjson_get_uint(cw);
+        }
+        yyjson_val *cm = opt && yyjson_is_obj(opt) ? yyjson_obj_get(opt, "cooccurrenceMinCount") : NULL;
+        if (cm) {
+            if (!yyjson_is_uint(cm) || yyjson_get_uint(cm) > UINT32_MAX) {
+                yyjson_doc_free(doc);
+                set_err(err, 400, "invalid options.cooccurrenceMinCount (unsigned integer)");
+                return false;
+            }
+            out->cooc_min_count = (size_t)yyjson_get_uint(cm);
+        }
+        yyjson_val *cl = opt && yyjson_is_obj(opt) ? yyjson_obj_get(opt, "cooccurrenceLimit") : NULL;
+        if (cl) {
+            if (!yyjson_is_uint(cl) || yyjson_get_uint(cl) == 0 || yyjson_get_uint(cl) > (1u << 24)) {
+                yyjson_doc_free(doc);
+                set_err(err, 400, "invalid options.cooccurrenceLimit (1..16777216)");
+                return false;
+            }
+            out->cooc_limit = (size_t)yyjson_get_uint(cl);
+        }
 
         /* Optional pipeline override (controls pipeline switch point). */
         if (cfg->allow_options_pipeline && opt && yyjson_is_obj(opt)) {
@@ -71,7 +158,7 @@ bool request_parse_and_validate(char *json,
                 app_pipeline_t pl = app_pipeline_from_str(yyjson_get_str(p), &ok);
                 if (!ok) {
                     yyjson_doc_free(doc);
-                    set_err(err, 400, "invalid options.pipeline (use auto|string|id)");
+                    set_err(err, 400, "invalid options.pipeline (use " APP_PIPELINE_CHOICES ")");
                     return false;
                 }
                 out->has_pipeline_from_options = true;
@@ -53,6 +53,18 @@ typedef struct {
     const char *domain;  // optional, pointer into JSON doc
     bool include_bigrams;
     bool per_page_results;
+    bool approximate;              // options.approximate
+    size_t approximate_capacity;   // options.approximateCapacity (0 = default)
+    double sample_rate;            // options.sampleRate (0 = not set)
+    uint64_t sample_seed;          // options.sampleSeed (0 = default)
+    unsigned ngram_max;            // options.ngrams (0 = off)
+    size_t ngram_limit;            // options.ngramLimit (0 = default)
+    unsigned cooc_window;          // options.cooccurrenceWindow (0 = off)
+    size_t cooc_min_count;         // options.cooccurrenceMinCount
+    size_t cooc_limit;             // options.cooccurrenceLimit (0 = default)
+    bool stem;                     // options.stem
+    bool tfidf;                    // options.tfidf
+    bool partial_on_timeout;       // options.partialOnTimeout
 
     size_t chars_total;  // total input size (used for pipeline switch decision)
 
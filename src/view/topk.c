@@ -1,4 +1,5 @@
 #include "view/topk.h"
+#include "core/arena.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -13,14 +14,80 @@ static inline uint64_t now_ns(void) {
     return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
 }
 
-/* Deep-copy helper; returned lists own their strings. */
-static char *dup_cstr(const char *s) {
-    if (!s) return NULL;
-    size_t n = strlen(s);
-    char *out = (char *)malloc(n + 1);
-    if (!out) return NULL;
-    memcpy(out, s, n + 1);
-    return out;
+/* Stable LSD radix (8-bit digits) of idx[0..n) by keys[idx[i]];
+ * digits equal for all keys are skipped. Returns 0 on OOM.
+ */
+static int radix_order_u64(const uint64_t *keys, size_t n, size_t *idx) {
+    if (n < 2) return 1;
+
+    uint64_t diff = 0;
+    for (size_t i = 1; i < n; i++) diff |= keys[i] ^ keys[0];
+    if (diff == 0) return 1;
+
+    size_t *tmp = (size_t *)malloc(n * sizeof(size_t));
+    if (!tmp) return 0;
+
+    size_t *src = idx, *dst = tmp;
+    for (unsigned shift = 0; shift < 64 && (diff >> shift) != 0; shift += 8) {
+        if (((diff >> shift) & 0xff) == 0) continue;
+
+        size_t hist[256] = {0};
+        for (size_t i = 0; i < n; i++) hist[(keys[src[i]] >> shift) & 0xff]++;
+
+        size_t sum = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t c = hist[b];
+            hist[b] = sum;
+            sum += c;
+        }
+        for (size_t i = 0; i < n; i++) dst[hist[(keys[src[i]] >> shift) & 0xff]++] = src[i];
+
+        size_t *t = src; src = dst; dst = t;
+    }
+
+    if (src != idx) memcpy(idx, src, n * sizeof(size_t));
+    free(tmp);
+    return 1;
+}
+
+/* Stable reorder of idx[0..n) by counts[idx[i]] DESC. Small count ranges
+ * (max <= n) use one counting-sort pass with one bucket per count value.
+ */
+static int order_by_count_desc_stable(const size_t *counts, size_t n, size_t *idx) {
+    size_t max = 0;
+    for (size_t i = 0; i < n; i++) if (counts[i] > max) max = counts[i];
+
+    if (max <= n) {
+        size_t *start = (size_t *)calloc(max + 2, sizeof(size_t));
+        size_t *tmp = (size_t *)malloc((n ? n : 1) * sizeof(size_t));
+        if (!start || !tmp) { free(start); free(tmp); return 0; }
+
+        /* Bucket b holds count (max - b): highest counts first. */
+        for (size_t i = 0; i < n; i++) start[max - counts[idx[i]] + 1]++;
+        for (size_t b = 1; b <= max + 1; b++) start[b] += start[b - 1];
+        for (size_t i = 0; i < n; i++) tmp[start[max - counts[idx[i]]]++] = idx[i];
+
+        memcpy(idx, tmp, n * sizeof(size_t));
+        free(start);
+        free(tmp);
+        return 1;
+    }
+
+    uint64_t *keys = (uint64_t *)malloc(n * sizeof(uint64_t));
+    if (!keys) return 0;
+    for (size_t i = 0; i < n; i++) keys[i] = (uint64_t)(max - counts[i]);
+    int ok = radix_order_u64(keys, n, idx);
+    free(keys);
+    return ok;
+}
+
+/* Identity order 0..n-1, reordered by count DESC (stable). Returns malloc'd indices. */
+static size_t *identity_by_count_desc(const size_t *counts, size_t n) {
+    size_t *idx = (size_t *)malloc(n * sizeof(size_t));
+    if (!idx) return NULL;
+    for (size_t i = 0; i < n; i++) idx[i] = i;
+    if (!order_by_count_desc_stable(counts, n, idx)) { free(idx); return NULL; }
+    return idx;
 }
 
 /* ---------- Word sorting ---------- */
@@ -42,66 +109,113 @@ static int cmp_wordcount_desc_then_word_asc(const void *a, const void *b) {
     return strcmp(wa->word, wb->word);
 }
 
+/* Pointer-array comparators (same order as the struct comparators). */
+static int cmp_wordptr(const void *a, const void *b) {
+    return cmp_wordcount_desc_then_word_asc(*(const WordCount *const *)a,
+                                            *(const WordCount *const *)b);
+}
+
+/* Heap of the k best items seen so far; the root is the worst of them
+ * (max under cmp), so a candidate only has to beat the root.
+ */
+typedef int (*topk_cmp_fn)(const void *, const void *);
+
+static void worst_heap_sift_down(const void **h, size_t n, size_t i, topk_cmp_fn cmp) {
+    for (;;) {
+        size_t l = 2 * i + 1, m = i;
+        if (l < n && cmp(&h[l], &h[m]) > 0) m = l;
+        if (l + 1 < n && cmp(&h[l + 1], &h[m]) > 0) m = l + 1;
+        if (m == i) return;
+        const void *t = h[i]; h[i] = h[m]; h[m] = t;
+        i = m;
+    }
+}
+
+static void worst_heap_sift_up(const void **h, size_t i, topk_cmp_fn cmp) {
+    while (i > 0) {
+        size_t p = (i - 1) / 2;
+        if (cmp(&h[i], &h[p]) <= 0) return;
+        const void *t = h[i]; h[i] = h[p]; h[p] = t;
+        i = p;
+    }
+}
+
+/* Selects the n = min(k, count) best of count items (stride bytes apart)
+ * into sel[0..n), sorted by cmp. Full sorts skip the heap.
+ * O(count log n) comparisons, no string copies.
+ */
+static size_t select_top_k(const void *items, size_t count, size_t stride, size_t k,
+                           topk_cmp_fn cmp, const void **sel) {
+    const char *base = (const char *)items;
+    size_t n = count < k ? count : k;
+
+    if (n == count) {
+        for (size_t i = 0; i < count; i++) sel[i] = base + i * stride;
+    } else {
+        size_t h = 0;
+        for (size_t i = 0; i < count; i++) {
+            const void *it = base + i * stride;
+            if (h < n) {
+                sel[h] = it;
+                worst_heap_sift_up(sel, h++, cmp);
+            } else if (cmp(&it, &sel[0]) < 0) {
+                sel[0] = it;
+                worst_heap_sift_down(sel, h, 0, cmp);
+            }
+        }
+    }
+
+    qsort(sel, n, sizeof(*sel), cmp);
+    return n;
+}
+
 WordCountList top_k_words(const WordCountList *list, size_t k) {
     WordCountList out = (WordCountList){0};
     if (!list || !list->items || list->count == 0 || k == 0) return out;
 
     /* Optional perf instrumentation:
-     * copy -> sort -> move-to-output (ownership transfer).
+     * select (pointers only) -> sort winners -> copy winners.
      */
     const char *perf = getenv("PERF_TOPK");
-    uint64_t t0=0, t_copy=0, t_sort=0, t_out=0;
+    uint64_t t0=0, t_sort=0, t_out=0;
 
     if (perf) t0 = now_ns();
 
-    /* Copy all items so we can sort without mutating the input list. */
-    WordCount *tmp = (WordCount *)calloc(list->count, sizeof(WordCount));
-    if (!tmp) return out;
-
-    for (size_t i = 0; i < list->count; i++) {
-        tmp[i].word = dup_cstr(list->items[i].word);
-        tmp[i].count = list->items[i].count;
-        if (list->items[i].word && !tmp[i].word) {
-            for (size_t j = 0; j < i; j++) free(tmp[j].word);
-            free(tmp);
-            return (WordCountList){0};
-        }
-    }
+    size_t cap = list->count < k ? list->count : k;
+    const void **sel = (const void **)malloc(cap * sizeof(*sel));
+    if (!sel) return out;
 
-    if (perf) t_copy = now_ns();
-
-    qsort(tmp, list->count, sizeof(WordCount), cmp_wordcount_desc_then_word_asc);
+    size_t n = select_top_k(list->items, list->count, sizeof(WordCount), k, cmp_wordptr, sel);
 
     if (perf) t_sort = now_ns();
 
-    size_t n = list->count < k ? list->count : k;
-
-    /* Output list takes ownership of the top-n copied strings. */
+    /* Only the winners are deep-copied into the output list. */
     out.items = (WordCount *)calloc(n, sizeof(WordCount));
     if (!out.items) {
-        for (size_t i = 0; i < list->count; i++) free(tmp[i].word);
-        free(tmp);
+        free(sel);
         return (WordCountList){0};
     }
-    out.count = n;
 
     for (size_t i = 0; i < n; i++) {
-        out.items[i].word = tmp[i].word;  // take ownership
-        out.items[i].count = tmp[i].count;
-        tmp[i].word = NULL;
+        const WordCount *src = (const WordCount *)sel[i];
+        out.items[i].word = str_dup(src->word);
+        out.items[i].count = src->count;
+        out.count = i + 1;
+        if (src->word && !out.items[i].word) {
+            free(sel);
+            free_word_counts(&out);
+            return (WordCountList){0};
+        }
     }
-
-    for (size_t i = 0; i < list->count; i++) free(tmp[i].word);
-    free(tmp);
+    free(sel);
 
     if (perf) {
         t_out = now_ns();
         fprintf(stderr,
-            "PERF_TOPK words total_ns=%" PRIu64 " copy_ns=%" PRIu64 " sort_ns=%" PRIu64
+            "PERF_TOPK words total_ns=%" PRIu64 " copy_ns=0 sort_ns=%" PRIu64
             " out_ns=%" PRIu64 " n=%zu k=%zu\n",
             (t_out - t0),
-            (t_copy - t0),
-            (t_sort - t_copy),
+            (t_sort - t0),
             (t_out - t_sort),
             list->count, k
         );
@@ -110,6 +224,52 @@ WordCountList top_k_words(const WordCountList *list, size_t k) {
     return out;
 }
 
+WordCountList top_k_words_lexsorted(const WordCountList *list, size_t k) {
+    WordCountList out = (WordCountList){0};
+    if (!list || !list->items || list->count == 0 || k == 0) return out;
+
+    const char *perf = getenv("PERF_TOPK");
+    uint64_t t0 = perf ? now_ns() : 0;
+
+    size_t *counts = (size_t *)malloc(list->count * sizeof(size_t));
+    if (!counts) return out;
+    for (size_t i = 0; i < list->count; i++) counts[i] = list->items[i].count;
+
+    size_t *order = identity_by_count_desc(counts, list->count);
+    free(counts);
+    if (!order) return out;
+
+    uint64_t t_sort = perf ? now_ns() : 0;
+
+    /* Copy only the n returned items. */
+    size_t n = list->count < k ? list->count : k;
+    out.items = (WordCount *)calloc(n, sizeof(WordCount));
+    if (!out.items) { free(order); return out; }
+
+    for (size_t i = 0; i < n; i++) {
+        const WordCount *src = &list->items[order[i]];
+        out.items[i].word = str_dup(src->word);
+        out.items[i].count = src->count;
+        out.count = i + 1;
+        if (src->word && !out.items[i].word) {
+            free(order);
+            free_word_counts(&out);
+            return (WordCountList){0};
+        }
+    }
+    free(order);
+
+    if (perf) {
+        uint64_t t_out = now_ns();
+        fprintf(stderr,
+            "PERF_TOPK words total_ns=%" PRIu64 " copy_ns=0 sort_ns=%" PRIu64
+            " out_ns=%" PRIu64 " n=%zu k=%zu\n",
+            (t_out - t0), (t_sort - t0), (t_out - t_sort), list->count, k);
+    }
+
+    return out;
+}
+
 /* Top-K outputs share the same free routine as regular WordCountList. */
 void free_top_k_words(WordCountList *list) {
     free_word_counts(list);
@@ -138,74 +298,56 @@ static int cmp_bigram_desc_then_lex(const void *a, const void *b) {
     return strcmp(a2, b2);
 }
 
+static int cmp_bigramptr(const void *a, const void *b) {
+    return cmp_bigram_desc_then_lex(*(const BigramCount *const *)a,
+                                    *(const BigramCount *const *)b);
+}
+
 BigramCountList top_k_bigrams(const BigramCountList *list, size_t k) {
     BigramCountList out = (BigramCountList){0};
     if (!list || !list->items || list->count == 0 || k == 0) return out;
 
     const char *perf = getenv("PERF_TOPK");
-    uint64_t t0=0, t_copy=0, t_sort=0, t_out=0;
+    uint64_t t0=0, t_sort=0, t_out=0;
 
     if (perf) t0 = now_ns();
 
-    /* Copy all items so we can sort without mutating the input list. */
-    BigramCount *tmp = (BigramCount *)calloc(list->count, sizeof(BigramCount));
-    if (!tmp) return out;
-
-    for (size_t i = 0; i < list->count; i++) {
-        tmp[i].w1 = dup_cstr(list->items[i].w1);
-        tmp[i].w2 = dup_cstr(list->items[i].w2);
-        tmp[i].count = list->items[i].count;
-
-        if ((list->items[i].w1 && !tmp[i].w1) || (list->items[i].w2 && !tmp[i].w2)) {
-            for (size_t j = 0; j <= i; j++) {
-                free(tmp[j].w1);
-                free(tmp[j].w2);
-            }
-            free(tmp);
-            return (BigramCountList){0};
-        }
-    }
-
-    if (perf) t_copy = now_ns();
+    size_t cap = list->count < k ? list->count : k;
+    const void **sel = (const void **)malloc(cap * sizeof(*sel));
+    if (!sel) return out;
 
-    qsort(tmp, list->count, sizeof(BigramCount), cmp_bigram_desc_then_lex);
+    size_t n = select_top_k(list->items, list->count, sizeof(BigramCount), k, cmp_bigramptr, sel);
 
     if (perf) t_sort = now_ns();
 
-    size_t n = list->count < k ? list->count : k;
-
-    /* Output list takes ownership of the top-n copied strings. */
+    /* Only the winners are deep-copied into the output list. */
     out.items = (BigramCount *)calloc(n, sizeof(BigramCount));
     if (!out.items) {
-        for (size_t i = 0; i < list->count; i++) {
-            free(tmp[i].w1);
-            free(tmp[i].w2);
-        }
-        free(tmp);
+        free(sel);
         return (BigramCountList){0};
     }
-    out.count = n;
 
     for (size_t i = 0; i < n; i++) {
-        out.items[i].w1 = tmp[i].w1; tmp[i].w1 = NULL;
-        out.items[i].w2 = tmp[i].w2; tmp[i].w2 = NULL;
-        out.items[i].count = tmp[i].count;
-    }
-
-    for (size_t i = 0; i < list->count; i++) {
-        free(tmp[i].w1);
-        free(tmp[i].w2);
+        const BigramCount *src = (const BigramCount *)sel[i];
+        out.items[i].w1 = str_dup(src->w1);
+        out.items[i].w2 = str_dup(src->w2);
+        out.items[i].count = src->count;
+        out.count = i + 1;
+        if ((src->w1 && !out.items[i].w1) || (src->w2 && !out.items[i].w2)) {
+            free(sel);
+            free_bigram_counts(&out);
+            return (BigramCountList){0};
+        }
     }
-    free(tmp);
+    free(sel);
 
     if (perf) {
         t_out = now_ns();
         fprintf(stderr,
-            "PERF_TOPK bigrams total_ns=%" PRIu64 " copy_ns=%" PRIu64 " sort_ns=%" PRIu64
+            "PERF_TOPK bigrams total_ns=%" PRIu64 " copy_ns=0 sort_ns=%" PRIu64
             " out_ns=%" PRIu64 " n=%zu k=%zu\n",
             (uint64_t)(t_out - t0),
-            (uint64_t)(t_copy - t0),
-            (uint64_t)(t_sort - t_copy),
+            (uint64_t)(t_sort - t0),
             (uint64_t)(t_out - t_sort),
             list->count, k
         );
@@ -214,7 +356,618 @@ BigramCountList top_k_bigrams(const BigramCountList *list, size_t k) {
     return out;
 }
 
+BigramCountList top_k_bigrams_lexsorted(const BigramCountList *list, size_t k) {
+    BigramCountList out = (BigramCountList){0};
+    if (!list || !list->items || list->count == 0 || k == 0) return out;
+
+    const char *perf = getenv("PERF_TOPK");
+    uint64_t t0 = perf ? now_ns() : 0;
+
+    size_t *counts = (size_t *)malloc(list->count * sizeof(size_t));
+    if (!counts) return out;
+    for (size_t i = 0; i < list->count; i++) counts[i] = list->items[i].count;
+
+    size_t *order = identity_by_count_desc(counts, list->count);
+    free(counts);
+    if (!order) return out;
+
+    uint64_t t_sort = perf ? now_ns() : 0;
+
+    /* Copy only the n returned items. */
+    size_t n = list->count < k ? list->count : k;
+    out.items = (BigramCount *)calloc(n, sizeof(BigramCount));
+    if (!out.items) { free(order); return out; }
+
+    for (size_t i = 0; i < n; i++) {
+        const BigramCount *src = &list->items[order[i]];
+        out.items[i].w1 = str_dup(src->w1);
+        out.items[i].w2 = str_dup(src->w2);
+        out.items[i].count = src->count;
+        out.count = i + 1;
+        if ((src->w1 && !out.items[i].w1) || (src->w2 && !out.items[i].w2)) {
+            free(order);
+            free_bigram_counts(&out);
+            return (BigramCountList){0};
+        }
+    }
+    free(order);
+
+    if (perf) {
+        uint64_t t_out = now_ns();
+        fprintf(stderr,
+            "PERF_TOPK bigrams total_ns=%" PRIu64 " copy_ns=0 sort_ns=%" PRIu64
+            " out_ns=%" PRIu64 " n=%zu k=%zu\n",
+            (t_out - t0), (t_sort - t0), (t_out - t_sort), list->count, k);
+    }
+
+    return out;
+}
+
 /* Top-K outputs share the same free routine as regular BigramCountList. */
 void free_top_k_bigrams(BigramCountList *list) {
     free_bigram_counts(list);
 }
+
+/* ---------- FULL ordering via lexicographic ranks ---------- */
+
+/* Multikey quicksort (Bentley/Sedgewick) of strings sharing their first
+ * d bytes: three-way partition on byte d, so common prefixes are compared
+ * once instead of once per strcmp. Iterates on the largest part.
+ */
+static void mkqs_strings(const char **a, size_t n, size_t d) {
+    while (n > 1) {
+        if (n < 16) {
+            for (size_t i = 1; i < n; i++) {
+                const char *v = a[i];
+                size_t j = i;
+                while (j > 0 && strcmp(a[j - 1] + d, v + d) > 0) { a[j] = a[j - 1]; j--; }
+                a[j] = v;
+            }
+            return;
+        }
+
+        unsigned char x = (unsigned char)a[0][d];
+        unsigned char y = (unsigned char)a[n / 2][d];
+        unsigned char z = (unsigned char)a[n - 1][d];
+        unsigned char v = (x < y) ? ((y < z) ? y : (x < z ? z : x))
+                                  : ((x < z) ? x : (y < z ? z : y));
+
+        size_t lt = 0, i = 0, gt = n;
+        while (i < gt) {
+            unsigned char c = (unsigned char)a[i][d];
+            if (c < v) { const char *t = a[lt]; a[lt++] = a[i]; a[i++] = t; }
+            else if (c > v) { const char *t = a[--gt]; a[gt] = a[i]; a[i] = t; }
+            else i++;
+        }
+
+        /* Parts: [0,lt) at d, [lt,gt) at d+1 (unless all ended), [gt,n) at d. */
+        size_t nl = lt, ne = (v != 0) ? gt - lt : 0, ng = n - gt;
+        if (nl >= ne && nl >= ng) {
+            mkqs_strings(a + lt, ne, d + 1);
+            mkqs_strings(a + gt, ng, d);
+            n = nl;
+        } else if (ne >= ng) {
+            mkqs_strings(a, nl, d);
+            mkqs_strings(a + gt, ng, d);
+            a += lt; n = ne; d++;
+        } else {
+            mkqs_strings(a, nl, d);
+            mkqs_strings(a + lt, ne, d + 1);
+            a += gt; n = ng;
+        }
+    }
+}
+
+/* Rank lookups are batched like the counting stages. */
+#define TOPK_RANK_CHUNK 64
+
+/* rank_of_id[id - 1] = lexicographic rank + 1 of every word in d. */
+static int rank_dict_words(Dict *d, uint32_t *rank_of_id) {
+    size_t v = dict_size(d);
+    const char **sorted = (const char **)malloc((v ? v : 1) * sizeof(*sorted));
+    if (!sorted) return 0;
+
+    for (size_t i = 0; i < v; i++) sorted[i] = dict_word(d, (uint32_t)(i + 1));
+
+    /* The only string sort: every later ordering compares integer ranks. */
+    mkqs_strings(sorted, v, 0);
+
+    /* Map each sorted word back to its dictionary ID (one lookup per word). */
+    uint32_t ids[TOPK_RANK_CHUNK];
+    for (size_t base = 0; base < v; base += TOPK_RANK_CHUNK) {
+        size_t c = v - base < TOPK_RANK_CHUNK ? v - base : TOPK_RANK_CHUNK;
+        if (!dict_get_or_add_batch(d, sorted + base, c, ids)) { free(sorted); return 0; }
+        for (size_t j = 0; j < c; j++) rank_of_id[ids[j] - 1] = (uint32_t)(base + j + 1);
+    }
+
+    free(sorted);
+    return 1;
+}
+
+int topk_lexrank_init(TopkLexRank *r, const WordCountList *words, const BigramCountList *bigrams) {
+    if (!r) return 0;
+    memset(r, 0, sizeof(*r));
+
+    size_t nw = (words && words->items) ? words->count : 0;
+    size_t nb = (bigrams && bigrams->items) ? bigrams->count : 0;
+
+    if (!dict_init(&r->dict, nw * 2 + 16)) return 0;
+    r->live = 1;
+
+    /* IDs of the source lists are kept: their own orderings need no lookups. */
+    r->word_ids = (uint32_t *)malloc((nw ? nw : 1) * sizeof(uint32_t));
+    r->bigram_ids = (uint32_t *)malloc((nb ? 2 * nb : 1) * sizeof(uint32_t));
+    if (!r->word_ids || !r->bigram_ids) goto fail;
+    r->src_words = words;
+    r->src_bigrams = bigrams;
+
+    /* Deduplicate through the dictionary first, then sort only distinct
+     * words. "" is not stored: its lookup ID 0 sorts before every rank.
+     */
+    const char *chunk[TOPK_RANK_CHUNK];
+    for (size_t base = 0; base < nw; base += TOPK_RANK_CHUNK) {
+        size_t c = nw - base < TOPK_RANK_CHUNK ? nw - base : TOPK_RANK_CHUNK;
+        for (size_t j = 0; j < c; j++) chunk[j] = words->items[base + j].word;
+        if (!dict_get_or_add_batch(&r->dict, chunk, c, r->word_ids + base)) goto fail;
+    }
+    for (size_t base = 0; base < nb; base += TOPK_RANK_CHUNK / 2) {
+        size_t c = nb - base < TOPK_RANK_CHUNK / 2 ? nb - base : TOPK_RANK_CHUNK / 2;
+        for (size_t j = 0; j < c; j++) {
+            chunk[2 * j] = bigrams->items[base + j].w1;
+            chunk[2 * j + 1] = bigrams->items[base + j].w2;
+        }
+        if (!dict_get_or_add_batch(&r->dict, chunk, 2 * c, r->bigram_ids + 2 * base)) goto fail;
+    }
+
+    size_t v = dict_size(&r->dict);
+    r->rank_of_id = (uint32_t *)malloc((v ? v : 1) * sizeof(uint32_t));
+    if (!r->rank_of_id || !rank_dict_words(&r->dict, r->rank_of_id)) goto fail;
+    r->n_vocab = v;
+    return 1;
+
+fail:
+    topk_lexrank_free(r);
+    return 0;
+}
+
+void topk_lexrank_free(TopkLexRank *r) {
+    if (!r || !r->live) return;
+    dict_free(&r->dict);
+    free(r->rank_of_id);
+    free(r->word_ids);
+    free(r->bigram_ids);
+    memset(r, 0, sizeof(*r));
+}
+
+/* Ranks of the lists topk_lexrank_init was built from (IDs recorded there). */
+static void cached_ranks(const TopkLexRank *r, const uint32_t *ids, size_t n, uint32_t *out) {
+    for (size_t i = 0; i < n; i++) out[i] = ids[i] ? r->rank_of_id[ids[i] - 1] : 0;
+}
+
+/* Rank + 1 of each word ("" -> 0). 0 if a word is not in the vocabulary. */
+static int lookup_ranks(TopkLexRank *r, const char *const *words, size_t n, uint32_t *out) {
+    for (size_t base = 0; base < n; base += TOPK_RANK_CHUNK) {
+        size_t c = n - base < TOPK_RANK_CHUNK ? n - base : TOPK_RANK_CHUNK;
+        if (!dict_get_or_add_batch(&r->dict, words + base, c, out + base)) return 0;
+        for (size_t j = 0; j < c; j++) {
+            uint32_t id = out[base + j];
+            if (id > r->n_vocab) return 0;  // unknown word
+            out[base + j] = id ? r->rank_of_id[id - 1] : 0;
+        }
+    }
+    return 1;
+}
+
+/* Index order by (count DESC, key ASC); keys are unique rank tuples. */
+static size_t *order_by_count_then_key(const size_t *counts, const uint64_t *keys, size_t n) {
+    size_t *idx = (size_t *)malloc(n * sizeof(size_t));
+    if (!idx) return NULL;
+    for (size_t i = 0; i < n; i++) idx[i] = i;
+
+    if (!radix_order_u64(keys, n, idx) || !order_by_count_desc_stable(counts, n, idx)) {
+        free(idx);
+        return NULL;
+    }
+    return idx;
+}
+
+WordCountList top_k_words_ranked(TopkLexRank *r, const WordCountList *list, size_t k) {
+    WordCountList out = (WordCountList){0};
+    if (!list || !list->items || list->count == 0 || k == 0) return out;
+    if (!r || !r->live || k < list->count) return top_k_words(list, k);
+
+    const char *perf = getenv("PERF_TOPK");
+    uint64_t t0 = perf ? now_ns() : 0;
+
+    size_t n = list->count;
+    const char **words = (const char **)malloc(n * sizeof(*words));
+    uint32_t *ranks = (uint32_t *)malloc(n * sizeof(uint32_t));
+    uint64_t *keys = (uint64_t *)malloc(n * sizeof(uint64_t));
+    size_t *counts = (size_t *)malloc(n * sizeof(size_t));
+    size_t *order = NULL;
+    int fallback = !words || !ranks || !keys || !counts;
+
+    if (!fallback) {
+        for (size_t i = 0; i < n; i++) {
+            words[i] = list->items[i].word;
+            counts[i] = list->items[i].count;
+            if (!words[i]) fallback = 1;  // NULL sorts last; keep the comparator path
+        }
+    }
+    if (!fallback) {
+        if (list == r->src_words) cached_ranks(r, r->word_ids, n, ranks);
+        else fallback = !lookup_ranks(r, words, n, ranks);
+    }
+    if (!fallback) {
+        for (size_t i = 0; i < n; i++) keys[i] = ranks[i];
+        order = order_by_count_then_key(counts, keys, n);
+        fallback = !order;
+    }
+    free(words);
+    free(ranks);
+    free(keys);
+    free(counts);
+    if (fallback) return top_k_words(list, k);
+
+    uint64_t t_sort = perf ? now_ns() : 0;
+
+    out.items = (WordCount *)calloc(n, sizeof(WordCount));
+    if (!out.items) { free(order); return out; }
+    for (size_t i = 0; i < n; i++) {
+        const WordCount *src = &list->items[order[i]];
+        out.items[i].word = str_dup(src->word);
+        out.items[i].count = src->count;
+        out.count = i + 1;
+        if (!out.items[i].word) {
+            free(order);
+            free_word_counts(&out);
+            return (WordCountList){0};
+        }
+    }
+    free(order);
+
+    if (perf) {
+        uint64_t t_out = now_ns();
+        fprintf(stderr,
+            "PERF_TOPK words total_ns=%" PRIu64 " copy_ns=0 sort_ns=%" PRIu64
+            " out_ns=%" PRIu64 " n=%zu k=%zu\n",
+            (t_out - t0), (t_sort - t0), (t_out - t_sort), list->count, k);
+    }
+
+    return out;
+}
+
+BigramCountList top_k_bigrams_ranked(TopkLexRank *r, const BigramCountList *list, size_t k) {
+    BigramCountList out = (BigramCountList){0};
+    if (!list || !list->items || list->count == 0 || k == 0) return out;
+    if (!r || !r->live || k < list->count) return top_k_bigrams(list, k);
+
+    const char *perf = getenv("PERF_TOPK");
+    uint64_t t0 = perf ? now_ns() : 0;
+
+    size_t n = list->count;
+    const char **words = (const char **)malloc(2 * n * sizeof(*words));
+    uint32_t *ranks = (uint32_t *)malloc(2 * n * sizeof(uint32_t));
+    uint64_t *keys = (uint64_t *)malloc(n * sizeof(uint64_t));
+    size_t *counts = (size_t *)malloc(n * sizeof(size_t));
+    size_t *order = NULL;
+    int fallback = !words || !ranks || !keys || !counts;
+
+    if (!fallback) {
+        /* NULL parts compare as "" (same as cmp_bigram_desc_then_lex). */
+        for (size_t i = 0; i < n; i++) {
+            words[2 * i] = list->items[i].w1 ? list->items[i].w1 : "";
+            words[2 * i + 1] = list->items[i].w2 ? list->items[i].w2 : "";
+            counts[i] = list->items[i].count;
+        }
+        if (list == r->src_bigrams) cached_ranks(r, r->bigram_ids, 2 * n, ranks);
+        else fallback = !lookup_ranks(r, words, 2 * n, ranks);
+    }
+    if (!fallback) {
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = ((uint64_t)ranks[2 * i] << 32) | ranks[2 * i + 1];
+        }
+        order = order_by_count_then_key(counts, keys, n);
+        fallback = !order;
+    }
+    free(words);
+    free(ranks);
+    free(keys);
+    free(counts);
+    if (fallback) return top_k_bigrams(list, k);
+
+    uint64_t t_sort = perf ? now_ns() : 0;
+
+    out.items = (BigramCount *)calloc(n, sizeof(BigramCount));
+    if (!out.items) { free(order); return out; }
+    for (size_t i = 0; i < n; i++) {
+        const BigramCount *src = &list->items[order[i]];
+        out.items[i].w1 = str_dup(src->w1);
+        out.items[i].w2 = str_dup(src->w2);
+        out.items[i].count = src->count;
+        out.count = i + 1;
+        if ((src->w1 && !out.items[i].w1) || (src->w2 && !out.items[i].w2)) {
+            free(order);
+            free_bigram_counts(&out);
+            return (BigramCountList){0};
+        }
+    }
+    free(order);
+
+    if (perf) {
+        uint64_t t_out = now_ns();
+        fprintf(stderr,
+            "PERF_TOPK bigrams total_ns=%" PRIu64 " copy_ns=0 sort_ns=%" PRIu64
+            " out_ns=%" PRIu64 " n=%zu k=%zu\n",
+            (t_out - t0), (t_sort - t0), (t_out - t_sort), list->count, k);
+    }
+
+    return out;
+}
+
+/* ---------- Top-K in ID space ---------- */
+
+uint32_t *topk_dict_ranks(Dict *d) {
+    if (!d) return NULL;
+    size_t v = dict_size(d);
+    uint32_t *rank_of_id = (uint32_t *)malloc((v ? v : 1) * sizeof(uint32_t));
+    if (!rank_of_id) return NULL;
+    if (!rank_dict_words(d, rank_of_id)) { free(rank_of_id); return NULL; }
+    return rank_of_id;
+}
+
+/* Number of bits needed to represent v (0 for v == 0). */
+static unsigned bit_width(uint64_t v) {
+    unsigned b = 0;
+    while (v) { b++; v >>= 1; }
+    return b;
+}
+
+static void key_heap_sift_down(const uint64_t *keys, size_t *h, size_t n, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1, m = i;
+        if (l < n && keys[h[l]] > keys[h[m]]) m = l;
+        if (l + 1 < n && keys[h[l + 1]] > keys[h[m]]) m = l + 1;
+        if (m == i) return;
+        size_t t = h[i]; h[i] = h[m]; h[m] = t;
+        i = m;
+    }
+}
+
+/* Indices of the k smallest (unique) keys, ascending: max-heap of the
+ * best k seen so far, then heap sort of the winners. O(n log k).
+ */
+static void select_smallest_keys(const uint64_t *keys, size_t n, size_t k, size_t *sel) {
+    for (size_t i = 0; i < k; i++) sel[i] = i;
+    for (size_t i = k / 2; i-- > 0; ) key_heap_sift_down(keys, sel, k, i);
+
+    for (size_t i = k; i < n; i++) {
+        if (keys[i] < keys[sel[0]]) {
+            sel[0] = i;
+            key_heap_sift_down(keys, sel, k, 0);
+        }
+    }
+    for (size_t end = k; end > 1; end--) {
+        size_t t = sel[0]; sel[0] = sel[end - 1]; sel[end - 1] = t;
+        key_heap_sift_down(keys, sel, end - 1, 0);
+    }
+}
+
+/* Order of the best min(k, n) entries by (count DESC, tie ASC); ties are
+ * unique rank tuples below 2^tie_bits. Count and tie are packed into one
+ * key when they fit 64 bits; otherwise two stable radix passes order all
+ * entries. Returns malloc'd indices (*n_out of them), NULL on OOM.
+ */
+static size_t *order_ids_topk(const uint32_t *counts, const uint64_t *ties, unsigned tie_bits,
+                              size_t n, size_t k, size_t *n_out) {
+    size_t m = (k < n) ? k : n;
+    uint32_t max = 0;
+    for (size_t i = 0; i < n; i++) if (counts[i] > max) max = counts[i];
+
+    size_t *idx = (size_t *)malloc((n ? n : 1) * sizeof(size_t));
+    if (!idx) return NULL;
+
+    if (bit_width(max) + tie_bits <= 64) {
+        uint64_t *keys = (uint64_t *)malloc((n ? n : 1) * sizeof(uint64_t));
+        if (!keys) { free(idx); return NULL; }
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = (tie_bits < 64 ? (uint64_t)(max - counts[i]) << tie_bits : 0) | ties[i];
+        }
+
+        int ok = 1;
+        if (m < n) {
+            select_smallest_keys(keys, n, m, idx);
+        } else {
+            for (size_t i = 0; i < n; i++) idx[i] = i;
+            ok = radix_order_u64(keys, n, idx);
+        }
+        free(keys);
+        if (!ok) { free(idx); return NULL; }
+    } else {
+        size_t *cnt = (size_t *)malloc((n ? n : 1) * sizeof(size_t));
+        if (!cnt) { free(idx); return NULL; }
+        for (size_t i = 0; i < n; i++) { cnt[i] = counts[i]; idx[i] = i; }
+
+        int ok = radix_order_u64(ties, n, idx) && order_by_count_desc_stable(cnt, n, idx);
+        free(cnt);
+        if (!ok) { free(idx); return NULL; }
+    }
+
+    *n_out = m;
+    return idx;
+}
+
+WordCountList top_k_word_ids(const Dict *d, const uint32_t *rank_of_id,
+                             const IdCountList *list, size_t k) {
+    WordCountList out = (WordCountList){0};
+    if (!d || !rank_of_id || !list || !list->items || list->count == 0 || k == 0) return out;
+
+    const char *perf = getenv("PERF_TOPK");
+    uint64_t t0 = perf ? now_ns() : 0;
+
+    size_t n = list->count;
+    uint32_t *counts = (uint32_t *)malloc(n * sizeof(uint32_t));
+    uint64_t *ties = (uint64_t *)malloc(n * sizeof(uint64_t));
+    if (!counts || !ties) { free(counts); free(ties); return out; }
+
+    for (size_t i = 0; i < n; i++) {
+        counts[i] = list->items[i].count;
+        ties[i] = rank_of_id[list->items[i].id - 1];
+    }
+
+    size_t m = 0;
+    size_t *order = order_ids_topk(counts, ties, bit_width(dict_size(d)), n, k, &m);
+    free(counts);
+    free(ties);
+    if (!order) return out;
+
+    uint64_t t_sort = perf ? now_ns() : 0;
+
+    /* Materialization: only the selected entries become strings. */
+    out.items = (WordCount *)calloc(m ? m : 1, sizeof(WordCount));
+    if (!out.items) { free(order); return out; }
+    for (size_t i = 0; i < m; i++) {
+        const IdCount *src = &list->items[order[i]];
+        out.items[i].word = str_dup(dict_word(d, src->id));
+        out.items[i].count = src->count;
+        out.count = i + 1;
+        if (!out.items[i].word) {
+            free(order);
+            free_word_counts(&out);
+            return (WordCountList){0};
+        }
+    }
+    free(order);
+
+    if (perf) {
+        uint64_t t_out = now_ns();
+        fprintf(stderr,
+            "PERF_TOPK words total_ns=%" PRIu64 " copy_ns=0 sort_ns=%" PRIu64
+            " out_ns=%" PRIu64 " n=%zu k=%zu\n",
+            (t_out - t0), (t_sort - t0), (t_out - t_sort), list->count, k);
+    }
+
+    return out;
+}
+
+BigramCountList top_k_bigram_ids(const Dict *d, const uint32_t *rank_of_id,
+                                 const IdPairCountList *list, size_t k) {
+    BigramCountList out = (BigramCountList){0};
+    if (!d || !rank_of_id || !list || !list->items || list->count == 0 || k == 0) return out;
+
+    const char *perf = getenv("PERF_TOPK");
+    uint64_t t0 = perf ? now_ns() : 0;
+
+    size_t n = list->count;
+    uint32_t *counts = (uint32_t *)malloc(n * sizeof(uint32_t));
+    uint64_t *ties = (uint64_t *)malloc(n * sizeof(uint64_t));
+    if (!counts || !ties) { free(counts); free(ties); return out; }
+
+    /* Tie key: (rank(w1), rank(w2)), each in bits-wide halves. */
+    unsigned bits = bit_width(dict_size(d));
+    for (size_t i = 0; i < n; i++) {
+        const IdPairCount *pc = &list->items[i];
+        counts[i] = pc->count;
+        ties[i] = ((uint64_t)rank_of_id[pc->id1 - 1] << bits) | rank_of_id[pc->id2 - 1];
+    }
+
+    size_t m = 0;
+    size_t *order = order_ids_topk(counts, ties, 2 * bits, n, k, &m);
+    free(counts);
+    free(ties);
+    if (!order) return out;
+
+    uint64_t t_sort = perf ? now_ns() : 0;
+
+    out.items = (BigramCount *)calloc(m ? m : 1, sizeof(BigramCount));
+    if (!out.items) { free(order); return out; }
+    for (size_t i = 0; i < m; i++) {
+        const IdPairCount *src = &list->items[order[i]];
+        out.items[i].w1 = str_dup(dict_word(d, src->id1));
+        out.items[i].w2 = str_dup(dict_word(d, src->id2));
+        out.items[i].count = src->count;
+        out.count = i + 1;
+        if (!out.items[i].w1 || !out.items[i].w2) {
+            free(order);
+            free_bigram_counts(&out);
+            return (BigramCountList){0};
+        }
+    }
+    free(order);
+
+    if (perf) {
+        uint64_t t_out = now_ns();
+        fprintf(stderr,
+            "PERF_TOPK bigrams total_ns=%" PRIu64 " copy_ns=0 sort_ns=%" PRIu64
+            " out_ns=%" PRIu64 " n=%zu k=%zu\n",
+            (t_out - t0), (t_sort - t0), (t_out - t_sort), list->count, k);
+    }
+
+    return out;
+}
+
+int top_k_tfidf(const Dict *d, const uint32_t *rank_of_id, const IdDocFreq *f,
+                size_t k, TfidfList *out) {
+    if (!d || !rank_of_id || !f || !out) return 0;
+    *out = (TfidfList){0};
+
+    size_t v = dict_size(d);
+    if (v > f->tf.cap) v = f->tf.cap;
+    size_t n = 0;
+    double max = 0.0;
+    for (size_t i = 0; i < v; i++) {
+        uint32_t tf = f->tf.counts[i];
+        if (!tf) continue;
+        double s = (double)tf * iddf_idf(f, idfreq_get(&f->df, (uint32_t)(i + 1)));
+        if (s > max) max = s;
+        n++;
+    }
+    if (n == 0 || k == 0) return 1;
+
+    uint32_t *keys = (uint32_t *)malloc(n * sizeof(uint32_t));
+    uint64_t *ties = (uint64_t *)malloc(n * sizeof(uint64_t));
+    uint32_t *ids = (uint32_t *)malloc(n * sizeof(uint32_t));
+    if (!keys || !ties || !ids) { free(keys); free(ties); free(ids); return 0; }
+
+    /* Score keys in [0, 2^32): equal (tf, df) give equal keys, so ties
+     * fall back to the lexicographic rank as in every other list.
+     */
+    size_t j = 0;
+    for (size_t i = 0; i < v; i++) {
+        uint32_t tf = f->tf.counts[i];
+        if (!tf) continue;
+        double s = (double)tf * iddf_idf(f, idfreq_get(&f->df, (uint32_t)(i + 1)));
+        keys[j] = (uint32_t)(s / max * 4294967295.0 + 0.5);
+        ties[j] = rank_of_id[i];
+        ids[j] = (uint32_t)(i + 1);
+        j++;
+    }
+
+    size_t m = 0;
+    size_t *order = order_ids_topk(keys, ties, bit_width(dict_size(d)), n, k, &m);
+    free(keys);
+    free(ties);
+    if (!order) { free(ids); return 0; }
+
+    out->items = (TfidfEntry *)calloc(m ? m : 1, sizeof(TfidfEntry));
+    if (!out->items) { free(order); free(ids); return 0; }
+    for (size_t i = 0; i < m; i++) {
+        uint32_t id = ids[order[i]];
+        TfidfEntry *e = &out->items[i];
+        e->word = str_dup(dict_word(d, id));
+        e->count = idfreq_get(&f->tf, id);
+        e->df = idfreq_get(&f->df, id);
+        e->idf = iddf_idf(f, e->df);
+        e->score = (double)e->count * e->idf;
+        out->count = i + 1;
+        if (!e->word) {
+            free(order);
+            free(ids);
+            free_tfidf_list(out);
+            return 0;
+        }
+    }
+    free(order);
+    free(ids);
+    return 1;
+}
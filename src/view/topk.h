@@ -5,6 +5,10 @@
 
 #include "core/freq.h"
 #include "core/bigrams.h"
+#include "core/dict.h"
+#include "core/id_freq.h"
+#include "core/id_bigrams.h"
+#include "core/id_docfreq.h"
 
 /*
  * Top-K view layer.
@@ -15,6 +19,9 @@
  * - apply deterministic tie-breaking (lexicographic ASC),
  * - return a NEW deep-copied list limited to k elements.
  *
+ * Selection works on pointers (bounded heap, O(n log k)); only the k
+ * returned entries are copied.
+ *
  * Important:
  * - k == 0 is interpreted by the caller as "FULL" and therefore
  *   typically passed as list->count.
@@ -27,6 +34,65 @@ WordCountList top_k_words(const WordCountList *list, size_t k);
 // Bigrams: sort by count desc, then w1 asc, then w2 asc.
 BigramCountList top_k_bigrams(const BigramCountList *list, size_t k);
 
+/*
+ * Variants for input lists that are already in tie-break order
+ * (word ASC / w1,w2 ASC, e.g. ART engine output): a stable radix pass
+ * over the counts replaces the strcmp-based qsort, and only the k
+ * returned items are copied.
+ */
+WordCountList top_k_words_lexsorted(const WordCountList *list, size_t k);
+BigramCountList top_k_bigrams_lexsorted(const BigramCountList *list, size_t k);
+
+/*
+ * FULL ordering (k >= list->count, e.g. top_k = 0 in CLI/batch runs).
+ * The distinct words of the domain lists are sorted once (multikey
+ * quicksort); lists are then ordered by integer keys (count DESC,
+ * rank ASC) with radix/counting sorts instead of strcmp-based qsort.
+ * Same output as top_k_*; partial k and words outside the vocabulary
+ * fall back to top_k_*.
+ */
+typedef struct {
+    Dict dict;             // word -> id
+    uint32_t *rank_of_id;  // index id - 1: lexicographic rank + 1
+    size_t n_vocab;        // distinct words ranked
+
+    /* Source lists and their word IDs (no lookups when ordering them). */
+    const WordCountList *src_words;
+    const BigramCountList *src_bigrams;
+    uint32_t *word_ids;    // per src_words item
+    uint32_t *bigram_ids;  // w1, w2 per src_bigrams item
+    int live;
+} TopkLexRank;
+
+/* Rank all words of the (domain) lists; bigrams may be NULL. 0 on OOM. */
+int topk_lexrank_init(TopkLexRank *r, const WordCountList *words, const BigramCountList *bigrams);
+void topk_lexrank_free(TopkLexRank *r);
+
+WordCountList top_k_words_ranked(TopkLexRank *r, const WordCountList *list, size_t k);
+BigramCountList top_k_bigrams_ranked(TopkLexRank *r, const BigramCountList *list, size_t k);
+
+/*
+ * Top-K in ID space (ID engine): lists are (id, count) / (id1, id2, count)
+ * arrays over one Dict, ties ordered by a precomputed lexicographic rank
+ * per ID (topk_dict_ranks, index id - 1, malloc'd). Selection compares
+ * packed integer keys; only the k returned entries become strings.
+ * Same output order as top_k_*; k is resolved by the caller.
+ */
+uint32_t *topk_dict_ranks(Dict *d);
+WordCountList top_k_word_ids(const Dict *d, const uint32_t *rank_of_id,
+                             const IdCountList *list, size_t k);
+BigramCountList top_k_bigram_ids(const Dict *d, const uint32_t *rank_of_id,
+                                 const IdPairCountList *list, size_t k);
+
+/*
+ * TF-IDF ranking (options.tfidf): every ID with tf > 0 is scored as
+ * tf * idf; scores are quantized to 32-bit keys relative to the maximum
+ * and selected like top_k_word_ids (ties by rank). Only the k returned
+ * entries become strings. 0 on OOM.
+ */
+int top_k_tfidf(const Dict *d, const uint32_t *rank_of_id, const IdDocFreq *f,
+                size_t k, TfidfList *out);
+
 // Free helpers (mirror free_word_counts / free_bigram_counts).
 void free_top_k_words(WordCountList *list);
 void free_top_k_bigrams(BigramCountList *list);
@@ -0,0 +1,136 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# -------------------------------------------------------------------
+# run_perf_adversarial.sh
+#
+# Worst-case latency under hostile inputs (CLI, per pipeline):
+# - giant_token:  one multi-MB token without any separator
+# - long_tokens:  many tokens just above/below the token length cap
+# - fnv_collide:  tokens whose unseeded FNV-1a hashes share the low
+#                 COLLIDE_BITS bits (Joux multicollision, 4-char blocks);
+#                 forces one long probe chain in an unseeded Dict
+# - baseline:     ordinary text of similar size (reference)
+#
+# Reports per case the max and avg runtime_ms_analyze over RUNS.
+#
+# Override via env vars:
+#   BIN, OUT_DIR, RUNS, TIMEOUT_SEC, GIANT_MB, COLLIDE_STAGES, COLLIDE_BITS,
+#   MAX_TOKEN_LEN (--max-token-len, default 256 like the API; 0 = no cap),
+#   PIPELINES (space-separated, default "string id"; "all" = every registered engine)
+# -------------------------------------------------------------------
+
+BIN="${BIN:-build/analyze_cli}"
+OUT_DIR="${OUT_DIR:-tests/performance/results}"
+RUNS="${RUNS:-5}"
+TIMEOUT_SEC="${TIMEOUT_SEC:-60}"
+GIANT_MB="${GIANT_MB:-8}"
+COLLIDE_STAGES="${COLLIDE_STAGES:-12}"   # 2^stages colliding tokens
+COLLIDE_BITS="${COLLIDE_BITS:-20}"
+PIPELINES="${PIPELINES:-string id}"
+MAX_TOKEN_LEN="${MAX_TOKEN_LEN:-256}"
+
+PY="$(command -v python3 || command -v python)"
+
+have() { command -v "$1" >/dev/null 2>&1; }
+
+run_with_timeout() {
+  local seconds="$1"; shift
+  if have timeout; then timeout "${seconds}s" "$@"; return $?
+  elif have gtimeout; then gtimeout "${seconds}s" "$@"; return $?
+  else "$@"; return $?
+  fi
+}
+
+if [ ! -x "$BIN" ]; then
+  echo "[ERROR] BIN '$BIN' not found or not executable. Set BIN=... (e.g. BIN=build/analyze_cli)" >&2
+  exit 2
+fi
+
+if [ "$PIPELINES" = "all" ]; then
+  PIPELINES="$("$BIN" pipelines | tr '\n' ' ')"
+fi
+
+mkdir -p "$OUT_DIR"
+ts="$(date +%Y%m%d-%H%M%S)"
+CSV="$OUT_DIR/perf_cli_adversarial_${ts}.csv"
+
+DATA_DIR="$(mktemp -d)"
+trap 'rm -rf "$DATA_DIR"' EXIT
+
+echo "[INFO] Generating inputs in $DATA_DIR"
+"$PY" - "$DATA_DIR" "$GIANT_MB" "$COLLIDE_STAGES" "$COLLIDE_BITS" <<'PY'
+import itertools, json, os, random, string, sys
+
+out, giant_mb, stages, bits = sys.argv[1], int(sys.argv[2]), int(sys.argv[3]), int(sys.argv[4])
+mask = (1 << bits) - 1
+FNV_OFF, FNV_PRIME = 1469598103934665603, 1099511628211
+rnd = random.Random(42)
+
+def write(name, text):
+    with open(os.path.join(out, name), "w", encoding="utf-8") as f:
+        json.dump({"pages": [{"text": text}]}, f)
+
+# Low bits of FNV-1a only depend on low bits of the state, so collisions
+# can be searched in `bits` bits and chained block by block.
+def step(h, block):
+    for ch in block.encode():
+        h = ((h ^ ch) * FNV_PRIME) & mask
+    return h
+
+def colliding_blocks(h):
+    seen = {}
+    while True:
+        b = "".join(rnd.choice(string.ascii_lowercase) for _ in range(4))
+        v = step(h, b)
+        if v in seen and seen[v] != b:
+            return seen[v], b, v
+        seen[v] = b
+
+h = FNV_OFF & mask
+pairs = []
+for _ in range(stages):
+    a, b, h = colliding_blocks(h)
+    pairs.append((a, b))
+words = ["".join(c) for c in itertools.product(*pairs)]
+rnd.shuffle(words)
+write("fnv_collide.json", " ".join(words * 3))
+
+write("giant_token.json", "a" * (giant_mb * 1024 * 1024))
+
+long_words = ["".join(rnd.choice(string.ascii_lowercase) for _ in range(rnd.choice((250, 260, 1000))))
+              for _ in range(20000)]
+write("long_tokens.json", " ".join(long_words))
+
+vocab = ["".join(rnd.choice(string.ascii_lowercase) for _ in range(rnd.randint(3, 10))) for _ in range(5000)]
+write("baseline.json", " ".join(rnd.choice(vocab) for _ in range(len(words) * 3)))
+PY
+
+echo "case,bytes,pipeline,runs,ok,max_runtime_ms_analyze,avg_runtime_ms_analyze" > "$CSV"
+
+for f in "$DATA_DIR"/*.json; do
+  base="$(basename "$f" .json)"
+  sz="$(stat -c%s "$f" 2>/dev/null || stat -f%z "$f" 2>/dev/null || echo 0)"
+
+  for pipeline in $PIPELINES; do
+    vals="$(mktemp)"
+    for i in $(seq 1 "$RUNS"); do
+      out="$(run_with_timeout "$TIMEOUT_SEC" "$BIN" "$f" --pipeline "$pipeline" --max-token-len "$MAX_TOKEN_LEN" 2>/dev/null)" || {
+        echo "[FAIL] $base pipeline=$pipeline run=$i" >&2
+        continue
+      }
+      printf "%s\n" "$out" | tr -d '\r' | awk -F= '/^runtime_ms_analyze=/{print $2; exit}' >> "$vals"
+    done
+
+    ok="$(wc -l < "$vals" | tr -d ' ')"
+    max="$(awk 'BEGIN{m="NA"} {if(m=="NA"||$1>m)m=$1} END{print m}' "$vals")"
+    avg="$(awk '{s+=$1;n+=1} END{ if(n==0) print "NA"; else printf "%.3f", (s/n) }' "$vals")"
+    rm -f "$vals"
+
+    echo "[INFO] $base pipeline=$pipeline max=${max}ms avg=${avg}ms" >&2
+    echo "$base,$sz,$pipeline,$RUNS,$ok,$max,$avg" >> "$CSV"
+  done
+done
+
+echo
+echo "[DONE] CSV: $CSV"
@@ -23,6 +23,8 @@ set -euo pipefail
 # Usage examples:
 #   API_URL=http://127.0.0.1:8080/analyze RUNS=5 WARMUP=1 bash tests/performance/scripts/run_perf_tests_dual_pipelines.sh
 #   CLI_JSON_ARGS="--json" bash tests/performance/scripts/run_perf_tests_dual_pipelines.sh
+#   PIPELINES="id sort" bash tests/performance/scripts/run_perf_tests_dual_pipelines.sh   # hash vs sort engine
+#   PIPELINES=all bash tests/performance/scripts/run_perf_tests_dual_pipelines.sh         # every registered engine
 # -------------------------------
 
 # --- JSON parser (portable) ---
@@ -67,8 +69,11 @@ API_URL="${API_URL:-http://127.0.0.1:8080/analyze}"
 RUNS="${RUNS:-5}"
 WARMUP="${WARMUP:-1}"
 
-# Which pipelines to test (space-separated)
+# Which pipelines to test (space-separated; "all" = engines registered in BIN)
 PIPELINES="${PIPELINES:-string id}"
+if [ "$PIPELINES" = "all" ]; then
+  PIPELINES="$("$BIN" pipelines | tr '\n' ' ')"
+fi
 
 mkdir -p "$OUT_DIR"
 echo "pipeline,file,metric,median_ms,min_ms,max_ms,runs,comment" > "$OUT_FILE_CLI"
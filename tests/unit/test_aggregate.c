@@ -2,6 +2,13 @@
 
 #include "core/freq.h"
 #include "core/aggregate.h"
+#include "core/bigram_aggregate.h"
+#include "core/aggregate_ta.h"
+#include "view/topk.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 void test_aggregate_g5_basic(void) {
     // list1: apfel(2), banane(1)
@@ -28,3 +35,91 @@ void test_aggregate_g5_basic(void) {
 
     free_aggregated_word_counts(&agg);
 }
+
+static int cmp_word(const void *a, const void *b) {
+    return strcmp(((const WordCount *)a)->word, ((const WordCount *)b)->word);
+}
+
+void test_aggregate_threshold_topk_matches_full(void) {
+    // 8 Seiten mit Zipf-artigen Zählungen: wenige häufige, viele seltene Wörter
+    enum { PAGES = 8, WORDS = 400 };
+    static char names[WORDS][8];
+    static WordCount items[PAGES][WORDS];
+    static BigramCount bitems[PAGES][WORDS];
+    WordCountList pages[PAGES];
+    BigramCountList bpages[PAGES];
+
+    for (int w = 0; w < WORDS; w++) snprintf(names[w], sizeof(names[w]), "w%03d", (w * 37) % WORDS);
+    unsigned seed = 7;
+    for (int p = 0; p < PAGES; p++) {
+        size_t n = 0;
+        for (int w = 0; w < WORDS; w++) {
+            seed = seed * 1103515245u + 12345u;
+            if ((seed >> 16) % 3 == 0) continue;  // Wort fehlt auf dieser Seite
+            size_t c = 1 + (size_t)(600 / (w + 1)) + (seed >> 20) % 2;
+            items[p][n] = (WordCount){.word = names[w], .count = c};
+            bitems[p][n] = (BigramCount){.w1 = names[w], .w2 = names[(w + p) % 5], .count = c};
+            n++;
+        }
+        pages[p] = (WordCountList){.items = items[p], .count = n};
+        bpages[p] = (BigramCountList){.items = bitems[p], .count = n};
+    }
+
+    WordCountList agg = aggregate_word_counts(pages, PAGES);
+    BigramCountList bagg = aggregate_bigram_counts(bpages, PAGES);
+
+    const size_t ks[] = { 1, 5, 20 };
+    for (size_t t = 0; t < 3; t++) {
+        WordCountList ref = top_k_words(&agg, ks[t]);
+        WordCountList ta = (WordCountList){0};
+        TEST_ASSERT_TRUE(aggregate_top_k_words_ta(pages, PAGES, false, ks[t], &ta));
+        TEST_ASSERT_EQUAL_UINT((unsigned)ref.count, (unsigned)ta.count);
+        for (size_t i = 0; i < ref.count; i++) {
+            TEST_ASSERT_EQUAL_STRING(ref.items[i].word, ta.items[i].word);
+            TEST_ASSERT_EQUAL_UINT((unsigned)ref.items[i].count, (unsigned)ta.items[i].count);
+        }
+        free_top_k_words(&ref);
+        free_top_k_words(&ta);
+
+        BigramCountList bref = top_k_bigrams(&bagg, ks[t]);
+        BigramCountList bta = (BigramCountList){0};
+        TEST_ASSERT_TRUE(aggregate_top_k_bigrams_ta(bpages, PAGES, false, ks[t], &bta));
+        TEST_ASSERT_EQUAL_UINT((unsigned)bref.count, (unsigned)bta.count);
+        for (size_t i = 0; i < bref.count; i++) {
+            TEST_ASSERT_EQUAL_STRING(bref.items[i].w1, bta.items[i].w1);
+            TEST_ASSERT_EQUAL_STRING(bref.items[i].w2, bta.items[i].w2);
+            TEST_ASSERT_EQUAL_UINT((unsigned)bref.items[i].count, (unsigned)bta.items[i].count);
+        }
+        free_top_k_bigrams(&bref);
+        free_top_k_bigrams(&bta);
+    }
+
+    // Nach Wort sortierte Seiten (wie ART): Direktzugriff per binärer Suche
+    for (int p = 0; p < PAGES; p++) qsort(items[p], pages[p].count, sizeof(WordCount), cmp_word);
+    WordCountList ref = top_k_words(&agg, 20);
+    WordCountList ta = (WordCountList){0};
+    TEST_ASSERT_TRUE(aggregate_top_k_words_ta(pages, PAGES, true, 20, &ta));
+    TEST_ASSERT_EQUAL_UINT((unsigned)ref.count, (unsigned)ta.count);
+    for (size_t i = 0; i < ref.count; i++) {
+        TEST_ASSERT_EQUAL_STRING(ref.items[i].word, ta.items[i].word);
+        TEST_ASSERT_EQUAL_UINT((unsigned)ref.items[i].count, (unsigned)ta.items[i].count);
+    }
+    free_top_k_words(&ref);
+    free_top_k_words(&ta);
+
+    free_aggregated_word_counts(&agg);
+    free_aggregated_bigram_counts(&bagg);
+
+    // Flache Verteilung (alle Zählungen 1, disjunkte Seiten): keine Konvergenz
+    WordCount flat[4][2] = {
+        {{.word = "a", .count = 1}, {.word = "b", .count = 1}},
+        {{.word = "c", .count = 1}, {.word = "d", .count = 1}},
+        {{.word = "e", .count = 1}, {.word = "f", .count = 1}},
+        {{.word = "g", .count = 1}, {.word = "h", .count = 1}},
+    };
+    WordCountList flat_pages[4];
+    for (int p = 0; p < 4; p++) flat_pages[p] = (WordCountList){.items = flat[p], .count = 2};
+    WordCountList none = (WordCountList){0};
+    TEST_ASSERT_FALSE(aggregate_top_k_words_ta(flat_pages, 4, true, 2, &none));
+    TEST_ASSERT_EQUAL_UINT(0, (unsigned)none.count);
+}
@@ -0,0 +1,797 @@
+#include "unity.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/arena.h"
+#include "core/cancel.h"
+#include "core/dict.h"
+#include "core/id_bigrams.h"
+#include "core/id_freq.h"
+#include "core/table_alloc.h"
+#include "core/art.h"
+#include "core/heavy_hitters.h"
+#include "core/id_ngrams.h"
+#include "core/id_cooc.h"
+#include "core/stem_de.h"
+#include "core/tokenizer.h"
+#include "core/id_sort.h"
+#include "view/topk.h"
+
+void test_dict_ids_stable_across_incremental_rehash(void) {
+    Dict d;
+    TEST_ASSERT_TRUE(dict_init(&d, 16));
+
+    char buf[32];
+    for (unsigned i = 0; i < 5000; i++) {
+        snprintf(buf, sizeof(buf), "wort%u", i);
+        TEST_ASSERT_EQUAL_UINT(i + 1, dict_get_or_add(&d, buf));
+
+        // Lookups of earlier words must hit while migration is in progress.
+        if (i % 7 == 0) {
+            snprintf(buf, sizeof(buf), "wort%u", i / 2);
+            TEST_ASSERT_EQUAL_UINT(i / 2 + 1, dict_get_or_add(&d, buf));
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT(5000, (unsigned)dict_size(&d));
+    TEST_ASSERT_EQUAL_STRING("wort0", dict_word(&d, 1));
+    TEST_ASSERT_EQUAL_STRING("wort4999", dict_word(&d, 5000));
+
+    dict_free(&d);
+}
+
+// Kette, die im alten Table über das Tabellenende läuft: nach der Migration
+// des Anfangs muss die Suche hinter dem geleerten Präfix weiterlaufen
+void test_dict_ids_stable_when_old_chain_wraps(void) {
+    enum { CAP = 1024, WRAP = 20 };
+    Dict d;
+    TEST_ASSERT_TRUE(dict_init(&d, CAP));
+    TEST_ASSERT_EQUAL_UINT(CAP, (unsigned)d.cap);
+
+    // Wörter mit Heimat im letzten Bucket: belegt CAP-1, dann 0..WRAP-2
+    char wrap[WRAP][32];
+    char buf[32];
+    unsigned found = 0;
+    for (unsigned i = 0; found < WRAP; i++) {
+        snprintf(buf, sizeof(buf), "rand%u", i);
+        if (dict_bucket(&d, buf) != CAP - 1) continue;
+        memcpy(wrap[found], buf, sizeof(buf));
+        TEST_ASSERT_EQUAL_UINT(found + 1, dict_get_or_add(&d, wrap[found]));
+        found++;
+    }
+
+    // Auffüllen bis zum Wachstum; der Rehash beginnt bei Bucket 0
+    for (unsigned i = 0; !d.old_entries; i++) {
+        snprintf(buf, sizeof(buf), "fuell%u", i);
+        TEST_ASSERT_TRUE(dict_get_or_add(&d, buf) != 0);
+    }
+    TEST_ASSERT_EQUAL_UINT(0, (unsigned)d.rehash_pos);
+    size_t size = dict_size(&d);
+
+    // Erster Aufruf migriert 0..15; das letzte Wort liegt dahinter
+    TEST_ASSERT_EQUAL_UINT(WRAP, dict_get_or_add(&d, wrap[WRAP - 1]));
+    TEST_ASSERT_TRUE(d.rehash_pos > 0 && d.rehash_pos < WRAP - 2);
+    TEST_ASSERT_NOT_NULL(d.old_entries);
+    for (unsigned k = 0; k < WRAP; k++) TEST_ASSERT_EQUAL_UINT(k + 1, dict_get_or_add(&d, wrap[k]));
+    TEST_ASSERT_EQUAL_UINT((unsigned)size, (unsigned)dict_size(&d));
+
+    dict_free(&d);
+}
+
+void test_idbigrams_counts_across_incremental_rehash(void) {
+    IdBigrams b;
+    TEST_ASSERT_TRUE(idbigrams_init(&b, 64));
+
+    // 100 x 50 distinct pairs, each counted 3 times in different orders.
+    for (int round = 0; round < 3; round++) {
+        for (uint32_t a = 1; a <= 100; a++) {
+            for (uint32_t c = 1; c <= 50; c++) {
+                uint32_t id1 = (round == 1) ? 101 - a : a;
+                TEST_ASSERT_TRUE(idbigrams_inc(&b, id1, c));
+            }
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT(5000, (unsigned)b.size);
+
+    size_t seen = 0, cursor = 0;
+    uint32_t id1, id2, count;
+    while (idbigrams_next(&b, &cursor, &id1, &id2, &count)) {
+        TEST_ASSERT_EQUAL_UINT(3, count);
+        seen++;
+    }
+    TEST_ASSERT_EQUAL_UINT(5000, (unsigned)seen);
+
+    idbigrams_free(&b);
+}
+
+// Wie beim Dict: Paar in einer umlaufenden Kette des alten Tables wird
+// weitergezählt statt ein zweites Mal angelegt
+void test_idbigrams_counts_when_old_chain_wraps(void) {
+    enum { CAP = 1024, WRAP = 20 };
+    IdBigrams b;
+    TEST_ASSERT_TRUE(idbigrams_init(&b, CAP));
+    TEST_ASSERT_EQUAL_UINT(CAP, (unsigned)b.cap);
+
+    uint32_t wrap[WRAP];
+    unsigned found = 0;
+    for (uint32_t j = 1; found < WRAP; j++) {
+        if (idbigrams_bucket(&b, 1, j) != CAP - 1) continue;
+        wrap[found++] = j;
+        TEST_ASSERT_TRUE(idbigrams_inc(&b, 1, j));
+    }
+
+    for (uint32_t j = 1; !b.old_keys; j++) TEST_ASSERT_TRUE(idbigrams_inc(&b, 2, j));
+    TEST_ASSERT_EQUAL_UINT(0, (unsigned)b.rehash_pos);
+    size_t size = b.size;
+
+    TEST_ASSERT_TRUE(idbigrams_inc(&b, 1, wrap[WRAP - 1]));
+    TEST_ASSERT_TRUE(b.rehash_pos > 0 && b.rehash_pos < WRAP - 2);
+    TEST_ASSERT_NOT_NULL(b.old_keys);
+    for (unsigned k = 0; k + 1 < WRAP; k++) TEST_ASSERT_TRUE(idbigrams_inc(&b, 1, wrap[k]));
+    TEST_ASSERT_EQUAL_UINT((unsigned)size, (unsigned)b.size);
+
+    // Jedes Paar genau einmal, mit Zählung 2
+    size_t cursor = 0, seen = 0;
+    uint32_t id1, id2, count;
+    while (idbigrams_next(&b, &cursor, &id1, &id2, &count)) {
+        if (id1 != 1) continue;
+        TEST_ASSERT_EQUAL_UINT(2, count);
+        seen++;
+    }
+    TEST_ASSERT_EQUAL_UINT(WRAP, (unsigned)seen);
+
+    idbigrams_free(&b);
+}
+
+void test_idbigrams_widens_keys_for_large_ids(void) {
+    IdBigrams b;
+    TEST_ASSERT_TRUE(idbigrams_init(&b, 64));
+    TEST_ASSERT_EQUAL_UINT(4, b.key_bytes);
+
+    // Narrow keys first, then IDs beyond 16 bits force the 8-byte layout.
+    for (uint32_t i = 1; i <= 2000; i++) TEST_ASSERT_TRUE(idbigrams_inc(&b, i, i + 1));
+    TEST_ASSERT_EQUAL_UINT(4, b.key_bytes);
+    TEST_ASSERT_TRUE(idbigrams_inc(&b, 70000, 1));
+    TEST_ASSERT_TRUE(idbigrams_inc(&b, 1, 70000));
+    TEST_ASSERT_EQUAL_UINT(8, b.key_bytes);
+    for (uint32_t i = 1; i <= 2000; i++) TEST_ASSERT_TRUE(idbigrams_inc(&b, i, i + 1));
+    TEST_ASSERT_TRUE(idbigrams_inc(&b, 70000, 1));
+
+    size_t seen = 0, cursor = 0;
+    uint32_t id1, id2, count;
+    while (idbigrams_next(&b, &cursor, &id1, &id2, &count)) {
+        if (id1 == 70000) {
+            TEST_ASSERT_EQUAL_UINT(1, id2);
+            TEST_ASSERT_EQUAL_UINT(2, count);
+        } else if (id2 == 70000) {
+            TEST_ASSERT_EQUAL_UINT(1, id1);
+            TEST_ASSERT_EQUAL_UINT(1, count);
+        } else {
+            TEST_ASSERT_EQUAL_UINT(id1 + 1, id2);
+            TEST_ASSERT_EQUAL_UINT(2, count);
+        }
+        seen++;
+    }
+    TEST_ASSERT_EQUAL_UINT(2002, (unsigned)seen);
+
+    idbigrams_free(&b);
+}
+
+typedef struct {
+    unsigned char prev[300];
+    size_t prev_len;
+    size_t seen;
+} ArtOrderCheck;
+
+static int check_art_order(void *ctx, const unsigned char *key, size_t len, uint32_t count) {
+    ArtOrderCheck *c = (ArtOrderCheck *)ctx;
+    if (c->seen > 0) {
+        size_t m = len < c->prev_len ? len : c->prev_len;
+        int r = memcmp(c->prev, key, m);
+        TEST_ASSERT_TRUE(r < 0 || (r == 0 && c->prev_len < len));
+    }
+    TEST_ASSERT_TRUE(count > 0);
+    TEST_ASSERT_TRUE(len <= sizeof(c->prev));
+    memcpy(c->prev, key, len);
+    c->prev_len = len;
+    c->seen++;
+    return 1;
+}
+
+void test_art_prefix_keys_and_ordered_iteration(void) {
+    ArtTree t;
+    art_init(&t);
+
+    // Prefix chains, splits inside compressed paths and a 256-way fan-out.
+    const char *words[] = { "haus", "hausboot", "haustür", "hau", "h", "hausbootsteg",
+                            "donaudampfschifffahrtsgesellschaft", "donau", "donaudampf" };
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        TEST_ASSERT_TRUE(art_inc(&t, (const unsigned char *)words[i], strlen(words[i])));
+    }
+    TEST_ASSERT_TRUE(art_inc(&t, (const unsigned char *)"haus", 4));
+    unsigned char key[2] = { 'x', 0 };
+    for (unsigned b = 0; b < 256; b++) {
+        key[1] = (unsigned char)b;
+        TEST_ASSERT_TRUE(art_inc(&t, key, 2));
+    }
+    unsigned char long_key[280];
+    memset(long_key, 'q', sizeof(long_key));
+    TEST_ASSERT_TRUE(art_inc(&t, long_key, sizeof(long_key)));
+    TEST_ASSERT_TRUE(art_inc(&t, long_key, sizeof(long_key) - 1));
+
+    TEST_ASSERT_EQUAL_UINT(9 + 256 + 2, (unsigned)t.size);
+    TEST_ASSERT_EQUAL_UINT(2, art_get(&t, (const unsigned char *)"haus", 4));
+    TEST_ASSERT_EQUAL_UINT(1, art_get(&t, (const unsigned char *)"hau", 3));
+    TEST_ASSERT_EQUAL_UINT(0, art_get(&t, (const unsigned char *)"ha", 2));
+    TEST_ASSERT_EQUAL_UINT(0, art_get(&t, (const unsigned char *)"hausb", 5));
+    TEST_ASSERT_EQUAL_UINT(1, art_get(&t, long_key, sizeof(long_key)));
+    key[1] = 0;
+    TEST_ASSERT_EQUAL_UINT(1, art_get(&t, key, 2));
+
+    ArtOrderCheck c = {0};
+    TEST_ASSERT_TRUE(art_iter(&t, check_art_order, &c));
+    TEST_ASSERT_EQUAL_UINT((unsigned)t.size, (unsigned)c.seen);
+
+    art_free(&t);
+}
+
+void test_idfreq_grows_across_mmap_threshold(void) {
+    IdFreq f;
+    TEST_ASSERT_TRUE(idfreq_init(&f, 16));
+
+    // Crosses TABLE_MMAP_THRESHOLD_BYTES (heap -> mapped -> remapped).
+    uint32_t max_id = (uint32_t)(TABLE_MMAP_THRESHOLD_BYTES / sizeof(uint32_t)) * 3;
+    for (uint32_t id = 1; id <= max_id; id += 997) {
+        TEST_ASSERT_TRUE(idfreq_inc(&f, id));
+        TEST_ASSERT_TRUE(idfreq_inc(&f, id));
+    }
+
+    for (uint32_t id = 1; id <= max_id; id += 997) {
+        TEST_ASSERT_EQUAL_UINT(2, idfreq_get(&f, id));
+        TEST_ASSERT_EQUAL_UINT(0, idfreq_get(&f, id + 1));
+    }
+
+    idfreq_free(&f);
+}
+
+void test_dict_batch_matches_single_lookups(void) {
+    Dict single, batch;
+    TEST_ASSERT_TRUE(dict_init(&single, 16));
+    TEST_ASSERT_TRUE(dict_init(&batch, 16));
+
+    // Repeats, empty slots and NULLs mixed in; tables grow mid-window.
+    enum { N = 3000 };
+    static char bufs[N][16];
+    const char *words[N];
+    for (unsigned i = 0; i < N; i++) {
+        snprintf(bufs[i], sizeof(bufs[i]), "w%u", (i * 7919u) % 1200u);
+        words[i] = bufs[i];
+        if (i % 97 == 0) words[i] = (i % 2) ? "" : NULL;
+    }
+
+    uint32_t ids[N];
+    TEST_ASSERT_TRUE(dict_get_or_add_batch(&batch, words, N, ids));
+
+    for (unsigned i = 0; i < N; i++) {
+        uint32_t expect = words[i] ? dict_get_or_add(&single, words[i]) : 0;
+        TEST_ASSERT_EQUAL_UINT(expect, ids[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT((unsigned)dict_size(&single), (unsigned)dict_size(&batch));
+
+    dict_free(&single);
+    dict_free(&batch);
+}
+
+void test_heavy_hitters_bounds_and_verified_topk(void) {
+    // Zipf-artiger Strom über 2000 Wörter, nur 64 Slots
+    enum { WORDS = 2000, CAP = 64 };
+    static size_t truth[WORDS];
+    memset(truth, 0, sizeof(truth));
+
+    HeavyHitters hh;
+    TEST_ASSERT_TRUE(hh_init(&hh, CAP));
+
+    char buf[16];
+    unsigned seed = 11;
+    for (int round = 0; round < 4; round++) {
+        for (int w = 0; w < WORDS; w++) {
+            seed = seed * 1103515245u + 12345u;
+            size_t reps = (size_t)(400 / (w + 1)) + ((seed >> 16) % 2);
+            for (size_t r = 0; r < reps; r++) {
+                snprintf(buf, sizeof(buf), "w%04d", w);
+                TEST_ASSERT_TRUE(hh_add(&hh, buf, strlen(buf)));
+                truth[w]++;
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT(CAP, (unsigned)hh.size);
+
+    // Schranken: count - error <= wahrer Wert <= count
+    for (size_t i = 0; i < hh.size; i++) {
+        const HhEntry *e = &hh.entries[i];
+        int w = atoi(e->key + 1);
+        TEST_ASSERT_TRUE(e->count >= truth[w]);
+        TEST_ASSERT_TRUE(e->count - e->error <= truth[w]);
+    }
+
+    // Zweiter Durchlauf: exakte Zählung der überwachten Schlüssel
+    hh_verify_begin(&hh);
+    for (int round = 0; round < 4; round++) {
+        for (int w = 0; w < WORDS; w++) {
+            for (size_t r = 0; r < truth[w] / 4 + (round < (int)(truth[w] % 4)); r++) {
+                snprintf(buf, sizeof(buf), "w%04d", w);
+                TEST_ASSERT_TRUE(hh_add(&hh, buf, strlen(buf)));
+            }
+        }
+    }
+
+    WordCountList top = (WordCountList){0};
+    size_t *err = NULL;
+    bool exact = false;
+    TEST_ASSERT_TRUE(hh_top_k_words(&hh, 5, &top, &err, &exact));
+    TEST_ASSERT_TRUE(exact);
+    TEST_ASSERT_EQUAL_UINT(5, (unsigned)top.count);
+    for (size_t i = 0; i < top.count; i++) {
+        snprintf(buf, sizeof(buf), "w%04d", (int)i);
+        TEST_ASSERT_EQUAL_STRING(buf, top.items[i].word);
+        TEST_ASSERT_EQUAL_UINT((unsigned)truth[i], (unsigned)top.items[i].count);
+        TEST_ASSERT_EQUAL_UINT(0, (unsigned)err[i]);
+    }
+    free_top_k_words(&top);
+    free(err);
+    hh_free(&hh);
+
+    // Kleine Eingabe passt komplett: exakt ohne zweiten Durchlauf, Bigramme ohne Brücken
+    char t0[] = "haus", t1[] = "baum", t2[] = "x", t3[] = "haus", t4[] = "baum";
+    char *items[] = { t0, t1, t2, t3, t4 };
+    TokenList raw = { .items = items, .count = 5 };
+    HeavyHitters words, bigrams;
+    TEST_ASSERT_TRUE(hh_init(&words, 8));
+    TEST_ASSERT_TRUE(hh_init(&bigrams, 8));
+    TEST_ASSERT_TRUE(hh_add_tokens(&words, &bigrams, &raw, NULL));
+
+    BigramCountList bl = (BigramCountList){0};
+    TEST_ASSERT_TRUE(hh_top_k_bigrams(&bigrams, 0, &bl, NULL, &exact));
+    TEST_ASSERT_TRUE(exact);
+    TEST_ASSERT_EQUAL_UINT(1, (unsigned)bl.count);
+    TEST_ASSERT_EQUAL_STRING("haus", bl.items[0].w1);
+    TEST_ASSERT_EQUAL_STRING("baum", bl.items[0].w2);
+    TEST_ASSERT_EQUAL_UINT(2, (unsigned)bl.items[0].count);
+    free_top_k_bigrams(&bl);
+    hh_free(&words);
+    hh_free(&bigrams);
+}
+
+void test_id_ngrams_single_pass_all_orders(void) {
+    // Drei Läufe, getrennt durch ignorierte Tokens ("x", "42"): keine Brücken
+    const char *text[] = { "haus", "baum", "weg", "x", "haus", "baum", "weg", "42",
+                           "haus", "baum", "weg", "haus" };
+    char *items[12];
+    for (int i = 0; i < 12; i++) items[i] = (char*)text[i];
+    TokenList raw = { .items = items, .count = 12 };
+
+    Dict d;
+    IdNgrams g;
+    TEST_ASSERT_TRUE(dict_init(&d, 16));
+    TEST_ASSERT_TRUE(idngrams_init(&g, 16, 0));
+    TEST_ASSERT_TRUE(idngrams_count_tokens(&g, &d, &raw, NULL, NGRAM_MAX_N));
+
+    uint32_t haus = dict_get_or_add(&d, "haus");
+    uint32_t baum = dict_get_or_add(&d, "baum");
+    uint32_t weg = dict_get_or_add(&d, "weg");
+
+    // n = 1 und 2 entsprechen Wörtern und Bigrammen
+    uint32_t k1[] = { haus }, k2[] = { haus, baum }, k2b[] = { weg, haus };
+    TEST_ASSERT_EQUAL_UINT(4, idngrams_get(&g, k1, 1));
+    TEST_ASSERT_EQUAL_UINT(3, idngrams_get(&g, k2, 2));
+    TEST_ASSERT_EQUAL_UINT(1, idngrams_get(&g, k2b, 2));
+
+    uint32_t k3[] = { haus, baum, weg }, k3b[] = { baum, weg, haus };
+    uint32_t k4[] = { haus, baum, weg, haus }, k4x[] = { baum, weg, haus, baum };
+    TEST_ASSERT_EQUAL_UINT(3, idngrams_get(&g, k3, 3));
+    TEST_ASSERT_EQUAL_UINT(1, idngrams_get(&g, k3b, 3));
+    TEST_ASSERT_EQUAL_UINT(1, idngrams_get(&g, k4, 4));
+    TEST_ASSERT_EQUAL_UINT(0, idngrams_get(&g, k4x, 4));
+
+    // Top-K je Ordnung: Anzahl absteigend, dann wortweise lexikografisch
+    NgramCountList top = (NgramCountList){0};
+    TEST_ASSERT_TRUE(idngrams_top_k(&g, &d, 3, 0, &top));
+    TEST_ASSERT_EQUAL_UINT(2, (unsigned)top.count);
+    TEST_ASSERT_EQUAL_STRING("haus", top.items[0].words[0]);
+    TEST_ASSERT_EQUAL_STRING("weg", top.items[0].words[2]);
+    TEST_ASSERT_EQUAL_UINT(3, (unsigned)top.items[0].count);
+    free_ngram_counts(&top);
+
+    TEST_ASSERT_TRUE(idngrams_top_k(&g, &d, 1, 2, &top));
+    TEST_ASSERT_EQUAL_UINT(2, (unsigned)top.count);
+    TEST_ASSERT_EQUAL_STRING("haus", top.items[0].words[0]);
+    TEST_ASSERT_EQUAL_STRING("baum", top.items[1].words[0]);  // baum == weg (3), baum zuerst
+    free_ngram_counts(&top);
+    idngrams_free(&g);
+
+    // Speichergrenze: neue N-Gramme werden verworfen, bekannte zählen exakt weiter
+    TEST_ASSERT_TRUE(idngrams_init(&g, 16, 3));
+    TEST_ASSERT_TRUE(idngrams_count_tokens(&g, &d, &raw, NULL, 2));
+    TEST_ASSERT_EQUAL_UINT(3, (unsigned)g.size);
+    TEST_ASSERT_TRUE(g.dropped > 0);
+    TEST_ASSERT_EQUAL_UINT(4, idngrams_get(&g, k1, 1));
+    TEST_ASSERT_EQUAL_UINT(3, idngrams_get(&g, k2, 2));
+    idngrams_free(&g);
+    dict_free(&d);
+}
+
+void test_id_cooc_window_seams_and_pruning(void) {
+    // Fenster ±2: "x" belegt eine Position, "" (Sampling-Naht) beendet das Fenster
+    const char *text[] = { "haus", "baum", "x", "weg", "", "haus", "baum" };
+    char *items[7];
+    for (int i = 0; i < 7; i++) items[i] = (char*)text[i];
+    TokenList raw = { .items = items, .count = 7 };
+
+    Dict d;
+    IdStream st = {0};
+    IdCooc c;
+    TEST_ASSERT_TRUE(dict_init(&d, 16));
+    TEST_ASSERT_TRUE(idcooc_init(&c, 2, 0));
+    TEST_ASSERT_TRUE(id_stream_resolve(&st, &d, &raw, NULL));
+    TEST_ASSERT_EQUAL_UINT(ID_STREAM_BREAK, st.ids[4]);
+    TEST_ASSERT_EQUAL_UINT(0, st.ids[2]);
+    TEST_ASSERT_TRUE(idcooc_count_ids(&c, st.ids, st.count));
+
+    uint32_t haus = dict_get_or_add(&d, "haus");
+    uint32_t baum = dict_get_or_add(&d, "baum");
+    uint32_t weg = dict_get_or_add(&d, "weg");
+    TEST_ASSERT_EQUAL_UINT(2, idcooc_get(&c, baum, haus));
+    TEST_ASSERT_EQUAL_UINT(1, idcooc_get(&c, weg, baum));
+    TEST_ASSERT_EQUAL_UINT(0, idcooc_get(&c, haus, weg));  // Abstand 3
+
+    // COO-Export: sortiertes Vokabular, rows < cols, Anzahl absteigend
+    CoocMatrix m;
+    TEST_ASSERT_TRUE(idcooc_export(&c, &d, 1, 0, &m));
+    TEST_ASSERT_EQUAL_UINT(3, (unsigned)m.n_vocab);
+    TEST_ASSERT_EQUAL_STRING("baum", m.vocab[0]);
+    TEST_ASSERT_EQUAL_STRING("weg", m.vocab[2]);
+    TEST_ASSERT_EQUAL_UINT(2, (unsigned)m.nnz);
+    TEST_ASSERT_EQUAL_UINT(0, m.rows[0]);
+    TEST_ASSERT_EQUAL_UINT(1, m.cols[0]);
+    TEST_ASSERT_EQUAL_UINT(2, m.counts[0]);
+    free_cooc_matrix(&m);
+
+    // Mindestanzahl filtert seltene Paare
+    TEST_ASSERT_TRUE(idcooc_export(&c, &d, 2, 0, &m));
+    TEST_ASSERT_EQUAL_UINT(1, (unsigned)m.nnz);
+    free_cooc_matrix(&m);
+    idcooc_free(&c);
+
+    // Speichergrenze: seltene Paare werden entfernt, Unterzählung begrenzt
+    TEST_ASSERT_TRUE(idcooc_init(&c, 2, 4));
+    TEST_ASSERT_TRUE(idcooc_add(&c, 1, 2, 5));
+    TEST_ASSERT_TRUE(idcooc_add(&c, 1, 3, 1));
+    TEST_ASSERT_TRUE(idcooc_add(&c, 4, 1, 1));
+    TEST_ASSERT_TRUE(idcooc_add(&c, 1, 5, 1));
+    TEST_ASSERT_TRUE(idcooc_add(&c, 6, 1, 1));
+    TEST_ASSERT_EQUAL_UINT(1, (unsigned)c.prunes);
+    TEST_ASSERT_EQUAL_UINT(1, (unsigned)c.undercount);
+    TEST_ASSERT_EQUAL_UINT(5, idcooc_get(&c, 2, 1));
+    TEST_ASSERT_EQUAL_UINT(1, idcooc_get(&c, 1, 6));
+    TEST_ASSERT_EQUAL_UINT(0, idcooc_get(&c, 1, 3));
+    idcooc_free(&c);
+
+    id_stream_free(&st);
+    dict_free(&d);
+}
+
+void test_stem_de_memo_and_fold(void) {
+    // CISTEM: Flexionsformen fallen zusammen, Umlaute/ß werden gefaltet
+    char buf[64];
+    stem_de("analysen", buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING("analy", buf);
+    stem_de("analyse", buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING("analy", buf);
+    stem_de("h\xc3\xa4user", buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING("hau", buf);
+    stem_de("stra\xc3\x9f" "e", buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING("strass", buf);
+    stem_de("gemacht", buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING("mach", buf);
+
+    // Memo: jede Oberflächenform wird genau einmal gestemmt
+    StemMemo m;
+    TEST_ASSERT_TRUE(stem_memo_init(&m));
+    uint32_t a = stem_memo_word(&m, "analysen");
+    TEST_ASSERT_EQUAL_UINT(a, stem_memo_word(&m, "analyse"));
+    TEST_ASSERT_EQUAL_UINT(a, stem_memo_word(&m, "analysen"));
+    TEST_ASSERT_EQUAL_UINT(2, (unsigned)m.stemmed);
+
+    // Stringliste: Zählungen gleicher Stämme summiert, Sortierung erhalten
+    const char *w[] = { "analyse", "haus", "analysen" };
+    WordCountList wl = { calloc(3, sizeof(WordCount)), 3 };
+    for (int i = 0; i < 3; i++) {
+        wl.items[i].word = malloc(strlen(w[i]) + 1);
+        strcpy(wl.items[i].word, w[i]);
+        wl.items[i].count = (size_t)(i + 1);
+    }
+    TEST_ASSERT_TRUE(stem_fold_words(&m, &wl, true));
+    TEST_ASSERT_EQUAL_UINT(2, (unsigned)wl.count);
+    TEST_ASSERT_EQUAL_STRING("analy", wl.items[0].word);
+    TEST_ASSERT_EQUAL_UINT(4, (unsigned)wl.items[0].count);
+    TEST_ASSERT_EQUAL_STRING("hau", wl.items[1].word);
+    free_word_counts(&wl);
+
+    // ID-Raum: eine Abbildungstabelle pro Dict, Faltung in einem Durchlauf
+    Dict d;
+    TEST_ASSERT_TRUE(dict_init(&d, 16));
+    uint32_t i1 = dict_get_or_add(&d, "analysen");
+    uint32_t i2 = dict_get_or_add(&d, "haus");
+    uint32_t i3 = dict_get_or_add(&d, "analyse");
+    uint32_t *map = stem_memo_map_dict(&m, &d);
+    TEST_ASSERT_NOT_NULL(map);
+    TEST_ASSERT_EQUAL_UINT(map[i1], map[i3]);
+    TEST_ASSERT_EQUAL_UINT(3, (unsigned)m.stemmed);  // nur "haus" neu
+
+    IdCount ic[] = { { i1, 3 }, { i2, 1 }, { i3, 2 } };
+    IdCountList il = { malloc(sizeof(ic)), 3 };
+    memcpy(il.items, ic, sizeof(ic));
+    uint32_t *slot = calloc(dict_size(&m.stems) + 1, sizeof(uint32_t));
+    id_counts_fold(&il, map, slot);
+    TEST_ASSERT_EQUAL_UINT(2, (unsigned)il.count);
+    TEST_ASSERT_EQUAL_UINT(map[i1], il.items[0].id);
+    TEST_ASSERT_EQUAL_UINT(5, il.items[0].count);
+    for (size_t s = 0; s <= dict_size(&m.stems); s++) TEST_ASSERT_EQUAL_UINT(0, slot[s]);
+
+    IdPairCount pc[] = { { i1, i2, 1 }, { i3, i2, 4 } };
+    IdPairCountList pl = { malloc(sizeof(pc)), 2 };
+    memcpy(pl.items, pc, sizeof(pc));
+    TEST_ASSERT_TRUE(id_pairs_fold(&pl, map));
+    TEST_ASSERT_EQUAL_UINT(1, (unsigned)pl.count);
+    TEST_ASSERT_EQUAL_UINT(5, pl.items[0].count);
+
+    free_id_pair_counts(&pl);
+    free_id_counts(&il);
+    free(slot);
+    free(map);
+    dict_free(&d);
+    stem_memo_free(&m);
+}
+
+void test_docfreq_tfidf_ranking(void) {
+    // Drei Seiten: "seite" überall (Boilerplate), "analyse" nur auf einer
+    const char *p1w[] = { "seite", "analyse" };
+    size_t p1c[] = { 3, 3 };
+    const char *p2w[] = { "seite", "haus" };
+    size_t p2c[] = { 3, 1 };
+    WordCount i1[2], i2[2];
+    for (int i = 0; i < 2; i++) {
+        i1[i] = (WordCount){ (char*)p1w[i], p1c[i] };
+        i2[i] = (WordCount){ (char*)p2w[i], p2c[i] };
+    }
+    WordCountList l1 = { i1, 2 }, l2 = { i2, 2 };
+
+    Dict d;
+    IdDocFreq f;
+    TEST_ASSERT_TRUE(dict_init(&d, 16));
+    TEST_ASSERT_TRUE(iddf_init(&f, 4));
+    TEST_ASSERT_TRUE(iddf_add_words(&f, &d, &l1));
+    TEST_ASSERT_TRUE(iddf_add_words(&f, &d, &l2));
+
+    // Seite in ID-Raum (gleiche IDs wie das Dict)
+    IdCount ic[] = { { dict_get_or_add(&d, "seite"), 1 } };
+    IdCountList il = { ic, 1 };
+    TEST_ASSERT_TRUE(iddf_add_page(&f, &il));
+    TEST_ASSERT_EQUAL_UINT(3, (unsigned)f.n_docs);
+
+    uint32_t seite = dict_get_or_add(&d, "seite");
+    TEST_ASSERT_EQUAL_UINT(7, idfreq_get(&f.tf, seite));
+    TEST_ASSERT_EQUAL_UINT(3, idfreq_get(&f.df, seite));
+    TEST_ASSERT_EQUAL_DOUBLE(1.0, iddf_idf(&f, 3));
+
+    // Ranking: "seite" hat die höchste Häufigkeit, aber idf 1
+    uint32_t *rank = topk_dict_ranks(&d);
+    TEST_ASSERT_NOT_NULL(rank);
+    TfidfList out;
+    TEST_ASSERT_TRUE(top_k_tfidf(&d, rank, &f, 10, &out));
+    TEST_ASSERT_EQUAL_UINT(3, (unsigned)out.count);
+    TEST_ASSERT_EQUAL_STRING("seite", out.items[0].word);  // 7 * 1.0
+    TEST_ASSERT_EQUAL_STRING("analyse", out.items[1].word); // 3 * 1.69
+    TEST_ASSERT_EQUAL_UINT(1, out.items[1].df);
+    TEST_ASSERT_TRUE(out.items[1].score > 5.0 && out.items[1].score < 5.1);
+    free_tfidf_list(&out);
+
+    // k = 1 wählt nur den besten Eintrag aus
+    TEST_ASSERT_TRUE(top_k_tfidf(&d, rank, &f, 1, &out));
+    TEST_ASSERT_EQUAL_UINT(1, (unsigned)out.count);
+    TEST_ASSERT_EQUAL_STRING("seite", out.items[0].word);
+    free_tfidf_list(&out);
+
+    free(rank);
+    iddf_free(&f);
+    dict_free(&d);
+}
+
+void test_arena_bump_reset_and_string_hooks(void) {
+    Arena a;
+    arena_init(&a);
+    TEST_ASSERT_NULL(a.head);
+
+    // Ausrichtung und fortlaufende Vergabe im Kopfblock
+    char *p = (char*)arena_alloc(&a, 3, 1);
+    uint64_t *q = (uint64_t*)arena_alloc(&a, sizeof(uint64_t), 8);
+    TEST_ASSERT_NOT_NULL(p);
+    TEST_ASSERT_EQUAL_UINT(0, (unsigned)((uintptr_t)q % 8));
+    char *r = (char*)arena_alloc(&a, 16, 1);
+    TEST_ASSERT_EQUAL_PTR((char*)q + sizeof(uint64_t), r);
+
+    // Große Anforderung: eigener Block, der Kopfblock vergibt weiter
+    char *big = (char*)arena_alloc(&a, ARENA_BLOCK_BYTES, 1);
+    TEST_ASSERT_NOT_NULL(big);
+    memset(big, 'x', ARENA_BLOCK_BYTES);
+    TEST_ASSERT_EQUAL_PTR(r + 16, arena_alloc(&a, 4, 1));
+    TEST_ASSERT_EQUAL_UINT(2, (unsigned)a.blocks);
+
+    // Reset behält nur den Kopfblock und beginnt vorn
+    arena_reset(&a);
+    TEST_ASSERT_EQUAL_UINT(0, (unsigned)a.used);
+    TEST_ASSERT_EQUAL_UINT(ARENA_BLOCK_BYTES, (unsigned)a.reserved);
+    TEST_ASSERT_EQUAL_PTR(p, arena_alloc(&a, 1, 1));
+    TEST_ASSERT_TRUE(a.peak_reserved > a.reserved);
+
+    // Gebunden: Strings aus der Arena, str_free ist wirkungslos
+    TEST_ASSERT_NULL(arena_bind(&a));
+    TEST_ASSERT_EQUAL_PTR(&a, arena_bound());
+    size_t used = a.used;
+    char *s = str_dup("arena");
+    TEST_ASSERT_EQUAL_STRING("arena", s);
+    TEST_ASSERT_EQUAL_UINT(used + 6, (unsigned)a.used);
+    str_free(s);
+    TEST_ASSERT_EQUAL_STRING("arena", s);
+
+    // Dict-Schlüssel gehen mit der Arena (ASan meldet sonst free())
+    Dict d;
+    TEST_ASSERT_TRUE(dict_init(&d, 4));
+    char w[16];
+    for (int i = 0; i < 100; i++) {
+        snprintf(w, sizeof(w), "wort%d", i);
+        TEST_ASSERT_TRUE(dict_get_or_add(&d, w) != 0);
+    }
+    dict_free(&d);
+    TEST_ASSERT_EQUAL_PTR(&a, arena_bind(NULL));
+
+    // Ungebunden: malloc/free
+    char *h = str_dupn("heapxyz", 4);
+    TEST_ASSERT_EQUAL_STRING("heap", h);
+    str_free(h);
+
+    arena_free(&a);
+    TEST_ASSERT_NULL(a.head);
+}
+
+// Abgelaufene Deadline: heiße Schleifen brechen am nächsten Prüfpunkt ab,
+// ungebundene Threads zählen vollständig
+void test_cancel_stops_hot_loops(void) {
+    enum { N = (1 << 16) + 100 };
+    char *text = (char*)malloc(3 * N + 1);
+    TEST_ASSERT_NOT_NULL(text);
+    for (size_t i = 0; i < N; i++) memcpy(text + 3 * i, (i & 1) ? "ab " : "cd ", 3);
+    text[3 * N] = '\0';
+    uint64_t *keys = (uint64_t*)malloc(N * sizeof(uint64_t));
+    uint64_t *tmp = (uint64_t*)malloc(N * sizeof(uint64_t));
+    TEST_ASSERT_NOT_NULL(keys);
+    TEST_ASSERT_NOT_NULL(tmp);
+    for (size_t i = 0; i < N; i++) keys[i] = (uint64_t)(N - i);
+
+    TokenList full = tokenize(text);
+    TEST_ASSERT_EQUAL_UINT(N, (unsigned)full.count);
+    TEST_ASSERT_FALSE(cancel_requested());
+
+    // Keine Deadline: gebunden, aber nie ausgelöst
+    Cancel none;
+    cancel_init(&none, 0.0);
+    TEST_ASSERT_NULL(cancel_bind(&none));
+    TokenList again = tokenize(text);
+    TEST_ASSERT_EQUAL_UINT(N, (unsigned)again.count);
+    TEST_ASSERT_FALSE(cancel_requested());
+    free_tokens(&again);
+
+    Cancel late;
+    cancel_init(&late, cancel_now_ms() - 1.0);
+    TEST_ASSERT_EQUAL_PTR(&none, cancel_bind(&late));
+    TEST_ASSERT_FALSE(cancel_requested());
+
+    // Tokenizer: Teilliste (hier leer, Abbruch im Zähl-Durchlauf)
+    TokenList cut = tokenize(text);
+    TEST_ASSERT_TRUE(cut.count < N);
+    TEST_ASSERT_TRUE(cancel_requested());
+    free_tokens(&cut);
+
+    // int-Funktionen schlagen fehl und hinterlassen nichts
+    TEST_ASSERT_FALSE(radix_sort_u64(keys, tmp, N, 32));
+    Dict d;
+    TEST_ASSERT_TRUE(dict_init(&d, 16));
+    IdFreq f = {0};
+    IdCountList ids = {0};
+    TEST_ASSERT_FALSE(id_count_word_ids(&full, &d, &f, &ids));
+    TEST_ASSERT_NULL(ids.items);
+    TEST_ASSERT_EQUAL_PTR(&late, cancel_bind(NULL));
+
+    // Ungebunden: vollständig
+    TEST_ASSERT_FALSE(cancel_requested());
+    TEST_ASSERT_TRUE(radix_sort_u64(keys, tmp, N, 32));
+    TEST_ASSERT_EQUAL_UINT64(1, keys[0]);
+    TEST_ASSERT_EQUAL_UINT64(N, keys[N - 1]);
+    TEST_ASSERT_TRUE(id_count_word_ids(&full, &d, &f, &ids));
+    TEST_ASSERT_EQUAL_UINT(2, (unsigned)ids.count);
+
+    free_id_counts(&ids);
+    idfreq_free(&f);
+    dict_free(&d);
+    free_tokens(&full);
+    free(tmp);
+    free(keys);
+    free(text);
+}
+
+// Wiederverwendung: Generationen im Dict, Zurücksetzen der Zähltabellen
+// und Freigabe zu großer Tabellen (High-Water-Trim)
+void test_scratch_tables_reset_and_trim(void) {
+    Dict d;
+    TEST_ASSERT_TRUE(dict_init(&d, 16));
+    TEST_ASSERT_EQUAL_UINT(1, dict_get_or_add(&d, "apfel"));
+    TEST_ASSERT_EQUAL_UINT(2, dict_get_or_add(&d, "banane"));
+    DictEntry *entries = d.entries;
+    uint32_t gen = d.gen;
+
+    // Alte Einträge gelten als frei, die Tabelle bleibt
+    dict_reset(&d);
+    TEST_ASSERT_EQUAL_UINT(0, (unsigned)dict_size(&d));
+    TEST_ASSERT_EQUAL_UINT(gen + 1, d.gen);
+    TEST_ASSERT_EQUAL_PTR(entries, d.entries);
+    TEST_ASSERT_NULL(dict_word(&d, 1));
+    TEST_ASSERT_EQUAL_UINT(1, dict_get_or_add(&d, "banane"));
+    TEST_ASSERT_EQUAL_UINT(2, dict_get_or_add(&d, "kirsche"));
+    TEST_ASSERT_EQUAL_UINT(1, dict_get_or_add(&d, "banane"));
+    TEST_ASSERT_EQUAL_STRING("kirsche", dict_word(&d, 2));
+
+    // Überlauf des Zählers: Tabelle wird einmal geleert
+    d.gen = UINT32_MAX;
+    dict_reset(&d);
+    TEST_ASSERT_EQUAL_UINT(1, d.gen);
+    TEST_ASSERT_EQUAL_UINT(1, dict_get_or_add(&d, "zitrone"));
+    TEST_ASSERT_EQUAL_UINT(1, (unsigned)dict_size(&d));
+    dict_free(&d);
+
+    // IdFreq: nur das benutzte Präfix wird genullt
+    IdFreq f = {0};
+    TEST_ASSERT_TRUE(idfreq_prepare(&f, 10));
+    uint32_t *counts = f.counts;
+    TEST_ASSERT_TRUE(idfreq_inc(&f, 3));
+    idfreq_clear(&f, 3);
+    TEST_ASSERT_TRUE(idfreq_prepare(&f, 10));
+    TEST_ASSERT_EQUAL_PTR(counts, f.counts);
+    TEST_ASSERT_EQUAL_UINT(0, idfreq_get(&f, 3));
+
+    // Zu groß für den nächsten Aufruf: neu und klein angelegt
+    uint32_t big = (uint32_t)(ID_SCRATCH_KEEP_BYTES / sizeof(uint32_t)) * 2;
+    TEST_ASSERT_TRUE(idfreq_inc(&f, big));
+    idfreq_clear(&f, big);
+    TEST_ASSERT_TRUE(idfreq_prepare(&f, big));
+    TEST_ASSERT_TRUE(f.cap >= big);
+    TEST_ASSERT_TRUE(idfreq_prepare(&f, 10));
+    TEST_ASSERT_TRUE(f.cap * sizeof(uint32_t) <= ID_SCRATCH_KEEP_BYTES);
+    idfreq_free(&f);
+
+    // IdBigrams: leer nach clear, gleiche Tabelle beim nächsten Aufruf
+    IdBigrams b = {0};
+    TEST_ASSERT_TRUE(idbigrams_prepare(&b, 64));
+    void *keys = b.keys;
+    TEST_ASSERT_TRUE(idbigrams_add(&b, 1, 2, 5));
+    idbigrams_clear(&b);
+    TEST_ASSERT_TRUE(idbigrams_prepare(&b, 64));
+    TEST_ASSERT_EQUAL_PTR(keys, b.keys);
+    IdPairCountList pairs;
+    TEST_ASSERT_TRUE(idbigrams_collect(&b, &pairs));
+    TEST_ASSERT_EQUAL_UINT(0, (unsigned)pairs.count);
+    free_id_pair_counts(&pairs);
+    idbigrams_free(&b);
+}
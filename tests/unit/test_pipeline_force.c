@@ -5,6 +5,8 @@
 #include <stdlib.h>
 
 #include "app/analyze.h"
+#include "app/engine.h"
+#include "app/cost_model.h"
 #include "yyjson.h"
 
 // Helper: meta string holen
@@ -48,8 +50,13 @@ static void analyze_one_page_and_assert(app_pipeline_t requested, const char *ex
 
     TEST_ASSERT_EQUAL_STRING(expect_used, used);
 
+    // Begründung: explizit => "requested", AUTO => Kostenmodell
+    const char *reason = meta_get_str_mut(r.response_doc, "pipelineReason");
+    TEST_ASSERT_NOT_NULL(reason);
+    if (requested == APP_PIPELINE_AUTO) TEST_ASSERT_EQUAL_INT(0, strncmp(reason, "auto: ", 6));
+    else TEST_ASSERT_EQUAL_STRING("requested", reason);
+
     yyjson_mut_doc_free(r.response_doc);
-    
 }
 
 void test_pipeline_force_string(void) {
@@ -63,3 +70,80 @@ void test_pipeline_force_id(void) {
 void test_pipeline_auto_small_uses_string(void) {
     analyze_one_page_and_assert(APP_PIPELINE_AUTO, "string");
 }
+
+// Kostenmodell (Prioren): kleine Anfrage bleibt bei string, viele mittlere
+// Seiten wechseln zur Engine mit k-Wege-Merge
+void test_auto_model_request_choice(void) {
+    cost_model_reset();
+    CostModel m;
+    cost_model_snapshot(&m);
+
+    size_t tiny[1] = { 21 };
+    CostChoice c;
+    cost_choose(&m, tiny, 1, 1.0, 1, true, true, &c);
+    TEST_ASSERT_EQUAL_INT(APP_PIPELINE_STRING, c.engine);
+
+    size_t pages[100];
+    for (size_t i = 0; i < 100; i++) pages[i] = 5000;
+    cost_choose(&m, pages, 100, 1.0, 1, true, true, &c);
+    TEST_ASSERT_EQUAL_INT(APP_PIPELINE_ART, c.engine);
+    TEST_ASSERT_TRUE(c.engine_ns < c.next_ns);
+}
+
+// Zähler pro Einheit: kleiner Pfad für kleine Seiten, sonst der günstigste
+// Zähler, dessen Listen die Engine mergen kann
+void test_auto_model_unit_counter(void) {
+    cost_model_reset();
+    CostModel m;
+    cost_model_snapshot(&m);
+
+    size_t next = 0;
+    TEST_ASSERT_EQUAL_UINT(COST_SMALL, cost_pick_counter(&m, APP_PIPELINE_STRING, 500, true, &next));
+    TEST_ASSERT_TRUE(next != COST_SMALL);
+
+    size_t c = cost_pick_counter(&m, APP_PIPELINE_STRING, 500, false, NULL);
+    TEST_ASSERT_TRUE(c != COST_SMALL);
+
+    c = cost_pick_counter(&m, APP_PIPELINE_STRING, 50000, true, NULL);
+    TEST_ASSERT_TRUE(c != COST_SMALL && c != APP_PIPELINE_STRING);
+    TEST_ASSERT_TRUE(app_engine_at(c)->lists_in_state == false);
+
+    // Listen im Zustand: id zählt jede Einheit selbst
+    TEST_ASSERT_EQUAL_UINT(APP_PIPELINE_ID, cost_pick_counter(&m, APP_PIPELINE_ID, 50000, true, NULL));
+
+    // lexsortierte Engine nimmt nur lexsortiert liefernde Zähler
+    c = cost_pick_counter(&m, APP_PIPELINE_ART, 50000, true, NULL);
+    TEST_ASSERT_TRUE(app_engine_at(c)->lists_lexsorted);
+}
+
+// Messungen verschieben den Maßstab gedämpft (EWMA, Verhältnis gedeckelt);
+// Schattenläufe zählen nur als Zeitmessung
+void test_auto_model_refines_from_reports(void) {
+    cost_model_reset();
+    CostModel m;
+    cost_model_snapshot(&m);
+    if (m.fixed) return;  // TA_AUTO_MODEL=fixed: Modell bleibt bei den Prioren
+
+    double pred = cost_count_ns(&m, APP_PIPELINE_SORT, 20000.0, 300.0);
+    CostReport r;
+    memset(&r, 0, sizeof(r));
+    cost_report_unit(&r, &m, APP_PIPELINE_SORT, 20000, 144000, 300, COST_UNKNOWN, 10.0 * pred, false);
+    cost_report_unit(&r, &m, APP_PIPELINE_ART, 20000, 144000, 300, COST_UNKNOWN, 1.0, true);
+    TEST_ASSERT_EQUAL_UINT(1, r.units[APP_PIPELINE_SORT]);
+    TEST_ASSERT_EQUAL_UINT(0, r.units[APP_PIPELINE_ART]);
+    TEST_ASSERT_EQUAL_UINT(1, r.shadows);
+
+    cost_model_report(&r, APP_PIPELINE_SORT);
+    CostModel after;
+    cost_model_snapshot(&after);
+    TEST_ASSERT_EQUAL_UINT(1, after.reports);
+    TEST_ASSERT_EQUAL_UINT(1, after.shadows);
+    // höchstens Faktor 2 pro Messung, davon 20 %
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 1.2 * m.count_scale[APP_PIPELINE_SORT],
+                              after.count_scale[APP_PIPELINE_SORT]);
+    TEST_ASSERT_TRUE(after.count_scale[APP_PIPELINE_ART] < m.count_scale[APP_PIPELINE_ART]);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, m.count_scale[APP_PIPELINE_STRING],
+                              after.count_scale[APP_PIPELINE_STRING]);
+
+    cost_model_reset();
+}
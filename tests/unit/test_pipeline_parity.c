@@ -3,13 +3,26 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
 
 #include "core/tokenizer.h"
 #include "core/stopwords.h"
 #include "core/freq.h"
 #include "core/bigrams.h"
+#include "core/small_count.h"
 
-#include "app/pipeline_id.h"
+#include "core/aggregate.h"
+#include "core/bigram_aggregate.h"
+#include "view/topk.h"
+
+#include "app/engine.h"
+#include "app/analyze.h"
+#include "app/page_plan.h"
+#include "app/scratch.h"
+#include "app/cost_model.h"
+#include "core/cancel.h"
+#include "yyjson.h"
 
 // Sortier-Vergleiche für deterministischen Vergleich
 static int cmp_wc(const void *a, const void *b) {
@@ -73,6 +86,137 @@ static void assert_bigrams_equal(BigramCountList *a, BigramCountList *b) {
     }
 }
 
+// Referenz: String-Zählung pro Seite, lineare Aggregation, Top-K (voll)
+static void reference_topk(TokenList *raw, TokenList *filtered, size_t n_pages,
+                           const StopwordList *sw, int include_bigrams,
+                           WordCountList *top_w, BigramCountList *top_b) {
+    WordCountList *pw = (WordCountList *)calloc(n_pages, sizeof(WordCountList));
+    BigramCountList *pb = (BigramCountList *)calloc(n_pages, sizeof(BigramCountList));
+    TEST_ASSERT_NOT_NULL(pw);
+    TEST_ASSERT_NOT_NULL(pb);
+
+    for (size_t i = 0; i < n_pages; i++) {
+        pw[i] = count_words(&filtered[i]);
+        if (include_bigrams) pb[i] = count_bigrams_excluding_stopwords(&raw[i], sw);
+    }
+
+    WordCountList dw = aggregate_word_counts(pw, n_pages);
+    *top_w = top_k_words(&dw, dw.count);
+    free_aggregated_word_counts(&dw);
+
+    if (include_bigrams) {
+        BigramCountList db = aggregate_bigram_counts(pb, n_pages);
+        *top_b = top_k_bigrams(&db, db.count);
+        free_aggregated_bigram_counts(&db);
+    }
+
+    for (size_t i = 0; i < n_pages; i++) {
+        free_word_counts(&pw[i]);
+        free_bigram_counts(&pb[i]);
+    }
+    free(pw);
+    free(pb);
+}
+
+// Ein Engine-Durchlauf wie in app_analyze_pages: count_page -> merge -> Top-K
+static void engine_topk(const app_engine_t *e, TokenList *raw, TokenList *filtered,
+                        size_t n_pages, const StopwordList *sw, int include_bigrams,
+                        WordCountList *top_w, BigramCountList *top_b) {
+    void *state = NULL;
+    if (e->init) TEST_ASSERT_TRUE(e->init(&state, n_pages));
+
+    WordCountList *pw = (WordCountList *)calloc(n_pages, sizeof(WordCountList));
+    BigramCountList *pb = (BigramCountList *)calloc(n_pages, sizeof(BigramCountList));
+    TEST_ASSERT_NOT_NULL(pw);
+    TEST_ASSERT_NOT_NULL(pb);
+
+    for (size_t i = 0; i < n_pages; i++) {
+        int ok = e->count_page(state, i, &filtered[i], &raw[i], sw,
+                               &pw[i], include_bigrams ? &pb[i] : NULL);
+        TEST_ASSERT_TRUE_MESSAGE(ok, e->name);
+    }
+
+    WordCountList dw = (WordCountList){0};
+    BigramCountList db = (BigramCountList){0};
+    TEST_ASSERT_TRUE_MESSAGE(e->merge(state, pw, include_bigrams ? pb : NULL, n_pages,
+                                      &dw, include_bigrams ? &db : NULL), e->name);
+
+    TEST_ASSERT_TRUE_MESSAGE(e->topk_words(state, APP_ENGINE_DOMAIN, &dw, 0, top_w), e->name);
+    if (include_bigrams) {
+        TEST_ASSERT_TRUE_MESSAGE(e->topk_bigrams(state, APP_ENGINE_DOMAIN, &db, 0, top_b), e->name);
+    }
+
+    free_aggregated_word_counts(&dw);
+    free_aggregated_bigram_counts(&db);
+    for (size_t i = 0; i < n_pages; i++) {
+        free_word_counts(&pw[i]);
+        free_bigram_counts(&pb[i]);
+    }
+    free(pw);
+    free(pb);
+    if (e->destroy) e->destroy(state);
+}
+
+// Top-K-Listen müssen exakt gleich sein (inkl. Reihenfolge)
+static void assert_topk_equal(const char *engine, const WordCountList *a, const WordCountList *b,
+                              const BigramCountList *ab, const BigramCountList *bb) {
+    TEST_ASSERT_EQUAL_UINT_MESSAGE((unsigned)a->count, (unsigned)b->count, engine);
+    for (size_t i = 0; i < a->count; i++) {
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(a->items[i].word, b->items[i].word, engine);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(a->items[i].count, b->items[i].count, engine);
+    }
+    TEST_ASSERT_EQUAL_UINT_MESSAGE((unsigned)ab->count, (unsigned)bb->count, engine);
+    for (size_t i = 0; i < ab->count; i++) {
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(ab->items[i].w1, bb->items[i].w1, engine);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(ab->items[i].w2, bb->items[i].w2, engine);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(ab->items[i].count, bb->items[i].count, engine);
+    }
+}
+
+// Alle registrierten Engines gegen die String-Referenz (mehrseitig)
+static void run_parity_pages(const char *const *texts, size_t n_pages, int include_bigrams) {
+    StopwordList sw = {0};
+    TEST_ASSERT_EQUAL_INT(0, stopwords_load(&sw, "data/stopwords_de.txt"));
+
+    TokenList *raw = (TokenList *)calloc(n_pages, sizeof(TokenList));
+    TokenList *filtered = (TokenList *)calloc(n_pages, sizeof(TokenList));
+    TEST_ASSERT_NOT_NULL(raw);
+    TEST_ASSERT_NOT_NULL(filtered);
+    for (size_t i = 0; i < n_pages; i++) {
+        raw[i] = tokenize(texts[i]);
+        filtered[i] = filter_stopwords_copy(&raw[i], "data/stopwords_de.txt");
+    }
+
+    WordCountList ref_w = (WordCountList){0};
+    BigramCountList ref_b = (BigramCountList){0};
+    reference_topk(raw, filtered, n_pages, &sw, include_bigrams, &ref_w, &ref_b);
+
+    size_t engines = 0;
+    for (size_t i = 0; i < app_engine_count(); i++) {
+        const app_engine_t *e = app_engine_at(i);
+        if (!e) continue;
+
+        WordCountList w = (WordCountList){0};
+        BigramCountList b = (BigramCountList){0};
+        engine_topk(e, raw, filtered, n_pages, &sw, include_bigrams, &w, &b);
+        assert_topk_equal(e->name, &ref_w, &w, &ref_b, &b);
+        free_top_k_words(&w);
+        free_top_k_bigrams(&b);
+        engines++;
+    }
+    TEST_ASSERT_TRUE(engines >= 2);
+
+    free_top_k_words(&ref_w);
+    free_top_k_bigrams(&ref_b);
+    for (size_t i = 0; i < n_pages; i++) {
+        free_tokens(&filtered[i]);
+        free_tokens(&raw[i]);
+    }
+    free(raw);
+    free(filtered);
+    stopwords_free(&sw);
+}
+
 static void run_parity_case(const char *text, int include_bigrams) {
     // raw bleibt unverändert für natürliche Bigrams
     TokenList raw = tokenize(text);
@@ -92,23 +236,40 @@ static void run_parity_case(const char *text, int include_bigrams) {
         b_str = count_bigrams_excluding_stopwords(&raw, &sw);
     }
 
-    // ID-Pipeline
-    WordCountList w_id = (WordCountList){0};
-    BigramCountList b_id = (BigramCountList){0};
+    // Jede registrierte Engine: Seitenlisten (Reihenfolge egal) gegen Referenz
+    for (size_t i = 0; i < app_engine_count(); i++) {
+        const app_engine_t *e = app_engine_at(i);
+        if (!e) continue;
 
-    int ok = analyze_id_pipeline(
-        &filtered,
-        &raw,
-        include_bigrams ? true : false,
-        &sw,
-        &w_id,
-        include_bigrams ? &b_id : NULL
-    );
-    TEST_ASSERT_TRUE(ok);
+        void *state = NULL;
+        if (e->init) TEST_ASSERT_TRUE(e->init(&state, 1));
+
+        WordCountList w = (WordCountList){0};
+        BigramCountList b = (BigramCountList){0};
+        int ok = e->count_page(state, 0, &filtered, &raw, &sw, &w, include_bigrams ? &b : NULL);
+        TEST_ASSERT_TRUE_MESSAGE(ok, e->name);
+
+        // Engines mit Zustand: Seitenliste erst nach dem Merge über die Top-K-Hooks
+        if (e->lists_in_state) {
+            WordCountList dw = (WordCountList){0};
+            BigramCountList db = (BigramCountList){0};
+            TEST_ASSERT_TRUE_MESSAGE(e->merge(state, &w, include_bigrams ? &b : NULL, 1,
+                                              &dw, include_bigrams ? &db : NULL), e->name);
+            free_aggregated_word_counts(&dw);
+            free_aggregated_bigram_counts(&db);
+            TEST_ASSERT_EQUAL_UINT_MESSAGE(0, (unsigned)w.count, e->name);
+
+            TEST_ASSERT_TRUE_MESSAGE(e->topk_words(state, 0, &w, 0, &w), e->name);
+            if (include_bigrams) TEST_ASSERT_TRUE_MESSAGE(e->topk_bigrams(state, 0, &b, 0, &b), e->name);
+        }
 
-    // Vergleich
-    assert_words_equal(&w_str, &w_id);
-    if (include_bigrams) assert_bigrams_equal(&b_str, &b_id);
+        assert_words_equal(&w_str, &w);
+        if (include_bigrams) assert_bigrams_equal(&b_str, &b);
+
+        free_word_counts(&w);
+        free_bigram_counts(&b);
+        if (e->destroy) e->destroy(state);
+    }
 
     // cleanup
     free_tokens(&filtered);
@@ -118,8 +279,8 @@ static void run_parity_case(const char *text, int include_bigrams) {
     free_word_counts(&w_str);
     if (include_bigrams) free_bigram_counts(&b_str);
 
-    free_word_counts(&w_id);
-    if (include_bigrams) free_bigram_counts(&b_id);
+    // Gesamter Engine-Durchlauf inkl. Merge und Top-K
+    run_parity_pages(&text, 1, include_bigrams);
 }
 
 // -------- G1–G5 Parity --------
@@ -148,3 +309,661 @@ void test_parity_g5_multi_page_like(void) {
         1
     );
 }
+
+// Mehrere Seiten: Merge-Stufe jeder Engine (u. a. sortierter k-Wege-Merge)
+void test_parity_engines_multi_page(void) {
+    const char *pages[] = {
+        "Apfel Banane Kirsche Apfel, Banane und Kirsche.",
+        "Kirsche Kirsche Dattel — Apfel Banane Apfel Banane!",
+        "Zitrone",
+        "",
+        "Banane Apfel Zitrone Dattel Apfel Banane Kirsche Kirsche Kirsche"
+    };
+    run_parity_pages(pages, sizeof(pages) / sizeof(pages[0]), 1);
+    run_parity_pages(pages, sizeof(pages) / sizeof(pages[0]), 0);
+}
+
+// Wort-/Bigramm-Arrays zweier Antworten Eintrag für Eintrag vergleichen
+static void assert_json_lists_equal(yyjson_mut_val *a, yyjson_mut_val *b) {
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_EQUAL_UINT((unsigned)yyjson_mut_arr_size(a), (unsigned)yyjson_mut_arr_size(b));
+    for (size_t i = 0; i < yyjson_mut_arr_size(a); i++) {
+        yyjson_mut_val *x = yyjson_mut_arr_get(a, i), *y = yyjson_mut_arr_get(b, i);
+        const char *keys[] = { "word", "w1", "w2" };
+        for (int k = 0; k < 3; k++) {
+            yyjson_mut_val *sx = yyjson_mut_obj_get(x, keys[k]), *sy = yyjson_mut_obj_get(y, keys[k]);
+            if (sx || sy) TEST_ASSERT_EQUAL_STRING(yyjson_mut_get_str(sx), yyjson_mut_get_str(sy));
+        }
+        TEST_ASSERT_EQUAL_UINT((unsigned)yyjson_mut_get_uint(yyjson_mut_obj_get(x, "count")),
+                               (unsigned)yyjson_mut_get_uint(yyjson_mut_obj_get(y, "count")));
+    }
+}
+
+// Große Seite aus festem Wortschatz (Stoppwörter, Zahlen, Satzzeichen), deterministisch
+static char *make_big_page(size_t min_bytes) {
+    static const char *vocab[] = {
+        "Apfel", "Banane", "und", "Kirsche", "die", "Dattel", "2024", "Zitrone,",
+        "der", "Birne.", "Feige", "mit", "Traube", "x", "Mango!", "Quitte\n"
+    };
+    char *buf = (char *)malloc(min_bytes + 64);
+    TEST_ASSERT_NOT_NULL(buf);
+    size_t n = 0;
+    uint32_t r = 12345u;
+    while (n < min_bytes) {
+        r = r * 1103515245u + 12345u;
+        const char *w = vocab[(r >> 16) % (sizeof(vocab) / sizeof(vocab[0]))];
+        size_t l = strlen(w);
+        memcpy(buf + n, w, l);
+        n += l;
+        buf[n++] = ' ';
+    }
+    buf[n] = '\0';
+    return buf;
+}
+
+// Seiten parallel: große Seite wird geteilt (Bigramme über Chunk-Grenzen),
+// kleine gebündelt; Ausgabe wie sequentiell, Deadline greift in den Workern
+void test_parallel_pages_match_sequential(void) {
+    enum { N = 7 };
+    char *big = make_big_page(400 * 1024);
+    app_page_t pages[N] = {0};
+    const char *texts[N] = {
+        "Apfel Banane Kirsche Apfel, Banane und Kirsche.",
+        "Kirsche Kirsche Dattel — Apfel Banane Apfel Banane!",
+        big,
+        "Zitrone",
+        "",
+        "Banane Apfel Zitrone Dattel Apfel Banane Kirsche Kirsche Kirsche",
+        "Dattel Dattel Zitrone Apfel"
+    };
+    for (int i = 0; i < N; i++) pages[i].text = texts[i];
+
+    for (size_t e = 1; e < app_engine_count(); e++) {
+        app_analyze_opts_t opts = {0};
+        opts.stopwords_path = "data/stopwords_de.txt";
+        opts.include_bigrams = true;
+        opts.per_page_results = true;
+        opts.top_k = 0;
+        opts.pipeline = (app_pipeline_t)e;
+
+        app_analyze_result_t seq = app_analyze_pages(pages, N, &opts);
+        opts.threads = 4;
+        app_analyze_result_t par = app_analyze_pages(pages, N, &opts);
+        TEST_ASSERT_EQUAL_INT(0, seq.status);
+        TEST_ASSERT_EQUAL_INT(0, par.status);
+
+        yyjson_mut_val *rs = yyjson_mut_doc_get_root(seq.response_doc);
+        yyjson_mut_val *rp = yyjson_mut_doc_get_root(par.response_doc);
+        yyjson_mut_val *meta = yyjson_mut_obj_get(rp, "meta");
+        TEST_ASSERT_EQUAL_UINT(4, (unsigned)yyjson_mut_get_uint(yyjson_mut_obj_get(meta, "threads")));
+        yyjson_mut_val *sc = yyjson_mut_obj_get(meta, "scheduler");
+        TEST_ASSERT_EQUAL_UINT(1, (unsigned)yyjson_mut_get_uint(yyjson_mut_obj_get(sc, "splitPages")));
+        TEST_ASSERT_TRUE(yyjson_mut_get_uint(yyjson_mut_obj_get(sc, "chunks")) >= 4);
+        TEST_ASSERT_EQUAL_UINT(2, (unsigned)yyjson_mut_get_uint(yyjson_mut_obj_get(sc, "batches")));
+
+        yyjson_mut_val *ds = yyjson_mut_obj_get(rs, "domainResult");
+        yyjson_mut_val *dp = yyjson_mut_obj_get(rp, "domainResult");
+        assert_json_lists_equal(yyjson_mut_obj_get(ds, "words"), yyjson_mut_obj_get(dp, "words"));
+        assert_json_lists_equal(yyjson_mut_obj_get(ds, "bigrams"), yyjson_mut_obj_get(dp, "bigrams"));
+
+        yyjson_mut_val *ps = yyjson_mut_obj_get(rs, "pageResults");
+        yyjson_mut_val *pp = yyjson_mut_obj_get(rp, "pageResults");
+        TEST_ASSERT_EQUAL_UINT(N, (unsigned)yyjson_mut_arr_size(pp));
+        for (size_t i = 0; i < N; i++) {
+            yyjson_mut_val *a = yyjson_mut_arr_get(ps, i), *b = yyjson_mut_arr_get(pp, i);
+            assert_json_lists_equal(yyjson_mut_obj_get(a, "words"), yyjson_mut_obj_get(b, "words"));
+            assert_json_lists_equal(yyjson_mut_obj_get(a, "bigrams"), yyjson_mut_obj_get(b, "bigrams"));
+            const char *metrics[] = { "charCount", "wordCount", "wordCharCount" };
+            for (int m = 0; m < 3; m++) {
+                TEST_ASSERT_EQUAL_UINT((unsigned)yyjson_mut_get_uint(yyjson_mut_obj_get(a, metrics[m])),
+                                       (unsigned)yyjson_mut_get_uint(yyjson_mut_obj_get(b, metrics[m])));
+            }
+        }
+        yyjson_mut_doc_free(seq.response_doc);
+        yyjson_mut_doc_free(par.response_doc);
+
+        // Abgelaufene Deadline: 503 statt Teilergebnis
+        opts.deadline_ms = 1.0;
+        app_analyze_result_t late = app_analyze_pages(pages, N, &opts);
+        TEST_ASSERT_EQUAL_INT(503, late.status);
+        TEST_ASSERT_NULL(late.response_doc);
+    }
+    free(big);
+}
+
+#ifdef TEST_COUNT_ALLOCS
+// Heap-Aufrufe aller Threads zählen (unit_tests wird mit
+// -Wl,--wrap=malloc/calloc/realloc gelinkt); g_allocs_analyzed hält den
+// Stand beim Anlegen des Antwort-Dokuments, also am Ende der Analyse
+static _Atomic size_t g_allocs;
+static _Atomic size_t g_allocs_analyzed;
+
+void *__real_malloc(size_t n);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t n);
+void *__wrap_malloc(size_t n);
+void *__wrap_calloc(size_t n, size_t size);
+void *__wrap_realloc(void *p, size_t n);
+
+void *__wrap_malloc(size_t n) {
+    atomic_fetch_add_explicit(&g_allocs, 1, memory_order_relaxed);
+    return __real_malloc(n);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    atomic_fetch_add_explicit(&g_allocs, 1, memory_order_relaxed);
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *p, size_t n) {
+    atomic_fetch_add_explicit(&g_allocs, 1, memory_order_relaxed);
+    return __real_realloc(p, n);
+}
+
+yyjson_mut_doc *__real_yyjson_mut_doc_new(const yyjson_alc *alc);
+yyjson_mut_doc *__wrap_yyjson_mut_doc_new(const yyjson_alc *alc);
+
+yyjson_mut_doc *__wrap_yyjson_mut_doc_new(const yyjson_alc *alc) {
+    atomic_store(&g_allocs_analyzed, atomic_load(&g_allocs));
+    return __real_yyjson_mut_doc_new(alc);
+}
+#endif
+
+static uint64_t meta_uint(yyjson_mut_doc *doc, const char *obj, const char *key) {
+    yyjson_mut_val *meta = yyjson_mut_obj_get(yyjson_mut_doc_get_root(doc), "meta");
+    return yyjson_mut_get_uint(yyjson_mut_obj_get(yyjson_mut_obj_get(meta, obj), key));
+}
+
+static bool pool_has(const Scratch *s, const DictEntry *entries) {
+    for (size_t i = 0; i < s->n_dicts; i++) {
+        if (s->dicts[i].entries == entries) return true;
+    }
+    return false;
+}
+
+// Obergrenze der Heap-Aufrufe der Analyse einer warmen Anfrage, ohne das
+// JSON-Dokument (gemessen 34 bis 42 je nach Engine)
+#define SCRATCH_WARM_MAX_ALLOCS 48
+
+// Folgeanfragen desselben Threads: Arenen, Stopwords, Dicts und
+// Zähltabellen werden wiederverwendet (keine neuen Blöcke/Tabellen),
+// die Ergebnisse bleiben gleich
+void test_scratch_reused_across_requests(void) {
+    app_page_t pages[2] = {0};
+    pages[0].text = "Der schnelle braune Fuchs springt über den faulen Hund. Apfel Banane Kirsche Apfel.";
+    pages[1].text = "Kirsche Kirsche Dattel — Apfel Banane Apfel Banane!";
+
+    for (size_t e = 1; e < app_engine_count(); e++) {
+        app_analyze_opts_t opts = {0};
+        opts.stopwords_path = "data/stopwords_de.txt";
+        opts.include_bigrams = true;
+        opts.per_page_results = true;
+        opts.top_k = 0;
+        opts.pipeline = (app_pipeline_t)e;
+
+        app_analyze_result_t first = app_analyze_pages(pages, 2, &opts);
+        TEST_ASSERT_EQUAL_INT(0, first.status);
+        uint64_t served = meta_uint(first.response_doc, "scratch", "requests");
+        TEST_ASSERT_TRUE(served >= 1);
+
+        Scratch *s = scratch_get();
+        TEST_ASSERT_NOT_NULL(s);
+        TEST_ASSERT_FALSE(s->in_request);
+        char **sw_items = s->sw.items;
+        void *counts = s->freq.counts, *keys = s->pairs.keys;
+        size_t n_dicts = s->n_dicts;
+        DictEntry *pooled[SCRATCH_MAX_DICTS];
+        for (size_t i = 0; i < n_dicts; i++) pooled[i] = s->dicts[i].entries;
+
+        for (int r = 1; r <= 2; r++) {
+            app_analyze_result_t again = app_analyze_pages(pages, 2, &opts);
+            TEST_ASSERT_EQUAL_INT(0, again.status);
+            TEST_ASSERT_EQUAL_UINT64(served + r, meta_uint(again.response_doc, "scratch", "requests"));
+            TEST_ASSERT_EQUAL_UINT64(0, meta_uint(again.response_doc, "arena", "blocks"));
+
+            TEST_ASSERT_EQUAL_PTR(sw_items, s->sw.items);
+            TEST_ASSERT_EQUAL_PTR(counts, s->freq.counts);
+            TEST_ASSERT_EQUAL_PTR(keys, s->pairs.keys);
+            TEST_ASSERT_EQUAL_UINT((unsigned)n_dicts, (unsigned)s->n_dicts);
+            for (size_t i = 0; i < n_dicts; i++) TEST_ASSERT_TRUE(pool_has(s, pooled[i]));
+
+            yyjson_mut_val *ra = yyjson_mut_doc_get_root(first.response_doc);
+            yyjson_mut_val *rb = yyjson_mut_doc_get_root(again.response_doc);
+            yyjson_mut_val *da = yyjson_mut_obj_get(ra, "domainResult");
+            yyjson_mut_val *db = yyjson_mut_obj_get(rb, "domainResult");
+            assert_json_lists_equal(yyjson_mut_obj_get(da, "words"), yyjson_mut_obj_get(db, "words"));
+            assert_json_lists_equal(yyjson_mut_obj_get(da, "bigrams"), yyjson_mut_obj_get(db, "bigrams"));
+            yyjson_mut_doc_free(again.response_doc);
+        }
+        yyjson_mut_doc_free(first.response_doc);
+    }
+
+#ifdef TEST_COUNT_ALLOCS
+    // Heap-Aufrufe einer warmen Anfrage: Antwort fester Form (Top-5, keine
+    // Seitenlisten), einmal mit kleinen und einmal mit 50-mal längeren
+    // Seiten (gleicher Wortschatz). Die Analyse darf nicht pro Token,
+    // Wort oder Seite allozieren; gezählt wird bis zum Antwort-Dokument
+    size_t big_len = 50 * (strlen(pages[0].text) + 1);
+    char *long_text = (char *)malloc(big_len + 1);
+    TEST_ASSERT_NOT_NULL(long_text);
+    long_text[0] = '\0';
+    for (int k = 0; k < 50; k++) {
+        strcat(long_text, pages[0].text);
+        strcat(long_text, " ");
+    }
+    app_page_t long_pages[2] = { { .text = long_text }, { .text = pages[1].text } };
+
+    for (size_t e = 1; e < app_engine_count(); e++) {
+        app_analyze_opts_t opts = {0};
+        opts.stopwords_path = "data/stopwords_de.txt";
+        opts.include_bigrams = true;
+        opts.per_page_results = false;
+        opts.top_k = 5;
+        opts.pipeline = (app_pipeline_t)e;
+
+        size_t allocs[2] = {0};
+        for (int v = 0; v < 2; v++) {
+            const app_page_t *in = v ? long_pages : pages;
+            for (int r = 0; r < 2; r++) {
+                size_t before = atomic_load(&g_allocs);
+                app_analyze_result_t res = app_analyze_pages(in, 2, &opts);
+                TEST_ASSERT_EQUAL_INT(0, res.status);
+                allocs[v] = atomic_load(&g_allocs_analyzed) - before;
+                yyjson_mut_doc_free(res.response_doc);
+            }
+        }
+        TEST_ASSERT_TRUE(allocs[0] <= SCRATCH_WARM_MAX_ALLOCS);
+        TEST_ASSERT_TRUE(allocs[1] <= allocs[0] + 4);
+    }
+    free(long_text);
+#endif
+}
+
+static int cmp_wc_word(const void *a, const void *b) {
+    return strcmp(((const WordCount *)a)->word, ((const WordCount *)b)->word);
+}
+
+static int cmp_bc_key(const void *a, const void *b) {
+    const BigramCount *x = (const BigramCount *)a, *y = (const BigramCount *)b;
+    int c = strcmp(x->w1, y->w1);
+    return c ? c : strcmp(x->w2, y->w2);
+}
+
+// Schneller Pfad für kleine Seiten: dieselben Listen wie Filter + lineares
+// Zählen, in derselben Reihenfolge (bzw. nach Schlüssel sortiert)
+void test_small_count_matches_regular_path(void) {
+    StopwordList sw = {0};
+    TEST_ASSERT_EQUAL_INT(0, stopwords_load(&sw, "data/stopwords_de.txt"));
+    char *mid = make_big_page(8 * 1024);
+    const char *texts[] = {
+        "Hallo Welt",
+        "Der Apfel und die Banane, 2024 x Apfel! Banane Apfel 7 Kirsche.",
+        "und die der",
+        mid,
+        "Kirsche Dattel Kirsche"  // nach der größeren Seite: Tabellen wiederverwendet
+    };
+
+    // Tabellen über alle Aufrufe geteilt, sortiert ohne (pro Aufruf alloziert)
+    SmallCountTables *tables = small_count_tables_new();
+    TEST_ASSERT_NOT_NULL(tables);
+    for (size_t t = 0; t < sizeof(texts) / sizeof(texts[0]); t++) {
+        TokenList raw = tokenize(texts[t]);
+        TEST_ASSERT_TRUE(raw.count <= SMALL_PAGE_MAX_TOKENS);
+        TokenList filtered = filter_stopwords_copy(&raw, "data/stopwords_de.txt");
+        WordCountList ref_w = count_words(&filtered);
+        BigramCountList ref_b = count_bigrams_excluding_stopwords(&raw, &sw);
+
+        for (int sorted = 0; sorted < 2; sorted++) {
+            if (sorted) {
+                if (ref_w.count > 1) qsort(ref_w.items, ref_w.count, sizeof(WordCount), cmp_wc_word);
+                if (ref_b.count > 1) qsort(ref_b.items, ref_b.count, sizeof(BigramCount), cmp_bc_key);
+            }
+            WordCountList w;
+            BigramCountList b;
+            TEST_ASSERT_EQUAL_INT(1, small_count_page(&raw, &sw, sorted, sorted ? NULL : tables, &w, &b));
+            TEST_ASSERT_EQUAL_UINT((unsigned)ref_w.count, (unsigned)w.count);
+            for (size_t i = 0; i < w.count; i++) {
+                TEST_ASSERT_EQUAL_STRING(ref_w.items[i].word, w.items[i].word);
+                TEST_ASSERT_EQUAL_UINT((unsigned)ref_w.items[i].count, (unsigned)w.items[i].count);
+            }
+            TEST_ASSERT_EQUAL_UINT((unsigned)ref_b.count, (unsigned)b.count);
+            for (size_t i = 0; i < b.count; i++) {
+                TEST_ASSERT_EQUAL_STRING(ref_b.items[i].w1, b.items[i].w1);
+                TEST_ASSERT_EQUAL_STRING(ref_b.items[i].w2, b.items[i].w2);
+                TEST_ASSERT_EQUAL_UINT((unsigned)ref_b.items[i].count, (unsigned)b.items[i].count);
+            }
+            free_word_counts(&w);
+            free_bigram_counts(&b);
+        }
+        free_word_counts(&ref_w);
+        free_bigram_counts(&ref_b);
+        free_tokens(&filtered);
+        free_tokens(&raw);
+    }
+
+    // Über der Grenze: regulärer Pfad zuständig, nichts alloziert
+    char *big = make_big_page(64 * 1024);
+    TokenList raw = tokenize(big);
+    TEST_ASSERT_TRUE(raw.count > SMALL_PAGE_MAX_TOKENS);
+    WordCountList w;
+    TEST_ASSERT_EQUAL_INT(0, small_count_page(&raw, &sw, false, tables, &w, NULL));
+    TEST_ASSERT_NULL(w.items);
+    free_tokens(&raw);
+    small_count_tables_free(tables);
+
+    free(big);
+    free(mid);
+    stopwords_free(&sw);
+}
+
+// Anfragen mit und ohne schnellen Pfad: gleiche Ausgabe in allen Engines
+// (auch mit Stammformen); meta.smallPages zählt die kleinen Einheiten
+void test_small_pages_match_regular_requests(void) {
+    enum { N = 5 };
+    char *mid = make_big_page(6 * 1024);
+    char *big = make_big_page(64 * 1024);
+    const char *texts[N] = {
+        "Apfel Banane Kirsche Apfel, Banane und Kirsche.",
+        mid,
+        big,
+        "",
+        "Kirsche Kirsche Dattel — Apfel Banane Apfel Banane!"
+    };
+    app_page_t pages[N] = {0};
+    for (int i = 0; i < N; i++) pages[i].text = texts[i];
+
+    for (size_t e = 1; e < app_engine_count(); e++) {
+        for (int stem = 0; stem < 2; stem++) {
+            app_analyze_opts_t opts = {0};
+            opts.stopwords_path = "data/stopwords_de.txt";
+            opts.include_bigrams = true;
+            opts.per_page_results = true;
+            opts.top_k = 0;
+            opts.pipeline = (app_pipeline_t)e;
+            opts.stem = stem;
+
+            app_analyze_result_t fast = app_analyze_pages(pages, N, &opts);
+            opts.no_small_pages = true;
+            app_analyze_result_t slow = app_analyze_pages(pages, N, &opts);
+            TEST_ASSERT_EQUAL_INT(0, fast.status);
+            TEST_ASSERT_EQUAL_INT(0, slow.status);
+
+            yyjson_mut_val *rf = yyjson_mut_doc_get_root(fast.response_doc);
+            yyjson_mut_val *rs = yyjson_mut_doc_get_root(slow.response_doc);
+            unsigned expect = app_engine_at(e)->small_pages ? N - 1 : 0;
+            TEST_ASSERT_EQUAL_UINT(expect, (unsigned)yyjson_mut_get_uint(
+                yyjson_mut_obj_get(yyjson_mut_obj_get(rf, "meta"), "smallPages")));
+            TEST_ASSERT_EQUAL_UINT(0, (unsigned)yyjson_mut_get_uint(
+                yyjson_mut_obj_get(yyjson_mut_obj_get(rs, "meta"), "smallPages")));
+
+            yyjson_mut_val *df = yyjson_mut_obj_get(rf, "domainResult");
+            yyjson_mut_val *ds = yyjson_mut_obj_get(rs, "domainResult");
+            assert_json_lists_equal(yyjson_mut_obj_get(df, "words"), yyjson_mut_obj_get(ds, "words"));
+            assert_json_lists_equal(yyjson_mut_obj_get(df, "bigrams"), yyjson_mut_obj_get(ds, "bigrams"));
+            yyjson_mut_val *pf = yyjson_mut_obj_get(rf, "pageResults");
+            yyjson_mut_val *ps = yyjson_mut_obj_get(rs, "pageResults");
+            for (size_t i = 0; i < N; i++) {
+                yyjson_mut_val *a = yyjson_mut_arr_get(pf, i), *b = yyjson_mut_arr_get(ps, i);
+                assert_json_lists_equal(yyjson_mut_obj_get(a, "words"), yyjson_mut_obj_get(b, "words"));
+                assert_json_lists_equal(yyjson_mut_obj_get(a, "bigrams"), yyjson_mut_obj_get(b, "bigrams"));
+            }
+            yyjson_mut_doc_free(fast.response_doc);
+            yyjson_mut_doc_free(slow.response_doc);
+        }
+    }
+    free(big);
+    free(mid);
+}
+
+// AUTO mischt Zähler pro Seite (kleiner Pfad, andere zustandslose Engine,
+// Schattenlauf): gleiche Ausgabe wie erzwungenes string
+void test_auto_mixed_counters_match_forced_string(void) {
+    enum { N = 5 };
+    char *short_page = make_big_page(2 * 1024);
+    char *mid = make_big_page(6 * 1024);
+    char *big = make_big_page(64 * 1024);
+    const char *texts[N] = {
+        "Apfel Banane Kirsche Apfel, Banane und Kirsche.",
+        short_page,
+        mid,
+        big,
+        "Kirsche Kirsche Dattel — Apfel Banane Apfel Banane!"
+    };
+    app_page_t pages[N] = {0};
+    for (int i = 0; i < N; i++) pages[i].text = texts[i];
+
+    for (unsigned threads = 1; threads <= 4; threads += 3) {
+        for (int stem = 0; stem < 2; stem++) {
+            // erste AUTO-Anfrage nach dem Zurücksetzen zählt eine Seite zur Probe doppelt
+            cost_model_reset();
+            app_analyze_opts_t opts = {0};
+            opts.stopwords_path = "data/stopwords_de.txt";
+            opts.include_bigrams = true;
+            opts.per_page_results = true;
+            opts.top_k = 0;
+            opts.threads = threads;
+            opts.stem = stem;
+
+            opts.pipeline = APP_PIPELINE_AUTO;
+            app_analyze_result_t a = app_analyze_pages(pages, N, &opts);
+            opts.pipeline = APP_PIPELINE_STRING;
+            app_analyze_result_t s = app_analyze_pages(pages, N, &opts);
+            TEST_ASSERT_EQUAL_INT(0, a.status);
+            TEST_ASSERT_EQUAL_INT(0, s.status);
+
+            yyjson_mut_val *ra = yyjson_mut_doc_get_root(a.response_doc);
+            yyjson_mut_val *rs = yyjson_mut_doc_get_root(s.response_doc);
+            const char *reason = yyjson_mut_get_str(
+                yyjson_mut_obj_get(yyjson_mut_obj_get(ra, "meta"), "pipelineReason"));
+            TEST_ASSERT_NOT_NULL(reason);
+            TEST_ASSERT_EQUAL_INT(0, strncmp(reason, "auto: ", 6));
+            TEST_ASSERT_NOT_NULL(strstr(reason, "; shadow 1"));
+
+            yyjson_mut_val *da = yyjson_mut_obj_get(ra, "domainResult");
+            yyjson_mut_val *ds = yyjson_mut_obj_get(rs, "domainResult");
+            assert_json_lists_equal(yyjson_mut_obj_get(da, "words"), yyjson_mut_obj_get(ds, "words"));
+            assert_json_lists_equal(yyjson_mut_obj_get(da, "bigrams"), yyjson_mut_obj_get(ds, "bigrams"));
+            yyjson_mut_val *pa = yyjson_mut_obj_get(ra, "pageResults");
+            yyjson_mut_val *ps = yyjson_mut_obj_get(rs, "pageResults");
+            for (size_t i = 0; i < N; i++) {
+                yyjson_mut_val *x = yyjson_mut_arr_get(pa, i), *y = yyjson_mut_arr_get(ps, i);
+                assert_json_lists_equal(yyjson_mut_obj_get(x, "words"), yyjson_mut_obj_get(y, "words"));
+                assert_json_lists_equal(yyjson_mut_obj_get(x, "bigrams"), yyjson_mut_obj_get(y, "bigrams"));
+            }
+            yyjson_mut_doc_free(a.response_doc);
+            yyjson_mut_doc_free(s.response_doc);
+        }
+    }
+    cost_model_reset();
+    free(big);
+    free(mid);
+    free(short_page);
+}
+
+// partialOnTimeout: die große Seite reißt die Deadline und wird mitten in
+// der Zählung abgeschnitten; die fertige Seite bildet das Domänenergebnis
+void test_partial_results_on_timeout(void) {
+    char *big = make_big_page(32 * 1024 * 1024);
+    app_page_t pages[2] = {0};
+    pages[0].text = "Apfel Banane Kirsche Apfel, Banane und Kirsche.";
+    pages[1].text = big;
+
+    for (size_t e = 1; e < app_engine_count(); e++) {
+        for (unsigned threads = 1; threads <= 4; threads += 3) {
+            app_analyze_opts_t opts = {0};
+            opts.stopwords_path = "data/stopwords_de.txt";
+            opts.include_bigrams = true;
+            opts.per_page_results = true;
+            opts.top_k = 0;
+            opts.pipeline = (app_pipeline_t)e;
+            opts.threads = threads;
+            opts.sample_rate = 1.0;  // kein AUTO-Sampling vor der Deadline
+            opts.partial_on_timeout = true;
+
+            // Deadline aus gemessenen Laufzeiten: Vorbereitung beider Seiten
+            // (abgelaufene Deadline, 503 vor der Seitenstufe) und eine warme
+            // Anfrage nur mit der kleinen Seite (Sanitizer-Builds sind um
+            // ein Vielfaches langsamer), plus Reserve für die Zeitscheiben
+            // der übrigen Worker auf wenigen Kernen; die große Seite braucht
+            // trotzdem um Größenordnungen länger
+            double t0 = cancel_now_ms();
+            opts.deadline_ms = 1.0;
+            app_analyze_result_t prep = app_analyze_pages(pages, 2, &opts);
+            TEST_ASSERT_EQUAL_INT(503, prep.status);
+            double t1 = cancel_now_ms();
+            opts.deadline_ms = 0.0;
+            app_analyze_result_t warm = app_analyze_pages(pages, 1, &opts);
+            TEST_ASSERT_EQUAL_INT(0, warm.status);
+            yyjson_mut_doc_free(warm.response_doc);
+            double budget = 2.0 * (t1 - t0) + 3.0 * (cancel_now_ms() - t1) + 100.0;
+
+            opts.deadline_ms = cancel_now_ms() + budget;
+            app_analyze_result_t r = app_analyze_pages(pages, 2, &opts);
+            TEST_ASSERT_EQUAL_INT(0, r.status);
+            TEST_ASSERT_FALSE(cancel_requested());
+
+            yyjson_mut_val *root = yyjson_mut_doc_get_root(r.response_doc);
+            yyjson_mut_val *meta = yyjson_mut_obj_get(root, "meta");
+            TEST_ASSERT_TRUE(yyjson_mut_get_bool(yyjson_mut_obj_get(meta, "partial")));
+            TEST_ASSERT_EQUAL_UINT(1, (unsigned)yyjson_mut_get_uint(yyjson_mut_obj_get(meta, "pagesCompleted")));
+
+            yyjson_mut_val *pr = yyjson_mut_obj_get(root, "pageResults");
+            yyjson_mut_val *p0 = yyjson_mut_arr_get(pr, 0), *p1 = yyjson_mut_arr_get(pr, 1);
+            TEST_ASSERT_NULL(yyjson_mut_obj_get(p0, "partial"));
+            TEST_ASSERT_TRUE(yyjson_mut_get_bool(yyjson_mut_obj_get(p1, "partial")));
+            TEST_ASSERT_EQUAL_UINT(0, (unsigned)yyjson_mut_get_uint(yyjson_mut_obj_get(p1, "wordCount")));
+            TEST_ASSERT_EQUAL_UINT(0, (unsigned)yyjson_mut_arr_size(yyjson_mut_obj_get(p1, "words")));
+
+            yyjson_mut_val *dr = yyjson_mut_obj_get(root, "domainResult");
+            assert_json_lists_equal(yyjson_mut_obj_get(p0, "words"), yyjson_mut_obj_get(dr, "words"));
+            assert_json_lists_equal(yyjson_mut_obj_get(p0, "bigrams"), yyjson_mut_obj_get(dr, "bigrams"));
+            yyjson_mut_doc_free(r.response_doc);
+
+            // Ohne die Option: 503 wie bisher
+            opts.partial_on_timeout = false;
+            opts.deadline_ms = cancel_now_ms() + budget;
+            app_analyze_result_t late = app_analyze_pages(pages, 2, &opts);
+            TEST_ASSERT_EQUAL_INT(503, late.status);
+            TEST_ASSERT_NULL(late.response_doc);
+        }
+    }
+    free(big);
+}
+
+// Seite aus zufälligen Wörtern mit zwei Buchstaben (36 Wörter, 1296
+// Bigramme): volle Listen je Chunk, das Zusammenführen dauert
+static char *make_wide_page(size_t min_bytes) {
+    char *buf = (char *)malloc(min_bytes + 8);
+    TEST_ASSERT_NOT_NULL(buf);
+    size_t n = 0;
+    uint32_t r = 777u;
+    while (n < min_bytes) {
+        for (int k = 0; k < 2; k++) {
+            r = r * 1103515245u + 12345u;
+            buf[n++] = (char)('a' + (r >> 16) % 6);
+        }
+        buf[n++] = ' ';
+    }
+    buf[n] = '\0';
+    return buf;
+}
+
+// Deadline während des Zusammenführens der Chunk-Listen einer geteilten
+// Seite (Engines ohne join): die Seite ist danach vollständig oder als
+// partial markiert, nie still gekürzt. Die Deadlines liegen im hinteren
+// Teil der gemessenen Laufzeit, wo das Zusammenführen läuft.
+void test_partial_cut_during_chunk_merge(void) {
+    char *wide = make_wide_page(300 * 1024);
+    app_page_t pages[2] = {0};
+    pages[0].text = "Apfel Banane Kirsche Apfel, Banane und Kirsche.";
+    pages[1].text = wide;
+    const double at[] = { 0.55, 0.7, 0.85, 0.95 };
+
+    for (size_t e = 1; e < app_engine_count(); e++) {
+        if (app_engine_get((app_pipeline_t)e)->join) continue;
+
+        app_analyze_opts_t opts = {0};
+        opts.stopwords_path = "data/stopwords_de.txt";
+        opts.include_bigrams = true;
+        opts.per_page_results = true;
+        opts.top_k = 0;
+        opts.pipeline = (app_pipeline_t)e;
+        opts.threads = 4;
+        opts.sample_rate = 1.0;
+        opts.partial_on_timeout = true;
+
+        double t0 = cancel_now_ms();
+        app_analyze_result_t full = app_analyze_pages(pages, 2, &opts);
+        TEST_ASSERT_EQUAL_INT(0, full.status);
+        double took = cancel_now_ms() - t0;
+        yyjson_mut_val *fp = yyjson_mut_arr_get(
+            yyjson_mut_obj_get(yyjson_mut_doc_get_root(full.response_doc), "pageResults"), 1);
+
+        for (size_t i = 0; i < sizeof(at) / sizeof(at[0]); i++) {
+            opts.deadline_ms = cancel_now_ms() + took * at[i];
+            app_analyze_result_t r = app_analyze_pages(pages, 2, &opts);
+            TEST_ASSERT_EQUAL_INT(0, r.status);
+
+            yyjson_mut_val *root = yyjson_mut_doc_get_root(r.response_doc);
+            yyjson_mut_val *meta = yyjson_mut_obj_get(root, "meta");
+            yyjson_mut_val *p1 = yyjson_mut_arr_get(yyjson_mut_obj_get(root, "pageResults"), 1);
+            bool cut = yyjson_mut_obj_get(p1, "partial") != NULL;
+            TEST_ASSERT_EQUAL(cut, yyjson_mut_get_bool(yyjson_mut_obj_get(meta, "partial")));
+            if (cut) {
+                TEST_ASSERT_EQUAL_UINT(0, (unsigned)yyjson_mut_arr_size(yyjson_mut_obj_get(p1, "words")));
+                TEST_ASSERT_EQUAL_UINT(0, (unsigned)yyjson_mut_arr_size(yyjson_mut_obj_get(p1, "bigrams")));
+            } else {
+                assert_json_lists_equal(yyjson_mut_obj_get(fp, "words"), yyjson_mut_obj_get(p1, "words"));
+                assert_json_lists_equal(yyjson_mut_obj_get(fp, "bigrams"), yyjson_mut_obj_get(p1, "bigrams"));
+            }
+            yyjson_mut_doc_free(r.response_doc);
+        }
+        yyjson_mut_doc_free(full.response_doc);
+    }
+    free(wide);
+}
+
+// Plan: Schnitte nur an Leerraum, Chunks decken die Seite lückenlos ab
+void test_page_plan_split_and_batch(void) {
+    const char *texts[] = { "aa bb", "cc", "dddd eeee ffff gggg hhhh iiii", "jj", "kk", "ohneleerraumlangeseite" };
+    app_page_t pages[6] = {0};
+    for (int i = 0; i < 6; i++) pages[i].text = texts[i];
+
+    PagePlanLimits lim = { .split_bytes = 10, .chunk_bytes = 6, .batch_bytes = 4 };
+    PagePlan plan;
+    TEST_ASSERT_EQUAL_INT(1, page_plan_build(&plan, pages, 6, 2, true, &lim));
+
+    // Seite 2 geteilt, Seite 5 ohne Leerraum bleibt ganz
+    TEST_ASSERT_EQUAL_UINT(1, (unsigned)plan.n_splits);
+    TEST_ASSERT_EQUAL_UINT(2, (unsigned)plan.splits[0].page);
+    TEST_ASSERT_EQUAL_UINT(6, (unsigned)plan.splits[0].first_slot);
+    TEST_ASSERT_EQUAL_UINT(6 + plan.splits[0].n_chunks, (unsigned)plan.n_slots);
+
+    size_t covered = 0, chunks = 0;
+    for (size_t u = 0; u < plan.n_units; u++) {
+        const PageUnit *pu = &plan.units[u];
+        if (pu->split == PAGE_NO_SPLIT) {
+            TEST_ASSERT_EQUAL_UINT(pu->page, pu->slot);
+            continue;
+        }
+        TEST_ASSERT_EQUAL_UINT(covered, (unsigned)pu->begin);
+        if (pu->end < strlen(texts[2])) TEST_ASSERT_EQUAL_INT(' ', texts[2][pu->end]);
+        covered = pu->end;
+        chunks++;
+    }
+    TEST_ASSERT_EQUAL_UINT(strlen(texts[2]), (unsigned)covered);
+    TEST_ASSERT_EQUAL_UINT(plan.splits[0].n_chunks, (unsigned)chunks);
+
+    // Tasks: [aa bb] (>= 4 Bytes), [cc] (vor der geteilten Seite beendet),
+    // Chunks, [jj kk] als einziger Batch, [ohneleerraum...]
+    TEST_ASSERT_EQUAL_UINT(1, (unsigned)plan.batches);
+    TEST_ASSERT_EQUAL_UINT(4 + chunks, (unsigned)plan.n_tasks);
+    page_plan_free(&plan);
+
+    // Ein Thread: nichts wird geteilt
+    TEST_ASSERT_EQUAL_INT(1, page_plan_build(&plan, pages, 6, 1, true, &lim));
+    TEST_ASSERT_EQUAL_UINT(0, (unsigned)plan.n_splits);
+    TEST_ASSERT_EQUAL_UINT(6, (unsigned)plan.n_slots);
+    page_plan_free(&plan);
+}
@@ -181,7 +181,9 @@ void test_options_defaults_and_overrides(void) {
         "{"
         "  \"domain\":\"d\","
         "  \"pages\":[{\"text\":\"hi\"}],"
-        "  \"options\":{\"includeBigrams\":false,\"perPageResults\":true}"
+        "  \"options\":{\"includeBigrams\":false,\"perPageResults\":true,"
+        "              \"approximate\":true,\"approximateCapacity\":128,\"stem\":true,\"tfidf\":true,"
+        "              \"partialOnTimeout\":true}"
         "}";
 
     validated_request_t out;
@@ -191,6 +193,11 @@ void test_options_defaults_and_overrides(void) {
     TEST_ASSERT_EQUAL_STRING("d", out.domain);
     TEST_ASSERT_FALSE(out.include_bigrams);
     TEST_ASSERT_TRUE(out.per_page_results);
+    TEST_ASSERT_TRUE(out.approximate);
+    TEST_ASSERT_EQUAL_UINT(128, (unsigned)out.approximate_capacity);
+    TEST_ASSERT_TRUE(out.stem);
+    TEST_ASSERT_TRUE(out.tfidf);
+    TEST_ASSERT_TRUE(out.partial_on_timeout);
 
     validated_request_free(&out);
     free(buf);
@@ -226,6 +233,32 @@ void test_api_rejects_invalid_pipeline_option(void) {
     assert_validate_fail(json, &cfg, 400);
 }
 
+void test_api_validates_sample_options(void) {
+    req_validate_cfg_t cfg = api_cfg();
+    const char *json =
+        "{"
+        "  \"pages\":[{\"text\":\"hi\"}],"
+        "  \"options\":{\"sampleRate\":0.25,\"sampleSeed\":42}"
+        "}";
+
+    validated_request_t out;
+    char *buf = NULL;
+    assert_validate_ok(json, &cfg, &out, &buf);
+    TEST_ASSERT_TRUE(out.sample_rate > 0.24 && out.sample_rate < 0.26);
+    TEST_ASSERT_EQUAL_UINT(42, (unsigned)out.sample_seed);
+    validated_request_free(&out);
+    free(buf);
+
+    // Rate außerhalb von (0, 1] wird abgelehnt
+    assert_validate_fail("{\"pages\":[{\"text\":\"hi\"}],\"options\":{\"sampleRate\":0}}", &cfg, 400);
+    assert_validate_fail("{\"pages\":[{\"text\":\"hi\"}],\"options\":{\"sampleRate\":1.5}}", &cfg, 400);
+
+    // N-Gramm-Ordnung 0..4, Kookkurrenz-Fenster 0..16, Grenzen positiv
+    assert_validate_fail("{\"pages\":[{\"text\":\"hi\"}],\"options\":{\"ngrams\":5}}", &cfg, 400);
+    assert_validate_fail("{\"pages\":[{\"text\":\"hi\"}],\"options\":{\"ngramLimit\":0}}", &cfg, 400);
+    assert_validate_fail("{\"pages\":[{\"text\":\"hi\"}],\"options\":{\"cooccurrenceWindow\":17}}", &cfg, 400);
+}
+
 void test_cli_ignores_pipeline_option(void) {
     req_validate_cfg_t cfg = cli_cfg();
     const char *json =
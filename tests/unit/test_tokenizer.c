@@ -4,6 +4,10 @@
 #include "core/tokenizer.h"
 #include "core/stopwords.h"
 #include "core/freq.h"
+#include "core/sampling.h"
+
+#include <stdio.h>
+#include <string.h>
 
 static void assert_tokens(TokenList tl, const char **expected, size_t n) {
     TEST_ASSERT_EQUAL_UINT((unsigned)n, (unsigned)tl.count);
@@ -92,7 +96,89 @@ void test_tokenizer_with_stats_counts_including_stopwords_single_letters_umlaut(
     free_tokens(&tl);
 }
 
+void test_tokenizer_skips_overlong_tokens(void) {
+    const char *text = "kurz abcdefghij ende";
+    TokenStats st;
+    TokenList tl = tokenize_with_limit(text, &st, 8);
+
+    // "abcdefghij" (10 bytes) exceeds the limit and is dropped, not truncated
+    const char *exp[] = {"kurz", "ende"};
+    assert_tokens(tl, exp, 2);
+    TEST_ASSERT_EQUAL_UINT((unsigned)2, (unsigned)st.wordCount);
+    TEST_ASSERT_EQUAL_UINT((unsigned)1, (unsigned)st.tokensTooLong);
+    free_tokens(&tl);
+
+    // 0 = keine Grenze: auch ein Token über TOKENIZER_MAX_TOKEN_BYTES bleibt
+    char longtext[TOKENIZER_MAX_TOKEN_BYTES + 16];
+    memset(longtext, 'x', TOKENIZER_MAX_TOKEN_BYTES + 8);
+    longtext[TOKENIZER_MAX_TOKEN_BYTES + 8] = '\0';
+    tl = tokenize_with_limit(longtext, &st, 0);
+    TEST_ASSERT_EQUAL_UINT((unsigned)1, (unsigned)tl.count);
+    TEST_ASSERT_EQUAL_UINT((unsigned)(TOKENIZER_MAX_TOKEN_BYTES + 8), (unsigned)strlen(tl.items[0]));
+    TEST_ASSERT_EQUAL_UINT((unsigned)0, (unsigned)st.tokensTooLong);
+    free_tokens(&tl);
+}
+
+void test_tokenizer_sampled_windows_are_stable(void) {
+    // 60 Wörter, Fenster à 32 Bytes
+    char text[1024] = "";
+    for (int i = 0; i < 60; i++) {
+        char w[24];
+        snprintf(w, sizeof(w), "wort%02d ", i);
+        strcat(text, w);
+    }
+    TokenList full = tokenize(text);
+
+    // Rate 1: identisch mit dem normalen Tokenizer
+    SampleSpec all = { .rate = 1.0, .seed = 1, .window_bytes = 32 };
+    TokenList same = sample_tokenize(text, 0, &all, 0, NULL);
+    TEST_ASSERT_EQUAL_UINT((unsigned)full.count, (unsigned)same.count);
+    free_tokens(&same);
+
+    // Rate 0.5: gleicher Seed -> gleiche Auswahl; Tokens in Originalreihenfolge,
+    // Lücken nur als leere Tokens zwischen zwei Spans
+    SampleSpec half = { .rate = 0.5, .seed = 7, .window_bytes = 32 };
+    SampleStats st1, st2;
+    TokenList a = sample_tokenize(text, 3, &half, 0, &st1);
+    TokenList b = sample_tokenize(text, 3, &half, 0, &st2);
+    TEST_ASSERT_EQUAL_UINT((unsigned)a.count, (unsigned)b.count);
+    TEST_ASSERT_EQUAL_UINT((unsigned)strlen(text), (unsigned)st1.bytes_total);
+    TEST_ASSERT_TRUE(st1.windows_kept > 0 && st1.windows_kept < st1.windows_total);
+    TEST_ASSERT_TRUE(st1.bytes_kept < st1.bytes_total);
+    TEST_ASSERT_EQUAL_UINT((unsigned)st1.bytes_kept, (unsigned)st2.bytes_kept);
+
+    size_t pos = 0, words = 0;
+    TEST_ASSERT_TRUE(a.count > 0 && a.items[0][0] != '\0' && a.items[a.count - 1][0] != '\0');
+    for (size_t i = 0; i < a.count; i++) {
+        TEST_ASSERT_EQUAL_STRING(b.items[i], a.items[i]);
+        if (a.items[i][0] == '\0') continue;
+        while (pos < full.count && strcmp(full.items[pos], a.items[i]) != 0) pos++;
+        TEST_ASSERT_TRUE(pos < full.count);
+        words++;
+    }
+    TEST_ASSERT_TRUE(words < full.count);
+    free_tokens(&a);
+    free_tokens(&b);
+
+    // Keine Auswahl: leere Liste, nichts gelesen
+    SampleSpec none = { .rate = 1e-12, .seed = 7, .window_bytes = 32 };
+    SampleStats st0;
+    TokenList z = sample_tokenize(text, 0, &none, 0, &st0);
+    TEST_ASSERT_EQUAL_UINT(0, (unsigned)z.count);
+    TEST_ASSERT_EQUAL_UINT(0, (unsigned)st0.bytes_kept);
+    free_tokens(&z);
+
+    // Konfidenzintervall umschließt die Hochrechnung, untere Grenze >= Stichprobe
+    size_t lo = 0, hi = 0;
+    sample_interval(50, 0.25, &lo, &hi);
+    TEST_ASSERT_EQUAL_UINT(200, (unsigned)sample_scale_count(50, 0.25));
+    TEST_ASSERT_TRUE(lo >= 50 && lo < 200 && hi > 200);
+
+    free_tokens(&full);
+}
+
 void test_aggregate_g5_basic(void);
+void test_aggregate_threshold_topk_matches_full(void);
 
 void test_bigrams_basic(void);
 void test_bigrams_do_not_bridge_over_stopwords(void);
@@ -101,22 +187,58 @@ void test_bigram_aggregate_basic(void);
 
 void test_topk_words_order_and_truncate(void);
 void test_topk_bigrams_order_and_truncate(void);
+void test_topk_partial_selection_matches_full_sort(void);
+void test_topk_ranked_full_order_matches_comparator(void);
+void test_topk_id_space_matches_comparator(void);
 
 void test_parity_g1_short(void);
 void test_parity_g2_punct(void);
 void test_parity_g3_stopwords(void);
 void test_parity_g4_repetitions(void);
 void test_parity_g5_multi_page_like(void);
+void test_parity_engines_multi_page(void);
+void test_parallel_pages_match_sequential(void);
+void test_page_plan_split_and_batch(void);
+
+void test_dict_ids_stable_across_incremental_rehash(void);
+void test_dict_ids_stable_when_old_chain_wraps(void);
+void test_idbigrams_counts_across_incremental_rehash(void);
+void test_idbigrams_counts_when_old_chain_wraps(void);
+void test_idbigrams_widens_keys_for_large_ids(void);
+void test_dict_batch_matches_single_lookups(void);
+void test_art_prefix_keys_and_ordered_iteration(void);
+void test_idfreq_grows_across_mmap_threshold(void);
 
 void test_api_rejects_root_array(void);
 void test_cli_accepts_root_array(void);
 void test_api_requires_pages_array(void);
+void test_heavy_hitters_bounds_and_verified_topk(void);
+void test_id_ngrams_single_pass_all_orders(void);
+void test_id_cooc_window_seams_and_pruning(void);
+void test_stem_de_memo_and_fold(void);
+void test_docfreq_tfidf_ranking(void);
+void test_arena_bump_reset_and_string_hooks(void);
+void test_scratch_tables_reset_and_trim(void);
+void test_cancel_stops_hot_loops(void);
+void test_scratch_reused_across_requests(void);
+void test_small_count_matches_regular_path(void);
+void test_small_pages_match_regular_requests(void);
+void test_pipeline_force_string(void);
+void test_pipeline_force_id(void);
+void test_pipeline_auto_small_uses_string(void);
+void test_auto_model_request_choice(void);
+void test_auto_model_unit_counter(void);
+void test_auto_model_refines_from_reports(void);
+void test_auto_mixed_counters_match_forced_string(void);
+void test_partial_results_on_timeout(void);
+void test_partial_cut_during_chunk_merge(void);
 void test_api_rejects_empty_pages(void);
 void test_api_rejects_too_many_pages(void);
 void test_page_requires_text_string(void);
 void test_options_defaults_and_overrides(void);
 void test_api_accepts_valid_pipeline_option(void);
 void test_api_rejects_invalid_pipeline_option(void);
+void test_api_validates_sample_options(void);
 void test_cli_ignores_pipeline_option(void);
 
 int main(void) {
@@ -125,19 +247,56 @@ int main(void) {
     RUN_TEST(test_tokenizer_g2_punctuation);
     RUN_TEST(test_tokenizer_with_stats_counts_including_stopwords);
     RUN_TEST(test_tokenizer_with_stats_counts_including_stopwords_single_letters_umlaut);
+    RUN_TEST(test_tokenizer_skips_overlong_tokens);
+    RUN_TEST(test_tokenizer_sampled_windows_are_stable);
     RUN_TEST(test_stopwords_g3_basic);
     RUN_TEST(test_freq_g4_basic_counts);
     RUN_TEST(test_aggregate_g5_basic);
+    RUN_TEST(test_aggregate_threshold_topk_matches_full);
     RUN_TEST(test_bigrams_basic);
     RUN_TEST(test_bigrams_do_not_bridge_over_stopwords);
     RUN_TEST(test_bigram_aggregate_basic);
     RUN_TEST(test_topk_words_order_and_truncate);
     RUN_TEST(test_topk_bigrams_order_and_truncate);
+    RUN_TEST(test_topk_partial_selection_matches_full_sort);
+    RUN_TEST(test_topk_ranked_full_order_matches_comparator);
+    RUN_TEST(test_topk_id_space_matches_comparator);
     RUN_TEST(test_parity_g1_short);
     RUN_TEST(test_parity_g2_punct);
     RUN_TEST(test_parity_g3_stopwords);
     RUN_TEST(test_parity_g4_repetitions);
     RUN_TEST(test_parity_g5_multi_page_like);
+    RUN_TEST(test_parity_engines_multi_page);
+    RUN_TEST(test_parallel_pages_match_sequential);
+    RUN_TEST(test_page_plan_split_and_batch);
+    RUN_TEST(test_dict_ids_stable_across_incremental_rehash);
+    RUN_TEST(test_dict_ids_stable_when_old_chain_wraps);
+    RUN_TEST(test_idbigrams_counts_across_incremental_rehash);
+    RUN_TEST(test_idbigrams_counts_when_old_chain_wraps);
+    RUN_TEST(test_idbigrams_widens_keys_for_large_ids);
+    RUN_TEST(test_dict_batch_matches_single_lookups);
+    RUN_TEST(test_art_prefix_keys_and_ordered_iteration);
+    RUN_TEST(test_idfreq_grows_across_mmap_threshold);
+    RUN_TEST(test_heavy_hitters_bounds_and_verified_topk);
+    RUN_TEST(test_id_ngrams_single_pass_all_orders);
+    RUN_TEST(test_id_cooc_window_seams_and_pruning);
+    RUN_TEST(test_stem_de_memo_and_fold);
+    RUN_TEST(test_docfreq_tfidf_ranking);
+    RUN_TEST(test_arena_bump_reset_and_string_hooks);
+    RUN_TEST(test_scratch_tables_reset_and_trim);
+    RUN_TEST(test_cancel_stops_hot_loops);
+    RUN_TEST(test_scratch_reused_across_requests);
+    RUN_TEST(test_small_count_matches_regular_path);
+    RUN_TEST(test_small_pages_match_regular_requests);
+    RUN_TEST(test_pipeline_force_string);
+    RUN_TEST(test_pipeline_force_id);
+    RUN_TEST(test_pipeline_auto_small_uses_string);
+    RUN_TEST(test_auto_model_request_choice);
+    RUN_TEST(test_auto_model_unit_counter);
+    RUN_TEST(test_auto_model_refines_from_reports);
+    RUN_TEST(test_auto_mixed_counters_match_forced_string);
+    RUN_TEST(test_partial_results_on_timeout);
+    RUN_TEST(test_partial_cut_during_chunk_merge);
     RUN_TEST(test_api_rejects_root_array);
     RUN_TEST(test_cli_accepts_root_array);
     RUN_TEST(test_api_requires_pages_array);
@@ -147,6 +306,7 @@ int main(void) {
     RUN_TEST(test_options_defaults_and_overrides);
     RUN_TEST(test_api_accepts_valid_pipeline_option);
     RUN_TEST(test_api_rejects_invalid_pipeline_option);
+    RUN_TEST(test_api_validates_sample_options);
     RUN_TEST(test_cli_ignores_pipeline_option);
 
     return UNITY_END();
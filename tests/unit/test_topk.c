@@ -1,5 +1,9 @@
 #include "unity.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "core/freq.h"
 #include "core/bigrams.h"
 #include "view/topk.h"
@@ -56,3 +60,152 @@ void test_topk_bigrams_order_and_truncate(void) {
 
     free_top_k_bigrams(&top);
 }
+
+void test_topk_partial_selection_matches_full_sort(void) {
+    // Many ties on few counts: heap selection must keep the full-sort order.
+    enum { N = 500 };
+    WordCount words[N];
+    BigramCount bigrams[N];
+    char wbuf[N][16], b1buf[N][8], b2buf[N][8];
+    for (unsigned i = 0; i < N; i++) {
+        unsigned r = (i * 2654435761u) >> 7;
+        snprintf(wbuf[i], sizeof(wbuf[i]), "w%u", r % 100000);
+        snprintf(b1buf[i], sizeof(b1buf[i]), "a%u", r % 37);
+        snprintf(b2buf[i], sizeof(b2buf[i]), "b%u", i);
+        words[i] = (WordCount){ .word = wbuf[i], .count = 1 + r % 7 };
+        bigrams[i] = (BigramCount){ .w1 = b1buf[i], .w2 = b2buf[i], .count = 1 + r % 5 };
+    }
+    WordCountList wl = {.items = words, .count = N};
+    BigramCountList bl = {.items = bigrams, .count = N};
+
+    WordCountList wfull = top_k_words(&wl, N);
+    BigramCountList bfull = top_k_bigrams(&bl, N);
+    TEST_ASSERT_EQUAL_UINT(N, (unsigned)wfull.count);
+
+    const size_t ks[] = {1, 2, 20, 499};
+    for (size_t t = 0; t < sizeof(ks) / sizeof(ks[0]); t++) {
+        WordCountList w = top_k_words(&wl, ks[t]);
+        BigramCountList b = top_k_bigrams(&bl, ks[t]);
+        TEST_ASSERT_EQUAL_UINT((unsigned)ks[t], (unsigned)w.count);
+        TEST_ASSERT_EQUAL_UINT((unsigned)ks[t], (unsigned)b.count);
+        for (size_t i = 0; i < ks[t]; i++) {
+            TEST_ASSERT_EQUAL_STRING(wfull.items[i].word, w.items[i].word);
+            TEST_ASSERT_EQUAL_UINT((unsigned)wfull.items[i].count, (unsigned)w.items[i].count);
+            TEST_ASSERT_EQUAL_STRING(bfull.items[i].w1, b.items[i].w1);
+            TEST_ASSERT_EQUAL_STRING(bfull.items[i].w2, b.items[i].w2);
+        }
+        free_top_k_words(&w);
+        free_top_k_bigrams(&b);
+    }
+
+    // Full list is ordered by count DESC, then word ASC.
+    for (size_t i = 1; i < wfull.count; i++) {
+        const WordCount *p = &wfull.items[i - 1], *c = &wfull.items[i];
+        TEST_ASSERT_TRUE(p->count > c->count || (p->count == c->count && strcmp(p->word, c->word) <= 0));
+    }
+
+    free_top_k_words(&wfull);
+    free_top_k_bigrams(&bfull);
+}
+
+void test_topk_ranked_full_order_matches_comparator(void) {
+    // Domain list plus a "page" list with a subset of its words.
+    WordCount dw[] = {
+        {.word = "kirsche", .count = 3}, {.word = "apfel", .count = 3},
+        {.word = "apfelbaum", .count = 1}, {.word = "banane", .count = 7},
+        {.word = "äpfel", .count = 3}, {.word = "zz", .count = 1},
+    };
+    WordCount pw[] = {
+        {.word = "zz", .count = 1}, {.word = "apfelbaum", .count = 1}, {.word = "apfel", .count = 1},
+    };
+    BigramCount db[] = {
+        {.w1 = "apfel", .w2 = "kirsche", .count = 2}, {.w1 = "apfel", .w2 = "banane", .count = 2},
+        {.w1 = "zz", .w2 = "apfel", .count = 5}, {.w1 = "banane", .w2 = "", .count = 2},
+    };
+    WordCountList domain = {.items = dw, .count = 6};
+    WordCountList page = {.items = pw, .count = 3};
+    WordCountList unknown = {.items = (WordCount[]){{.word = "neu", .count = 1}, {.word = "apfel", .count = 1}}, .count = 2};
+    BigramCountList dbl = {.items = db, .count = 4};
+
+    TopkLexRank r;
+    TEST_ASSERT_TRUE(topk_lexrank_init(&r, &domain, &dbl));
+
+    const WordCountList *lists[] = { &domain, &page, &unknown };
+    for (size_t l = 0; l < 3; l++) {
+        WordCountList a = top_k_words(lists[l], lists[l]->count);
+        WordCountList b = top_k_words_ranked(&r, lists[l], lists[l]->count);
+        TEST_ASSERT_EQUAL_UINT((unsigned)a.count, (unsigned)b.count);
+        for (size_t i = 0; i < a.count; i++) {
+            TEST_ASSERT_EQUAL_STRING(a.items[i].word, b.items[i].word);
+            TEST_ASSERT_EQUAL_UINT((unsigned)a.items[i].count, (unsigned)b.items[i].count);
+        }
+        free_top_k_words(&a);
+        free_top_k_words(&b);
+    }
+
+    BigramCountList a = top_k_bigrams(&dbl, dbl.count);
+    BigramCountList b = top_k_bigrams_ranked(&r, &dbl, dbl.count);
+    TEST_ASSERT_EQUAL_UINT((unsigned)a.count, (unsigned)b.count);
+    for (size_t i = 0; i < a.count; i++) {
+        TEST_ASSERT_EQUAL_STRING(a.items[i].w1, b.items[i].w1);
+        TEST_ASSERT_EQUAL_STRING(a.items[i].w2, b.items[i].w2);
+    }
+    free_top_k_bigrams(&a);
+    free_top_k_bigrams(&b);
+
+    topk_lexrank_free(&r);
+}
+
+void test_topk_id_space_matches_comparator(void) {
+    // IDs in Einfügereihenfolge, nicht lexikografisch
+    const char *vocab[] = { "kirsche", "apfel", "äpfel", "banane", "apfelbaum", "zz" };
+    Dict d;
+    TEST_ASSERT_TRUE(dict_init(&d, 16));
+    for (size_t i = 0; i < 6; i++) TEST_ASSERT_EQUAL_UINT(i + 1, dict_get_or_add(&d, vocab[i]));
+
+    IdCount wi[] = { {1, 3}, {2, 3}, {3, 3}, {4, 7}, {5, 1}, {6, 1} };
+    IdPairCount bi[] = { {2, 1, 2}, {2, 4, 2}, {6, 2, 5}, {4, 5, 2}, {1, 1, 2} };
+    IdCountList ids = {.items = wi, .count = 6};
+    IdPairCountList pairs = {.items = bi, .count = 5};
+
+    WordCount ws[6];
+    for (size_t i = 0; i < 6; i++) ws[i] = (WordCount){.word = (char *)vocab[wi[i].id - 1], .count = wi[i].count};
+    BigramCount bs[5];
+    for (size_t i = 0; i < 5; i++) {
+        bs[i] = (BigramCount){.w1 = (char *)vocab[bi[i].id1 - 1], .w2 = (char *)vocab[bi[i].id2 - 1],
+                              .count = bi[i].count};
+    }
+    WordCountList wl = {.items = ws, .count = 6};
+    BigramCountList bl = {.items = bs, .count = 5};
+
+    uint32_t *rank = topk_dict_ranks(&d);
+    TEST_ASSERT_NOT_NULL(rank);
+
+    // Teilauswahl (Heap) und volle Ordnung (Radix)
+    const size_t ks[] = { 1, 3, 6, 100 };
+    for (size_t t = 0; t < 4; t++) {
+        WordCountList a = top_k_words(&wl, ks[t]);
+        WordCountList b = top_k_word_ids(&d, rank, &ids, ks[t]);
+        TEST_ASSERT_EQUAL_UINT((unsigned)a.count, (unsigned)b.count);
+        for (size_t i = 0; i < a.count; i++) {
+            TEST_ASSERT_EQUAL_STRING(a.items[i].word, b.items[i].word);
+            TEST_ASSERT_EQUAL_UINT((unsigned)a.items[i].count, (unsigned)b.items[i].count);
+        }
+        free_top_k_words(&a);
+        free_top_k_words(&b);
+
+        BigramCountList ab = top_k_bigrams(&bl, ks[t]);
+        BigramCountList bb = top_k_bigram_ids(&d, rank, &pairs, ks[t]);
+        TEST_ASSERT_EQUAL_UINT((unsigned)ab.count, (unsigned)bb.count);
+        for (size_t i = 0; i < ab.count; i++) {
+            TEST_ASSERT_EQUAL_STRING(ab.items[i].w1, bb.items[i].w1);
+            TEST_ASSERT_EQUAL_STRING(ab.items[i].w2, bb.items[i].w2);
+            TEST_ASSERT_EQUAL_UINT((unsigned)ab.items[i].count, (unsigned)bb.items[i].count);
+        }
+        free_top_k_bigrams(&ab);
+        free_top_k_bigrams(&bb);
+    }
+
+    free(rank);
+    dict_free(&d);
+}